@@ -0,0 +1,84 @@
+#ifndef ACTUATION_TRACE_H
+#define ACTUATION_TRACE_H
+
+#include <Arduino.h>
+#include "device_state.h"
+
+// End-to-end actuation tracing. A status or mode command that carries an
+// "id", and every auto-mode pump start/stop, is stamped with micros() on its
+// way to the relay:
+//
+//   received  MQTT callback on the network task (commands only)
+//   applied   control stage applied the command / took the auto decision
+//   gpio      relay pin written (missing when the relay did not change)
+//   published actual-status with the trace handed to the client
+//
+// The control stage finishes the traces of a tick and passes them to the
+// network task through a bounded lock-free SPSC ring (same scheme as
+// command_queue.h). The network task publishes each one on
+// actuator/{id}/actual-status on its next iteration, not on the publish
+// period:
+//
+//   {"value":"on","id":"op-17","seq":12,"source":"command","relay":"changed",
+//    "us":{"queue":41200,"control":35,"report":18400,"total":59635}}
+//
+// queue = received -> applied, control = applied -> gpio, report = gpio (or
+// applied) -> published, total = first stamp -> published. Auto transitions
+// have no queue hop. Commands without an "id" behave as before.
+
+#define ACTUATION_ID_MAX        24  // correlation id incl. terminator; longer ids are cut
+#define ACTUATION_RING_CAPACITY 8   // finished traces waiting for the network task, power of two
+#define ACTUATION_SLO_US        500000 // total above this is counted (and logged) as a miss
+
+enum ActuationSource : uint8_t {
+    ACTUATION_COMMAND = 0,  // actuator/{id}/status or mode with an "id"
+    ACTUATION_AUTO,         // auto-mode pump cycle start or stop
+    ACTUATION_SOURCE_COUNT
+};
+
+struct ActuationTrace {
+    char id[ACTUATION_ID_MAX]; // the command's id; empty for auto transitions ("auto-{seq}")
+    uint32_t seq;              // per boot, gaps mean lost traces
+    uint8_t zone;
+    ActuationSource source;
+    bool on;                   // relay state at the end of the tick
+    bool relayChanged;         // false: the relay already was there (or mode/cap held it)
+    uint32_t receivedUs;
+    uint32_t appliedUs;
+    uint32_t gpioUs;           // only when relayChanged
+};
+
+struct ActuationStats {
+    unsigned long traces[ACTUATION_SOURCE_COUNT]; // finished by the control stage
+    unsigned long dropped;      // ring full
+    unsigned long published;
+    unsigned long unpublished;  // offline or publish failed
+    unsigned long sloMisses;    // published with total > ACTUATION_SLO_US
+    uint32_t maxControlUs;      // worst applied -> gpio
+    uint32_t lastTotalUs;
+    uint32_t maxTotalUs;
+};
+
+// Control loop (core 1)
+void actuationTrace_commandApplied(uint8_t zone, const char* id, uint32_t receivedUs);
+// Called by zones_control() right after writing a relay. decidedUs is when
+// the tick's rules were evaluated; used for auto transitions.
+void actuationTrace_relayWritten(uint8_t zone, bool automatic, uint32_t decidedUs);
+// Finishes every trace opened this tick and hands it to the network task
+void actuationTrace_endTick(ZoneMask pumpOn);
+
+// Network task
+bool actuationTrace_pop(ActuationTrace& out);
+void actuationTrace_recordPublished(const ActuationTrace& trace, uint32_t publishUs, bool published);
+void actuationTrace_getStats(ActuationStats& out);
+
+// Pure helpers, also used by host tools
+// Copies a correlation id from a payload, replacing '"', '\' and control
+// characters so it can be echoed into JSON as is. Returns its length.
+size_t actuationTrace_copyId(char* out, const char* id, size_t len);
+// actual-status payload with the hop latencies up to publishUs; returns its
+// length or 0 if it did not fit
+size_t actuationTrace_format(const ActuationTrace& trace, uint32_t publishUs, char* buf, size_t len);
+uint32_t actuationTrace_totalUs(const ActuationTrace& trace, uint32_t publishUs);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef BOOT_TIMING_H
+#define BOOT_TIMING_H
+
+#include <Arduino.h>
+
+// Boot-time breakdown: milliseconds since the app started (esp_timer) at
+// which each milestone was first reached. Any task may mark a milestone;
+// only the first mark counts.
+
+enum BootMilestone : uint8_t {
+    BOOT_SETUP_START = 0,
+    BOOT_STATE_RESTORED,   // NVS state applied (or defaults kept)
+    BOOT_SETUP_DONE,
+    BOOT_FIRST_DECISION,   // first pump decision on a real soil reading
+    BOOT_WIFI_UP,
+    BOOT_MQTT_UP,
+    BOOT_FIRST_PUBLISH,    // first telemetry message accepted by the client
+    BOOT_MILESTONE_COUNT
+};
+
+void bootTiming_mark(BootMilestone milestone);
+uint32_t bootTiming_ms(BootMilestone milestone); // 0 = not reached yet
+// JSON object of every milestone reached so far; returns the length or 0
+size_t bootTiming_format(char* buf, size_t len);
+
+#endif
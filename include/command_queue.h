@@ -0,0 +1,81 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <Arduino.h>
+#include "actuation_trace.h"
+#include "device_state.h"
+#include "rule_engine.h"
+#include "soil_calibration.h"
+
+// Typed commands sent from the network task (core 0) to the control loop (core 1).
+// The queue is a bounded lock-free single-producer/single-consumer ring:
+// only the MQTT callback pushes and only the control stage pops.
+
+#define COMMAND_QUEUE_CAPACITY 16 // must be a power of two
+
+enum CommandType : uint8_t {
+    CMD_SET_MODE = 0,
+    CMD_SET_STATUS,
+    CMD_SET_RULE,
+    CMD_SET_PROGRAM,
+    CMD_SET_CALIBRATION
+};
+
+// Bits for RuleUpdate::fields - only flagged fields are applied
+enum RuleField : uint8_t {
+    RULE_FIELD_MIN_MOISTURE       = 1 << 0,
+    RULE_FIELD_MAX_MOISTURE       = 1 << 1,
+    RULE_FIELD_PLANT_NAME         = 1 << 2,
+    RULE_FIELD_PREFERRED_HUMIDITY = 1 << 3,
+    RULE_FIELD_PREFERRED_TEMP     = 1 << 4,
+    RULE_FIELD_PUMP_TIMING        = 1 << 5  // default program run/cooldown (plant profile)
+};
+
+struct RuleUpdate {
+    uint8_t fields;
+    int16_t minMoisture;
+    int16_t maxMoisture;
+    int16_t preferredHumidity;
+    int16_t preferredTemp;
+    uint16_t runS;
+    uint16_t cooldownS;
+    char plantName[PLANT_NAME_MAX];
+};
+
+// Bits for CalibrationUpdate::fields, applied in this order
+enum CalibrationField : uint8_t {
+    CAL_FIELD_RESET      = 1 << 0,  // back to the default table
+    CAL_FIELD_POINTS     = 1 << 1,  // replace the table
+    CAL_FIELD_TEMP_COEFF = 1 << 2,
+    CAL_FIELD_CAPTURE    = 1 << 3   // current reading becomes the point for captureMoistureX100
+};
+
+struct CalibrationUpdate {
+    uint8_t fields;
+    uint8_t pointCount;
+    SoilCalPoint points[SOIL_CAL_MAX_POINTS];
+    int16_t tempCoeffQ8;
+    uint16_t captureMoistureX100;
+};
+
+struct Command {
+    CommandType type;
+    uint8_t zone;      // zone index (actuator id - ACTUATOR_ID)
+    ActuatorMode mode; // CMD_SET_MODE
+    bool on;           // CMD_SET_STATUS
+    char traceId[ACTUATION_ID_MAX]; // CMD_SET_MODE/STATUS: correlation id, "" = untraced
+    uint32_t receivedUs;            // micros() when the message arrived (traced only)
+    union {
+        RuleUpdate rule;       // CMD_SET_RULE
+        RuleProgram program;   // CMD_SET_PROGRAM, compiled on the network task
+        CalibrationUpdate calibration; // CMD_SET_CALIBRATION
+    };
+};
+
+// Producer side. Returns false (and counts a drop) when the queue is full.
+bool commandQueue_push(const Command& cmd);
+// Consumer side. Returns false when the queue is empty.
+bool commandQueue_pop(Command& cmd);
+unsigned long commandQueue_dropped();
+
+#endif
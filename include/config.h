@@ -6,7 +6,151 @@
 #define DHTPIN 23
 #define SOIL_PIN 34
 
-// DHT sensor type
-#define DHTTYPE DHT22
+// Irrigation zones: one soil probe and one pump relay each (see zones.h).
+// Zone z is actuator ACTUATOR_ID + z on MQTT. Probes must be on ADC1
+// (GPIO 32-39, 8 channels); zones may share a probe. For other layouts set
+// ZONE_COUNT and provide ZONE_SOIL_PINS / ZONE_RELAY_PINS with that many entries.
+#ifndef ZONE_COUNT
+#define ZONE_COUNT 1
+#endif
+#if ZONE_COUNT == 1
+#define ZONE_SOIL_PINS   { SOIL_PIN }
+#define ZONE_RELAY_PINS  { RELAY_PIN }
+#endif
+#define ZONE_MAX              16     // ZoneMask is 16 bits
+#define MAX_ACTIVE_PUMPS      2      // pumps allowed to run at once (supply pressure / power)
+#define PUMP_RUN_MS           10000  // auto mode: run for 10 s...
+#define PUMP_COOLDOWN_MS      60000  // ...then let the water soak in for 60 s
+
+// DHT22 reader (RMT capture, see dht_reader.h)
+#define DHT_RESPONSE_TIMEOUT_MS  20
+#define DHT_STALE_MS             10000  // readings older than this count as invalid
+#define DHT_TASK_CORE            1
+#define DHT_TASK_PRIORITY        2
+#define DHT_TASK_STACK           3072
+
+// Scheduler stage periods and deadlines (ms)
+#define SOIL_READ_PERIOD_MS      50
+#define SOIL_READ_DEADLINE_MS    20
+#define DHT_READ_PERIOD_MS       2000   // DHT22 can't be sampled faster than 0.5 Hz
+#define DHT_READ_DEADLINE_MS     500
+#define CONTROL_PERIOD_MS        50
+#define CONTROL_DEADLINE_MS      20
+#define DISPLAY_PERIOD_MS        250    // fast enough for the 500 ms alert blink
+#define DISPLAY_DEADLINE_MS      200
+#define STATUS_LOG_PERIOD_MS     2000
+#define STATUS_LOG_DEADLINE_MS   1000
+#define PERSIST_PERIOD_MS        1000
+#define PERSIST_DEADLINE_MS      500
+
+// Persisted control state (NVS, see state_store.h)
+#define STATE_SAVE_DEBOUNCE_MS   5000   // save once commands have been quiet this long...
+#define STATE_SAVE_MAX_DELAY_MS  60000  // ...or at the latest this long after the first change
+
+// Soil moisture acquisition (ADC DMA, see soil_sensor.h)
+#define SOIL_SAMPLE_RATE_HZ      20000  // lowest rate the ESP32 ADC DMA supports
+#define SOIL_FRAME_SAMPLES       128    // samples per probe per DMA frame
+#define SOIL_EMA_SHIFT           3      // EMA weight 1/8 per frame
+#define SOIL_FALLBACK_SAMPLES    16     // polled analogRead() burst when DMA is unavailable
+#define SOIL_FALLBACK_PERIOD_MS  10
+#define SOIL_TASK_CORE           1
+#define SOIL_TASK_PRIORITY       2
+#define SOIL_TASK_STACK          3072
+
+// OLED (SSD1306 over I2C)
+#define OLED_I2C_CLOCK_HZ        400000 // fast-mode; many modules also run at 1000000
+#define OLED_FLUSH_TASK_CORE     0
+#define OLED_FLUSH_TASK_PRIORITY 1
+#define OLED_FLUSH_TASK_STACK    2048
+#define SPLASH_DURATION_MS       2000
+#define DISPLAY_ZONE_PERIOD_MS   28000  // one full scene rotation per zone
+
+// Network task (WiFi/MQTT) - runs on core 0, the Arduino loop() (control) on core 1
+#define NETWORK_TASK_CORE        0
+#define NETWORK_TASK_PRIORITY    1
+#define NETWORK_TASK_STACK       8192
+#define MQTT_LOOP_PERIOD_MS      20
+#define MQTT_PUBLISH_PERIOD_MS   5000
+#define PROFILE_PUBLISH_PERIOD_MS 60000 // hot-path profile window (see profiler.h)
+#define STATS_PUBLISH_PERIOD_MS  60000  // diagnostics/stats, plus once after every reconnect
+
+// Logging (see logger.h): formatting and UART output run in the log task
+#define LOG_RING_SLOTS           64     // records, power of two (128 bytes each)
+#define LOG_LINE_MAX             192
+#define LOG_FLUSH_PERIOD_MS      20
+#define LOG_TASK_CORE            0
+#define LOG_TASK_PRIORITY        1
+#define LOG_TASK_STACK           3072
+
+// Memory diagnostics (see mem_diag.h), published on diagnostics/memory
+#define MEM_DIAG_SAMPLE_MS          1000
+#define MEM_DIAG_PERIOD_MS          30000  // plus immediately when an alert is raised
+#define MEM_ALERT_FREE_HEAP         32768  // bytes
+#define MEM_ALERT_LARGEST_BLOCK     16384  // bytes; MQTT/WiFi buffers need contiguous blocks
+#define MEM_ALERT_FRAGMENTATION_PCT 60
+#define MEM_ALERT_STACK_FREE        512    // bytes left in any registered task
+
+// Reconnect backoff (ms): exponential from BASE up to MAX, with jitter
+#define WIFI_CONNECT_TIMEOUT_MS  10000
+#define WIFI_BACKOFF_BASE_MS     1000
+#define WIFI_BACKOFF_MAX_MS      60000
+#define MQTT_BACKOFF_BASE_MS     1000
+#define MQTT_BACKOFF_MAX_MS      60000
+#define MQTT_CONNECT_TIMEOUT_MS  5000   // TCP handshake plus CONNACK
+#define MQTT_KEEPALIVE_S         15
+#define MQTT_ACK_TIMEOUT_MS      10000  // a QoS 1 publish unacknowledged this long drops the connection
+#define MQTT_CLIENT_ID           "ESP32_Plant_Monitor" // fixed: the broker keys the persistent session on it
+#ifndef MQTT_BUFFER_SIZE
+#define MQTT_BUFFER_SIZE         1024   // largest MQTT packet either way (rule JSON, backlog batches)
+#endif
+#ifndef MQTT_OUTBOX_BYTES
+#define MQTT_OUTBOX_BYTES        8192   // queued and in-flight publishes (see mqtt_async.h)
+#endif
+#define MQTT_MAX_INFLIGHT        8      // QoS 1 publishes on the wire awaiting PUBACK
+#define NTP_SERVER               "pool.ntp.org"
+#define EPOCH_VALID_AFTER        1609459200  // 2021-01-01: any earlier time() means NTP has not synced yet
+// Optional static IP (skips DHCP on every connect), e.g.
+//   #define WIFI_STATIC_IP   192, 168, 1, 50
+//   #define WIFI_GATEWAY     192, 168, 1, 1
+//   #define WIFI_SUBNET      255, 255, 255, 0
+//   #define WIFI_DNS         192, 168, 1, 1
+#ifndef TIME_ZONE
+#define TIME_ZONE                "WIB-7"  // POSIX TZ, local time for rule windows
+#endif
+
+// Batched telemetry encoding: 0 = JSON on telemetry, 1 = MessagePack on telemetry/msgpack
+#ifndef TELEMETRY_MSGPACK
+#define TELEMETRY_MSGPACK        0
+#endif
+// Also publish the legacy sensor/{id} and actual-status topics every cycle
+#ifndef TELEMETRY_LEGACY_TOPICS
+#define TELEMETRY_LEGACY_TOPICS  1
+#endif
+
+// Report-by-exception defaults (overridable via the "deadband" rule object)
+#define REPORT_MOISTURE_DEADBAND_ABS     1.0f    // %
+#define REPORT_TEMPERATURE_DEADBAND_ABS  0.3f    // C
+#define REPORT_HUMIDITY_DEADBAND_ABS     1.0f    // %
+#define REPORT_HEARTBEAT_MS              300000  // publish every channel at least every 5 min
+
+// Store-and-forward telemetry while the broker is unreachable
+#define TELEMETRY_RING_CAPACITY      1024   // samples on LittleFS (~24 KB, ~85 min at 5 s, shared by the zones)
+#define TELEMETRY_STAGING_SAMPLES    8      // RAM samples per flash write
+#define TELEMETRY_DRAIN_BATCH        10     // samples per backlog message
+#define TELEMETRY_DRAIN_INTERVAL_MS  1000   // at most one backlog message per interval
+#define TELEMETRY_DRAIN_HOLDOFF_MS   3000   // let live traffic settle after a reconnect
+#define TELEMETRY_TAIL_SAVE_DEBOUNCE_MS  5000   // drain position saved once draining pauses this long...
+#define TELEMETRY_TAIL_SAVE_MAX_DELAY_MS 30000  // ...or at the latest this long after the first drain
+
+// On-device history (see history_store.h)
+#define HISTORY_SAMPLE_PERIOD_MS     60000  // plus one sample on every pump change
+#define HISTORY_BLOCK_BYTES          256
+#define HISTORY_RAM_BYTES            16384  // 64 blocks, ~1-3 B/sample -> days at 1/min, shared by the zones
+#ifndef HISTORY_FLASH_BLOCKS
+#define HISTORY_FLASH_BLOCKS         128    // LittleFS tier for evicted blocks (32 KB), 0 = RAM only
+#endif
+#define HISTORY_QUERY_MAX_POINTS     240    // downsampled points per query
+#define HISTORY_CHUNK_POINTS         20     // points per response message
+#define HISTORY_DEFAULT_RANGE_S      86400  // range when the query gives no "from"
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef DEVICE_STATE_H
+#define DEVICE_STATE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define PLANT_NAME_MAX 24
+
+enum ActuatorMode : uint8_t {
+    MODE_MANUAL = 0,
+    MODE_AUTO = 1
+};
+
+// One bit per zone, bit z = zone z
+typedef uint16_t ZoneMask;
+#define ZONE_BIT(z) ((ZoneMask)(1u << (z)))
+
+// Control state, owned by the control loop on core 1. Other cores must not
+// touch these directly: send a Command (command_queue.h) to change them and
+// read a DeviceState snapshot to observe them. Per-zone values are parallel
+// arrays indexed by zone.
+extern ActuatorMode actuatorMode[ZONE_COUNT];  // manual | auto - controlled via MQTT
+extern bool actuatorStatusOn[ZONE_COUNT];      // desired pump state in manual mode
+extern int ruleMinMoisture[ZONE_COUNT];        // min_moisture
+extern int ruleMaxMoisture[ZONE_COUNT];        // max_moisture
+extern char rulePlantName[ZONE_COUNT][PLANT_NAME_MAX]; // plant_name
+extern int rulePreferredHumidity[ZONE_COUNT];  // preferred_humidity
+extern int rulePreferredTemp[ZONE_COUNT];      // preferred_temp
+
+// Consistent copy of everything other consumers need from the control loop
+struct DeviceState {
+    float temperature;
+    float humidity;
+    float moisture[ZONE_COUNT];
+    ZoneMask pumpOn;
+    ZoneMask autoMode;        // zones in MODE_AUTO
+    ZoneMask manualStatusOn;
+    int16_t ruleMinMoisture[ZONE_COUNT];
+    int16_t ruleMaxMoisture[ZONE_COUNT];
+    char plantName[ZONE_COUNT][PLANT_NAME_MAX];
+    unsigned long updatedAt; // millis() of the control tick that produced it
+};
+
+// Double-buffered snapshot: one writer (control loop), any number of readers.
+void deviceState_publish(const DeviceState& state);
+void deviceState_read(DeviceState& out);
+
+const char* actuatorModeName(ActuatorMode mode); // "manual" | "auto"
+
+#endif
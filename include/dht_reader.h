@@ -0,0 +1,33 @@
+#ifndef DHT_READER_H
+#define DHT_READER_H
+
+#include <Arduino.h>
+
+// Asynchronous DHT22 reader. A background task sends the start pulse and the
+// RMT peripheral captures the 40-bit response, so no code runs with interrupts
+// disabled and reads can continue while the pump is switching. Each
+// transaction yields temperature and humidity together.
+
+struct DhtReading {
+    float temperature;       // C
+    float humidity;          // %
+    unsigned long timestamp; // millis() when the frame was captured
+    bool valid;              // false until the first good frame
+};
+
+typedef void (*DhtCallback)(const DhtReading& reading);
+
+struct DhtStats {
+    unsigned long reads;
+    unsigned long checksumErrors;
+    unsigned long timeouts;      // no or truncated response
+};
+
+bool dhtReader_begin(int pin);
+// Latest good reading (mailbox, never blocks). Returns false if none yet.
+bool dhtReader_latest(DhtReading& out);
+// Optional: called from the reader task after every good frame
+void dhtReader_setCallback(DhtCallback callback);
+void dhtReader_getStats(DhtStats& out);
+
+#endif
@@ -4,8 +4,30 @@
 #include <Arduino.h>
 
 void initDisplay();
-void updateDisplay(float temp, float moisture, int threshold, const String& pumpStatusStr);
-void updateDisplayScenes(float temp, float moisture, int threshold, float humidity);
+void updateDisplay(float temp, float moisture, int threshold, bool pumpOn);
+// zone selects whose plant name, mode and pump state are shown; pumpOn is
+// that zone's relay as driven (auto or manual, after the running-pump cap)
+void updateDisplayScenes(uint8_t zone, float temp, float moisture, int threshold, float humidity, bool pumpOn);
 void resetSceneTiming();
 
+// Rendering cost. Only widgets whose values changed are redrawn; the frame is
+// handed to a background flush task that sends only the changed columns of
+// each SSD1306 page over I2C, so callers never wait on the OLED. Safe to read
+// from any task; each field is read atomically, not the struct as a whole.
+struct DisplayStats {
+    unsigned long frames;
+    unsigned long fullRedraws;    // scene changes
+    unsigned long lastFrameUs;    // render + hand-off to the flush task
+    unsigned long maxFrameUs;
+    unsigned long totalFrameUs;
+    unsigned long flushes;
+    unsigned long droppedFrames;  // frames skipped because the previous flush was still running
+    unsigned long lastFlushUs;    // I2C transfer time in the flush task
+    unsigned long maxFlushUs;
+    size_t lastI2cBytes;          // including address/control/command bytes
+    unsigned long totalI2cBytes;
+};
+
+void getDisplayStats(DisplayStats& out);
+
 #endif
@@ -0,0 +1,40 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <Arduino.h>
+#include "telemetry_store.h"
+
+// On-device history of moisture, temperature, humidity and pump state, per
+// zone: a block holds the samples of one zone, and a query reads one zone.
+// Samples are packed into HISTORY_BLOCK_BYTES blocks inside a fixed RAM
+// budget: a tag byte per sample, the time step only when it changed
+// (delta-of-delta), and zigzag varint deltas for the channels that moved.
+// A steady reading costs one byte per zone. When RAM is full the oldest block moves to
+// a LittleFS ring (HISTORY_FLASH_BLOCKS, 0 = RAM only) or is dropped.
+// Only the network task may call these functions.
+
+struct HistoryStats {
+    uint32_t samples;            // samples currently held (RAM + flash)
+    uint32_t encodedBytes;       // encoded size of those samples
+    float bytesPerSample;
+    uint16_t ramBlocks;
+    uint16_t flashBlocks;
+    uint32_t oldestTimestamp;    // epoch seconds, 0 if unknown
+    unsigned long flashWrites;   // blocks moved from RAM to flash
+    unsigned long droppedBlocks; // blocks lost for good (ring wrapped)
+    unsigned long queries;
+    unsigned long lastQueryUs;   // scan + decode time of the last query
+    unsigned long maxQueryUs;
+};
+
+// Called for every sample in a queried range, oldest first. Timestamps are
+// epoch seconds; uptime-stamped samples of this boot are converted once the
+// clock is synced, older uptime samples are skipped.
+typedef void (*HistoryVisitor)(const TelemetrySample& sample, void* ctx);
+
+bool history_begin();  // after telemetryStore_begin() (shares the LittleFS mount)
+void history_append(const TelemetrySample& sample);
+size_t history_query(uint8_t zone, uint32_t from, uint32_t to, HistoryVisitor visitor, void* ctx);
+void history_getStats(HistoryStats& out);
+
+#endif
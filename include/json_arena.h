@@ -0,0 +1,35 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Bump allocator for ArduinoJson documents on hot paths. All allocations are
+// served from a caller-provided static buffer and released at once by reset().
+// Requests that don't fit fall back to the heap and are counted, so
+// heapFallbacks() == 0 proves the path stayed allocation-free.
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    JsonArena(uint8_t* buffer, size_t capacity);
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+
+    void reset();
+    size_t used() const { return offset; }
+    size_t highWater() const { return peak; }
+    unsigned long heapFallbacks() const { return fallbacks; }
+
+private:
+    bool owns(const void* ptr) const;
+
+    uint8_t* buffer;
+    size_t capacity;
+    size_t offset;
+    size_t lastBlock; // offset of the most recent block (may grow in place)
+    size_t peak;
+    unsigned long fallbacks;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Asynchronous leveled logging. A LOG_* call stores a pointer to its static
+// call site (format string, tag, level) plus the raw argument values in a
+// lock-free ring; string arguments are copied into the record. The "log"
+// task formats records and writes them to Serial, so only that task ever
+// waits for the UART. When the ring is full the record is dropped and
+// counted; the log task reports drops as they happen.
+//
+// Levels are filtered twice: LOG_COMPILE_LEVEL removes calls at build time,
+// log_setLevel() per tag at runtime (also via the log/level MQTT topic).
+// Arguments must be at most 32 bits wide (int, unsigned, long, float,
+// double, char*); doubles are stored as float.
+//
+//   LOG_INFO(LOG_TAG_MQTT, "Zone %u status command queued: %s", zone, on ? "on" : "off");
+
+enum LogLevel : uint8_t {
+    LOG_LEVEL_NONE = 0,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG
+};
+
+enum LogTag : uint8_t {
+    LOG_TAG_MAIN = 0,  // status line, setup
+    LOG_TAG_CONTROL,   // commands applied by the control loop
+    LOG_TAG_MQTT,      // ingest and publishing
+    LOG_TAG_NET,       // WiFi/MQTT connection
+    LOG_TAG_DIAG,      // diagnostics
+    LOG_TAG_COUNT
+};
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_MAX_ARGS   10
+#define LOG_TEXT_BYTES 76  // copied string arguments per record
+
+struct LogSite {
+    const char* fmt;
+    LogTag tag;
+    LogLevel level;
+};
+
+struct LogRecord {
+    const LogSite* site;   // the format id
+    uint32_t timestampMs;
+    uint8_t argCount;
+    uint8_t textUsed;
+    uint32_t args[LOG_MAX_ARGS];  // int bits, float bits or offset into text
+    char text[LOG_TEXT_BYTES];
+};
+
+struct LogStats {
+    unsigned long written;
+    unsigned long dropped;  // ring full
+};
+
+void log_begin();  // starts the log task; records made before are kept
+void log_setLevel(LogTag tag, LogLevel level);
+bool log_parseLevel(const char* name, size_t len, LogLevel* level);
+bool log_parseTag(const char* name, size_t len, LogTag* tag);
+bool log_push(LogRecord& record);
+// Formats one record as a line (with newline); returns its length
+size_t log_format(const LogRecord& record, char* out, size_t len);
+void log_getStats(LogStats& out);
+
+extern std::atomic<uint8_t> logRuntimeLevel[LOG_TAG_COUNT];
+
+inline bool log_enabled(LogTag tag, LogLevel level) {
+    return level <= logRuntimeLevel[tag].load(std::memory_order_relaxed);
+}
+
+namespace logdetail {
+
+inline void put(LogRecord& r, int v) { r.args[r.argCount++] = (uint32_t)v; }
+inline void put(LogRecord& r, unsigned v) { r.args[r.argCount++] = v; }
+inline void put(LogRecord& r, long v) { r.args[r.argCount++] = (uint32_t)v; }
+inline void put(LogRecord& r, unsigned long v) { r.args[r.argCount++] = (uint32_t)v; }
+inline void put(LogRecord& r, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    r.args[r.argCount++] = bits;
+}
+inline void put(LogRecord& r, double v) { put(r, (float)v); }
+void put(LogRecord& r, const char* s);  // copies, truncating when the text area is full
+
+// Never called: lets the compiler check format strings against arguments
+inline void checkFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void checkFormat(const char*, ...) {}
+
+template<class... Args>
+inline void write(const LogSite* site, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+    LogRecord r;
+    r.site = site;
+    r.argCount = 0;
+    r.textUsed = 0;
+    int expand[] = { 0, (put(r, args), 0)... };
+    (void)expand;
+    log_push(r);
+}
+
+} // namespace logdetail
+
+#define LOG_ENABLED(tag, level) ((level) <= LOG_COMPILE_LEVEL && log_enabled(tag, level))
+
+#define LOG_AT(level, tag, fmt, ...)                                   \
+    do {                                                               \
+        if (LOG_ENABLED(tag, level)) {                                 \
+            static const LogSite logSite_ = { fmt, tag, level };       \
+            if (0) logdetail::checkFormat(fmt, ##__VA_ARGS__);         \
+            logdetail::write(&logSite_, ##__VA_ARGS__);                \
+        }                                                              \
+    } while (0)
+
+#define LOG_ERROR(tag, fmt, ...) LOG_AT(LOG_LEVEL_ERROR, tag, fmt, ##__VA_ARGS__)
+#define LOG_WARN(tag, fmt, ...)  LOG_AT(LOG_LEVEL_WARN, tag, fmt, ##__VA_ARGS__)
+#define LOG_INFO(tag, fmt, ...)  LOG_AT(LOG_LEVEL_INFO, tag, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(tag, fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef MEM_DIAG_H
+#define MEM_DIAG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Memory diagnostics: free heap, largest free block, minimum-ever free heap,
+// fragmentation and the stack high-water mark of every registered task,
+// checked against the MEM_ALERT_* thresholds in config.h. Heap figures come
+// from the ESP-IDF heap_caps API. A host build has no heap API; instead it
+// counts every operator new, which the profiler attributes per stage.
+
+#define MEM_DIAG_MAX_TASKS 8
+
+enum MemAlert : uint8_t {
+    MEM_ALERT_LOW_HEAP   = 1 << 0,  // free heap below MEM_ALERT_FREE_HEAP
+    MEM_ALERT_FRAGMENTED = 1 << 1,  // largest block or fragmentation past its threshold
+    MEM_ALERT_LOW_STACK  = 1 << 2   // a task has less than MEM_ALERT_STACK_FREE left
+};
+
+struct MemTaskStack {
+    const char* name;
+    uint32_t minFreeBytes;  // high-water mark: least stack ever left
+};
+
+struct MemStats {
+    uint32_t freeHeap;
+    uint32_t largestBlock;
+    uint32_t minFreeHeap;
+    uint8_t fragmentationPct;  // 100 - largest block / free heap
+    uint8_t alerts;            // MemAlert bits
+    uint8_t taskCount;
+    MemTaskStack tasks[MEM_DIAG_MAX_TASKS];
+    uint32_t allocations;      // host build only: operator new calls so far
+};
+
+// Called once at the top of each task (and from setup() for the loop task)
+void memDiag_registerCurrentTask();
+void memDiag_sample(MemStats& out);
+// JSON for diagnostics/memory; returns the length or 0 if it did not fit
+size_t memDiag_format(const MemStats& stats, char* buf, size_t len);
+uint32_t memDiag_allocationCount(); // always 0 on the ESP32
+
+#endif
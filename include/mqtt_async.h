@@ -0,0 +1,81 @@
+#ifndef MQTT_ASYNC_H
+#define MQTT_ASYNC_H
+
+#include <Arduino.h>
+
+// Event-driven MQTT 3.1.1 client over a non-blocking link (mqtt_link.h).
+//
+// mqttAsync_publish() only encodes the PUBLISH packet into the outbox, a
+// preallocated byte ring of MQTT_OUTBOX_BYTES, and returns; it never touches
+// the socket or the heap, and may be called from any task (producers claim
+// space with a compare-and-swap, like log_push()). Everything else runs on
+// the network task: mqttAsync_service() advances the connection, reads and
+// dispatches incoming packets, and writes queued packets as far as the
+// socket takes them. mqttAsync_wait() sleeps until data arrives or the
+// timeout passes, so incoming commands are handled as they come.
+//
+// QoS 1 publishes stay in the outbox until their PUBACK; up to
+// MQTT_MAX_INFLIGHT of them are on the wire at once. The session is
+// persistent (clean session off, fixed client id): after a reconnect the
+// unacknowledged ones are sent again with DUP set, and the broker keeps our
+// subscriptions and the QoS 1 messages sent to us while we were away. QoS 0
+// publishes leave the outbox once written. A full outbox rejects the
+// publish; nothing already queued is dropped.
+//
+// Packets up to MQTT_BUFFER_SIZE bytes go both ways. Larger incoming
+// publishes are skipped (and acknowledged) rather than breaking the session.
+
+enum MqttAsyncState : uint8_t {
+    MQTT_ASYNC_DISCONNECTED = 0,
+    MQTT_ASYNC_CONNECTING,  // TCP handshake, then CONNECT sent and waiting for CONNACK
+    MQTT_ASYNC_CONNECTED
+};
+
+// Why the last connection attempt or session ended
+enum MqttAsyncError : int8_t {
+    MQTT_ASYNC_OK = 0,
+    MQTT_ASYNC_ERR_LINK = -1,       // could not connect, or the connection broke
+    MQTT_ASYNC_ERR_TIMEOUT = -2,    // no CONNACK, PINGRESP or PUBACK in time
+    MQTT_ASYNC_ERR_PROTOCOL = -3,   // malformed or unexpected packet
+    // 1..5: CONNACK return code from the broker
+};
+
+typedef void (*MqttMessageHandler)(char* topic, uint8_t* payload, unsigned int length);
+
+struct MqttAsyncStats {
+    unsigned long enqueued;
+    unsigned long rejected;      // outbox full or packet larger than MQTT_BUFFER_SIZE
+    unsigned long sent;          // packets written (QoS 0) or acknowledged (QoS 1)
+    unsigned long retransmits;   // QoS 1 publishes sent again after a reconnect
+    unsigned long received;
+    unsigned long oversized;     // incoming publishes skipped
+    size_t outboxUsed;           // bytes queued or in flight
+    size_t outboxPeak;
+    uint8_t inflight;
+    uint32_t maxEnqueueUs;       // slowest mqttAsync_publish()
+    uint32_t lastAckUs;          // QoS 1 publish written -> PUBACK
+    uint32_t maxAckUs;
+    bool sessionPresent;         // broker still had our session on the last connect
+    int8_t lastError;            // MqttAsyncError or CONNACK code
+};
+
+void mqttAsync_begin(const char* host, uint16_t port, const char* clientId, MqttMessageHandler handler);
+bool mqttAsync_connect();     // starts an attempt; follow it with mqttAsync_state()
+void mqttAsync_disconnect();  // sends DISCONNECT if connected; the outbox is kept
+MqttAsyncState mqttAsync_state();
+bool mqttAsync_connected();
+int8_t mqttAsync_lastError();
+
+// Remembered and sent on every connect (a resubscribe also brings back the
+// retained messages a persistent session would not queue)
+bool mqttAsync_subscribe(const char* filter, uint8_t qos);
+// Any task. False when the packet does not fit the outbox or MQTT_BUFFER_SIZE.
+bool mqttAsync_publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retained);
+bool mqttAsync_publish(const char* topic, const char* payload, uint8_t qos, bool retained);
+
+// Network task only
+void mqttAsync_service();
+void mqttAsync_wait(uint32_t timeoutMs);
+void mqttAsync_getStats(MqttAsyncStats& out);
+
+#endif
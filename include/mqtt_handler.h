@@ -2,25 +2,74 @@
 #define MQTT_HANDLER_H
 
 #include <Arduino.h>
+#include "device_state.h"
+#include "report_gate.h"
 
-void setup_wifi();
-void mqtt_loop();
-void mqtt_reconnect();
+// Connection state, in the order the reconnect state machine walks through it
+enum NetState : uint8_t {
+    NET_WIFI_DOWN = 0,     // waiting for the WiFi backoff to expire
+    NET_WIFI_CONNECTING,   // WiFi.begin() issued, polling for WL_CONNECTED
+    NET_WIFI_UP,           // WiFi ok, MQTT disconnected (backing off between attempts)
+    NET_MQTT_CONNECTING,   // mqttAsync_connect() issued, waiting for CONNACK
+    NET_MQTT_CONNECTED
+};
+
+struct NetStats {
+    NetState state;
+    unsigned long wifiAttempts;
+    unsigned long mqttAttempts;
+    unsigned long reconnects;        // successful MQTT (re)connects
+    uint8_t failedAttempts;          // consecutive failures, drives the backoff
+    unsigned long nextRetryInMs;     // last backoff chosen
+    unsigned long currentOutageMs;   // 0 while connected
+    unsigned long lastReconnectMs;   // time from link loss to MQTT connected
+    unsigned long maxReconnectMs;
+};
+
+void setup_wifi();      // non-blocking: configures the client and arms the state machine
+void mqtt_loop();       // services the client and drives the reconnect state machine
+void mqtt_reconnect();  // one non-blocking reconnect step (called by mqtt_loop)
+NetState mqtt_connectionState();
+void mqtt_getNetStats(NetStats& out);
 // Removed legacy publishData interface.
 
-// New extended MQTT API
-void mqtt_publishSensors(float temperature, float moisture, float humidity);
-void mqtt_publishActualActuatorStatus(bool isOn);
+// Start the WiFi/MQTT task pinned to core 0. It owns the MQTT connection
+// (mqtt_async.h) and publishes from DeviceState snapshots; commands go to the control loop
+// through the command queue.
+void mqtt_startTask();
+
+// Batched telemetry: one message per report on device/{code}/telemetry (JSON) or
+// telemetry/msgpack, plus the legacy per-sensor topics when
+// TELEMETRY_LEGACY_TOPICS is enabled.
+enum TelemetryFormat : uint8_t {
+    TELEMETRY_FORMAT_JSON = 0,
+    TELEMETRY_FORMAT_MSGPACK = 1,
+    TELEMETRY_FORMAT_LEGACY = 2, // the per-sensor + actual-status publishes of one cycle
+    TELEMETRY_FORMAT_COUNT
+};
+
+struct TelemetryFormatStats {
+    unsigned long messages;
+    size_t lastBytes;
+    unsigned long lastEncodeUs;
+    unsigned long totalBytes;
+    unsigned long totalEncodeUs;
+};
+
+// Publishes only the channels in mask (REPORT_MASK(...) bits, see report_gate.h).
+// False when the batch was not queued (offline, outbox full); the legacy
+// topics only go out with a queued batch.
+bool mqtt_publishTelemetry(const DeviceState& state, ReportMask mask);
+void mqtt_getTelemetryFormatStats(TelemetryFormat format, TelemetryFormatStats& out);
+
+// Ingest statistics. mqtt_ingestHeapAllocations() stays at 0 as long as the
+// callback path is allocation-free (rule JSON is parsed into a static arena).
+unsigned long mqtt_ingestMessageCount();
+unsigned long mqtt_ingestUnroutedCount();
+unsigned long mqtt_ingestHeapAllocations();
 
 // Constants for new topic schema
 extern const char* DEVICE_CODE; // e.g., "GH-001"
-extern const int ACTUATOR_ID;   // e.g., 1 (pump)
-
-// Rule parameters updated via subscribed JSON on device/{device_code}/rule
-extern int ruleMinMoisture;      // min_moisture
-extern int ruleMaxMoisture;      // max_moisture
-extern String rulePlantName;     // plant_name
-extern int rulePreferredHumidity; // preferred_humidity
-extern int rulePreferredTemp;     // preferred_temp
+extern const int ACTUATOR_ID;   // e.g., 1 (pump of zone 0; zone z is ACTUATOR_ID + z)
 
 #endif
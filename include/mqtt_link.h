@@ -0,0 +1,30 @@
+#ifndef MQTT_LINK_H
+#define MQTT_LINK_H
+
+#include <Arduino.h>
+
+// Non-blocking byte stream to the MQTT broker, used only by mqtt_async.cpp
+// on the network task. On the ESP32 it is an lwIP TCP socket in
+// non-blocking mode (src/mqtt_link.cpp); the host build links the simulated
+// broker from lib/native_hal instead. No call waits for the network except
+// mqttLink_wait().
+
+enum MqttLinkState : uint8_t {
+    LINK_CLOSED = 0,
+    LINK_CONNECTING,  // TCP handshake in progress
+    LINK_OPEN,
+    LINK_FAILED       // connect refused/timed out or the connection broke; close it
+};
+
+// Starts connecting; false if that could not even start (no route, bad host)
+bool mqttLink_open(const char* host, uint16_t port);
+MqttLinkState mqttLink_poll();  // progresses a pending connect
+// Bytes taken (0 when the socket buffer is full), -1 on error
+int mqttLink_send(const uint8_t* data, size_t len);
+// Bytes read (0 when nothing is pending), -1 when the peer closed or on error
+int mqttLink_recv(uint8_t* data, size_t len);
+// Blocks the calling task until data arrives or timeoutMs passes
+void mqttLink_wait(uint32_t timeoutMs);
+void mqttLink_close();
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef MQTT_SCHEMA_H
+#define MQTT_SCHEMA_H
+
+#include <Arduino.h>
+#include "device_state.h"
+
+// Topic schema and command payloads, shared by the firmware's network task
+// and host tools that speak for simulated devices (tools/fleet_sim). Nothing
+// here keeps state.
+//
+// Schema: device/{device_code}/...
+//   actuator/{actuator_id}/mode           manual|auto or {"value":"...","id":"..."} (SUBSCRIBE)
+//   actuator/{actuator_id}/status         {"value":"on|off"}, optional "id" traces it (SUBSCRIBE)
+//   rule                                  JSON rule object, "actuator_id" picks the zone, a known
+//                                         "plant_name" fills unset fields from its profile (SUBSCRIBE)
+//   calibration                           soil probe table: "capture" dry|wet|%, "points",
+//                                         "temp_coeff", "reset"; "actuator_id" picks the zone (SUBSCRIBE)
+//   sensor/{sensor_id}                    soil moisture=1, temperature=2, humidity=3 (PUBLISH)
+//   actuator/{actuator_id}/actual-status  {"value":"on|off"}, plus id and hop latencies when traced (PUBLISH)
+//   telemetry                             batched JSON reading with ts/seq (PUBLISH)
+//   telemetry/msgpack                     same, MessagePack (PUBLISH, opt-in)
+//   telemetry/backlog                     samples buffered while offline; with several zones each
+//                                         sample carries its own "actuator_id" (PUBLISH)
+//   history/query                         {"from":ts,"to":ts,"step":s,"id":"..."}, "actuator_id"
+//                                         picks the zone (SUBSCRIBE)
+//   history                               chunked, downsampled query response for that zone (PUBLISH)
+//   log/level                             "debug" or {"level":"debug","tag":"mqtt"} (SUBSCRIBE)
+//   diagnostics/profile|memory|boot       diagnostics reports (PUBLISH)
+//   diagnostics/stats                     runtime counters, one message per section (PUBLISH)
+
+#define TOPIC_MAX 64
+// "device/" + code + "/" plus the longest suffix, "actuator/65535/actual-status",
+// has to fit TOPIC_MAX
+#define TOPIC_SUFFIX_MAX 28
+#define DEVICE_CODE_MAX  (TOPIC_MAX - 1 - TOPIC_SUFFIX_MAX - 8)
+
+// Topics of one device, built once into fixed buffers
+struct MqttTopics {
+    char base[TOPIC_MAX];                 // "device/{code}/"
+    size_t baseLen;
+    char subscribe[TOPIC_MAX];            // "device/{code}/#"
+    char sensor[3][TOPIC_MAX];            // index = sensor_id - 1
+    char actualStatus[ZONE_COUNT][TOPIC_MAX]; // index = zone
+    char backlog[TOPIC_MAX];              // telemetry/backlog - samples taken while offline
+    char telemetry[TOPIC_MAX];            // telemetry - one batched JSON message per cycle
+    char telemetryMsgPack[TOPIC_MAX];     // telemetry/msgpack - same content, MessagePack
+    char history[TOPIC_MAX];              // history - responses to history/query
+    char profile[TOPIC_MAX];              // diagnostics/profile - one message per profiled stage
+    char memory[TOPIC_MAX];               // diagnostics/memory - heap and stack report
+    char boot[TOPIC_MAX];                 // diagnostics/boot - boot-time breakdown, once per boot
+    char stats[TOPIC_MAX];                // diagnostics/stats - runtime counters
+};
+
+// False (and out unusable) when deviceCode is longer than DEVICE_CODE_MAX
+bool mqttSchema_buildTopics(MqttTopics& out, const char* deviceCode, int actuatorId);
+
+// "actuator/{id}/{action}" (the part after the base): the id indexes the zone
+// directly (zone = id - actuatorId). On success points action into suffix.
+bool mqttSchema_parseActuatorTopic(const char* suffix, size_t suffixLen, int actuatorId,
+                                   uint8_t& zone, const char*& action, size_t& actionLen);
+
+// Find the string value of "key" in a flat JSON object without copying or
+// allocating. On success points value/valueLen into the payload buffer.
+bool mqttSchema_findString(const byte* payload, unsigned int length, const char* key,
+                           const char** value, size_t* valueLen);
+bool mqttSchema_parseMode(const char* value, size_t len, ActuatorMode* mode); // "manual" | "auto"
+bool mqttSchema_parseOnOff(const char* value, size_t len, bool* on);          // "on" | "off"
+
+#endif
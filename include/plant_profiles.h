@@ -0,0 +1,62 @@
+#ifndef PLANT_PROFILES_H
+#define PLANT_PROFILES_H
+
+#include <Arduino.h>
+
+// Plant profile database: watering thresholds, climate preferences and pump
+// timing for a few hundred species, in a const table in flash. The table is
+// generated from tools/plant_db/plants.csv (include/plant_profiles_table.h)
+// and laid out by a minimal perfect hash, so a lookup by name is one hash,
+// one seed, one slot and one string compare, with no allocation. The build
+// checks every entry against the hash, so a stale table does not compile.
+//
+// A rule message's "plant_name" selects a profile; fields the message does
+// not set come from it (plantProfile_fillRule(), used by handleRuleMessage()
+// in mqtt_handler.cpp and by the fleet simulator).
+
+struct RuleUpdate;
+
+struct PlantProfile {
+    const char* name;          // canonical name; lookups ignore ASCII case
+    uint8_t minMoisture;       // %: water below this
+    uint8_t maxMoisture;       // %
+    int8_t preferredTemp;      // C
+    uint8_t preferredHumidity; // %
+    uint16_t runS;             // auto-mode pump pulse
+    uint16_t cooldownS;        // soak time after a pulse
+};
+
+// FNV-1a over the ASCII-lowercased name, seeded, then a final mix. constexpr
+// (C++11 single-return form) so the table can be verified at compile time;
+// the generator implements the same function.
+constexpr char plantHash_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+constexpr uint32_t plantHash_fnv(const char* s, uint32_t h) {
+    return *s ? plantHash_fnv(s + 1, (h ^ (uint8_t)plantHash_lower(*s)) * 16777619u) : h;
+}
+
+constexpr uint32_t plantHash_mix2(uint32_t h) {
+    return h ^ (h >> 16);
+}
+
+constexpr uint32_t plantHash_mix(uint32_t h) {
+    return plantHash_mix2((h ^ (h >> 16)) * 0x45D9F3Bu);
+}
+
+constexpr uint32_t plantHash(const char* name, uint32_t seed) {
+    return plantHash_mix(plantHash_fnv(name, 2166136261u ^ seed));
+}
+
+// nullptr when the name is not in the table
+const PlantProfile* plantProfile_find(const char* name);
+// The only slot plantProfile_find() compares name against
+size_t plantProfile_slot(const char* name);
+// Thresholds and climate the rule does not set come from the profile; its
+// pump timing always does
+void plantProfile_fillRule(const PlantProfile& profile, RuleUpdate& rule);
+size_t plantProfile_count();
+const PlantProfile& plantProfile_at(size_t index);  // table order
+
+#endif
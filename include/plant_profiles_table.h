@@ -0,0 +1,431 @@
+// Generated by tools/plant_db/gen_plant_profiles.py from plants.csv - do not edit.
+// Included by src/plant_profiles.cpp only; slot order is the perfect hash's.
+
+#define PLANT_PROFILE_COUNT 410
+#define PLANT_BUCKET_COUNT  137
+
+static constexpr uint16_t PLANT_SEEDS[PLANT_BUCKET_COUNT] = {
+    11, 26, 1, 5, 9, 3, 3, 23, 33, 8, 4, 26, 0, 30, 42, 15,
+    0, 6, 18, 4, 207, 10, 6, 2, 13, 2, 1, 2, 1, 20, 11, 3,
+    12, 48, 6, 11, 23, 17, 8, 125, 4, 7, 9, 0, 2, 4, 62, 1,
+    3, 2, 109, 6, 29, 74, 1, 13, 0, 3, 114, 159, 15, 0, 8, 28,
+    80, 36, 24, 17, 14, 32, 4, 35, 3, 44, 2, 8, 57, 19, 44, 1,
+    258, 2, 2, 1, 8, 48, 2, 139, 17, 4, 16, 2, 5, 158, 103, 16,
+    31, 43, 330, 39, 185, 69, 26, 2, 90, 84, 31, 13, 58, 2, 2, 73,
+    43, 66, 46, 14, 30, 544, 63, 0, 63, 7, 75, 7, 7, 5, 8, 57,
+    84, 1550, 83, 46, 865, 4, 397, 1009, 11,
+};
+
+static constexpr PlantProfile PLANT_PROFILES[PLANT_PROFILE_COUNT] = {
+    // name, min/max moisture %, preferred temp C, preferred humidity %, run s, cooldown s
+    { "Strawberry",               55,  79,  25,  67,   15,    90 }, // fruiting
+    { "Marigold",                 48,  73,  24,  62,   10,    90 }, // flower
+    { "Celery",                   56,  86,  19,  70,   10,    60 }, // leafy
+    { "Lentil",                   46,  72,  25,  61,   12,    90 }, // legume
+    { "Zygopetalum",              34,  65,  22,  66,    5,   180 }, // orchid
+    { "Sawi pahit",               60,  88,  17,  74,   10,    60 }, // leafy
+    { "Blackberry",               43,  73,  25,  59,   20,   180 }, // fruit_tree
+    { "Hyssop",                   29,  59,  22,  49,    8,   120 }, // herb_dry
+    { "Bengkuang",                43,  75,  18,  66,   12,    90 }, // root
+    { "Alocasia",                 49,  75,  26,  71,   10,   120 }, // tropical
+    { "Tillandsia",               37,  66,  24,  72,    5,   180 }, // orchid
+    { "Ryegrass",                 37,  62,  22,  54,   15,   120 }, // grass
+    { "Caraway",                  31,  63,  21,  53,    8,   120 }, // herb_dry
+    { "Shiso",                    45,  78,  19,  64,   10,    60 }, // herb_leafy
+    { "Coleus",                   48,  77,  22,  69,   10,   120 }, // tropical
+    { "Aglaonema",                45,  73,  25,  72,   10,   120 }, // tropical
+    { "Hibiscus",                 48,  78,  23,  59,   10,    90 }, // flower
+    { "Chamomile",                33,  61,  20,  51,    8,   120 }, // herb_dry
+    { "Spider plant",             46,  77,  26,  68,   10,   120 }, // tropical
+    { "Iceberg",                  59,  84,  18,  67,   10,    60 }, // leafy
+    { "Cucumber",                 53,  82,  27,  63,   15,    90 }, // fruiting
+    { "Leek",                     58,  85,  20,  70,   10,    60 }, // leafy
+    { "Lithops",                  16,  43,  26,  38,    5,   300 }, // succulent
+    { "Verbena",                  43,  75,  20,  60,   10,    90 }, // flower
+    { "Jerusalem artichoke",      46,  73,  20,  61,   12,    90 }, // root
+    { "Mammillaria",              21,  46,  27,  34,    5,   300 }, // succulent
+    { "Cordyline",                46,  74,  23,  68,   10,   120 }, // tropical
+    { "Cactus",                   20,  45,  27,  35,    5,   300 }, // succulent
+    { "Begonia",                  50,  77,  25,  67,   10,   120 }, // tropical
+    { "Kemangi",                  45,  72,  22,  61,   10,    60 }, // herb_leafy
+    { "Kacang panjang",           46,  76,  26,  63,   12,    90 }, // legume
+    { "Bird of paradise",         48,  75,  26,  70,   10,   120 }, // tropical
+    { "Endive",                   60,  83,  17,  74,   10,    60 }, // leafy
+    { "Soybean",                  43,  74,  24,  61,   12,    90 }, // legume
+    { "Zebra plant",              49,  72,  23,  70,   10,   120 }, // tropical
+    { "Kalanchoe",                20,  43,  28,  39,    5,   300 }, // succulent
+    { "Starfruit",                38,  73,  23,  62,   20,   180 }, // fruit_tree
+    { "Mango",                    39,  69,  22,  56,   20,   180 }, // fruit_tree
+    { "Moss",                     58,  89,  20,  76,    8,    60 }, // fern
+    { "Kencur",                   42,  77,  16,  65,   12,    90 }, // root
+    { "Snake gourd",              54,  78,  23,  69,   15,    90 }, // fruiting
+    { "Cassava",                  42,  75,  16,  65,   12,    90 }, // root
+    { "Pandan",                   42,  76,  19,  66,   10,    60 }, // herb_leafy
+    { "Burdock",                  48,  75,  16,  67,   12,    90 }, // root
+    { "Lantana",                  42,  76,  24,  63,   10,    90 }, // flower
+    { "Arrowroot",                46,  76,  19,  62,   12,    90 }, // root
+    { "Turmeric",                 43,  73,  18,  68,   12,    90 }, // root
+    { "Chervil",                  45,  75,  19,  68,   10,    60 }, // herb_leafy
+    { "Lotus",                    70,  98,  29,  84,   20,    60 }, // bog
+    { "Habanero",                 49,  79,  25,  68,   15,    90 }, // fruiting
+    { "Pachyphytum",              21,  48,  25,  38,    5,   300 }, // succulent
+    { "Rosemary",                 32,  63,  23,  48,    8,   120 }, // herb_dry
+    { "Wasabi",                   48,  75,  20,  67,   12,    90 }, // root
+    { "Stinging nettle",          48,  74,  22,  65,   10,    60 }, // herb_leafy
+    { "Anthurium",                51,  77,  22,  69,   10,   120 }, // tropical
+    { "Daun salam",               46,  76,  18,  64,   10,    60 }, // herb_leafy
+    { "Bluegrass",                37,  63,  20,  58,   15,   120 }, // grass
+    { "Snapdragon",               43,  76,  23,  63,   10,    90 }, // flower
+    { "Sugarcane",                36,  67,  24,  53,   15,   120 }, // grass
+    { "Calamansi",                43,  67,  26,  57,   20,   180 }, // fruit_tree
+    { "Chili",                    40,  80,  25,  70,   10,    60 }, // fruiting
+    { "Ground cherry",            55,  83,  27,  63,   15,    90 }, // fruiting
+    { "Rutabaga",                 44,  74,  20,  69,   12,    90 }, // root
+    { "Peace lily",               51,  74,  22,  74,   10,   120 }, // tropical
+    { "Perilla",                  44,  78,  20,  63,   10,    60 }, // herb_leafy
+    { "Fennel",                   27,  58,  24,  50,    8,   120 }, // herb_dry
+    { "Pothos",                   51,  77,  26,  72,   10,   120 }, // tropical
+    { "Torenia",                  44,  75,  22,  64,   10,    90 }, // flower
+    { "Sage",                     31,  63,  21,  49,    8,   120 }, // herb_dry
+    { "Lime",                     43,  73,  24,  56,   20,   180 }, // fruit_tree
+    { "Guava",                    43,  73,  23,  57,   20,   180 }, // fruit_tree
+    { "Mangosteen",               39,  67,  23,  57,   20,   180 }, // fruit_tree
+    { "Anggrek bulan",            32,  62,  25,  74,    5,   180 }, // orchid
+    { "Mandarin",                 42,  71,  24,  63,   20,   180 }, // fruit_tree
+    { "Staghorn fern",            63,  93,  22,  82,    8,    60 }, // fern
+    { "Chia",                     42,  77,  24,  64,   12,    90 }, // legume
+    { "Pomegranate",              43,  72,  25,  56,   20,   180 }, // fruit_tree
+    { "Grapefruit",               39,  70,  26,  58,   20,   180 }, // fruit_tree
+    { "Jicama",                   42,  77,  20,  65,   12,    90 }, // root
+    { "Fig",                      38,  68,  23,  59,   20,   180 }, // fruit_tree
+    { "Heliconia",                51,  72,  24,  73,   10,   120 }, // tropical
+    { "Sundew",                   72,  97,  26,  80,   20,    60 }, // bog
+    { "Vanilla",                  35,  66,  22,  68,    5,   180 }, // orchid
+    { "Cayenne",                  55,  83,  26,  66,   15,    90 }, // fruiting
+    { "Rice",                     69,  97,  30,  80,   20,    60 }, // bog
+    { "Selaginella",              63,  92,  19,  77,    8,    60 }, // fern
+    { "Wheat",                    43,  73,  26,  56,   12,    90 }, // legume
+    { "Chives",                   43,  72,  19,  67,   10,    60 }, // herb_leafy
+    { "African violet",           45,  75,  22,  58,   10,    90 }, // flower
+    { "Hydrangea",                45,  72,  24,  61,   10,    90 }, // flower
+    { "Pumpkin",                  53,  83,  23,  65,   15,    90 }, // fruiting
+    { "Taro",                     48,  78,  17,  69,   12,    90 }, // root
+    { "Lovage",                   46,  73,  20,  61,   10,    60 }, // herb_leafy
+    { "Bird's nest fern",         58,  88,  20,  78,    8,    60 }, // fern
+    { "Barley",                   47,  77,  24,  56,   12,    90 }, // legume
+    { "Venus flytrap",            71,  92,  29,  83,   20,    60 }, // bog
+    { "Dill",                     33,  62,  21,  54,    8,   120 }, // herb_dry
+    { "Peperomia",                48,  77,  23,  66,   10,   120 }, // tropical
+    { "Parlor palm",              49,  76,  24,  67,   10,   120 }, // tropical
+    { "Clover",                   43,  72,  23,  62,   12,    90 }, // legume
+    { "Petunia",                  47,  74,  22,  60,   10,    90 }, // flower
+    { "Allium",                   37,  71,  16,  59,   10,   120 }, // bulb
+    { "Soursop",                  41,  67,  23,  61,   20,   180 }, // fruit_tree
+    { "Orange",                   37,  73,  26,  56,   20,   180 }, // fruit_tree
+    { "Caladium",                 49,  72,  26,  72,   10,   120 }, // tropical
+    { "Winged bean",              47,  75,  26,  61,   12,    90 }, // legume
+    { "Aloe vera",                21,  45,  29,  32,    5,   300 }, // succulent
+    { "Pansy",                    45,  76,  21,  60,   10,    90 }, // flower
+    { "Rose",                     42,  75,  21,  58,   10,    90 }, // flower
+    { "Daikon",                   47,  76,  16,  67,   12,    90 }, // root
+    { "Lychee",                   41,  71,  25,  58,   20,   180 }, // fruit_tree
+    { "Olive",                    39,  69,  22,  57,   20,   180 }, // fruit_tree
+    { "Lawn grass",               32,  66,  24,  58,   15,   120 }, // grass
+    { "Kaffir lime",              37,  73,  22,  60,   20,   180 }, // fruit_tree
+    { "Chayote",                  55,  77,  26,  67,   15,    90 }, // fruiting
+    { "Sugar snap pea",           48,  74,  22,  62,   12,    90 }, // legume
+    { "Kumquat",                  40,  73,  23,  62,   20,   180 }, // fruit_tree
+    { "Kangkung",                 59,  82,  16,  69,   10,    60 }, // leafy
+    { "Carrot",                   43,  78,  17,  62,   12,    90 }, // root
+    { "Holy basil",               42,  77,  21,  67,   10,    60 }, // herb_leafy
+    { "Durian",                   43,  71,  22,  59,   20,   180 }, // fruit_tree
+    { "Maranta",                  51,  78,  24,  69,   10,   120 }, // tropical
+    { "Butternut squash",         51,  83,  27,  68,   15,    90 }, // fruiting
+    { "Longan",                   43,  69,  25,  56,   20,   180 }, // fruit_tree
+    { "Thyme",                    33,  57,  20,  49,    8,   120 }, // herb_dry
+    { "Bok choy",                 59,  83,  20,  73,   10,    60 }, // leafy
+    { "Asparagus fern",           57,  91,  22,  78,    8,    60 }, // fern
+    { "Cabai rawit",              49,  77,  27,  66,   15,    90 }, // fruiting
+    { "Chrysanthemum",            45,  74,  23,  61,   10,    90 }, // flower
+    { "Sweet corn",               55,  81,  23,  66,   15,    90 }, // fruiting
+    { "Cattleya",                 37,  65,  26,  69,    5,   180 }, // orchid
+    { "Lily",                     43,  71,  17,  59,   10,   120 }, // bulb
+    { "Kecipir",                  48,  73,  25,  63,   12,    90 }, // legume
+    { "Amaranth",                 60,  86,  17,  71,   10,    60 }, // leafy
+    { "Komatsuna",                58,  88,  19,  66,   10,    60 }, // leafy
+    { "Cabbage",                  58,  82,  16,  73,   10,    60 }, // leafy
+    { "Crassula",                 16,  46,  29,  34,    5,   300 }, // succulent
+    { "Aeonium",                  21,  48,  29,  35,    5,   300 }, // succulent
+    { "Senecio",                  16,  47,  29,  31,    5,   300 }, // succulent
+    { "Cherry tomato",            55,  78,  24,  66,   15,    90 }, // fruiting
+    { "Pomelo",                   42,  71,  24,  60,   20,   180 }, // fruit_tree
+    { "Bamboo",                   34,  63,  20,  55,   15,   120 }, // grass
+    { "Malabar spinach",          56,  84,  17,  73,   10,    60 }, // leafy
+    { "Lucky bamboo",             35,  65,  24,  51,   15,   120 }, // grass
+    { "Frangipani",               45,  78,  20,  61,   10,    90 }, // flower
+    { "Portulaca",                44,  75,  21,  63,   10,    90 }, // flower
+    { "Parsnip",                  45,  77,  18,  65,   12,    90 }, // root
+    { "Agave",                    18,  44,  25,  39,    5,   300 }, // succulent
+    { "Green bean",               42,  76,  24,  59,   12,    90 }, // legume
+    { "Tea",                      38,  69,  23,  60,   20,   180 }, // fruit_tree
+    { "Hyacinth",                 43,  67,  20,  59,   10,   120 }, // bulb
+    { "Pigeon pea",               45,  72,  25,  63,   12,    90 }, // legume
+    { "Peach",                    37,  70,  23,  59,   20,   180 }, // fruit_tree
+    { "Turnip",                   44,  77,  20,  68,   12,    90 }, // root
+    { "Coconut",                  37,  67,  24,  59,   20,   180 }, // fruit_tree
+    { "Spinach",                  60,  85,  18,  70,   10,    60 }, // leafy
+    { "Sword fern",               57,  88,  19,  78,    8,    60 }, // fern
+    { "Collard greens",           57,  82,  19,  68,   10,    60 }, // leafy
+    { "Ginger",                   44,  74,  17,  61,   12,    90 }, // root
+    { "Dragon fruit",             16,  46,  28,  32,    5,   300 }, // succulent
+    { "Graptopetalum",            16,  48,  27,  38,    5,   300 }, // succulent
+    { "Moringa",                  39,  71,  23,  63,   20,   180 }, // fruit_tree
+    { "Swiss chard",              61,  88,  19,  68,   10,    60 }, // leafy
+    { "Salak",                    39,  72,  24,  63,   20,   180 }, // fruit_tree
+    { "Water hyacinth",           70,  97,  27,  77,   20,    60 }, // bog
+    { "Blueberry",                41,  72,  22,  59,   20,   180 }, // fruit_tree
+    { "Miracle fruit",            37,  72,  22,  57,   20,   180 }, // fruit_tree
+    { "Wild rice",                73,  98,  26,  83,   20,    60 }, // bog
+    { "Bay laurel",               32,  57,  22,  54,    8,   120 }, // herb_dry
+    { "Sesame",                   46,  74,  25,  59,   12,    90 }, // legume
+    { "Gardenia",                 48,  78,  21,  59,   10,    90 }, // flower
+    { "Zucchini",                 55,  83,  25,  65,   15,    90 }, // fruiting
+    { "Desert rose",              20,  47,  29,  39,    5,   300 }, // succulent
+    { "Grape",                    40,  69,  22,  64,   20,   180 }, // fruit_tree
+    { "Celeriac",                 44,  77,  17,  62,   12,    90 }, // root
+    { "Curry leaf",               30,  62,  22,  50,    8,   120 }, // herb_dry
+    { "Beetroot",                 45,  74,  17,  63,   12,    90 }, // root
+    { "Sempervivum",              21,  46,  25,  32,    5,   300 }, // succulent
+    { "Alfalfa",                  48,  78,  25,  59,   12,    90 }, // legume
+    { "Bermuda grass",            33,  65,  24,  57,   15,   120 }, // grass
+    { "Lavender",                 28,  57,  21,  49,    8,   120 }, // herb_dry
+    { "Red cabbage",              59,  82,  20,  68,   10,    60 }, // leafy
+    { "Pitcher plant",            73,  94,  27,  79,   20,    60 }, // bog
+    { "Jackfruit",                43,  72,  24,  64,   20,   180 }, // fruit_tree
+    { "Sunflower",                45,  78,  24,  62,   10,    90 }, // flower
+    { "Croton",                   51,  75,  22,  72,   10,   120 }, // tropical
+    { "Brussels sprouts",         59,  83,  19,  68,   10,    60 }, // leafy
+    { "Pare",                     54,  83,  25,  66,   15,    90 }, // fruiting
+    { "Chinese celery",           56,  82,  20,  74,   10,    60 }, // leafy
+    { "Hyacinth bean",            48,  78,  24,  64,   12,    90 }, // legume
+    { "Portulacaria",             18,  43,  26,  38,    5,   300 }, // succulent
+    { "Gerbera",                  46,  76,  22,  60,   10,    90 }, // flower
+    { "Arugula",                  57,  85,  20,  74,   10,    60 }, // leafy
+    { "Long bean",                48,  78,  23,  60,   12,    90 }, // legume
+    { "Padi",                     72,  93,  26,  82,   20,    60 }, // bog
+    { "Taro paddy",               68,  93,  28,  77,   20,    60 }, // bog
+    { "Lemon balm",               45,  76,  18,  68,   10,    60 }, // herb_leafy
+    { "Gomphrena",                46,  72,  22,  63,   10,    90 }, // flower
+    { "Napa cabbage",             58,  88,  16,  67,   10,    60 }, // leafy
+    { "Tuberose",                 42,  72,  17,  55,   10,   120 }, // bulb
+    { "Choy sum",                 60,  87,  19,  66,   10,    60 }, // leafy
+    { "Maidenhair fern",          61,  88,  19,  77,    8,    60 }, // fern
+    { "Money plant",              46,  77,  22,  68,   10,   120 }, // tropical
+    { "Mint",                     46,  76,  22,  64,   10,    60 }, // herb_leafy
+    { "Freesia",                  38,  73,  19,  59,   10,   120 }, // bulb
+    { "Rubber plant",             50,  74,  23,  69,   10,   120 }, // tropical
+    { "Mizuna",                   59,  86,  17,  67,   10,    60 }, // leafy
+    { "Sweet pea",                42,  75,  24,  58,   10,    90 }, // flower
+    { "Sedum",                    18,  47,  27,  31,    5,   300 }, // succulent
+    { "Boston fern",              63,  87,  21,  80,    8,    60 }, // fern
+    { "Wax gourd",                53,  80,  27,  61,   15,    90 }, // fruiting
+    { "Kimberly fern",            63,  92,  19,  80,    8,    60 }, // fern
+    { "Watercress",               42,  77,  19,  68,   10,    60 }, // herb_leafy
+    { "Radish",                   42,  73,  20,  67,   12,    90 }, // root
+    { "Vinca",                    48,  78,  22,  59,   10,    90 }, // flower
+    { "Fescue",                   37,  66,  20,  56,   15,   120 }, // grass
+    { "Mustard greens",           60,  83,  20,  70,   10,    60 }, // leafy
+    { "Opuntia",                  18,  45,  25,  38,    5,   300 }, // succulent
+    { "Miltonia",                 38,  68,  25,  68,    5,   180 }, // orchid
+    { "Ponytail palm",            17,  43,  25,  33,    5,   300 }, // succulent
+    { "Tarragon",                 28,  62,  22,  53,    8,   120 }, // herb_dry
+    { "Pear",                     37,  70,  23,  56,   20,   180 }, // fruit_tree
+    { "Spathiphyllum",            51,  75,  23,  70,   10,   120 }, // tropical
+    { "Kohlrabi",                 61,  88,  20,  73,   10,    60 }, // leafy
+    { "Crocus",                   43,  70,  16,  55,   10,   120 }, // bulb
+    { "Peanut",                   48,  77,  23,  58,   12,    90 }, // legume
+    { "Cantaloupe",               50,  77,  25,  67,   15,    90 }, // fruiting
+    { "Ash gourd",                54,  82,  27,  63,   15,    90 }, // fruiting
+    { "Lemon",                    41,  67,  25,  56,   20,   180 }, // fruit_tree
+    { "Lemongrass",               33,  63,  23,  54,    8,   120 }, // herb_dry
+    { "Coffee",                   42,  70,  26,  61,   20,   180 }, // fruit_tree
+    { "Stevia",                   27,  60,  20,  52,    8,   120 }, // herb_dry
+    { "Tree fern",                57,  93,  22,  77,    8,    60 }, // fern
+    { "Azolla",                   69,  93,  29,  76,   20,    60 }, // bog
+    { "Bougainvillea",            44,  75,  21,  63,   10,    90 }, // flower
+    { "Ficus benjamina",          49,  72,  23,  74,   10,   120 }, // tropical
+    { "Horsetail",                67,  98,  29,  76,   20,    60 }, // bog
+    { "Jade plant",               21,  48,  26,  33,    5,   300 }, // succulent
+    { "Luffa",                    50,  83,  26,  62,   15,    90 }, // fruiting
+    { "Nasturtium",               48,  72,  20,  63,   10,    90 }, // flower
+    { "Oats",                     43,  72,  22,  56,   12,    90 }, // legume
+    { "Viola",                    42,  74,  23,  63,   10,    90 }, // flower
+    { "Broccoli",                 59,  85,  16,  68,   10,    60 }, // leafy
+    { "Cosmos",                   43,  73,  23,  62,   10,    90 }, // flower
+    { "Avocado",                  43,  73,  25,  59,   20,   180 }, // fruit_tree
+    { "Shallot",                  43,  75,  16,  62,   12,    90 }, // root
+    { "String of pearls",         18,  47,  25,  34,    5,   300 }, // succulent
+    { "Euphorbia",                17,  43,  26,  39,    5,   300 }, // succulent
+    { "Watermelon",               52,  83,  23,  67,   15,    90 }, // fruiting
+    { "Edamame",                  43,  72,  24,  60,   12,    90 }, // legume
+    { "Borage",                   47,  76,  22,  65,   10,    60 }, // herb_leafy
+    { "Spring onion",             57,  86,  16,  69,   10,    60 }, // leafy
+    { "Buckwheat",                45,  73,  24,  61,   12,    90 }, // legume
+    { "Fittonia",                 50,  74,  26,  69,   10,   120 }, // tropical
+    { "Snake plant",              20,  47,  26,  38,    5,   300 }, // succulent
+    { "Echeveria",                21,  44,  27,  36,    5,   300 }, // succulent
+    { "Fava bean",                44,  72,  23,  60,   12,    90 }, // legume
+    { "Rain lily",                40,  67,  18,  58,   10,   120 }, // bulb
+    { "Ixora",                    44,  73,  22,  59,   10,    90 }, // flower
+    { "Cauliflower",              55,  84,  20,  72,   10,    60 }, // leafy
+    { "Pilea",                    51,  72,  24,  71,   10,   120 }, // tropical
+    { "Philodendron",             45,  74,  23,  68,   10,   120 }, // tropical
+    { "Cherry",                   43,  73,  22,  59,   20,   180 }, // fruit_tree
+    { "Yam",                      47,  78,  19,  63,   12,    90 }, // root
+    { "Rambutan",                 42,  67,  25,  64,   20,   180 }, // fruit_tree
+    { "Jasmine",                  48,  75,  21,  60,   10,    90 }, // flower
+    { "Chinese evergreen",        48,  77,  26,  70,   10,   120 }, // tropical
+    { "Potato",                   46,  72,  16,  61,   12,    90 }, // root
+    { "Horseradish",              43,  75,  16,  63,   12,    90 }, // root
+    { "Marjoram",                 33,  58,  24,  47,    8,   120 }, // herb_dry
+    { "Eggplant",                 52,  83,  26,  63,   15,    90 }, // fruiting
+    { "Jambu air",                40,  71,  23,  63,   20,   180 }, // fruit_tree
+    { "Morning glory",            43,  72,  21,  64,   10,    90 }, // flower
+    { "Fountain grass",           36,  62,  24,  56,   15,   120 }, // grass
+    { "Sawi",                     57,  83,  16,  70,   10,    60 }, // leafy
+    { "Baby corn",                49,  81,  27,  63,   15,    90 }, // fruiting
+    { "Paphiopedilum",            36,  63,  26,  68,    5,   180 }, // orchid
+    { "Dracaena",                 47,  72,  22,  68,   10,   120 }, // tropical
+    { "Bottle gourd",             51,  82,  27,  69,   15,    90 }, // fruiting
+    { "Pampas grass",             33,  65,  21,  55,   15,   120 }, // grass
+    { "Raspberry",                43,  70,  25,  57,   20,   180 }, // fruit_tree
+    { "Garlic",                   44,  74,  20,  64,   12,    90 }, // root
+    { "Mung bean",                43,  72,  23,  62,   12,    90 }, // legume
+    { "Bayam",                    59,  88,  19,  74,   10,    60 }, // leafy
+    { "Syngonium",                47,  72,  22,  73,   10,   120 }, // tropical
+    { "Sorghum",                  43,  76,  24,  61,   12,    90 }, // legume
+    { "Lima bean",                44,  75,  23,  59,   12,    90 }, // legume
+    { "Apricot",                  42,  68,  25,  63,   20,   180 }, // fruit_tree
+    { "Pakis",                    61,  91,  21,  77,    8,    60 }, // fern
+    { "Carex",                    36,  63,  23,  58,   15,   120 }, // grass
+    { "Millet",                   48,  78,  25,  59,   12,    90 }, // legume
+    { "Sweet potato",             45,  76,  18,  65,   12,    90 }, // root
+    { "Celosia",                  42,  72,  22,  59,   10,    90 }, // flower
+    { "Holly fern",               61,  89,  20,  82,    8,    60 }, // fern
+    { "Pea",                      42,  72,  24,  64,   12,    90 }, // legume
+    { "Schefflera",               45,  76,  23,  73,   10,   120 }, // tropical
+    { "Iris",                     39,  69,  18,  51,   10,   120 }, // bulb
+    { "Areca palm",               49,  74,  23,  69,   10,   120 }, // tropical
+    { "Romaine",                  61,  85,  20,  70,   10,    60 }, // leafy
+    { "Tulip",                    37,  68,  20,  57,   10,   120 }, // bulb
+    { "Salsify",                  42,  76,  16,  65,   12,    90 }, // root
+    { "Daffodil",                 37,  68,  17,  54,   10,   120 }, // bulb
+    { "Tradescantia",             51,  73,  23,  71,   10,   120 }, // tropical
+    { "Anemone",                  42,  68,  17,  59,   10,   120 }, // bulb
+    { "Hoya",                     18,  48,  28,  34,    5,   300 }, // succulent
+    { "Kale",                     58,  85,  17,  74,   10,    60 }, // leafy
+    { "Dahlia",                   45,  72,  23,  62,   10,    90 }, // flower
+    { "Sapodilla",                40,  69,  24,  60,   20,   180 }, // fruit_tree
+    { "Peppermint",               46,  73,  18,  69,   10,    60 }, // herb_leafy
+    { "Vietnamese coriander",     45,  72,  22,  65,   10,    60 }, // herb_leafy
+    { "Jalapeno",                 55,  77,  24,  69,   15,    90 }, // fruiting
+    { "ZZ plant",                 20,  47,  29,  39,    5,   300 }, // succulent
+    { "Tomato",                   55,  80,  25,  65,   15,    90 }, // fruiting
+    { "Purslane",                 58,  85,  16,  72,   10,    60 }, // leafy
+    { "Fuchsia",                  44,  72,  20,  56,   10,    90 }, // flower
+    { "Roma tomato",              54,  83,  24,  62,   15,    90 }, // fruiting
+    { "Papyrus",                  69,  94,  30,  76,   20,    60 }, // bog
+    { "Oncidium",                 38,  62,  22,  67,    5,   180 }, // orchid
+    { "Canna",                    43,  68,  18,  59,   10,   120 }, // bulb
+    { "Mondo grass",              35,  67,  24,  56,   15,   120 }, // grass
+    { "Papaya",                   37,  69,  22,  64,   20,   180 }, // fruit_tree
+    { "Lotus root",               46,  74,  16,  63,   12,    90 }, // root
+    { "Bitter gourd",             52,  81,  23,  61,   15,    90 }, // fruiting
+    { "Cymbidium",                32,  65,  23,  72,    5,   180 }, // orchid
+    { "Ludisia",                  36,  62,  22,  71,    5,   180 }, // orchid
+    { "Onion",                    47,  77,  18,  62,   12,    90 }, // root
+    { "Duckweed",                 69,  95,  26,  82,   20,    60 }, // bog
+    { "Parsley",                  45,  76,  20,  66,   10,    60 }, // herb_leafy
+    { "Pak choi",                 57,  84,  17,  67,   10,    60 }, // leafy
+    { "Melati",                   46,  72,  21,  56,   10,    90 }, // flower
+    { "Haworthia",                15,  42,  27,  37,    5,   300 }, // succulent
+    { "Snow pea",                 42,  77,  25,  64,   12,    90 }, // legume
+    { "Button fern",              63,  89,  20,  83,    8,    60 }, // fern
+    { "Plum",                     42,  73,  24,  59,   20,   180 }, // fruit_tree
+    { "Kailan",                   60,  86,  18,  73,   10,    60 }, // leafy
+    { "Dieffenbachia",            46,  73,  26,  71,   10,   120 }, // tropical
+    { "Fiddle leaf fig",          50,  78,  25,  73,   10,   120 }, // tropical
+    { "Temulawak",                47,  77,  20,  66,   12,    90 }, // root
+    { "Sarracenia",               70,  98,  27,  80,   20,    60 }, // bog
+    { "Golden pothos",            48,  75,  24,  70,   10,   120 }, // tropical
+    { "Culantro",                 42,  74,  20,  68,   10,    60 }, // herb_leafy
+    { "St Augustine grass",       38,  63,  21,  52,   15,   120 }, // grass
+    { "Christmas cactus",         19,  46,  27,  36,    5,   300 }, // succulent
+    { "Gasteria",                 15,  42,  27,  36,    5,   300 }, // succulent
+    { "Zoysia",                   36,  68,  24,  51,   15,   120 }, // grass
+    { "Camellia",                 47,  76,  20,  62,   10,    90 }, // flower
+    { "Mulberry",                 41,  70,  25,  57,   20,   180 }, // fruit_tree
+    { "Geranium",                 48,  78,  23,  61,   10,    90 }, // flower
+    { "Amaryllis",                40,  68,  18,  54,   10,   120 }, // bulb
+    { "Bromeliad",                46,  77,  23,  72,   10,   120 }, // tropical
+    { "Lettuce",                  56,  88,  17,  71,   10,    60 }, // leafy
+    { "Passion fruit",            42,  72,  23,  60,   20,   180 }, // fruit_tree
+    { "Tatsoi",                   57,  87,  19,  68,   10,    60 }, // leafy
+    { "Colocasia",                49,  72,  23,  67,   10,   120 }, // tropical
+    { "Baby tears",               58,  93,  20,  77,    8,    60 }, // fern
+    { "Cumin",                    30,  60,  23,  54,    8,   120 }, // herb_dry
+    { "Aster",                    42,  77,  20,  57,   10,    90 }, // flower
+    { "Anise",                    29,  57,  23,  52,    8,   120 }, // herb_dry
+    { "Ranunculus",               39,  70,  19,  56,   10,   120 }, // bulb
+    { "Cabai keriting",           50,  81,  26,  67,   15,    90 }, // fruiting
+    { "Zinnia",                   47,  73,  22,  57,   10,    90 }, // flower
+    { "Azalea",                   48,  74,  20,  57,   10,    90 }, // flower
+    { "Garlic chives",            48,  77,  19,  63,   10,    60 }, // herb_leafy
+    { "Phalaenopsis",             33,  63,  23,  68,    5,   180 }, // orchid
+    { "Apple",                    39,  72,  25,  64,   20,   180 }, // fruit_tree
+    { "Selada",                   56,  88,  18,  68,   10,    60 }, // leafy
+    { "Banana",                   47,  75,  24,  70,   10,   120 }, // tropical
+    { "Spearmint",                42,  73,  20,  62,   10,    60 }, // herb_leafy
+    { "Gherkin",                  55,  82,  27,  66,   15,    90 }, // fruiting
+    { "Cilantro",                 48,  77,  21,  68,   10,    60 }, // herb_leafy
+    { "Epidendrum",               32,  63,  24,  67,    5,   180 }, // orchid
+    { "Quinoa",                   42,  77,  22,  63,   12,    90 }, // legume
+    { "Melon",                    53,  81,  23,  63,   15,    90 }, // fruiting
+    { "Adenium",                  16,  44,  27,  36,    5,   300 }, // succulent
+    { "Tomatillo",                49,  83,  25,  67,   15,    90 }, // fruiting
+    { "Ginger lily",              47,  76,  24,  71,   10,   120 }, // tropical
+    { "Mache",                    59,  84,  18,  74,   10,    60 }, // leafy
+    { "Staghorn orchid",          38,  63,  25,  71,    5,   180 }, // orchid
+    { "Mitsuba",                  42,  74,  20,  67,   10,    60 }, // herb_leafy
+    { "Impatiens",                42,  75,  22,  60,   10,    90 }, // flower
+    { "Sorrel",                   44,  77,  22,  62,   10,    60 }, // herb_leafy
+    { "Vetiver",                  35,  62,  20,  52,   15,   120 }, // grass
+    { "Gladiolus",                38,  73,  17,  56,   10,   120 }, // bulb
+    { "Galangal",                 43,  78,  19,  62,   12,    90 }, // root
+    { "Kyuri",                    55,  77,  25,  68,   15,    90 }, // fruiting
+    { "Cacao",                    41,  71,  26,  59,   20,   180 }, // fruit_tree
+    { "Savory",                   30,  59,  24,  50,    8,   120 }, // herb_dry
+    { "Salvia",                   47,  75,  21,  56,   10,    90 }, // flower
+    { "Radicchio",                57,  85,  16,  74,   10,    60 }, // leafy
+    { "Water spinach",            60,  87,  17,  72,   10,    60 }, // leafy
+    { "Oregano",                  28,  63,  22,  50,    8,   120 }, // herb_dry
+    { "Monstera",                 50,  75,  24,  70,   10,   120 }, // tropical
+    { "Water lily",               68,  97,  26,  83,   20,    60 }, // bog
+    { "Carnation",                43,  74,  20,  58,   10,    90 }, // flower
+    { "Dendrobium",               38,  65,  22,  68,    5,   180 }, // orchid
+    { "Thai basil",               43,  73,  21,  65,   10,    60 }, // herb_leafy
+    { "Chickpea",                 45,  77,  25,  64,   12,    90 }, // legume
+    { "Basil",                    42,  73,  19,  62,   10,    60 }, // herb_leafy
+    { "Butterhead",               59,  84,  20,  69,   10,    60 }, // leafy
+    { "Bell pepper",              49,  82,  25,  66,   15,    90 }, // fruiting
+    { "Calathea",                 46,  72,  22,  70,   10,   120 }, // tropical
+    { "Catnip",                   27,  61,  22,  47,    8,   120 }, // herb_dry
+    { "Terong",                   49,  83,  26,  62,   15,    90 }, // fruiting
+    { "Vanda",                    35,  63,  23,  69,    5,   180 }, // orchid
+    { "Rabbit foot fern",         60,  90,  22,  77,    8,    60 }, // fern
+    { "Kentia palm",              47,  74,  26,  69,   10,   120 }, // tropical
+    { "Echinocactus",             21,  48,  25,  36,    5,   300 }, // succulent
+    { "Okra",                     50,  78,  24,  64,   15,    90 }, // fruiting
+    { "Lisianthus",               44,  74,  23,  60,   10,    90 }, // flower
+    { "Cowpea",                   43,  75,  24,  61,   12,    90 }, // legume
+};
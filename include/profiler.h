@@ -0,0 +1,96 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "mem_diag.h"
+
+// Hot-path profiler: per-stage min/max/mean and a log2 latency histogram.
+// Stages are fixed ids so recording is a few adds, no lookup or lock. Each
+// stage must be recorded from one task only (its single writer); readers
+// take a snapshot. On the ESP32 the clock is the CPU cycle counter (stages
+// run in pinned tasks), on a host build std::chrono, so bench and field
+// profiles use the same stages and report format. The host build also
+// counts heap allocations per stage (see mem_diag.h).
+//
+// Build with -DPROFILER_ENABLED=0 to compile every probe out.
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Bucket 0 counts 0 us, bucket i (1..PROFILE_BUCKETS-2) [2^(i-1), 2^i) us,
+// the last bucket everything from 2^(PROFILE_BUCKETS-2) us (~262 ms) up.
+#define PROFILE_BUCKETS 20
+
+enum ProfileStage : uint8_t {
+    PROF_SOIL_STAGE = 0,  // loop: read filtered moisture
+    PROF_SOIL_FILTER,     // soil_adc task: filter one DMA frame
+    PROF_DHT_STAGE,       // loop: read the DHT snapshot
+    PROF_CONTROL,         // loop: commands, rules, relays, state publish
+    PROF_DISPLAY_DRAW,    // loop: updateDisplayScenes
+    PROF_DISPLAY_FLUSH,   // oled_flush task: I2C page transfer
+    PROF_STATUS_LOG,      // loop: status Serial.printf
+    PROF_MQTT_LOOP,       // network task: reconnect + mqttAsync_service
+    PROF_PUBLISH,         // network task: telemetry publish
+    PROF_STAGE_COUNT
+};
+
+struct ProfileStats {
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint32_t buckets[PROFILE_BUCKETS];
+    uint32_t allocations;  // host build only
+};
+
+#if PROFILER_ENABLED
+
+void profiler_begin();
+uint32_t profiler_now(); // opaque ticks, only for profiler_record
+void profiler_record(ProfileStage stage, uint32_t startTicks);
+void profiler_recordAllocations(ProfileStage stage, uint32_t count);
+void profiler_snapshot(ProfileStage stage, ProfileStats& out);
+// Starts a new window: every stage clears itself on its next record
+void profiler_resetWindow();
+const char* profiler_stageName(ProfileStage stage);
+// One stage of a window as a JSON object; returns the length or 0 if it did not fit
+size_t profiler_formatStage(ProfileStage stage, const ProfileStats& stats, unsigned long windowMs,
+                            char* buf, size_t len);
+
+class ProfileScope {
+public:
+#ifdef ARDUINO
+    explicit ProfileScope(ProfileStage stage) : stage(stage), start(profiler_now()) {}
+    ~ProfileScope() { profiler_record(stage, start); }
+#else
+    explicit ProfileScope(ProfileStage stage)
+        : stage(stage), start(profiler_now()), allocs(memDiag_allocationCount()) {}
+    ~ProfileScope() {
+        profiler_record(stage, start);
+        profiler_recordAllocations(stage, memDiag_allocationCount() - allocs);
+    }
+#endif
+
+private:
+    ProfileStage stage;
+    uint32_t start;
+#ifndef ARDUINO
+    uint32_t allocs;
+#endif
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// Times the rest of the enclosing block
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(stage)
+
+#else
+
+#define profiler_begin() ((void)0)
+#define PROFILE_SCOPE(stage) ((void)0)
+
+#endif
+
+#endif
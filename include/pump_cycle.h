@@ -0,0 +1,34 @@
+#ifndef PUMP_CYCLE_H
+#define PUMP_CYCLE_H
+
+#include <Arduino.h>
+#include "rule_engine.h"
+
+// Auto-mode pump cycle of one zone: when a rule matches run for its run_s,
+// cool down for its cooldown_s, run again if it still matches, otherwise go
+// idle. A started run and its cooldown complete whatever the reading does in
+// between; only soil above the zone's max_moisture (the upper end of the
+// min/max band) stops the pump early and ends the cycle. Plain data with no
+// hidden state, so zones.cpp keeps one per zone and host tools one per
+// simulated zone.
+
+enum PumpPhase : uint8_t {
+    PUMP_IDLE = 0,
+    PUMP_RUNNING,
+    PUMP_COOLDOWN
+};
+
+struct PumpCycle {
+    uint8_t phase;        // PumpPhase
+    uint32_t phaseStart;
+    uint32_t runMs;       // latched from the rule that started the pump
+    uint32_t cooldownMs;
+};
+
+// Advances the cycle. Starting the pump is left to the caller (it may be
+// capped); returns true when the zone wants to start now. aboveMax: the
+// moisture is over the zone's max_moisture.
+bool pumpCycle_step(PumpCycle& cycle, int8_t matchedRule, bool aboveMax, unsigned long now);
+void pumpCycle_start(PumpCycle& cycle, const CompiledRule& rule, unsigned long now);
+
+#endif
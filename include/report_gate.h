@@ -0,0 +1,56 @@
+#ifndef REPORT_GATE_H
+#define REPORT_GATE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Report-by-exception: a channel is published only when its value moved past
+// its deadband since the last publish, or when its heartbeat expired.
+// The pump channel carries the ZoneMask of running pumps with a zero
+// deadband, so every on/off change of any zone reports. Each zone has its own
+// moisture channel. Used by the network task only.
+
+enum ReportChannel : uint8_t {
+    REPORT_MOISTURE = 0,   // zone 0, see reportMoistureChannel()
+    REPORT_TEMPERATURE,
+    REPORT_HUMIDITY,
+    REPORT_PUMP,
+    REPORT_ZONE_MOISTURE,  // zones 1..ZONE_COUNT-1
+    REPORT_CHANNEL_COUNT = REPORT_ZONE_MOISTURE + ZONE_COUNT - 1
+};
+
+typedef uint32_t ReportMask;
+#define REPORT_MASK(ch) ((ReportMask)1u << (ch))
+#define REPORT_MASK_ALL (REPORT_MASK(REPORT_CHANNEL_COUNT) - 1)
+
+inline ReportChannel reportMoistureChannel(uint8_t zone) {
+    return zone == 0 ? REPORT_MOISTURE : (ReportChannel)(REPORT_ZONE_MOISTURE + zone - 1);
+}
+
+struct DeadbandConfig {
+    float absolute;            // publish when |value - last| >= absolute (0 = off)
+    float relative;            // publish when |value - last| >= relative * |last| (0 = off)
+    unsigned long heartbeatMs; // publish at least this often
+};
+
+struct ReportGateStats {
+    unsigned long published[REPORT_CHANNEL_COUNT];
+    unsigned long suppressed[REPORT_CHANNEL_COUNT];
+    unsigned long heartbeats[REPORT_CHANNEL_COUNT];
+    unsigned long messagesSuppressed; // evaluations where nothing was due
+};
+
+void reportGate_begin();
+// Configuring REPORT_MOISTURE applies to the moisture channels of every zone
+void reportGate_configure(ReportChannel channel, const DeadbandConfig& config);
+const DeadbandConfig& reportGate_config(ReportChannel channel);
+
+// Returns the mask of channels that must be published now. NAN values (and
+// invalid readings the caller maps to NAN) are never due.
+ReportMask reportGate_due(const float values[REPORT_CHANNEL_COUNT], unsigned long now);
+// Record that the channels in mask were published with these values.
+void reportGate_commit(ReportMask mask, const float values[REPORT_CHANNEL_COUNT], unsigned long now);
+
+void reportGate_getStats(ReportGateStats& out);
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "device_state.h"
+
+// Auto-mode watering rules. The "rules" array of the rule JSON is validated
+// and compiled once on the network task into a RuleProgram: a flat decision
+// table of fixed-point comparisons. The control loop evaluates the tables of
+// every zone each tick without JSON access or allocation.
+//
+//   "rules": [
+//     { "if": { "moisture": { "lt": 35 }, "temperature": { "gt": 30 } },
+//       "window": "06:00-18:00", "run_s": 15, "cooldown_s": 120 },
+//     { "if": { "moisture": { "lt": 25 } } }
+//   ]
+//
+// Conditions of one rule are ANDed, rules are ORed and the first match
+// supplies run/cooldown (defaults PUMP_RUN_MS / PUMP_COOLDOWN_MS). Operators
+// are lt, le, gt, ge. Windows are local time and may wrap midnight; windowed
+// rules never match while the clock is not synced. A zone without a "rules"
+// array (or with an empty one) waters below its min_moisture, as before,
+// with the run/cooldown of its plant profile (plant_profiles.h) if it has one.
+
+#define RULE_MAX_RULES       8
+#define RULE_MAX_CONDITIONS  16
+
+enum RuleInput : uint8_t {
+    RULE_IN_MOISTURE = 0,
+    RULE_IN_TEMPERATURE,
+    RULE_IN_HUMIDITY,
+    RULE_INPUT_COUNT
+};
+
+enum RuleComparison : uint8_t {
+    RULE_LT = 0,
+    RULE_LE,
+    RULE_GT,
+    RULE_GE
+};
+
+struct RuleCondition {
+    uint8_t input;       // RuleInput
+    uint8_t comparison;  // RuleComparison
+    int16_t thresholdX10;
+};
+
+#define RULE_NO_WINDOW 0xFFFF
+
+struct CompiledRule {
+    uint8_t firstCondition;
+    uint8_t conditionCount;
+    uint16_t windowStart;  // minute of day, RULE_NO_WINDOW = any time
+    uint16_t windowEnd;    // exclusive
+    uint16_t runS;
+    uint16_t cooldownS;
+};
+
+struct RuleProgram {
+    uint8_t ruleCount;
+    uint8_t conditionCount;
+    bool custom;           // false: derived from min_moisture
+    CompiledRule rules[RULE_MAX_RULES];
+    RuleCondition conditions[RULE_MAX_CONDITIONS];
+};
+
+struct RuleEngineStats {
+    unsigned long ticks;
+    uint32_t lastTickCycles;  // CPU cycles to evaluate every zone once
+    uint32_t maxTickCycles;
+    uint64_t totalCycles;
+};
+
+// Network task: validate and compile. On failure error holds the reason.
+bool ruleEngine_compile(JsonVariantConst rules, RuleProgram& out, char* error, size_t errorLen);
+void ruleEngine_defaultProgram(int minMoisture, RuleProgram& out, uint16_t runS = PUMP_RUN_MS / 1000,
+                               uint16_t cooldownS = PUMP_COOLDOWN_MS / 1000);
+
+// Control loop
+void ruleEngine_begin();  // default programs from ruleMinMoisture[]
+void ruleEngine_load(uint8_t zone, const RuleProgram& program);
+void ruleEngine_minMoistureChanged(uint8_t zone); // refreshes a default program
+// Run/cooldown of the zone's default program (from its plant profile); a
+// custom program keeps its own and picks these up only when reverted
+void ruleEngine_setDefaultTiming(uint8_t zone, uint16_t runS, uint16_t cooldownS);
+// Evaluates every zone. matched[z] is the index of the first matching rule
+// or -1; the return value has a bit set for every zone with a match.
+ZoneMask ruleEngine_evaluate(const float moisture[ZONE_COUNT], float temperature, float humidity,
+                             int8_t matched[ZONE_COUNT]);
+// One program against one set of readings, without touching the zones'
+// programs or stats (host tools run many of these side by side).
+// minuteOfDay is local time, -1 while the clock is not synced.
+int8_t ruleEngine_match(const RuleProgram& program, float moisture, float temperature, float humidity,
+                        int16_t minuteOfDay);
+const CompiledRule& ruleEngine_rule(uint8_t zone, uint8_t index);
+const RuleProgram& ruleEngine_program(uint8_t zone);
+// Bounds check for programs that did not come from ruleEngine_compile (NVS)
+bool ruleEngine_isValid(const RuleProgram& program);
+void ruleEngine_getStats(RuleEngineStats& out);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// Cooperative, non-blocking scheduler used by loop().
+// Each stage runs at its own period; a run counts as a missed deadline when it
+// finishes later than deadlineMs after its release time.
+
+#define SCHEDULER_MAX_TASKS 12
+
+typedef void (*SchedTaskFn)();
+
+struct SchedTask {
+    const char* name;
+    SchedTaskFn fn;
+    unsigned long periodMs;
+    unsigned long deadlineMs;
+    unsigned long nextRelease;     // millis() timestamp of the next release
+    unsigned long runs;
+    unsigned long missedDeadlines;
+    unsigned long maxLatenessMs;   // worst (finish - release) seen so far
+};
+
+// Register a stage. Returns the task index or -1 when the table is full.
+int scheduler_addTask(const char* name, SchedTaskFn fn, unsigned long periodMs, unsigned long deadlineMs);
+
+// Run every due stage (earliest deadline first), then sleep until the next release.
+void scheduler_run();
+
+int scheduler_taskCount();
+const SchedTask* scheduler_getTask(int index);
+unsigned long scheduler_totalMissedDeadlines();
+void scheduler_resetStats();
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef SOIL_CALIBRATION_H
+#define SOIL_CALIBRATION_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Per-probe soil moisture calibration: a piecewise-linear table of ADC counts
+// against moisture, plus the probe's temperature drift. Points are kept at
+// SOIL_CAL_REF_TEMP_C; a reading is first moved to that temperature and then
+// looked up. Everything is integer arithmetic on a compiled table (slopes
+// precomputed, no division), cheap enough to run on every ADC sample.
+//
+// The default table is the old linear mapping: 0 counts = 100 % (wet),
+// 4095 = 0 % (dry), no temperature drift.
+
+#define SOIL_CAL_MAX_POINTS  8
+#define SOIL_CAL_REF_TEMP_C  25
+#define SOIL_CAL_ADC_MAX     4095
+#define SOIL_TEMP_UNKNOWN    INT16_MIN  // temperature argument: no compensation
+
+struct SoilCalPoint {
+    uint16_t raw;           // ADC counts at SOIL_CAL_REF_TEMP_C
+    uint16_t moistureX100;  // 0..10000 (0.01 %)
+};
+
+// Persisted form (NVS, MQTT). Valid when it has 2..SOIL_CAL_MAX_POINTS points
+// with strictly increasing raw counts and monotonic moisture.
+struct SoilCalibration {
+    uint8_t pointCount;
+    int16_t tempCoeffQ8;    // counts per C above the reference, Q8 (a probe reading high when warm is > 0)
+    SoilCalPoint points[SOIL_CAL_MAX_POINTS];
+};
+
+// Compiled form used by the acquisition task
+struct SoilCalTable {
+    uint8_t pointCount;
+    int16_t tempCoeffQ8;
+    uint16_t raw[SOIL_CAL_MAX_POINTS];
+    uint16_t moistureX100[SOIL_CAL_MAX_POINTS];
+    int32_t slopeQ16[SOIL_CAL_MAX_POINTS];  // segment i, raw[i]..raw[i+1]: moistureX100 per count
+};
+
+void soilCalibration_default(SoilCalibration& out);
+bool soilCalibration_isValid(const SoilCalibration& cal);
+// Adds a point, replacing the one with the same moisture (so capturing "dry"
+// moves the 0 % end). Leaves cal unchanged and returns false if the result
+// would not be valid.
+bool soilCalibration_setPoint(SoilCalibration& cal, uint16_t raw, uint16_t moistureX100);
+void soilCalibration_compile(const SoilCalibration& cal, SoilCalTable& out);
+
+// Filtered counts (Q8) at temperatureX10 (0.1 C) -> counts at the reference
+// temperature (Q8). One multiply; the division by a constant is a multiply too.
+static inline int32_t soilCalibration_compensateQ8(const SoilCalTable& t, int32_t rawQ8, int16_t temperatureX10) {
+    if (temperatureX10 == SOIL_TEMP_UNKNOWN) return rawQ8;
+    return rawQ8 - (int32_t)t.tempCoeffQ8 * (temperatureX10 - SOIL_CAL_REF_TEMP_C * 10) / 10;
+}
+
+// Segment holding raw; -1 below the first point, pointCount - 1 from the last on
+static inline int8_t soilCalibration_segment(const SoilCalTable& t, int32_t raw) {
+    if (raw < t.raw[0]) return -1;
+    int8_t i = 0;
+    while (i < t.pointCount - 1 && raw >= t.raw[i + 1]) i++;
+    return i;
+}
+
+// Counts at the reference temperature -> moisture in 0.01 %, clamped to the
+// table's ends
+static inline uint16_t soilCalibration_toMoistureX100(const SoilCalTable& t, int32_t raw) {
+    int8_t i = soilCalibration_segment(t, raw);
+    if (i < 0) return t.moistureX100[0];
+    if (i == t.pointCount - 1) return t.moistureX100[i];
+    return (uint16_t)(t.moistureX100[i] + ((t.slopeQ16[i] * (raw - t.raw[i]) + 0x8000) >> 16));
+}
+
+// Local slope at raw (moistureX100 per count, Q16); 0 outside the table
+static inline int32_t soilCalibration_slopeQ16(const SoilCalTable& t, int32_t raw) {
+    int8_t i = soilCalibration_segment(t, raw);
+    return (i < 0 || i == t.pointCount - 1) ? 0 : t.slopeQ16[i];
+}
+
+#endif
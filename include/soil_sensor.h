@@ -0,0 +1,40 @@
+#ifndef SOIL_SENSOR_H
+#define SOIL_SENSOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "soil_calibration.h"
+
+// Continuous soil moisture acquisition for every zone. One ADC DMA pattern
+// scans all distinct probe pins (zoneSoilPin, see zones.h) in a single pass;
+// a background task splits each DMA frame per probe, takes the median to
+// reject relay/pump switching spikes and smooths the medians with an EMA.
+// The filtered counts are corrected for the probe's temperature drift (the
+// DHT reading, see soilSensor_setTemperature) and converted through the
+// probe's calibration table (soil_calibration.h). Results are published as
+// ready-to-use values, so readers pay no conversion cost.
+
+struct SoilReading {
+    float moisturePercent;   // filtered, 0..100
+    float noisePercent;      // smoothed mean absolute deviation of the raw samples
+    uint16_t filteredRaw;    // filtered ADC counts (0..4095)
+    uint16_t compensatedRaw; // the same at SOIL_CAL_REF_TEMP_C, what calibration points record
+    unsigned long updatedAt; // millis() of the last frame
+};
+
+bool soilSensor_begin();
+float soilSensor_moisture(uint8_t zone);               // lock-free, just loads the last value
+void soilSensor_readAll(float moisture[ZONE_COUNT]);   // every zone in one call
+void soilSensor_read(uint8_t zone, SoilReading& out);
+unsigned long soilSensor_frameCount();
+unsigned long soilSensor_overruns();   // DMA frames lost because the task fell behind
+bool soilSensor_usingDma();
+
+// Control loop. Air temperature for drift compensation; NAN = unknown (none applied).
+void soilSensor_setTemperature(float celsius);
+// Takes effect from the next frame; zones sharing a probe share its
+// calibration. Callable before soilSensor_begin() (saved calibration).
+bool soilSensor_setCalibration(uint8_t zone, const SoilCalibration& cal);
+void soilSensor_getCalibration(uint8_t zone, SoilCalibration& out);
+
+#endif
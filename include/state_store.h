@@ -0,0 +1,46 @@
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include <Arduino.h>
+#include "device_state.h"
+#include "soil_calibration.h"
+
+// Control state that has to survive a reboot: per-zone mode, manual status,
+// rule parameters and compiled rule programs. Kept in NVS as one versioned,
+// CRC-checked record and loaded in setup() before networking starts, so
+// control resumes where it left off instead of waiting for the broker to
+// re-deliver retained messages. Saves are debounced: a burst of commands
+// costs one flash write, and an unchanged state is never rewritten.
+//
+// Soil probe calibration has its own record: it changes rarely, so it is
+// not rewritten with every state save, but it goes through the same
+// debounce (a capture session of several points costs one write). The
+// network task also keeps the last access point (BSSID + channel) here for
+// fast WiFi reconnects.
+
+struct StateStoreStats {
+    bool restored;             // boot state came from NVS
+    unsigned long saves;
+    unsigned long unchanged;   // debounced saves skipped because nothing changed
+    unsigned long calibrationSaves;
+    unsigned long lastSaveUs;
+};
+
+// Control loop
+bool stateStore_load();  // applies the saved record to the control state; false = defaults kept
+void stateStore_markDirty(unsigned long now);             // mode, status, rules or programs changed
+void stateStore_markCalibrationDirty(unsigned long now);  // a probe's table changed (soil_sensor.h)
+void stateStore_service(unsigned long now);
+void stateStore_getStats(StateStoreStats& out);
+bool stateStore_loadCalibration(SoilCalibration out[ZONE_COUNT]);  // false = none saved, defaults kept
+
+// Network task
+struct WifiCache {
+    uint8_t bssid[6];
+    uint8_t channel;
+};
+
+bool stateStore_loadWifi(WifiCache& out);
+void stateStore_saveWifi(const WifiCache& cache);
+
+#endif
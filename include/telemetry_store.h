@@ -0,0 +1,61 @@
+#ifndef TELEMETRY_STORE_H
+#define TELEMETRY_STORE_H
+
+#include <Arduino.h>
+
+// Store-and-forward buffer for telemetry taken while the broker is
+// unreachable. Samples go to a small RAM staging area and are flushed in
+// groups to a fixed-size circular file on LittleFS, so flash sees one write
+// per TELEMETRY_STAGING_SAMPLES samples and never rewrites a header. After a
+// reboot the ring is rebuilt by scanning the slot sequence numbers. The drain
+// position is saved debounced (telemetryStore_service), so a reboot may send
+// up to TELEMETRY_TAIL_SAVE_MAX_DELAY_MS worth of drained samples again. Only
+// the network task may call these functions.
+//
+// A sample holds one zone's moisture and pump state next to the shared
+// temperature and humidity, so an offline period costs one slot per zone.
+
+enum TelemetryFlags : uint8_t {
+    TELEMETRY_TS_UPTIME = 1 << 0  // timestamp is seconds since boot, not epoch
+};
+
+struct TelemetrySample {
+    uint32_t timestamp;      // epoch seconds, or uptime seconds with TELEMETRY_TS_UPTIME
+    uint16_t bootId;         // random per boot, to tell which uptime a sample belongs to
+    uint16_t moistureX10;
+    int16_t temperatureX10;
+    uint16_t humidityX10;
+    uint8_t pumpOn;
+    uint8_t flags;
+    uint8_t zone;            // actuator id = ACTUATOR_ID + zone; was padding, so old rings read as zone 0
+};
+
+struct TelemetryStoreStats {
+    uint32_t count;          // samples waiting to be drained
+    uint32_t capacity;
+    uint8_t fillPercent;
+    unsigned long overflowDrops;  // oldest samples overwritten because the ring was full
+    unsigned long corruptSkipped; // slots that failed their CRC while draining
+    unsigned long flashWrites;    // staging flushes
+    unsigned long drained;
+};
+
+bool telemetryStore_begin();
+void telemetryStore_append(const TelemetrySample& sample);
+// Copies up to maxCount of the oldest samples without removing them. The
+// copies are consecutive, so consume(n) removes exactly the first n of them.
+// Slots at the front that fail their CRC are dropped (corruptSkipped);
+// returns 0 while the ring file cannot be read.
+size_t telemetryStore_peek(TelemetrySample* out, size_t maxCount);
+// Drops the count oldest samples once they were delivered.
+void telemetryStore_consume(size_t count);
+void telemetryStore_flush();
+void telemetryStore_service(unsigned long now);  // saves the drain position, debounced
+uint32_t telemetryStore_count();
+void telemetryStore_getStats(TelemetryStoreStats& out);
+
+// Build a sample stamped with the current wall clock (or uptime if not synced yet)
+TelemetrySample telemetryStore_makeSample(uint8_t zone, float temperature, float moisture, float humidity, bool pumpOn);
+uint16_t telemetryStore_bootId();
+
+#endif
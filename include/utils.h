@@ -1,8 +0,0 @@
-#ifndef UTILS_H
-#define UTILS_H
-
-#include <Arduino.h>
-
-int getThresholdByPlantType(String type);
-
-#endif
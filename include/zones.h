@@ -0,0 +1,32 @@
+#ifndef ZONES_H
+#define ZONES_H
+
+#include <Arduino.h>
+#include "device_state.h"
+
+// Per-zone pump control. Wiring, pump cycles (pump_cycle.h) and rules are
+// kept as tables indexed by zone, so a control tick is one linear pass over
+// small arrays; on/off states are packed into ZoneMask words.
+// At most MAX_ACTIVE_PUMPS pumps run at once: zones that want water while
+// the cap is reached wait, and free slots are handed out round-robin so no
+// zone starves. Owned by the control loop on core 1.
+
+extern const uint8_t zoneSoilPin[ZONE_COUNT];   // ZONE_SOIL_PINS
+extern const uint8_t zoneRelayPin[ZONE_COUNT];  // ZONE_RELAY_PINS
+
+struct ZoneStats {
+    unsigned long deferredStarts; // ticks a zone wanted to start but the cap was reached
+    uint8_t maxActive;            // highest number of pumps running at once
+    unsigned long lastTickUs;
+    unsigned long maxTickUs;
+};
+
+void zones_begin();  // relays to outputs, all pumps off
+// Evaluates the zones' rule programs (see rule_engine.h), runs every zone's
+// state machine and drives the relays that changed. Returns the mask of
+// running pumps.
+ZoneMask zones_control(const float moisture[ZONE_COUNT], float temperature, float humidity,
+                       unsigned long now);
+void zones_getStats(ZoneStats& out);
+
+#endif
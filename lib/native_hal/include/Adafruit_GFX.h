@@ -0,0 +1,50 @@
+#ifndef NATIVE_HAL_ADAFRUIT_GFX_H
+#define NATIVE_HAL_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+// Minimal Adafruit_GFX: real geometry for rectangles, lines and bitmaps; text
+// is drawn as one 6x8 cell per character whose columns encode the character,
+// so the frame changes exactly where the text changes. Fonts are not modelled.
+class Adafruit_GFX {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : screenWidth(w), screenHeight(h) {}
+    virtual ~Adafruit_GFX() {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, uint16_t color);
+
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    void setTextSize(uint8_t size) { textSize = size ? size : 1; }
+    void setTextColor(uint16_t color) { textColor = color; }
+    void getTextBounds(const char* text, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h);
+
+    size_t write(uint8_t c);
+    size_t print(const char* s);
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned int v) { return printf("%u", v); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+    size_t println(const char* s = "") { return print(s) + write('\n'); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    int16_t width() const { return screenWidth; }
+    int16_t height() const { return screenHeight; }
+
+protected:
+    int16_t screenWidth;
+    int16_t screenHeight;
+    int16_t cursorX = 0;
+    int16_t cursorY = 0;
+    uint8_t textSize = 1;
+    uint16_t textColor = 1;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef NATIVE_HAL_ADAFRUIT_SSD1306_H
+#define NATIVE_HAL_ADAFRUIT_SSD1306_H
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+
+#define SSD1306_BLACK   0
+#define SSD1306_WHITE   1
+#define SSD1306_INVERSE 2
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_COLUMNADDR   0x21
+#define SSD1306_PAGEADDR     0x22
+
+// Frame buffer in the SSD1306 page layout (one byte = 8 vertical pixels).
+// display() pushes the whole buffer through the Wire model like the library.
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi, int8_t resetPin, uint32_t clkDuring = 400000UL,
+                     uint32_t clkAfter = 100000UL);
+    ~Adafruit_SSD1306();
+
+    bool begin(uint8_t vccState = SSD1306_SWITCHCAPVCC, uint8_t address = 0x3C, bool reset = true,
+               bool periphBegin = true);
+    void clearDisplay();
+    void display();
+    void ssd1306_command(uint8_t c);
+    uint8_t* getBuffer() { return buffer; }
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+
+private:
+    TwoWire* wire;
+    uint8_t address = 0x3C;
+    uint8_t* buffer = nullptr;
+};
+
+#endif
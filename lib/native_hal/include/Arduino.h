@@ -0,0 +1,118 @@
+#ifndef NATIVE_HAL_ARDUINO_H
+#define NATIVE_HAL_ARDUINO_H
+
+// Host stand-in for the Arduino-ESP32 core, limited to what the firmware
+// uses. Time comes from the simulation's virtual clock and the pins from its
+// sensor/actuator models (see sim.h); nothing here touches real hardware.
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+
+#define F(string_literal) (string_literal)
+#define PROGMEM
+#define IRAM_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// Virtual clock
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+int64_t esp_timer_get_time();
+
+// GPIO / ADC, routed to the simulation's pin models
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+int8_t digitalPinToAnalogChannel(uint8_t pin);
+
+uint32_t esp_random(); // same sequence on every run
+void configTzTime(const char* tz, const char* server1, const char* server2 = nullptr,
+                  const char* server3 = nullptr);
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+class String {
+public:
+    String(const char* s = "") : value(s ? s : "") {}
+    String(const std::string& s) : value(s) {}
+    explicit String(int v) : value(std::to_string(v)) {}
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.size(); }
+    bool operator==(const String& o) const { return value == o.value; }
+    bool operator==(const char* o) const { return value == (o ? o : ""); }
+    bool operator!=(const String& o) const { return value != o.value; }
+    bool operator!=(const char* o) const { return !(*this == o); }
+    String& operator+=(const String& o) { value += o.value; return *this; }
+    String& operator+=(const char* o) { value += (o ? o : ""); return *this; }
+    String& operator+=(char c) { value += c; return *this; }
+    String operator+(const String& o) const { return String(value + o.value); }
+    char operator[](unsigned int i) const { return i < value.size() ? value[i] : '\0'; }
+    void toLowerCase() { for (char& c : value) c = tolower((unsigned char)c); }
+
+private:
+    std::string value;
+};
+
+// Output is discarded unless sim_setSerialEcho(true); see sim.h
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t len);
+    size_t print(const char* s) { return write(reinterpret_cast<const uint8_t*>(s), strlen(s)); }
+    size_t println(const char* s = "") { return print(s) + print("\n"); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
+
+// Cycle counter at SIM_CPU_FREQ_MHZ, derived from the host's monotonic clock,
+// so cycle-based measurements report real host work and not virtual time
+#define SIM_CPU_FREQ_MHZ 240
+
+class EspClass {
+public:
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz() { return SIM_CPU_FREQ_MHZ; }
+    void restart();
+};
+
+extern EspClass ESP;
+
+// Sketch entry points, provided by src/main.cpp
+void setup();
+void loop();
+
+#endif
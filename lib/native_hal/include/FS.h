@@ -0,0 +1,33 @@
+#ifndef NATIVE_HAL_FS_H
+#define NATIVE_HAL_FS_H
+
+#include <Arduino.h>
+#include <vector>
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+// Handle of a file in the simulated flash (see LittleFS.h). A default
+// constructed one is a file that could not be opened. The handle points
+// into the filesystem: removing the file while it is open is not supported.
+class File {
+public:
+    File() : data(nullptr), pos(0), writable(false) {}
+    File(std::vector<uint8_t>* file, bool canWrite, size_t start) : data(file), pos(start), writable(canWrite) {}
+
+    explicit operator bool() const { return data != nullptr; }
+    size_t size() const { return data ? data->size() : 0; }
+    size_t position() const { return pos; }
+    bool seek(uint32_t offset, SeekMode mode = SeekSet);
+    size_t read(uint8_t* buf, size_t len);
+    size_t write(const uint8_t* buf, size_t len);
+    int available() { return data ? (int)(data->size() - pos) : 0; }
+    void flush() {}
+    void close() { data = nullptr; }
+
+private:
+    std::vector<uint8_t>* data;
+    size_t pos;
+    bool writable;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef NATIVE_HAL_LITTLEFS_H
+#define NATIVE_HAL_LITTLEFS_H
+
+#include <FS.h>
+
+// Flash filesystem kept in host memory. By default there is no partition:
+// mounting fails, and the telemetry backlog and history stores run in their
+// RAM-only mode. sim_setFilesystemAvailable() (sim.h) adds one.
+class LittleFSFS {
+public:
+    bool begin(bool formatOnFail = false);
+    File open(const char* path, const char* mode = "r"); // "r", "r+", "w" or "a"
+    bool exists(const char* path);
+    bool remove(const char* path);
+    size_t totalBytes();
+    size_t usedBytes();
+};
+
+extern LittleFSFS LittleFS;
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef NATIVE_HAL_PREFERENCES_H
+#define NATIVE_HAL_PREFERENCES_H
+
+#include <Arduino.h>
+
+// NVS in host memory. Like the real partition, opening a namespace that was
+// never written fails in read-only mode. sim_resetPreferences() (sim.h)
+// erases everything.
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+private:
+    std::string key(const char* name) const;
+
+    std::string space;
+    bool opened = false;
+    bool readOnly = false;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef NATIVE_HAL_WIRE_H
+#define NATIVE_HAL_WIRE_H
+
+#include <Arduino.h>
+
+#define I2C_BUFFER_LENGTH 128
+
+// I2C master that accepts every transfer and only counts the bytes, so the
+// display's partial-update cost shows up in the simulation's statistics
+class TwoWire {
+public:
+    bool begin() { return true; }
+    bool setClock(uint32_t hz) { clockHz = hz; return true; }
+    void beginTransmission(uint8_t address) { (void)address; pending = 1; }
+    size_t write(uint8_t data) { (void)data; pending++; return 1; }
+    size_t write(const uint8_t* data, size_t len) { (void)data; pending += len; return len; }
+    uint8_t endTransmission(bool sendStop = true);
+
+    unsigned long transactions() const { return transactionCount; }
+    unsigned long bytesSent() const { return byteCount; }
+
+private:
+    uint32_t clockHz = 100000;
+    size_t pending = 0;
+    unsigned long transactionCount = 0;
+    unsigned long byteCount = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef NATIVE_HAL_SIM_H
+#define NATIVE_HAL_SIM_H
+
+#include <Arduino.h>
+
+// Simulation harness for the host build (env:native).
+//
+// The firmware runs unmodified on a virtual clock. Every FreeRTOS task is a
+// cooperative coroutine and the Arduino loop task is the caller of
+// sim_begin(); a task runs until it blocks (delay, vTaskDelay, a notify
+// wait), and the clock then jumps straight to the next wake-up. Code between
+// two blocking calls takes no virtual time, so a simulated day runs in
+// seconds, and every run with the same inputs takes the same decisions.
+//
+// Host CPU time is still measured per task, so the cost of the real code
+// can be reported per simulated hour. The profiler (profiler.h) and
+// ESP.getCycleCount() also measure host time.
+
+// --- Clock and tasks ---
+
+void sim_begin();               // call once, before setup(); the caller becomes "loopTask"
+uint64_t sim_micros();
+void sim_runFor(unsigned long ms); // runs loop() until ms of virtual time have passed
+
+struct SimTaskStats {
+    const char* name;
+    unsigned long wakeups;
+    uint64_t busyNs;   // host CPU time spent running this task
+};
+
+uint8_t sim_taskCount();
+bool sim_taskStats(uint8_t index, SimTaskStats& out);
+bool sim_findTask(const char* name, SimTaskStats& out);
+uint64_t sim_hostNs();          // host monotonic clock, for wall-time budgets
+
+// --- Pins ---
+
+// Returns the ADC counts (0..4095) the pin reads at the current virtual time
+typedef uint16_t (*SimAnalogSource)(uint8_t pin);
+// Called on every digitalWrite() that changes a pin, before the level changes
+typedef void (*SimPinListener)(uint8_t pin, uint8_t level);
+
+void sim_setAnalogSource(SimAnalogSource source);   // default: mid-scale
+void sim_setPinListener(SimPinListener listener);
+uint8_t sim_pinLevel(uint8_t pin);
+unsigned long sim_pinWrites(uint8_t pin);           // digitalWrite() calls that changed the level
+
+// --- DHT22 ---
+
+// Fills the current air temperature and humidity; false = sensor not answering
+typedef bool (*SimDhtSource)(float& temperature, float& humidity);
+
+void sim_setDhtSource(SimDhtSource source);         // default: 25 C, 60 %
+
+// --- Network ---
+
+// Simulated access point and broker, both down by default (offline device).
+// The broker speaks MQTT 3.1.1 to mqtt_async.cpp through mqttLink_* and
+// keeps the client's persistent session across connections.
+void sim_setWifiAvailable(bool available);
+void sim_setBrokerAvailable(bool available);   // false also breaks the open connection
+void sim_setBrokerAcks(bool acks);             // false: QoS 1 publishes go unacknowledged
+
+typedef void (*SimPublishListener)(const char* topic, const uint8_t* payload, size_t len, bool retained);
+
+void sim_setPublishListener(SimPublishListener listener);
+unsigned long sim_mqttPublishCount();
+unsigned long sim_mqttDuplicateCount();        // publishes received with DUP set
+// A message from another client. Sent right away to a connected subscriber
+// (waking mqttAsync_wait()); held in the session for an offline one that
+// subscribed at QoS 1; dropped when nothing subscribes to the topic.
+void sim_mqttInject(const char* topic, const char* payload);
+
+// --- Flash filesystem ---
+
+// No LittleFS partition by default (the stores run RAM-only). Files live in
+// host memory and survive a new setup(), like flash across a reboot.
+void sim_setFilesystemAvailable(bool available);     // takes effect on the next LittleFS.begin()
+void sim_resetFilesystem();                          // erases every file
+bool sim_corruptFile(const char* path, size_t offset); // flips one byte; false if out of range
+
+// --- Misc ---
+
+void sim_setSerialEcho(bool echo);                  // copy Serial output to stdout
+unsigned long sim_serialBytes();
+void sim_resetPreferences();
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef NATIVE_HAL_SIM_PLANT_H
+#define NATIVE_HAL_SIM_PLANT_H
+
+#include "sim.h"
+
+// Plant and weather model behind the simulated pins (see sim.h).
+//
+// Each zone is a bucket of soil water: evapotranspiration drains it faster
+// when it is hot and dry, and pumped water first pools and then soaks in
+// with a time constant, which is what makes a controller overshoot. The
+// probe reads the inverse of the firmware's default raw-to-percent mapping
+// plus noise and optional relay switching spikes; a real probe's range,
+// curvature and temperature drift can be set per zone. Alternatively a recorded trace
+// can drive moisture and air open-loop.
+
+#define SIM_PLANT_MAX_ZONES 8
+
+struct SimSoilParams {
+    float initialMoisture;     // %
+    float dryRatePerHour;      // % per hour at 25 C / 50 % RH
+    float pumpRatePerMinute;   // % per minute of pumping, once soaked in
+    float soakTimeS;           // infiltration time constant
+    uint16_t noiseCounts;      // uniform +/- ADC noise
+    uint16_t spikeEvery;       // every Nth sample reads spikeCounts drier (0 = never)
+    uint16_t spikeCounts;
+    uint16_t dryCounts;        // probe reading at 0 % and 25 C (default 4095)
+    uint16_t wetCounts;        // ... at 100 % (default 0)
+    float curve;               // 0 = linear; > 0 bows the response toward the wet end
+    float countsPerC;          // drift with the air temperature, away from 25 C
+};
+
+struct SimWeather {
+    float meanTemperature;     // C
+    float temperatureSwing;    // +/- over the day, warmest at 15:00
+    float meanHumidity;        // %
+    float humiditySwing;       // +/- over the day, driest at 15:00
+    float startHour;           // local hour of day at sim time 0
+};
+
+struct SimTracePoint {
+    uint32_t timeS;            // since the start of the simulation
+    float moisture;            // %
+    float temperature;         // C
+    float humidity;            // %
+};
+
+struct SimZoneStats {
+    float moisture;            // true soil moisture now
+    float minMoisture;         // since the last reset
+    float maxMoisture;
+    unsigned long pumpStarts;
+    uint64_t pumpOnMs;
+    uint32_t shortestRunMs;    // completed runs only
+    uint32_t longestRunMs;
+    float waterApplied;        // % moisture equivalent
+    float waterLost;           // % lost to evapotranspiration
+};
+
+SimSoilParams simPlant_defaultSoil();
+SimWeather simPlant_defaultWeather();
+
+// Installs the analog, relay and DHT hooks; call after sim_begin()
+void simPlant_begin(const SimWeather& weather);
+// Returns the zone index, or -1 if SIM_PLANT_MAX_ZONES are in use
+int8_t simPlant_addZone(uint8_t soilPin, uint8_t relayPin, const SimSoilParams& params);
+// Open loop: moisture of every zone and the air follow the trace (linear
+// interpolation, last point held); the pumps have no effect on it
+void simPlant_playTrace(const SimTracePoint* points, size_t count);
+// "time_s,moisture,temperature,humidity" lines, '#' comments and a header
+// are skipped; returns the number of points read
+size_t simTrace_loadCsv(const char* path, SimTracePoint* out, size_t maxPoints);
+
+void simPlant_zoneStats(uint8_t zone, SimZoneStats& out);
+void simPlant_resetStats(); // e.g. after a warm-up period
+void simPlant_air(float& temperature, float& humidity);
+
+#endif
@@ -0,0 +1,131 @@
+#include "sim.h"
+
+#define SIM_PIN_COUNT 40 // GPIO0..39 on the ESP32
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static uint8_t pinLevels[SIM_PIN_COUNT];
+static unsigned long pinWrites[SIM_PIN_COUNT];
+static SimPinListener pinListener = nullptr;
+
+static uint16_t midScale(uint8_t pin) {
+    (void)pin;
+    return 2048;
+}
+
+static SimAnalogSource analogSource = midScale;
+static bool serialEcho = false;
+static unsigned long serialBytes = 0;
+static uint32_t randomState = 0x2545F491;
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size != 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin >= SIM_PIN_COUNT) return;
+    uint8_t level = val ? HIGH : LOW;
+    if (pinLevels[pin] == level) return;
+    if (pinListener != nullptr) pinListener(pin, level);
+    pinLevels[pin] = level;
+    pinWrites[pin]++;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < SIM_PIN_COUNT ? pinLevels[pin] : LOW;
+}
+
+uint16_t analogRead(uint8_t pin) {
+    uint16_t counts = analogSource(pin);
+    return counts > 4095 ? 4095 : counts;
+}
+
+void analogReadResolution(uint8_t bits) {
+    (void)bits; // always 12 bits, like the firmware configures it
+}
+
+int8_t digitalPinToAnalogChannel(uint8_t pin) {
+    // ADC1: GPIO36..39 are channels 0..3, GPIO32..35 channels 4..7
+    if (pin >= 36 && pin <= 39) return pin - 36;
+    if (pin >= 32 && pin <= 35) return pin - 28;
+    return -1;
+}
+
+uint32_t esp_random() {
+    // xorshift32: the same sequence on every run
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+void configTzTime(const char* tz, const char* server1, const char* server2, const char* server3) {
+    (void)server1;
+    (void)server2;
+    (void)server3;
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len) {
+    serialBytes += len;
+    if (serialEcho) fwrite(data, 1, len, stdout);
+    return len;
+}
+
+size_t HardwareSerial::printf(const char* fmt, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n < 0) return 0;
+    return write(reinterpret_cast<const uint8_t*>(line), (size_t)n < sizeof(line) ? n : sizeof(line) - 1);
+}
+
+void EspClass::restart() {
+    fprintf(stderr, "sim: ESP.restart() called at %lu ms\n", millis());
+    abort();
+}
+
+void sim_setAnalogSource(SimAnalogSource source) {
+    analogSource = source ? source : midScale;
+}
+
+void sim_setPinListener(SimPinListener listener) {
+    pinListener = listener;
+}
+
+uint8_t sim_pinLevel(uint8_t pin) {
+    return pin < SIM_PIN_COUNT ? pinLevels[pin] : LOW;
+}
+
+unsigned long sim_pinWrites(uint8_t pin) {
+    return pin < SIM_PIN_COUNT ? pinWrites[pin] : 0;
+}
+
+void sim_setSerialEcho(bool echo) {
+    serialEcho = echo;
+}
+
+unsigned long sim_serialBytes() {
+    return serialBytes;
+}
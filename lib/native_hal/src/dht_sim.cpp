@@ -0,0 +1,75 @@
+#include "dht_reader.h"
+#include "config.h"
+#include "mem_diag.h"
+#include "sim.h"
+
+// Host replacement for src/dht_reader.cpp (excluded from env:native): the
+// same API and reader task cadence, with frames taken from the simulation's
+// DHT source instead of the RMT capture.
+
+#define DHT_FRAME_MS 5 // start pulse + 40-bit response on the wire
+
+static bool defaultSource(float& temperature, float& humidity) {
+    temperature = 25.0f;
+    humidity = 60.0f;
+    return true;
+}
+
+static SimDhtSource source = defaultSource;
+static DhtReading latest = {};
+static DhtCallback readingCallback = nullptr;
+static DhtStats stats = {};
+static bool started = false;
+
+static void readOnce() {
+    vTaskDelay(pdMS_TO_TICKS(DHT_FRAME_MS));
+    float temperature, humidity;
+    if (!source(temperature, humidity)) {
+        stats.timeouts++;
+        return;
+    }
+    stats.reads++;
+    // The sensor reports tenths
+    latest.temperature = roundf(temperature * 10) * 0.1f;
+    latest.humidity = roundf(constrain(humidity, 0.0f, 100.0f) * 10) * 0.1f;
+    latest.timestamp = millis();
+    latest.valid = true;
+    if (readingCallback) readingCallback(latest);
+}
+
+static void readerTask(void* arg) {
+    memDiag_registerCurrentTask();
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        readOnce();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(DHT_READ_PERIOD_MS));
+    }
+}
+
+bool dhtReader_begin(int pin) {
+    (void)pin;
+    started = true;
+    xTaskCreatePinnedToCore(readerTask, "dht", DHT_TASK_STACK, nullptr, DHT_TASK_PRIORITY, nullptr, DHT_TASK_CORE);
+    return true;
+}
+
+bool dhtReader_latest(DhtReading& out) {
+    if (!started || !latest.valid) {
+        out = DhtReading();
+        return false;
+    }
+    out = latest;
+    return true;
+}
+
+void dhtReader_setCallback(DhtCallback callback) {
+    readingCallback = callback;
+}
+
+void dhtReader_getStats(DhtStats& out) {
+    out = stats;
+}
+
+void sim_setDhtSource(SimDhtSource s) {
+    source = s ? s : defaultSource;
+}
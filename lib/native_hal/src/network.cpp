@@ -0,0 +1,361 @@
+#include <WiFi.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "mqtt_link.h"
+#include "sim.h"
+
+// Simulated access point and broker. Association takes a full scan unless
+// the station asks for the AP's BSSID on its channel.
+#define SIM_WIFI_SCAN_MS    2500
+#define SIM_WIFI_FAST_MS    300
+#define SIM_WIFI_CHANNEL    6
+
+WiFiClass WiFi;
+
+static const uint8_t AP_BSSID[6] = { 0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56 };
+
+static bool apAvailable = false;
+static bool brokerAvailable = false;
+static bool associating = false;
+static bool associated = false;
+static unsigned long associatedAt = 0;
+static uint8_t bssid[6];
+
+struct InjectedMessage {
+    std::string topic;
+    std::string payload;
+};
+
+// The broker keeps one persistent session (the firmware's fixed client id):
+// its subscriptions and the QoS 1 messages that arrive while it is offline
+struct BrokerSession {
+    bool exists;
+    std::vector<std::string> filters;
+    std::vector<uint8_t> qos;
+    std::deque<InjectedMessage> pending;
+};
+
+static BrokerSession session;
+static bool brokerAcks = true;
+static SimPublishListener publishListener = nullptr;
+static unsigned long publishCount = 0;
+static unsigned long duplicateCount = 0;
+
+// The client's end of the connection
+static MqttLinkState linkState = LINK_CLOSED;
+static bool sessionUp = false;               // CONNECT accepted on this connection
+static std::vector<uint8_t> toBroker;        // bytes not yet parsed by the broker
+static std::deque<uint8_t> toClient;
+static uint16_t brokerPacketId = 1;
+static TaskHandle_t waitingTask = nullptr;
+
+// --- WiFi ---
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel, const uint8_t* target,
+                             bool connect) {
+    (void)ssid;
+    (void)passphrase;
+    associated = false;
+    associating = connect;
+    bool fast = channel == SIM_WIFI_CHANNEL && target != nullptr && memcmp(target, AP_BSSID, 6) == 0;
+    associatedAt = millis() + (fast ? SIM_WIFI_FAST_MS : SIM_WIFI_SCAN_MS);
+    return WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::status() {
+    if (!apAvailable) {
+        bool lost = associated;
+        associated = false;
+        return lost ? WL_CONNECTION_LOST : WL_DISCONNECTED;
+    }
+    if (associating && (long)(millis() - associatedAt) >= 0) {
+        associating = false;
+        associated = true;
+        memcpy(bssid, AP_BSSID, sizeof(bssid));
+    }
+    return associated ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp) {
+    (void)wifiOff;
+    (void)eraseAp;
+    associating = false;
+    associated = false;
+    return true;
+}
+
+bool WiFiClass::config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1) {
+    (void)local;
+    (void)gateway;
+    (void)subnet;
+    (void)dns1;
+    return true;
+}
+
+uint8_t* WiFiClass::BSSID() {
+    return associated ? bssid : nullptr;
+}
+
+int32_t WiFiClass::channel() {
+    return associated ? SIM_WIFI_CHANNEL : 0;
+}
+
+IPAddress WiFiClass::localIP() {
+    return associated ? IPAddress(192, 168, 1, 50) : IPAddress();
+}
+
+// --- MQTT ---
+// An in-process broker behind the mqttLink_* byte stream, so mqtt_async.cpp
+// runs unmodified: it parses the client's packets and answers them the way
+// a 3.1.1 broker does. The connection breaks as soon as the AP or the
+// broker goes away.
+
+// MQTT filter match with the '+' and '#' wildcards
+static bool topicMatches(const char* filter, const char* topic) {
+    while (*filter) {
+        if (*filter == '#') return true;
+        if (*filter == '+') {
+            while (*topic && *topic != '/') topic++;
+            filter++;
+            continue;
+        }
+        if (*filter != *topic) return false;
+        filter++;
+        topic++;
+    }
+    return *topic == '\0';
+}
+
+static void wakeClient() {
+    if (waitingTask != nullptr) xTaskNotifyGive(waitingTask);
+}
+
+static void sendToClient(const uint8_t* data, size_t len) {
+    toClient.insert(toClient.end(), data, data + len);
+    wakeClient();
+}
+
+static void sendPublish(const InjectedMessage& message, uint8_t qos) {
+    std::vector<uint8_t> packet;
+    size_t remaining = 2 + message.topic.size() + (qos ? 2 : 0) + message.payload.size();
+    packet.push_back(0x30 | (qos ? 0x02 : 0));
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        packet.push_back(digit | (remaining ? 0x80 : 0));
+    } while (remaining);
+    packet.push_back(message.topic.size() >> 8);
+    packet.push_back(message.topic.size() & 0xFF);
+    packet.insert(packet.end(), message.topic.begin(), message.topic.end());
+    if (qos) {
+        uint16_t id = brokerPacketId++;
+        if (brokerPacketId == 0) brokerPacketId = 1;
+        packet.push_back(id >> 8);
+        packet.push_back(id & 0xFF);
+    }
+    packet.insert(packet.end(), message.payload.begin(), message.payload.end());
+    sendToClient(packet.data(), packet.size());
+}
+
+// Highest QoS among the session's matching filters, -1 if none matches
+static int subscribedQos(const std::string& topic) {
+    int best = -1;
+    for (size_t i = 0; i < session.filters.size(); i++) {
+        if (topicMatches(session.filters[i].c_str(), topic.c_str()) && session.qos[i] > best) best = session.qos[i];
+    }
+    return best;
+}
+
+static bool linkAlive() {
+    if (linkState != LINK_OPEN && linkState != LINK_CONNECTING) return false;
+    if (WiFi.status() == WL_CONNECTED && brokerAvailable) return true;
+    linkState = LINK_FAILED;
+    sessionUp = false;
+    return false;
+}
+
+static void handleConnect(const uint8_t* body, size_t len) {
+    // Protocol name (6) + level + flags + keepalive, then the client id
+    if (len < 10) {
+        linkState = LINK_FAILED;
+        return;
+    }
+    bool clean = body[7] & 0x02;
+    if (clean) {
+        session = BrokerSession();
+    }
+    uint8_t connack[] = { 0x20, 2, (uint8_t)(session.exists ? 1 : 0), 0 };
+    session.exists = !clean;
+    sessionUp = true;
+    sendToClient(connack, sizeof(connack));
+    while (!session.pending.empty()) {
+        sendPublish(session.pending.front(), 1);
+        session.pending.pop_front();
+    }
+}
+
+static void handleSubscribe(const uint8_t* body, size_t len) {
+    if (len < 2) return;
+    std::vector<uint8_t> suback = { 0x90, 0, body[0], body[1] };
+    for (size_t i = 2; i + 2 < len;) {
+        size_t filterLen = (body[i] << 8) | body[i + 1];
+        if (i + 2 + filterLen >= len) break;
+        std::string filter(reinterpret_cast<const char*>(body + i + 2), filterLen);
+        uint8_t qos = body[i + 2 + filterLen] > 1 ? 1 : body[i + 2 + filterLen];
+        bool known = false;
+        for (size_t f = 0; f < session.filters.size(); f++) {
+            if (session.filters[f] != filter) continue;
+            session.qos[f] = qos;
+            known = true;
+        }
+        if (!known) {
+            session.filters.push_back(filter);
+            session.qos.push_back(qos);
+        }
+        suback.push_back(qos);
+        i += 2 + filterLen + 1;
+    }
+    suback[1] = suback.size() - 2;
+    sendToClient(suback.data(), suback.size());
+}
+
+static void handlePublish(uint8_t flags, const uint8_t* body, size_t len) {
+    uint8_t qos = (flags >> 1) & 0x03;
+    if (len < 2) return;
+    size_t topicLen = (body[0] << 8) | body[1];
+    size_t offset = 2 + topicLen + (qos ? 2 : 0);
+    if (offset > len) return;
+    std::string topic(reinterpret_cast<const char*>(body + 2), topicLen);
+    publishCount++;
+    if (flags & 0x08) duplicateCount++;
+    if (publishListener != nullptr) publishListener(topic.c_str(), body + offset, len - offset, flags & 0x01);
+    if (qos && brokerAcks) {
+        uint8_t puback[] = { 0x40, 2, body[2 + topicLen], body[3 + topicLen] };
+        sendToClient(puback, sizeof(puback));
+    }
+}
+
+// Runs every complete packet the client has written
+static void brokerReceive() {
+    for (;;) {
+        if (toBroker.size() < 2) return;
+        size_t remaining = 0;
+        size_t n = 1;
+        for (uint8_t shift = 0;; shift += 7) {
+            if (n >= toBroker.size()) return;
+            remaining |= (size_t)(toBroker[n] & 0x7F) << shift;
+            if (!(toBroker[n++] & 0x80)) break;
+        }
+        if (toBroker.size() < n + remaining) return;
+        uint8_t header = toBroker[0];
+        const uint8_t* body = toBroker.data() + n;
+        if (!sessionUp && (header & 0xF0) != 0x10) {
+            linkState = LINK_FAILED; // anything before CONNECT is a protocol error
+            return;
+        }
+        switch (header & 0xF0) {
+            case 0x10: handleConnect(body, remaining); break;
+            case 0x30: handlePublish(header & 0x0F, body, remaining); break;
+            case 0x40: break; // PUBACK for our QoS 1 deliveries
+            case 0x80: handleSubscribe(body, remaining); break;
+            case 0xC0: {
+                static const uint8_t pingresp[] = { 0xD0, 0 };
+                sendToClient(pingresp, sizeof(pingresp));
+                break;
+            }
+            case 0xE0:
+                linkState = LINK_FAILED;
+                sessionUp = false;
+                break;
+            default:
+                linkState = LINK_FAILED;
+                break;
+        }
+        toBroker.erase(toBroker.begin(), toBroker.begin() + n + remaining);
+        if (linkState == LINK_FAILED) {
+            sessionUp = false;
+            return;
+        }
+    }
+}
+
+bool mqttLink_open(const char* host, uint16_t port) {
+    (void)host;
+    (void)port;
+    mqttLink_close();
+    if (WiFi.status() != WL_CONNECTED) return false;
+    linkState = LINK_CONNECTING;
+    return true;
+}
+
+MqttLinkState mqttLink_poll() {
+    if (linkState == LINK_CONNECTING) linkState = brokerAvailable ? LINK_OPEN : LINK_FAILED;
+    linkAlive();
+    return linkState;
+}
+
+int mqttLink_send(const uint8_t* data, size_t len) {
+    if (linkState != LINK_OPEN || !linkAlive()) return -1;
+    toBroker.insert(toBroker.end(), data, data + len);
+    brokerReceive();
+    return linkState == LINK_OPEN ? (int)len : -1;
+}
+
+int mqttLink_recv(uint8_t* data, size_t len) {
+    if (linkState != LINK_OPEN || !linkAlive()) return -1;
+    size_t n = 0;
+    while (n < len && !toClient.empty()) {
+        data[n++] = toClient.front();
+        toClient.pop_front();
+    }
+    return n;
+}
+
+void mqttLink_wait(uint32_t timeoutMs) {
+    if (linkState == LINK_OPEN && !toClient.empty()) return;
+    waitingTask = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+    waitingTask = nullptr;
+}
+
+void mqttLink_close() {
+    linkState = LINK_CLOSED;
+    sessionUp = false;
+    toBroker.clear();
+    toClient.clear();
+}
+
+// --- Harness ---
+
+void sim_setWifiAvailable(bool available) {
+    apAvailable = available;
+}
+
+void sim_setBrokerAvailable(bool available) {
+    brokerAvailable = available;
+}
+
+void sim_setPublishListener(SimPublishListener listener) {
+    publishListener = listener;
+}
+
+unsigned long sim_mqttPublishCount() {
+    return publishCount;
+}
+
+unsigned long sim_mqttDuplicateCount() {
+    return duplicateCount;
+}
+
+void sim_setBrokerAcks(bool acks) {
+    brokerAcks = acks;
+}
+
+void sim_mqttInject(const char* topic, const char* payload) {
+    InjectedMessage message{ topic, payload };
+    int qos = subscribedQos(message.topic);
+    if (qos < 0) return;
+    if (sessionUp && linkAlive()) sendPublish(message, qos);
+    else if (qos > 0) session.pending.push_back(message);
+}
@@ -0,0 +1,341 @@
+#include <Adafruit_SSD1306.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <Wire.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include "driver/adc.h"
+#include "sim.h"
+
+TwoWire Wire;
+LittleFSFS LittleFS;
+
+// --- I2C ---
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    transactionCount++;
+    byteCount += pending;
+    pending = 0;
+    return 0;
+}
+
+// --- Adafruit_GFX ---
+
+void Adafruit_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    for (int16_t i = 0; i < w; i++) drawPixel(x + i, y, color);
+}
+
+void Adafruit_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    for (int16_t i = 0; i < h; i++) drawPixel(x, y + i, color);
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for (int16_t i = 0; i < w; i++) drawFastVLine(x + i, y, h, color);
+}
+
+void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, uint16_t color) {
+    int16_t byteWidth = (w + 7) / 8;
+    for (int16_t j = 0; j < h; j++) {
+        for (int16_t i = 0; i < w; i++) {
+            if (bitmap[j * byteWidth + i / 8] & (0x80 >> (i & 7))) drawPixel(x + i, y + j, color);
+        }
+    }
+}
+
+void Adafruit_GFX::getTextBounds(const char* text, int16_t x, int16_t y, int16_t* x1, int16_t* y1,
+                                 uint16_t* w, uint16_t* h) {
+    size_t longest = 0, line = 0, lines = 1;
+    for (const char* c = text; *c; c++) {
+        if (*c == '\n') {
+            lines++;
+            line = 0;
+        } else if (++line > longest) {
+            longest = line;
+        }
+    }
+    *x1 = x;
+    *y1 = y;
+    *w = longest * 6 * textSize;
+    *h = lines * 8 * textSize;
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+    if (c == '\n') {
+        cursorX = 0;
+        cursorY += 8 * textSize;
+        return 1;
+    }
+    // 5 columns derived from the character code, 1 blank column
+    for (int16_t col = 0; col < 6; col++) {
+        uint8_t bits = col < 5 ? (uint8_t)(c * (col + 3)) : 0;
+        for (int16_t row = 0; row < 8; row++) {
+            uint16_t color = (bits >> row) & 1 ? textColor : SSD1306_BLACK;
+            fillRect(cursorX + col * textSize, cursorY + row * textSize, textSize, textSize, color);
+        }
+    }
+    cursorX += 6 * textSize;
+    return 1;
+}
+
+size_t Adafruit_GFX::print(const char* s) {
+    size_t n = 0;
+    while (*s) n += write((uint8_t)*s++);
+    return n;
+}
+
+size_t Adafruit_GFX::printf(const char* fmt, ...) {
+    char text[64];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    return print(text);
+}
+
+// --- SSD1306 ---
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi, int8_t resetPin, uint32_t clkDuring,
+                                   uint32_t clkAfter)
+    : Adafruit_GFX(w, h), wire(twi) {
+    (void)resetPin;
+    (void)clkDuring;
+    (void)clkAfter;
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+    free(buffer);
+}
+
+bool Adafruit_SSD1306::begin(uint8_t vccState, uint8_t i2cAddress, bool reset, bool periphBegin) {
+    (void)vccState;
+    (void)reset;
+    (void)periphBegin;
+    address = i2cAddress;
+    if (buffer == nullptr) buffer = static_cast<uint8_t*>(malloc(screenWidth * ((screenHeight + 7) / 8)));
+    if (buffer == nullptr) return false;
+    clearDisplay();
+    return true;
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+    memset(buffer, 0, screenWidth * ((screenHeight + 7) / 8));
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (buffer == nullptr || x < 0 || y < 0 || x >= screenWidth || y >= screenHeight) return;
+    uint8_t& b = buffer[x + (y / 8) * screenWidth];
+    uint8_t bit = 1 << (y & 7);
+    switch (color) {
+        case SSD1306_WHITE:   b |= bit; break;
+        case SSD1306_BLACK:   b &= ~bit; break;
+        case SSD1306_INVERSE: b ^= bit; break;
+    }
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
+    wire->beginTransmission(address);
+    wire->write((uint8_t)0x00);
+    wire->write(c);
+    wire->endTransmission();
+}
+
+void Adafruit_SSD1306::display() {
+    size_t total = screenWidth * ((screenHeight + 7) / 8);
+    for (size_t i = 0; i < total; i += I2C_BUFFER_LENGTH - 1) {
+        wire->beginTransmission(address);
+        wire->write((uint8_t)0x40);
+        wire->write(buffer + i, std::min(total - i, (size_t)I2C_BUFFER_LENGTH - 1));
+        wire->endTransmission();
+    }
+}
+
+// --- ADC DMA: not available on the host ---
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* config) {
+    (void)config;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* config) {
+    (void)config;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t adc_digi_start() {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t adc_digi_stop() {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t adc_digi_deinitialize() {
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length, uint32_t* outLength, uint32_t timeoutMs) {
+    (void)buf;
+    (void)length;
+    (void)timeoutMs;
+    *outLength = 0;
+    return ESP_ERR_INVALID_STATE;
+}
+
+// --- NVS ---
+
+static std::map<std::string, std::vector<uint8_t>>& nvs() {
+    static std::map<std::string, std::vector<uint8_t>> entries;
+    return entries;
+}
+
+std::string Preferences::key(const char* name) const {
+    return space + '/' + name;
+}
+
+bool Preferences::begin(const char* name, bool readOnlyMode, const char* partitionLabel) {
+    (void)partitionLabel;
+    space = name;
+    readOnly = readOnlyMode;
+    // Read-only opens fail until the namespace holds at least one key
+    opened = !readOnly || nvs().lower_bound(space + '/') != nvs().lower_bound(space + '0');
+    return opened;
+}
+
+void Preferences::end() {
+    opened = false;
+}
+
+bool Preferences::clear() {
+    if (!opened || readOnly) return false;
+    nvs().erase(nvs().lower_bound(space + '/'), nvs().lower_bound(space + '0'));
+    return true;
+}
+
+bool Preferences::remove(const char* name) {
+    return opened && !readOnly && nvs().erase(key(name)) == 1;
+}
+
+bool Preferences::isKey(const char* name) {
+    return opened && nvs().count(key(name)) == 1;
+}
+
+size_t Preferences::putBytes(const char* name, const void* value, size_t len) {
+    if (!opened || readOnly || value == nullptr || len == 0) return 0;
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    nvs()[key(name)].assign(bytes, bytes + len);
+    return len;
+}
+
+size_t Preferences::getBytesLength(const char* name) {
+    if (!opened) return 0;
+    auto it = nvs().find(key(name));
+    return it == nvs().end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* name, void* buf, size_t maxLen) {
+    size_t len = getBytesLength(name);
+    if (len == 0 || buf == nullptr || len > maxLen) return 0;
+    memcpy(buf, nvs()[key(name)].data(), len);
+    return len;
+}
+
+void sim_resetPreferences() {
+    nvs().clear();
+}
+
+// --- LittleFS ---
+
+static const size_t FLASH_PARTITION_BYTES = 1536 * 1024;
+static bool filesystemAvailable = false;
+static bool filesystemMounted = false;
+
+static std::map<std::string, std::vector<uint8_t>>& files() {
+    static std::map<std::string, std::vector<uint8_t>> entries;
+    return entries;
+}
+
+bool File::seek(uint32_t offset, SeekMode mode) {
+    if (!data) return false;
+    size_t base = mode == SeekSet ? 0 : mode == SeekCur ? pos : data->size();
+    if (base + offset > data->size()) return false;
+    pos = base + offset;
+    return true;
+}
+
+size_t File::read(uint8_t* buf, size_t len) {
+    if (!data || pos >= data->size()) return 0;
+    size_t n = std::min(len, data->size() - pos);
+    memcpy(buf, data->data() + pos, n);
+    pos += n;
+    return n;
+}
+
+size_t File::write(const uint8_t* buf, size_t len) {
+    if (!data || !writable) return 0;
+    if (pos + len > data->size()) data->resize(pos + len);
+    memcpy(data->data() + pos, buf, len);
+    pos += len;
+    return len;
+}
+
+bool LittleFSFS::begin(bool formatOnFail) {
+    (void)formatOnFail;
+    filesystemMounted = filesystemAvailable;
+    return filesystemMounted;
+}
+
+File LittleFSFS::open(const char* path, const char* mode) {
+    if (!filesystemMounted) return File();
+    auto it = files().find(path);
+    if (mode[0] == 'r') {
+        if (it == files().end()) return File();
+        return File(&it->second, mode[1] == '+', 0);
+    }
+    std::vector<uint8_t>& data = files()[path];
+    if (mode[0] == 'w') data.clear();
+    return File(&data, true, data.size());
+}
+
+bool LittleFSFS::exists(const char* path) {
+    return filesystemMounted && files().count(path) == 1;
+}
+
+bool LittleFSFS::remove(const char* path) {
+    return filesystemMounted && files().erase(path) == 1;
+}
+
+size_t LittleFSFS::totalBytes() {
+    return filesystemMounted ? FLASH_PARTITION_BYTES : 0;
+}
+
+size_t LittleFSFS::usedBytes() {
+    size_t used = 0;
+    if (!filesystemMounted) return 0;
+    for (auto& f : files()) used += f.second.size();
+    return used;
+}
+
+void sim_setFilesystemAvailable(bool available) {
+    filesystemAvailable = available;
+    if (!available) filesystemMounted = false;
+}
+
+void sim_resetFilesystem() {
+    files().clear();
+}
+
+bool sim_corruptFile(const char* path, size_t offset) {
+    auto it = files().find(path);
+    if (it == files().end() || offset >= it->second.size()) return false;
+    it->second[offset] ^= 0xFF;
+    return true;
+}
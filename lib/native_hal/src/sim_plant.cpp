@@ -0,0 +1,224 @@
+#include "sim_plant.h"
+
+static const uint64_t STEP_US = 1000000; // integration step
+
+struct Zone {
+    uint8_t soilPin;
+    uint8_t relayPin;
+    SimSoilParams params;
+    float moisture;
+    float pooled;          // pumped water not yet soaked in
+    uint32_t samples;
+    uint64_t runStartUs;
+    SimZoneStats stats;
+};
+
+static Zone zones[SIM_PLANT_MAX_ZONES];
+static uint8_t zoneCount = 0;
+static SimWeather weather;
+static const SimTracePoint* trace = nullptr;
+static size_t traceLength = 0;
+static uint64_t integratedUs = 0;
+static uint32_t noiseState = 0x1234567;
+
+SimSoilParams simPlant_defaultSoil() {
+    SimSoilParams p;
+    p.initialMoisture = 55.0f;
+    p.dryRatePerHour = 1.5f;
+    p.pumpRatePerMinute = 6.0f;
+    p.soakTimeS = 90.0f;
+    p.noiseCounts = 20;
+    p.spikeEvery = 0;
+    p.spikeCounts = 0;
+    p.dryCounts = 4095;
+    p.wetCounts = 0;
+    p.curve = 0.0f;
+    p.countsPerC = 0.0f;
+    return p;
+}
+
+SimWeather simPlant_defaultWeather() {
+    SimWeather w;
+    w.meanTemperature = 27.0f;
+    w.temperatureSwing = 5.0f;
+    w.meanHumidity = 65.0f;
+    w.humiditySwing = 15.0f;
+    w.startHour = 6.0f;
+    return w;
+}
+
+static void traceAt(uint64_t us, SimTracePoint& out) {
+    float t = us / 1e6f;
+    size_t i = 0;
+    while (i + 1 < traceLength && trace[i + 1].timeS <= t) i++;
+    out = trace[i];
+    if (i + 1 >= traceLength || t <= trace[i].timeS) return;
+    const SimTracePoint& next = trace[i + 1];
+    float f = (t - trace[i].timeS) / (next.timeS - trace[i].timeS);
+    out.moisture += (next.moisture - out.moisture) * f;
+    out.temperature += (next.temperature - out.temperature) * f;
+    out.humidity += (next.humidity - out.humidity) * f;
+}
+
+static void airAt(uint64_t us, float& temperature, float& humidity) {
+    if (trace != nullptr) {
+        SimTracePoint p;
+        traceAt(us, p);
+        temperature = p.temperature;
+        humidity = p.humidity;
+        return;
+    }
+    float hour = weather.startHour + us / 3.6e9f;
+    float phase = sinf((hour - 9.0f) * (float)M_PI / 12.0f); // +1 at 15:00
+    temperature = weather.meanTemperature + weather.temperatureSwing * phase;
+    humidity = weather.meanHumidity - weather.humiditySwing * phase;
+}
+
+static void track(Zone& z) {
+    if (z.moisture < z.stats.minMoisture) z.stats.minMoisture = z.moisture;
+    if (z.moisture > z.stats.maxMoisture) z.stats.maxMoisture = z.moisture;
+    z.stats.moisture = z.moisture;
+}
+
+// Integrates every zone up to the current virtual time
+static void advance() {
+    uint64_t now = sim_micros();
+    while (integratedUs < now) {
+        uint64_t stepUs = std::min(STEP_US, now - integratedUs);
+        float dt = stepUs / 1e6f;
+        float temperature, humidity;
+        airAt(integratedUs, temperature, humidity);
+        float climate = std::max(0.2f, 1.0f + 0.04f * (temperature - 25.0f) - 0.01f * (humidity - 50.0f));
+
+        for (uint8_t i = 0; i < zoneCount; i++) {
+            Zone& z = zones[i];
+            bool pumping = sim_pinLevel(z.relayPin) == HIGH;
+            if (pumping) {
+                float water = z.params.pumpRatePerMinute / 60.0f * dt;
+                z.pooled += water;
+                z.stats.waterApplied += water;
+                z.stats.pumpOnMs += stepUs / 1000;
+            }
+            if (trace != nullptr) {
+                SimTracePoint p;
+                traceAt(integratedUs + stepUs, p);
+                z.moisture = p.moisture;
+            } else {
+                float soaked = z.pooled * (1.0f - expf(-dt / z.params.soakTimeS));
+                z.pooled -= soaked;
+                // Drying slows down as the soil runs out of water
+                float lost = z.params.dryRatePerHour / 3600.0f * dt * climate * std::min(1.0f, z.moisture / 20.0f);
+                z.moisture = constrain(z.moisture + soaked - lost, 0.0f, 100.0f);
+                z.stats.waterLost += lost;
+            }
+            track(z);
+        }
+        integratedUs += stepUs;
+    }
+}
+
+static uint32_t nextNoise() {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    return noiseState >> 8;
+}
+
+static uint16_t readProbe(uint8_t pin) {
+    advance();
+    for (uint8_t i = 0; i < zoneCount; i++) {
+        Zone& z = zones[i];
+        if (z.soilPin != pin) continue;
+        // By default the inverse of the firmware's uncalibrated mapping: 0 counts = 100 % (wet), 4095 = 0 % (dry)
+        float x = z.moisture / 100.0f;
+        float response = x + z.params.curve * x * (1.0f - x);
+        float temperature, humidity;
+        airAt(sim_micros(), temperature, humidity);
+        float drift = z.params.countsPerC * (temperature - 25.0f);
+        int32_t counts = (int32_t)lroundf(z.params.dryCounts + ((float)z.params.wetCounts - z.params.dryCounts) * response + drift);
+        if (z.params.noiseCounts) counts += (int32_t)(nextNoise() % (2 * z.params.noiseCounts + 1)) - z.params.noiseCounts;
+        if (z.params.spikeEvery && ++z.samples % z.params.spikeEvery == 0) counts += z.params.spikeCounts;
+        return (uint16_t)constrain(counts, 0, 4095);
+    }
+    return 2048;
+}
+
+static void relayChanged(uint8_t pin, uint8_t level) {
+    advance(); // up to now with the old relay state
+    uint64_t now = sim_micros();
+    for (uint8_t i = 0; i < zoneCount; i++) {
+        Zone& z = zones[i];
+        if (z.relayPin != pin) continue;
+        if (level == HIGH) {
+            z.stats.pumpStarts++;
+            z.runStartUs = now;
+        } else if (z.stats.pumpStarts > 0) {
+            uint32_t runMs = (uint32_t)((now - z.runStartUs) / 1000);
+            if (z.stats.shortestRunMs == 0 || runMs < z.stats.shortestRunMs) z.stats.shortestRunMs = runMs;
+            if (runMs > z.stats.longestRunMs) z.stats.longestRunMs = runMs;
+        }
+    }
+}
+
+static bool readAir(float& temperature, float& humidity) {
+    airAt(sim_micros(), temperature, humidity);
+    return true;
+}
+
+void simPlant_begin(const SimWeather& w) {
+    weather = w;
+    integratedUs = sim_micros();
+    sim_setAnalogSource(readProbe);
+    sim_setPinListener(relayChanged);
+    sim_setDhtSource(readAir);
+}
+
+int8_t simPlant_addZone(uint8_t soilPin, uint8_t relayPin, const SimSoilParams& params) {
+    if (zoneCount >= SIM_PLANT_MAX_ZONES) return -1;
+    Zone& z = zones[zoneCount];
+    memset(&z, 0, sizeof(z));
+    z.soilPin = soilPin;
+    z.relayPin = relayPin;
+    z.params = params;
+    z.moisture = params.initialMoisture;
+    z.stats.minMoisture = z.stats.maxMoisture = z.stats.moisture = z.moisture;
+    return (int8_t)zoneCount++;
+}
+
+void simPlant_playTrace(const SimTracePoint* points, size_t count) {
+    advance();
+    trace = count ? points : nullptr;
+    traceLength = count;
+}
+
+size_t simTrace_loadCsv(const char* path, SimTracePoint* out, size_t maxPoints) {
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) return 0;
+    char line[128];
+    size_t n = 0;
+    while (n < maxPoints && fgets(line, sizeof(line), f)) {
+        SimTracePoint p;
+        unsigned long timeS;
+        if (line[0] == '#' || sscanf(line, "%lu,%f,%f,%f", &timeS, &p.moisture, &p.temperature, &p.humidity) != 4) continue;
+        p.timeS = (uint32_t)timeS;
+        out[n++] = p;
+    }
+    fclose(f);
+    return n;
+}
+
+void simPlant_zoneStats(uint8_t zone, SimZoneStats& out) {
+    advance();
+    out = zone < zoneCount ? zones[zone].stats : SimZoneStats();
+}
+
+void simPlant_resetStats() {
+    advance();
+    for (uint8_t i = 0; i < zoneCount; i++) {
+        Zone& z = zones[i];
+        memset(&z.stats, 0, sizeof(z.stats));
+        z.stats.minMoisture = z.stats.maxMoisture = z.stats.moisture = z.moisture;
+    }
+}
+
+void simPlant_air(float& temperature, float& humidity) {
+    airAt(sim_micros(), temperature, humidity);
+}
@@ -0,0 +1,245 @@
+#include "sim.h"
+#include <chrono>
+#include <ucontext.h>
+
+// Cooperative FreeRTOS on the virtual clock. Each task has its own ucontext
+// stack; the loop task runs on the caller's. Switching is a swapcontext(),
+// so only one task ever runs and the firmware's atomics and lock-free
+// queues behave as on one core.
+
+#define SIM_MAX_TASKS   16
+#define SIM_STACK_BYTES (256 * 1024) // host frames are larger than the device's
+
+static const uint64_t NEVER = UINT64_MAX;
+
+struct SimTask {
+    char name[16];
+    TaskFunction_t fn;
+    void* arg;
+    UBaseType_t priority;
+    uint32_t stackDepth;
+    ucontext_t context;
+    uint8_t* stack;
+    uint64_t wakeUs;        // ready once the clock reaches it
+    bool waitingNotify;
+    bool finished;
+    uint32_t notifications;
+    unsigned long wakeups;
+    uint64_t busyNs;
+};
+
+static SimTask tasks[SIM_MAX_TASKS];
+static uint8_t taskCount = 0;
+static SimTask* current = nullptr;
+static uint64_t nowUs = 0;
+static uint64_t runningSinceNs = 0;
+
+uint64_t sim_hostNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Highest priority among the ready tasks, then the earliest wake-up; if none
+// is ready the clock jumps to the next wake-up.
+static SimTask* pickNext() {
+    for (;;) {
+        SimTask* best = nullptr;
+        uint64_t nextWake = NEVER;
+        for (uint8_t i = 0; i < taskCount; i++) {
+            SimTask& t = tasks[i];
+            if (t.finished) continue;
+            if (t.wakeUs > nowUs) {
+                if (t.wakeUs < nextWake) nextWake = t.wakeUs;
+                continue;
+            }
+            if (best == nullptr || t.priority > best->priority ||
+                (t.priority == best->priority && t.wakeUs < best->wakeUs)) {
+                best = &t;
+            }
+        }
+        if (best != nullptr) return best;
+        if (nextWake == NEVER) {
+            fprintf(stderr, "sim: every task is blocked forever (deadlock)\n");
+            abort();
+        }
+        nowUs = nextWake;
+    }
+}
+
+static void switchTo(SimTask* next) {
+    uint64_t host = sim_hostNs();
+    current->busyNs += host - runningSinceNs;
+    runningSinceNs = host;
+    next->wakeups++;
+    if (next == current) return;
+    SimTask* previous = current;
+    current = next;
+    swapcontext(&previous->context, &next->context);
+}
+
+static void block(uint64_t wakeUs) {
+    current->wakeUs = wakeUs;
+    switchTo(pickNext());
+}
+
+static void taskEntry(int index) {
+    SimTask& t = tasks[index];
+    t.fn(t.arg);
+    // A FreeRTOS task must not return; treat it like vTaskDelete(nullptr)
+    t.finished = true;
+    switchTo(pickNext());
+}
+
+void sim_begin() {
+    if (taskCount != 0) return;
+    SimTask& loopTask = tasks[taskCount++];
+    strlcpy(loopTask.name, "loopTask", sizeof(loopTask.name));
+    loopTask.priority = 1;
+    current = &loopTask;
+    runningSinceNs = sim_hostNs();
+}
+
+uint64_t sim_micros() {
+    return nowUs;
+}
+
+void sim_runFor(unsigned long ms) {
+    uint64_t end = nowUs + (uint64_t)ms * 1000;
+    while (nowUs < end) loop();
+}
+
+uint8_t sim_taskCount() {
+    return taskCount;
+}
+
+bool sim_taskStats(uint8_t index, SimTaskStats& out) {
+    if (index >= taskCount) return false;
+    SimTask& t = tasks[index];
+    if (&t == current) {
+        uint64_t host = sim_hostNs();
+        t.busyNs += host - runningSinceNs;
+        runningSinceNs = host;
+    }
+    out.name = t.name;
+    out.wakeups = t.wakeups;
+    out.busyNs = t.busyNs;
+    return true;
+}
+
+bool sim_findTask(const char* name, SimTaskStats& out) {
+    for (uint8_t i = 0; i < taskCount; i++) {
+        if (strcmp(tasks[i].name, name) == 0) return sim_taskStats(i, out);
+    }
+    return false;
+}
+
+// --- Arduino time ---
+
+unsigned long millis() {
+    return (unsigned long)(nowUs / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)nowUs;
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)nowUs;
+}
+
+void delay(uint32_t ms) {
+    block(nowUs + (uint64_t)ms * 1000);
+}
+
+// Busy-waits on the device; here time just moves on
+void delayMicroseconds(uint32_t us) {
+    nowUs += us;
+}
+
+void yield() {
+    block(nowUs);
+}
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(sim_hostNs() * SIM_CPU_FREQ_MHZ / 1000);
+}
+
+// --- FreeRTOS ---
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    (void)core;
+    if (taskCount == 0) sim_begin();
+    if (taskCount >= SIM_MAX_TASKS) return pdFAIL;
+    uint8_t index = taskCount++;
+    SimTask& t = tasks[index];
+    strlcpy(t.name, name, sizeof(t.name));
+    t.fn = fn;
+    t.arg = arg;
+    t.priority = priority;
+    t.stackDepth = stackDepth;
+    t.stack = static_cast<uint8_t*>(malloc(SIM_STACK_BYTES));
+    t.wakeUs = nowUs;
+    getcontext(&t.context);
+    t.context.uc_stack.ss_sp = t.stack;
+    t.context.uc_stack.ss_size = SIM_STACK_BYTES;
+    t.context.uc_link = nullptr;
+    makecontext(&t.context, reinterpret_cast<void (*)()>(taskEntry), 1, (int)index);
+    if (handle != nullptr) *handle = &t;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == current) {
+        current->finished = true;
+        switchTo(pickNext());
+        return;
+    }
+    task->finished = true;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    block(nowUs + (uint64_t)ticks * 1000);
+}
+
+// Like FreeRTOS, returns at once if the wake time has already passed
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t period) {
+    *previousWake += period;
+    uint64_t wakeUs = (uint64_t)*previousWake * 1000;
+    if (wakeUs > nowUs) block(wakeUs);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(nowUs / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return current;
+}
+
+char* pcTaskGetName(TaskHandle_t task) {
+    return task ? task->name : current->name;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    (void)task;
+    return SIM_STACK_BYTES; // host stacks are not monitored
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t timeout) {
+    if (current->notifications == 0 && timeout != 0) {
+        current->waitingNotify = true;
+        block(timeout == portMAX_DELAY ? NEVER : nowUs + (uint64_t)timeout * 1000);
+        current->waitingNotify = false;
+    }
+    uint32_t value = current->notifications;
+    if (value != 0) current->notifications = clearOnExit ? 0 : value - 1;
+    return value;
+}
+
+// The woken task runs once the caller blocks (no preemption)
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    task->notifications++;
+    if (task->waitingNotify && task->wakeUs > nowUs) task->wakeUs = nowUs;
+    return pdPASS;
+}
@@ -0,0 +1,140 @@
+#include "actuation_trace.h"
+#include <atomic>
+
+// Traces opened during the current control tick (control loop only)
+static ActuationTrace open[ACTUATION_RING_CAPACITY];
+static bool gpioWritten[ACTUATION_RING_CAPACITY];
+static uint8_t openCount = 0;
+static uint32_t nextSeq = 0;
+
+// Finished traces, control loop -> network task
+static ActuationTrace slots[ACTUATION_RING_CAPACITY];
+static std::atomic<uint32_t> head(0);
+static std::atomic<uint32_t> tail(0);
+
+static ActuationStats stats = {};
+
+static ActuationTrace* openTrace(uint8_t zone, ActuationSource source) {
+    if (openCount >= ACTUATION_RING_CAPACITY) {
+        stats.dropped++;
+        return nullptr;
+    }
+    ActuationTrace& t = open[openCount];
+    memset(&t, 0, sizeof(t));
+    t.seq = nextSeq++;
+    t.zone = zone;
+    t.source = source;
+    gpioWritten[openCount] = false;
+    openCount++;
+    return &t;
+}
+
+void actuationTrace_commandApplied(uint8_t zone, const char* id, uint32_t receivedUs) {
+    ActuationTrace* t = openTrace(zone, ACTUATION_COMMAND);
+    if (t == nullptr) return;
+    strlcpy(t->id, id, sizeof(t->id));
+    t->receivedUs = receivedUs;
+    t->appliedUs = micros();
+}
+
+void actuationTrace_relayWritten(uint8_t zone, bool automatic, uint32_t decidedUs) {
+    uint32_t now = micros();
+    bool traced = false;
+    for (uint8_t i = 0; i < openCount; i++) {
+        if (open[i].zone != zone || gpioWritten[i]) continue;
+        open[i].gpioUs = now;
+        gpioWritten[i] = true;
+        traced = true;
+    }
+    // A command applied this tick owns the change; otherwise it is the pump cycle's
+    if (traced || !automatic) return;
+    ActuationTrace* t = openTrace(zone, ACTUATION_AUTO);
+    if (t == nullptr) return;
+    t->appliedUs = decidedUs;
+    t->gpioUs = now;
+    gpioWritten[openCount - 1] = true;
+}
+
+void actuationTrace_endTick(ZoneMask pumpOn) {
+    for (uint8_t i = 0; i < openCount; i++) {
+        ActuationTrace& t = open[i];
+        t.on = pumpOn & ZONE_BIT(t.zone);
+        t.relayChanged = gpioWritten[i];
+        stats.traces[t.source]++;
+        if (t.relayChanged && t.gpioUs - t.appliedUs > stats.maxControlUs) stats.maxControlUs = t.gpioUs - t.appliedUs;
+
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= ACTUATION_RING_CAPACITY) {
+            stats.dropped++;
+            continue;
+        }
+        slots[h & (ACTUATION_RING_CAPACITY - 1)] = t;
+        head.store(h + 1, std::memory_order_release);
+    }
+    openCount = 0;
+}
+
+bool actuationTrace_pop(ActuationTrace& out) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    out = slots[t & (ACTUATION_RING_CAPACITY - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t actuationTrace_totalUs(const ActuationTrace& trace, uint32_t publishUs) {
+    return publishUs - (trace.source == ACTUATION_COMMAND ? trace.receivedUs : trace.appliedUs);
+}
+
+void actuationTrace_recordPublished(const ActuationTrace& trace, uint32_t publishUs, bool published) {
+    if (!published) {
+        stats.unpublished++;
+        return;
+    }
+    uint32_t total = actuationTrace_totalUs(trace, publishUs);
+    stats.published++;
+    stats.lastTotalUs = total;
+    if (total > stats.maxTotalUs) stats.maxTotalUs = total;
+    if (total > ACTUATION_SLO_US) stats.sloMisses++;
+}
+
+void actuationTrace_getStats(ActuationStats& out) {
+    out = stats;
+}
+
+size_t actuationTrace_copyId(char* out, const char* id, size_t len) {
+    size_t n = 0;
+    for (; n < len && n < ACTUATION_ID_MAX - 1; n++) {
+        char c = id[n];
+        out[n] = (c == '"' || c == '\\' || (unsigned char)c < 0x20) ? '_' : c;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+size_t actuationTrace_format(const ActuationTrace& t, uint32_t publishUs, char* buf, size_t len) {
+    int n;
+    if (t.source == ACTUATION_AUTO) {
+        n = snprintf(buf, len, "{\"value\":\"%s\",\"id\":\"auto-%lu\",\"seq\":%lu,\"source\":\"auto\",\"relay\":\"%s\",\"us\":{",
+                     t.on ? "on" : "off", (unsigned long)t.seq, (unsigned long)t.seq,
+                     t.relayChanged ? "changed" : "unchanged");
+    } else {
+        n = snprintf(buf, len, "{\"value\":\"%s\",\"id\":\"%s\",\"seq\":%lu,\"source\":\"command\",\"relay\":\"%s\",\"us\":{\"queue\":%lu,",
+                     t.on ? "on" : "off", t.id, (unsigned long)t.seq, t.relayChanged ? "changed" : "unchanged",
+                     (unsigned long)(t.appliedUs - t.receivedUs));
+    }
+    if (n < 0 || (size_t)n >= len) return 0;
+    size_t pos = n;
+
+    uint32_t reportFrom = t.appliedUs;
+    if (t.relayChanged) {
+        n = snprintf(buf + pos, len - pos, "\"control\":%lu,", (unsigned long)(t.gpioUs - t.appliedUs));
+        if (n < 0 || (size_t)n >= len - pos) return 0;
+        pos += n;
+        reportFrom = t.gpioUs;
+    }
+    n = snprintf(buf + pos, len - pos, "\"report\":%lu,\"total\":%lu}}", (unsigned long)(publishUs - reportFrom),
+                 (unsigned long)actuationTrace_totalUs(t, publishUs));
+    if (n < 0 || (size_t)n >= len - pos) return 0;
+    return pos + n;
+}
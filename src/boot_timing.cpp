@@ -0,0 +1,40 @@
+#include "boot_timing.h"
+#include <atomic>
+
+static std::atomic<uint32_t> milestones[BOOT_MILESTONE_COUNT];
+
+static const char* const MILESTONE_NAMES[BOOT_MILESTONE_COUNT] = {
+    "setup_start_ms", "state_restored_ms", "setup_done_ms", "first_decision_ms",
+    "wifi_up_ms", "mqtt_up_ms", "first_publish_ms"
+};
+
+void bootTiming_mark(BootMilestone milestone) {
+    // +1 so a milestone at 0 ms still reads as reached
+    uint32_t ms = (uint32_t)(esp_timer_get_time() / 1000) + 1;
+    uint32_t unset = 0;
+    milestones[milestone].compare_exchange_strong(unset, ms, std::memory_order_relaxed);
+}
+
+uint32_t bootTiming_ms(BootMilestone milestone) {
+    uint32_t v = milestones[milestone].load(std::memory_order_relaxed);
+    return v ? v - 1 : 0;
+}
+
+size_t bootTiming_format(char* buf, size_t len) {
+    size_t pos = 0;
+    int n = snprintf(buf, len, "{");
+    if (n < 0 || (size_t)n >= len) return 0;
+    pos = n;
+    bool first = true;
+    for (uint8_t m = 0; m < BOOT_MILESTONE_COUNT; m++) {
+        if (milestones[m].load(std::memory_order_relaxed) == 0) continue;
+        n = snprintf(buf + pos, len - pos, first ? "\"%s\":%u" : ",\"%s\":%u",
+                     MILESTONE_NAMES[m], (unsigned)bootTiming_ms((BootMilestone)m));
+        if (n < 0 || (size_t)n >= len - pos) return 0;
+        pos += n;
+        first = false;
+    }
+    n = snprintf(buf + pos, len - pos, "}");
+    if (n < 0 || (size_t)n >= len - pos) return 0;
+    return pos + n;
+}
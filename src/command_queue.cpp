@@ -0,0 +1,30 @@
+#include "command_queue.h"
+#include <atomic>
+
+static Command slots[COMMAND_QUEUE_CAPACITY];
+static std::atomic<uint32_t> head(0); // next slot to write (producer)
+static std::atomic<uint32_t> tail(0); // next slot to read (consumer)
+static std::atomic<uint32_t> droppedCount(0);
+
+bool commandQueue_push(const Command& cmd) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= COMMAND_QUEUE_CAPACITY) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    slots[h & (COMMAND_QUEUE_CAPACITY - 1)] = cmd;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+bool commandQueue_pop(Command& cmd) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    cmd = slots[t & (COMMAND_QUEUE_CAPACITY - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+unsigned long commandQueue_dropped() {
+    return droppedCount.load(std::memory_order_relaxed);
+}
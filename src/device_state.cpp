@@ -0,0 +1,33 @@
+#include "device_state.h"
+#include <atomic>
+
+// Two buffers plus a sequence counter that advances twice per publish: odd
+// while the writer fills the inactive buffer, even once it is published. The
+// published buffer is buffers[(seq >> 1) & 1]. Readers never block the writer
+// and only retry if the writer lapped them and started overwriting the buffer
+// they were copying.
+static DeviceState buffers[2];
+static std::atomic<uint32_t> seq(0);
+
+void deviceState_publish(const DeviceState& state) {
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    buffers[((s >> 1) + 1) & 1] = state;
+    seq.store(s + 2, std::memory_order_release);
+}
+
+void deviceState_read(DeviceState& out) {
+    for (;;) {
+        uint32_t before = seq.load(std::memory_order_acquire) & ~1u;
+        out = buffers[(before >> 1) & 1];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t after = seq.load(std::memory_order_relaxed);
+        // The writer only touches our buffer from sequence before+3 onwards
+        if (after - before <= 2) return;
+    }
+}
+
+const char* actuatorModeName(ActuatorMode mode) {
+    return mode == MODE_AUTO ? "auto" : "manual";
+}
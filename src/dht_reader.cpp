@@ -0,0 +1,132 @@
+#include "dht_reader.h"
+#include "config.h"
+#include "logger.h"
+#include "mem_diag.h"
+#include "driver/gpio.h"
+#include "driver/rmt.h"
+#include "freertos/queue.h"
+#include "freertos/ringbuf.h"
+
+// DHT22 frame: host pulls the line low >= 1 ms, sensor answers 80 us low /
+// 80 us high, then 40 bits of 50 us low + 26-28 us (0) or 70 us (1) high.
+static const rmt_channel_t DHT_RMT_CHANNEL = RMT_CHANNEL_0;
+static const uint32_t START_PULSE_US = 1100;
+static const uint16_t BIT_ONE_THRESHOLD_US = 48;
+static const uint16_t IDLE_THRESHOLD_US = 120; // line high longer than any bit = end of frame
+static const int FRAME_BITS = 40;
+
+static gpio_num_t dhtPin = GPIO_NUM_NC;
+static RingbufHandle_t rxRing = nullptr;
+static QueueHandle_t mailbox = nullptr; // length 1, overwritten by every good frame
+static DhtCallback readingCallback = nullptr;
+static DhtStats stats = {};
+
+// Collect the high-pulse widths of the captured frame; the last 40 are the data bits
+static bool decodeFrame(const rmt_item32_t* items, size_t count, uint8_t data[5]) {
+    uint16_t highs[64];
+    int n = 0;
+    for (size_t i = 0; i < count && n < 64; i++) {
+        if (items[i].level0 && items[i].duration0) highs[n++] = items[i].duration0;
+        if (n < 64 && items[i].level1 && items[i].duration1) highs[n++] = items[i].duration1;
+    }
+    if (n < FRAME_BITS) return false;
+
+    memset(data, 0, 5);
+    const uint16_t* bits = highs + (n - FRAME_BITS);
+    for (int b = 0; b < FRAME_BITS; b++) {
+        if (bits[b] > BIT_ONE_THRESHOLD_US) data[b / 8] |= 0x80 >> (b % 8);
+    }
+    return true;
+}
+
+static void readOnce() {
+    stats.reads++;
+
+    // Start pulse via open-drain output; the RMT input stays attached
+    rmt_rx_stop(DHT_RMT_CHANNEL);
+    gpio_set_level(dhtPin, 0);
+    delayMicroseconds(START_PULSE_US);
+    rmt_rx_start(DHT_RMT_CHANNEL, true);
+    gpio_set_level(dhtPin, 1);
+
+    size_t size = 0;
+    rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(rxRing, &size, pdMS_TO_TICKS(DHT_RESPONSE_TIMEOUT_MS));
+    if (items == nullptr) {
+        stats.timeouts++;
+        return;
+    }
+
+    uint8_t data[5];
+    bool decoded = decodeFrame(items, size / sizeof(rmt_item32_t), data);
+    vRingbufferReturnItem(rxRing, items);
+    if (!decoded) {
+        stats.timeouts++;
+        return;
+    }
+    if ((uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4]) {
+        stats.checksumErrors++;
+        return;
+    }
+
+    DhtReading reading;
+    reading.humidity = ((data[0] << 8) | data[1]) * 0.1f;
+    int16_t t = ((data[2] & 0x7F) << 8) | data[3];
+    reading.temperature = (data[2] & 0x80 ? -t : t) * 0.1f;
+    reading.timestamp = millis();
+    reading.valid = true;
+
+    xQueueOverwrite(mailbox, &reading);
+    if (readingCallback) readingCallback(reading);
+}
+
+static void readerTask(void* arg) {
+    memDiag_registerCurrentTask();
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        readOnce();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(DHT_READ_PERIOD_MS));
+    }
+}
+
+bool dhtReader_begin(int pin) {
+    dhtPin = (gpio_num_t)pin;
+    mailbox = xQueueCreate(1, sizeof(DhtReading));
+
+    rmt_config_t config = RMT_DEFAULT_CONFIG_RX(dhtPin, DHT_RMT_CHANNEL);
+    config.clk_div = 80; // 1 tick = 1 us
+    config.mem_block_num = 1;
+    config.rx_config.filter_en = true;
+    config.rx_config.filter_ticks_thresh = 100; // ignore glitches < 1.25 us (APB ticks)
+    config.rx_config.idle_threshold = IDLE_THRESHOLD_US;
+    if (rmt_config(&config) != ESP_OK || rmt_driver_install(DHT_RMT_CHANNEL, 512, 0) != ESP_OK) {
+        LOG_ERROR(LOG_TAG_MAIN, "DHT RMT init gagal");
+        return false;
+    }
+    rmt_get_ringbuf_handle(DHT_RMT_CHANNEL, &rxRing);
+
+    // rmt_config() routed the pin to the RMT input as a plain input. Switching
+    // it to open drain keeps that input path alive while we drive the start
+    // pulse; the module's pull-up idles the line high.
+    gpio_set_direction(dhtPin, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(dhtPin, GPIO_PULLUP_ONLY);
+    gpio_set_level(dhtPin, 1);
+
+    xTaskCreatePinnedToCore(readerTask, "dht", DHT_TASK_STACK, nullptr, DHT_TASK_PRIORITY, nullptr, DHT_TASK_CORE);
+    return true;
+}
+
+bool dhtReader_latest(DhtReading& out) {
+    if (mailbox == nullptr || xQueuePeek(mailbox, &out, 0) != pdTRUE) {
+        out = DhtReading();
+        return false;
+    }
+    return true;
+}
+
+void dhtReader_setCallback(DhtCallback callback) {
+    readingCallback = callback;
+}
+
+void dhtReader_getStats(DhtStats& out) {
+    out = stats;
+}
@@ -2,7 +2,12 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include <Wire.h>
+#include <atomic>
+#include "config.h"
+#include "logger.h"
+#include "mem_diag.h"
 #include "mqtt_handler.h"
+#include "profiler.h"
 
 // Definisi OLED
 #define OLED_RESET    -1
@@ -10,8 +15,6 @@
 #define SCREEN_HEIGHT 64
 
 // Eksternal variabel dari modul lain
-extern String rulePlantName;
-extern String actuatorMode;
 extern bool lowMoistureAlert;
 extern unsigned long lastBlinkTime;
 extern bool blinkState;
@@ -22,10 +25,10 @@ extern float lastHumidity;
 static int currentScene = 0; // Mulai dari scene utama (0)
 static unsigned long lastSceneChange = 0;
 static const unsigned long SCENE_DURATION = 7000; // Durasi per scene 7 detik
-static const int TOTAL_SCENES = 4; // Total 4 scene (0: Utama, 1: Info, 2: Lingkungan, 3: Tanah)
 
 // Objek Display
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+// Clock tetap di OLED_I2C_CLOCK_HZ (bawaan library turun ke 100 kHz setelah transfer)
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET, OLED_I2C_CLOCK_HZ, OLED_I2C_CLOCK_HZ);
 
 // --- Kumpulan Ikon ---
 // Ikon Daun Tanaman (16x16)
@@ -58,246 +61,516 @@ static const unsigned char PROGMEM humidity_droplet_icon[] = {
 0x1F, 0xF8, 0x0F, 0xF0, 0x07, 0xE0, 0x03, 0xC0, 0x01, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 
-// Fungsi utilitas untuk mengubah huruf pertama menjadi kapital
-String capitalize(String str) {
-    if (str.length() > 0) {
-        str.toLowerCase();
-        str[0] = toupper(str[0]);
+// Nama tanaman yang sudah diformat (huruf pertama kapital) beserta tata
+// letaknya. Dihitung ulang hanya kalau rulePlantName berubah.
+struct PlantNameCache {
+    char source[PLANT_NAME_MAX];   // rulePlantName saat cache dibuat
+    char text[PLANT_NAME_MAX];     // hasil capitalize
+    bool smallFont;                // > 8 karakter: font ukuran 1 di dashboard
+    int16_t centeredX;             // posisi x untuk teks ukuran 2 di tengah layar
+    uint32_t version;              // naik setiap kali nama berubah
+};
+static PlantNameCache plantNameCache = {};
+static uint8_t displayZone = 0; // zona yang sedang ditampilkan (lihat updateDisplayScenes)
+
+static void prerenderSceneChrome(); // didefinisikan bersama tabel scene di bawah
+
+// --- Rendering bertahap (dirty region) ---
+// Setiap widget menyimpan "kunci" dari nilai yang terakhir digambar. Widget
+// hanya dihapus dan digambar ulang kalau kuncinya berubah, lalu hanya kolom
+// yang berubah per page SSD1306 yang dikirim lewat I2C.
+static const uint8_t OLED_ADDRESS = 0x3C;
+#ifdef I2C_BUFFER_LENGTH
+static const size_t OLED_I2C_CHUNK = I2C_BUFFER_LENGTH - 1; // 1 byte untuk control byte 0x40
+#else
+static const size_t OLED_I2C_CHUNK = 31;
+#endif
+static const int OLED_PAGES = SCREEN_HEIGHT / 8;
+
+// Double buffer: scene digambar ke buffer milik Adafruit (back buffer), lalu
+// disalin ke frontBuffer dan dikirim oleh task flush berprioritas rendah.
+// Isi panel saat ini (apa yang sudah dikirim ke SSD1306) ada di panelShadow.
+static uint8_t frontBuffer[SCREEN_WIDTH * OLED_PAGES];
+static uint8_t panelShadow[SCREEN_WIDTH * OLED_PAGES];
+static bool panelShadowValid = false;
+static std::atomic<bool> frontBusy(false); // true selama task flush memakai frontBuffer
+static TaskHandle_t flushTaskHandle = nullptr;
+static unsigned long splashUntil = 0;
+
+enum WidgetId {
+    W_PLANT_NAME = 0,
+    W_TEMP,
+    W_PUMP,
+    W_MOISTURE_TEXT,
+    W_MOISTURE_BAR,
+    W_ALERT,
+    W_INFO_PLANT_NAME,
+    W_INFO_FOOTER,
+    W_ENV_TEMP,
+    W_ENV_HUMIDITY,
+    W_SOIL_VALUE,
+    W_SOIL_THRESHOLD,
+    W_SOIL_BAR,
+    WIDGET_COUNT
+};
+
+static int32_t widgetKeys[WIDGET_COUNT];
+static bool widgetValid[WIDGET_COUNT];
+static int drawnScene = -1; // scene yang sedang ada di buffer
+// Ditulis oleh loop (frame) dan task flush (transfer), dibaca oleh task
+// network: setiap field atomic dan hanya punya satu penulis.
+struct DisplayCounters {
+    std::atomic<unsigned long> frames;
+    std::atomic<unsigned long> fullRedraws;
+    std::atomic<unsigned long> lastFrameUs;
+    std::atomic<unsigned long> maxFrameUs;
+    std::atomic<unsigned long> totalFrameUs;
+    std::atomic<unsigned long> flushes;
+    std::atomic<unsigned long> droppedFrames;
+    std::atomic<unsigned long> lastFlushUs;
+    std::atomic<unsigned long> maxFlushUs;
+    std::atomic<size_t> lastI2cBytes;
+    std::atomic<unsigned long> totalI2cBytes;
+};
+static DisplayCounters displayStats;
+
+template <typename T>
+static inline void statAdd(std::atomic<T>& counter, T value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+template <typename T>
+static inline void statSet(std::atomic<T>& last, std::atomic<T>& max, T value) {
+    last.store(value, std::memory_order_relaxed);
+    if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed);
+}
+
+static void invalidateWidgets() {
+    for (int i = 0; i < WIDGET_COUNT; i++) widgetValid[i] = false;
+}
+
+// True (dan area widget dibersihkan) kalau widget perlu digambar ulang
+static bool widgetNeedsRedraw(WidgetId id, int32_t key, int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (widgetValid[id] && widgetKeys[id] == key) return false;
+    widgetKeys[id] = key;
+    widgetValid[id] = true;
+    display.fillRect(x, y, w, h, SSD1306_BLACK);
+    return true;
+}
+
+// Kirim hanya kolom yang berubah per page; kembalikan jumlah byte I2C
+static size_t flushDirtyPages(const uint8_t* buffer) {
+    size_t bytes = 0;
+
+    for (int page = 0; page < OLED_PAGES; page++) {
+        const uint8_t* row = buffer + page * SCREEN_WIDTH;
+        uint8_t* shadow = panelShadow + page * SCREEN_WIDTH;
+
+        int first = -1, last = -1;
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            if (!panelShadowValid || row[x] != shadow[x]) {
+                if (first < 0) first = x;
+                last = x;
+            }
+        }
+        if (first < 0) continue;
+
+        // Jendela alamat: kolom first..last pada page ini
+        Wire.beginTransmission(OLED_ADDRESS);
+        Wire.write((uint8_t)0x00); // control byte: command stream
+        Wire.write((uint8_t)SSD1306_COLUMNADDR);
+        Wire.write((uint8_t)first);
+        Wire.write((uint8_t)last);
+        Wire.write((uint8_t)SSD1306_PAGEADDR);
+        Wire.write((uint8_t)page);
+        Wire.write((uint8_t)page);
+        Wire.endTransmission();
+        bytes += 8; // address + control + 6 command bytes
+
+        for (int x = first; x <= last;) {
+            size_t n = min((size_t)(last - x + 1), OLED_I2C_CHUNK);
+            Wire.beginTransmission(OLED_ADDRESS);
+            Wire.write((uint8_t)0x40); // control byte: data stream
+            Wire.write(row + x, n);
+            Wire.endTransmission();
+            bytes += 2 + n;
+            x += n;
+        }
+        memcpy(shadow + first, row + first, last - first + 1);
+    }
+    panelShadowValid = true;
+    return bytes;
+}
+
+// Task flush: menunggu frame baru, kirim page yang berubah. Transfer I2C
+// memblokir task ini saja (driver menunggu interrupt), bukan loop kontrol.
+static void flushTask(void* arg) {
+    memDiag_registerCurrentTask();
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        unsigned long start = micros();
+        size_t bytes;
+        {
+            PROFILE_SCOPE(PROF_DISPLAY_FLUSH);
+            bytes = flushDirtyPages(frontBuffer);
+        }
+        unsigned long flushUs = micros() - start;
+        frontBusy.store(false, std::memory_order_release);
+
+        statAdd(displayStats.flushes, 1UL);
+        statSet(displayStats.lastFlushUs, displayStats.maxFlushUs, flushUs);
+        displayStats.lastI2cBytes.store(bytes, std::memory_order_relaxed);
+        statAdd(displayStats.totalI2cBytes, (unsigned long)bytes);
+    }
+}
+
+// Serahkan back buffer ke task flush. Tidak pernah menunggu: kalau frame
+// sebelumnya masih dikirim, frame ini dilewati (isinya tetap ada di back
+// buffer dan ikut terkirim pada frame berikutnya).
+static void postFrame() {
+    if (frontBusy.load(std::memory_order_acquire)) {
+        statAdd(displayStats.droppedFrames, 1UL);
+        return;
     }
-    return str;
+    memcpy(frontBuffer, display.getBuffer(), sizeof(frontBuffer));
+    frontBusy.store(true, std::memory_order_release);
+    xTaskNotifyGive(flushTaskHandle);
 }
 
 // Inisialisasi display
 void initDisplay() {
-    // Gunakan pin I2C default untuk ESP32 (GPIO 21, 22)
-    Wire.begin(); 
+    // Gunakan pin I2C default untuk ESP32 (GPIO 21, 22), fast-mode
+    Wire.begin();
+    Wire.setClock(OLED_I2C_CLOCK_HZ);
     if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
-        Serial.println(F("Alokasi SSD1306 gagal"));
-        for (;;);
+        LOG_ERROR(LOG_TAG_MAIN, "Alokasi SSD1306 gagal");
+        for (;;) delay(1000); // leaves the log task time to print it
     }
+    prerenderSceneChrome();
+
     display.clearDisplay();
     display.setTextSize(2);
     display.setTextColor(SSD1306_WHITE);
     display.setCursor(15, 25);
     display.println("AgriSense");
-    display.display();
-    delay(2000);
+
+    // Splash dikirim oleh task flush dan ditahan tanpa memblokir boot
+    xTaskCreatePinnedToCore(flushTask, "oled_flush", OLED_FLUSH_TASK_STACK, nullptr,
+                            OLED_FLUSH_TASK_PRIORITY, &flushTaskHandle, OLED_FLUSH_TASK_CORE);
+    postFrame();
+    splashUntil = millis() + SPLASH_DURATION_MS;
 }
 
 // --- FUNGSI-FUNGSI TAMPILAN SCENE ---
+// Setiap scene = template: elemen statis (ikon, header, garis) digambar
+// sekali saat boot ke sceneChrome[], lalu widget dinamis digambar di atasnya
+// hanya kalau nilainya berubah. Scene baru cukup ditambahkan ke tabel scenes[].
+
+struct SceneData {
+    uint8_t zone;
+    float temp;
+    float moisture;
+    int threshold;
+    float humidity;
+    bool pumpOn;
+};
 
-// Scene 0: Tampilan Utama (Dashboard)
-void showMainScene(float temp, float moisture, int threshold, const String& pumpStatusStr) {
-    display.clearDisplay();
-    display.setTextColor(SSD1306_WHITE);
+typedef void (*SceneChromeFn)();
+typedef void (*SceneWidgetsFn)(const SceneData& data);
 
-    // --- Baris 1: Nama Tanaman ---
-    display.drawBitmap(0, 0, plant_leaf_icon, 16, 16, SSD1306_WHITE);
-    String plantName = capitalize(rulePlantName);
-    
-    // Solusi: Ukuran Font Dinamis
-    if (plantName.length() > 8) {
-        display.setTextSize(1);
-        display.setCursor(20, 4); // Sesuaikan posisi vertikal untuk font kecil
-    } else {
-        display.setTextSize(2);
-        display.setCursor(20, 0);
-    }
-    display.print(plantName);
+struct SceneTemplate {
+    SceneChromeFn drawChrome;
+    SceneWidgetsFn drawWidgets;
+};
 
-    // --- Baris 2: Data Sensor dan Status Pompa ---
-    display.drawBitmap(0, 24, temp_thermometer_icon, 16, 16, SSD1306_WHITE);
-    display.setTextSize(2);
-    display.setCursor(20, 24);
-    // **DIUBAH DI SINI: Menghilangkan koma pada suhu**
-    display.printf("%.0fC", temp); 
+static void refreshPlantNameCache(uint8_t zone) {
+    const char* name = rulePlantName[zone];
+    if (plantNameCache.version != 0 && strcmp(plantNameCache.source, name) == 0) return;
 
-    display.drawBitmap(72, 24, pump_motor_icon, 16, 16, SSD1306_WHITE);
-    display.setTextSize(2);
-    display.setCursor(92, 24);
-    display.print(pumpStatusStr == "1" ? "ON" : "OFF");
+    strlcpy(plantNameCache.source, name, sizeof(plantNameCache.source));
+    // Fungsi utilitas untuk mengubah huruf pertama menjadi kapital
+    size_t len = 0;
+    for (; plantNameCache.source[len] != '\0'; len++) {
+        char c = tolower(plantNameCache.source[len]);
+        plantNameCache.text[len] = (len == 0) ? toupper(c) : c;
+    }
+    plantNameCache.text[len] = '\0';
+    plantNameCache.smallFont = len > 8;
 
-    // --- Baris 3: Kelembapan Tanah (Tata Letak Baru) ---
-    // 1. Tampilkan teks label di baris atasnya
-    display.setTextSize(1);
-    display.setCursor(0, 48); // Pindahkan teks ke y=48
-    display.printf("Kelembapan Tanah: %.0f%%", moisture);
+    int16_t x1, y1;
+    uint16_t w, h;
+    display.setTextSize(2);
+    display.getTextBounds(plantNameCache.text, 0, 0, &x1, &y1, &w, &h);
+    plantNameCache.centeredX = (SCREEN_WIDTH - (int16_t)w) / 2;
+    plantNameCache.version++;
+}
 
-    // 2. Gambar progress bar di baris paling bawah (lebar penuh)
+// Progress bar kelembapan dengan garis ambang batas (threshold)
+static void drawMoistureBar(int barY, int barHeight, float moisture, int threshold) {
     int barX = 0;
-    int barY = 58; // Turunkan posisi bar sedikit
     int barWidth = SCREEN_WIDTH; // Gunakan lebar penuh layar
-    int barHeight = 6; // Buat bar sedikit lebih ramping
     display.drawRect(barX, barY, barWidth, barHeight, SSD1306_WHITE);
 
     // Mengisi bar sesuai nilai kelembapan
     int fillWidth = map(moisture, 0, 100, 0, barWidth - 2);
     display.fillRect(barX + 1, barY + 1, fillWidth, barHeight - 2, SSD1306_WHITE);
-    
+
     // Menampilkan garis ambang batas (threshold)
     int thresholdX = map(threshold, 0, 100, 0, barWidth - 2);
     display.drawFastVLine(barX + 1 + thresholdX, barY + 1, barHeight - 2, SSD1306_INVERSE);
+}
+
+static int32_t moistureBarKey(float moisture, int threshold) {
+    return map(moisture, 0, 100, 0, SCREEN_WIDTH - 2) * 1000 + map(threshold, 0, 100, 0, SCREEN_WIDTH - 2);
+}
+
+static void drawHeader(const char* title) {
+    display.setTextSize(1);
+    display.setCursor(0, 0);
+    display.print(title);
+    display.drawFastHLine(0, 10, SCREEN_WIDTH, SSD1306_WHITE);
+}
 
+// Scene 0: Tampilan Utama (Dashboard)
+static void mainSceneChrome() {
+    display.drawBitmap(0, 0, plant_leaf_icon, 16, 16, SSD1306_WHITE);
+    display.drawBitmap(0, 24, temp_thermometer_icon, 16, 16, SSD1306_WHITE);
+    display.drawBitmap(72, 24, pump_motor_icon, 16, 16, SSD1306_WHITE);
+}
+
+static void mainSceneWidgets(const SceneData& data) {
     // --- Peringatan Kedip (Blinking Alert) ---
     if (lowMoistureAlert) {
         if (millis() - lastBlinkTime > 500) {
             lastBlinkTime = millis();
             blinkState = !blinkState;
         }
-        if (blinkState) {
+    }
+    // Ikon peringatan menumpuk di area nama tanaman: kalau ikon berubah,
+    // area nama digambar ulang lalu ikon digambar di atasnya.
+    bool alertVisible = lowMoistureAlert && blinkState;
+    bool alertChanged = !widgetValid[W_ALERT] || widgetKeys[W_ALERT] != alertVisible;
+    if (alertChanged) widgetValid[W_PLANT_NAME] = false;
+
+    // --- Baris 1: Nama Tanaman ---
+    if (widgetNeedsRedraw(W_PLANT_NAME, plantNameCache.version, 20, 0, SCREEN_WIDTH - 20, 16)) {
+        // Solusi: Ukuran Font Dinamis
+        if (plantNameCache.smallFont) {
+            display.setTextSize(1);
+            display.setCursor(20, 4); // Sesuaikan posisi vertikal untuk font kecil
+        } else {
+            display.setTextSize(2);
+            display.setCursor(20, 0);
+        }
+        display.print(plantNameCache.text);
+
+        widgetKeys[W_ALERT] = alertVisible;
+        widgetValid[W_ALERT] = true;
+        if (alertVisible) {
             display.drawBitmap(112, 0, alert_droplet_icon, 16, 16, SSD1306_WHITE);
         }
     }
+
+    // --- Baris 2: Data Sensor dan Status Pompa ---
+    if (widgetNeedsRedraw(W_TEMP, lroundf(data.temp), 20, 24, 52, 16)) {
+        display.setTextSize(2);
+        display.setCursor(20, 24);
+        // **DIUBAH DI SINI: Menghilangkan koma pada suhu**
+        display.printf("%.0fC", data.temp);
+    }
+
+    if (widgetNeedsRedraw(W_PUMP, data.pumpOn, 92, 24, SCREEN_WIDTH - 92, 16)) {
+        display.setTextSize(2);
+        display.setCursor(92, 24);
+        display.print(data.pumpOn ? "ON" : "OFF");
+    }
+
+    // --- Baris 3: Kelembapan Tanah (Tata Letak Baru) ---
+    // 1. Tampilkan teks label di baris atasnya
+    if (widgetNeedsRedraw(W_MOISTURE_TEXT, lroundf(data.moisture), 0, 48, SCREEN_WIDTH, 8)) {
+        display.setTextSize(1);
+        display.setCursor(0, 48); // Pindahkan teks ke y=48
+        display.printf("Kelembapan Tanah: %.0f%%", data.moisture);
+    }
+
+    // 2. Gambar progress bar di baris paling bawah (lebar penuh)
+    if (widgetNeedsRedraw(W_MOISTURE_BAR, moistureBarKey(data.moisture, data.threshold), 0, 58, SCREEN_WIDTH, 6)) {
+        drawMoistureBar(58, 6, data.moisture, data.threshold); // bar sedikit lebih ramping
+    }
 }
 
 // Scene 1: Info Konfigurasi Tanaman
-void showPlantInfoScene(int threshold) {
-    display.clearDisplay();
-    display.setTextColor(SSD1306_WHITE);
-
-    // Header
-    display.setTextSize(1);
-    display.setCursor(0, 0);
-    display.print("PLANT CONFIGURATION");
-    display.drawFastHLine(0, 10, SCREEN_WIDTH, SSD1306_WHITE);
+static void plantInfoSceneChrome() {
+    drawHeader("PLANT CONFIGURATION");
 
     // Nama Tanaman (diberi ruang khusus agar tidak terpotong)
     display.setCursor(0, 18);
     display.print("Plant Name:");
-    display.setTextSize(2);
-    
-    String plantName = capitalize(rulePlantName);
-    int16_t x1, y1;
-    uint16_t w, h;
-    display.getTextBounds(plantName, 0, 0, &x1, &y1, &w, &h);
-    // Tampilkan nama di tengah layar
-    display.setCursor((SCREEN_WIDTH - w) / 2, 28);
-    display.println(plantName);
-    
+}
+
+static void plantInfoSceneWidgets(const SceneData& data) {
+    if (widgetNeedsRedraw(W_INFO_PLANT_NAME, plantNameCache.version, 0, 28, SCREEN_WIDTH, 16)) {
+        // Tampilkan nama di tengah layar (posisi dari cache)
+        display.setTextSize(2);
+        display.setCursor(plantNameCache.centeredX, 28);
+        display.print(plantNameCache.text);
+    }
+
     // Info Tambahan
-    display.setTextSize(1);
-    display.setCursor(0, 50);
-    display.printf("Threshold: %d%% | Mode: %s", threshold, (actuatorMode == "auto" ? "Auto" : "Manual"));
+    bool autoMode = actuatorMode[data.zone] == MODE_AUTO;
+    if (widgetNeedsRedraw(W_INFO_FOOTER, data.threshold * 2 + autoMode, 0, 50, SCREEN_WIDTH, 14)) {
+        display.setTextSize(1);
+        display.setCursor(0, 50);
+        display.printf("Threshold: %d%% | Mode: %s", data.threshold, (autoMode ? "Auto" : "Manual"));
+    }
 }
 
 // Scene 2: Data Sensor Lingkungan (DHT)
-void showEnvironmentScene(float temperature, float humidity) {
-    display.clearDisplay();
-    display.setTextColor(SSD1306_WHITE);
+static void environmentSceneChrome() {
+    drawHeader("ENVIRONMENT SENSORS");
+    display.drawBitmap(10, 20, temp_thermometer_icon, 16, 16, SSD1306_WHITE);
+    display.drawBitmap(10, 44, humidity_droplet_icon, 16, 16, SSD1306_WHITE);
+}
 
-    // Header
-    display.setTextSize(1);
-    display.setCursor(0, 0);
-    display.print("ENVIRONMENT SENSORS");
-    display.drawFastHLine(0, 10, SCREEN_WIDTH, SSD1306_WHITE);
-    
+static void environmentSceneWidgets(const SceneData& data) {
     // Suhu
-    display.drawBitmap(10, 20, temp_thermometer_icon, 16, 16, SSD1306_WHITE);
-    display.setTextSize(2);
-    display.setCursor(32, 20);
-    display.printf("%.1f C", temperature);
-    
+    if (widgetNeedsRedraw(W_ENV_TEMP, lroundf(data.temp * 10), 32, 20, SCREEN_WIDTH - 32, 16)) {
+        display.setTextSize(2);
+        display.setCursor(32, 20);
+        display.printf("%.1f C", data.temp);
+    }
+
     // Kelembapan Udara
-    display.drawBitmap(10, 44, humidity_droplet_icon, 16, 16, SSD1306_WHITE);
-    display.setTextSize(2);
-    display.setCursor(32, 44);
-    display.printf("%.1f %%", humidity);
+    if (widgetNeedsRedraw(W_ENV_HUMIDITY, lroundf(data.humidity * 10), 32, 44, SCREEN_WIDTH - 32, 16)) {
+        display.setTextSize(2);
+        display.setCursor(32, 44);
+        display.printf("%.1f %%", data.humidity);
+    }
 }
 
 // Scene 3: Detail Kelembapan Tanah
-void showMoistureScene(float moisture, int threshold) {
-    display.clearDisplay();
-    display.setTextColor(SSD1306_WHITE);
-    
-    // Header
-    display.setTextSize(1);
-    display.setCursor(0, 0);
-    display.print("SOIL MOISTURE");
-    display.drawFastHLine(0, 10, SCREEN_WIDTH, SSD1306_WHITE);
+static void moistureSceneChrome() {
+    drawHeader("SOIL MOISTURE");
+}
 
-    // Angka Persentase Besar
-    display.setTextSize(3);
-    String moistureText = String((int)moisture) + "%";
-    int16_t x1, y1;
-    uint16_t w, h;
-    display.getTextBounds(moistureText, 0, 0, &x1, &y1, &w, &h);
-    display.setCursor((SCREEN_WIDTH - w) / 2, 20);
-    display.print(moistureText);
+static void moistureSceneWidgets(const SceneData& data) {
+    // Angka Persentase Besar (ukuran 3: 18 px per karakter font bawaan)
+    int moistureValue = (int)data.moisture;
+    if (widgetNeedsRedraw(W_SOIL_VALUE, moistureValue, 0, 20, SCREEN_WIDTH, 24)) {
+        char moistureText[8];
+        int len = snprintf(moistureText, sizeof(moistureText), "%d%%", moistureValue);
+        display.setTextSize(3);
+        display.setCursor((SCREEN_WIDTH - len * 18) / 2, 20);
+        display.print(moistureText);
+    }
 
     // Bar Kelembapan di bagian bawah
-    display.setTextSize(1);
-    display.setCursor(0, 56);
-    display.printf("Threshold: %d%%", threshold);
+    if (widgetNeedsRedraw(W_SOIL_THRESHOLD, data.threshold, 0, 56, SCREEN_WIDTH, 8)) {
+        display.setTextSize(1);
+        display.setCursor(0, 56);
+        display.printf("Threshold: %d%%", data.threshold);
+    }
 
-    int barX = 0;
-    int barY = 46;
-    int barWidth = SCREEN_WIDTH;
-    int barHeight = 8;
-    display.drawRect(barX, barY, barWidth, barHeight, SSD1306_WHITE);
+    if (widgetNeedsRedraw(W_SOIL_BAR, moistureBarKey(data.moisture, data.threshold), 0, 46, SCREEN_WIDTH, 8)) {
+        drawMoistureBar(46, 8, data.moisture, data.threshold);
+    }
+}
 
-    int fillWidth = map(moisture, 0, 100, 0, barWidth - 2);
-    display.fillRect(barX + 1, barY + 1, fillWidth, barHeight - 2, SSD1306_WHITE);
-    
-    int thresholdX = map(threshold, 0, 100, 0, barWidth - 2);
-    display.drawFastVLine(barX + 1 + thresholdX, barY + 1, barHeight - 2, SSD1306_INVERSE);
+// Urutan rotasi scene (0: Utama, 1: Info, 2: Lingkungan, 3: Tanah)
+static const SceneTemplate scenes[] = {
+    { mainSceneChrome, mainSceneWidgets },
+    { plantInfoSceneChrome, plantInfoSceneWidgets },
+    { environmentSceneChrome, environmentSceneWidgets },
+    { moistureSceneChrome, moistureSceneWidgets },
+};
+static const int TOTAL_SCENES = sizeof(scenes) / sizeof(scenes[0]);
+
+// Elemen statis setiap scene, dirender sekali dalam format buffer SSD1306
+static uint8_t sceneChrome[TOTAL_SCENES][SCREEN_WIDTH * OLED_PAGES];
+
+static void prerenderSceneChrome() {
+    display.setTextColor(SSD1306_WHITE);
+    for (int i = 0; i < TOTAL_SCENES; i++) {
+        display.clearDisplay();
+        scenes[i].drawChrome();
+        memcpy(sceneChrome[i], display.getBuffer(), sizeof(sceneChrome[i]));
+    }
+    display.clearDisplay();
 }
 
 // Fungsi utama untuk manajemen dan pembaruan scene
-void updateDisplay(float temp, float moisture, int threshold, const String& pumpStatusStr) {
+void updateDisplay(float temp, float moisture, int threshold, bool pumpOn) {
     unsigned long currentTime = millis();
-    
+    if ((long)(currentTime - splashUntil) < 0) return; // splash masih tampil
+
+    unsigned long frameStart = micros();
+
     // Ganti scene jika sudah waktunya
     if (currentTime - lastSceneChange >= SCENE_DURATION) {
-        currentScene = (currentScene + 1) % TOTAL_SCENES; // Loop dari 0 ke 3
+        currentScene = (currentScene + 1) % TOTAL_SCENES;
         lastSceneChange = currentTime;
     }
-    
-    // Tampilkan scene yang sedang aktif
-    switch (currentScene) {
-        case 0:
-            showMainScene(temp, moisture, threshold, pumpStatusStr);
-            break;
-        case 1:
-            showPlantInfoScene(threshold);
-            break;
-        case 2:
-            // Pastikan Anda meneruskan nilai humidity dari sensor DHT di sini
-            showEnvironmentScene(temp, lastHumidity); 
-            break;
-        case 3:
-            showMoistureScene(moisture, threshold);
-            break;
-        default:
-            showMainScene(temp, moisture, threshold, pumpStatusStr);
-            break;
+
+    // Scene baru: salin template statis, setelah itu hanya widget yang berubah
+    if (currentScene != drawnScene) {
+        memcpy(display.getBuffer(), sceneChrome[currentScene], sizeof(sceneChrome[currentScene]));
+        invalidateWidgets();
+        drawnScene = currentScene;
+        statAdd(displayStats.fullRedraws, 1UL);
     }
 
-    display.display();
+    refreshPlantNameCache(displayZone);
+
+    SceneData data;
+    data.zone = displayZone;
+    data.temp = temp;
+    data.moisture = moisture;
+    data.threshold = threshold;
+    // Pastikan Anda meneruskan nilai humidity dari sensor DHT di sini
+    data.humidity = lastHumidity;
+    data.pumpOn = pumpOn;
+
+    display.setTextColor(SSD1306_WHITE);
+    scenes[currentScene].drawWidgets(data);
+
+    postFrame();
+
+    unsigned long frameUs = micros() - frameStart;
+    statAdd(displayStats.frames, 1UL);
+    statSet(displayStats.lastFrameUs, displayStats.maxFrameUs, frameUs);
+    statAdd(displayStats.totalFrameUs, frameUs);
+}
+
+void getDisplayStats(DisplayStats& out) {
+    const std::memory_order r = std::memory_order_relaxed;
+    out.frames = displayStats.frames.load(r);
+    out.fullRedraws = displayStats.fullRedraws.load(r);
+    out.lastFrameUs = displayStats.lastFrameUs.load(r);
+    out.maxFrameUs = displayStats.maxFrameUs.load(r);
+    out.totalFrameUs = displayStats.totalFrameUs.load(r);
+    out.flushes = displayStats.flushes.load(r);
+    out.droppedFrames = displayStats.droppedFrames.load(r);
+    out.lastFlushUs = displayStats.lastFlushUs.load(r);
+    out.maxFlushUs = displayStats.maxFlushUs.load(r);
+    out.lastI2cBytes = displayStats.lastI2cBytes.load(r);
+    out.totalI2cBytes = displayStats.totalI2cBytes.load(r);
 }
 
 // Fungsi updateDisplayScenes dengan parameter humidity tambahan
-void updateDisplayScenes(float temp, float moisture, int threshold, float humidity) {
+void updateDisplayScenes(uint8_t zone, float temp, float moisture, int threshold, float humidity, bool pumpOn) {
     // Update variabel global lastHumidity dengan nilai yang diterima
     lastHumidity = humidity;
-    
-    // Tentukan status pompa berdasarkan mode dan kondisi
-    String pumpStatusStr = "0"; // Default OFF
-    if (actuatorMode == "auto") {
-        // Untuk auto mode, kita perlu menentukan status pompa berdasarkan kondisi
-        // Ini adalah logika sederhana - bisa disesuaikan dengan kebutuhan
-        pumpStatusStr = (moisture < threshold) ? "1" : "0";
-    } else {
-        // Untuk manual mode, gunakan actuatorStatus dari main.cpp
-        extern String actuatorStatus;
-        pumpStatusStr = (actuatorStatus == "on") ? "1" : "0";
-    }
-    
-    // Panggil fungsi updateDisplay yang sudah ada
-    updateDisplay(temp, moisture, threshold, pumpStatusStr);
+    displayZone = zone < ZONE_COUNT ? zone : 0;
+
+    // Status pompa diambil dari relay yang sebenarnya, bukan ditebak dari
+    // moisture < threshold (cap pompa, siklus dan max_moisture ikut berlaku)
+    updateDisplay(temp, moisture, threshold, pumpOn);
 }
 
 // Fungsi untuk reset scene (opsional)
 void resetSceneTiming() {
     lastSceneChange = millis();
     currentScene = 0;
+    drawnScene = -1;
 }
\ No newline at end of file
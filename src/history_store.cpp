@@ -0,0 +1,399 @@
+#include "history_store.h"
+#include "config.h"
+#include "logger.h"
+#include <FS.h>
+#include <LittleFS.h>
+#include <time.h>
+
+static const char* HISTORY_PATH = "/history.bin";
+
+// Sample encoding: one tag byte, then the optional fields it announces
+enum HistoryTag : uint8_t {
+    TAG_MOISTURE    = 1 << 0,  // zigzag varint delta follows, per set channel bit
+    TAG_TEMPERATURE = 1 << 1,
+    TAG_HUMIDITY    = 1 << 2,
+    TAG_PUMP_ON     = 1 << 3,  // pump state itself, no payload
+    TAG_NEW_STEP    = 1 << 4   // varint time step follows, otherwise same as the previous one
+};
+static const int CHANNELS = 3;
+// Worst case: tag + 5-byte step + three 3-byte deltas (int16 range)
+static const size_t MAX_SAMPLE_BYTES = 1 + 5 + CHANNELS * 3;
+
+struct HistoryBlockHeader {
+    uint32_t seq;            // 1-based, 0 = empty
+    uint32_t firstTimestamp;
+    uint32_t lastTimestamp;
+    uint16_t bootId;
+    uint16_t count;
+    uint16_t used;           // bytes of data[] in use
+    uint8_t flags;           // TelemetryFlags shared by every sample in the block
+    uint8_t zone;            // every sample in a block belongs to one zone (was reserved, so 0)
+};
+
+struct HistoryBlock {
+    HistoryBlockHeader header;
+    uint8_t data[HISTORY_BLOCK_BYTES - sizeof(HistoryBlockHeader)];
+};
+
+struct HistoryFlashSlot {
+    HistoryBlock block;
+    uint16_t crc;
+};
+
+// Delta coder state; a fresh block starts from zero values and a zero step
+struct HistoryCursor {
+    uint32_t timestamp;
+    uint32_t step;
+    int32_t values[CHANNELS];
+};
+
+static const size_t RAM_BLOCKS = HISTORY_RAM_BYTES / sizeof(HistoryBlock);
+static HistoryBlock ramBlocks[RAM_BLOCKS];
+static size_t ramOldest = 0;
+static size_t ramCount = 0;
+// Zones delta-code separately, each into its own newest block
+static HistoryCursor writer[ZONE_COUNT] = {};  // state after the zone's newest sample
+static uint32_t openSeq[ZONE_COUNT] = {};      // seq of the zone's newest block, 0 = none
+static uint32_t nextSeq = 1;
+
+#if HISTORY_FLASH_BLOCKS > 0
+// Headers of the flash blocks, slot = seq % HISTORY_FLASH_BLOCKS, so queries
+// only read the blocks that overlap the requested range
+static HistoryBlockHeader flashIndex[HISTORY_FLASH_BLOCKS];
+static uint32_t flashNewestSeq = 0;
+static uint16_t flashLive = 0;
+#endif
+static bool flashReady = false;
+static HistoryStats stats = {};
+
+static uint16_t crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static inline size_t putVarint(uint8_t* out, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static inline bool readVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 35; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static inline void sampleValues(const TelemetrySample& s, int32_t values[CHANNELS]) {
+    values[0] = s.moistureX10;
+    values[1] = s.temperatureX10;
+    values[2] = s.humidityX10;
+}
+
+// Offset that turns the block's timestamps into epoch seconds. Uptime stamps
+// only map onto the wall clock for this boot and once NTP has synced.
+static bool epochOffset(const HistoryBlockHeader& h, uint32_t& offset) {
+    if (!(h.flags & TELEMETRY_TS_UPTIME)) {
+        offset = 0;
+        return true;
+    }
+    time_t now = time(nullptr);
+    if (now <= EPOCH_VALID_AFTER || h.bootId != telemetryStore_bootId()) return false;
+    offset = (uint32_t)now - millis() / 1000;
+    return true;
+}
+
+static void dropBlock(const HistoryBlockHeader& h) {
+    stats.samples -= h.count;
+    stats.encodedBytes -= h.used;
+    stats.droppedBlocks++;
+}
+
+#if HISTORY_FLASH_BLOCKS > 0
+static bool writeFlashSlot(const HistoryBlock& block) {
+    File f = LittleFS.open(HISTORY_PATH, "r+");
+    if (!f) return false;
+    static HistoryFlashSlot slot;
+    slot.block = block;
+    slot.crc = crc16(reinterpret_cast<const uint8_t*>(&slot), offsetof(HistoryFlashSlot, crc));
+    size_t index = block.header.seq % HISTORY_FLASH_BLOCKS;
+    bool ok = f.seek(index * sizeof(HistoryFlashSlot), SeekSet) &&
+              f.write(reinterpret_cast<const uint8_t*>(&slot), sizeof(slot)) == sizeof(slot);
+    f.close();
+    if (!ok) return false;
+
+    if (flashIndex[index].seq != 0) dropBlock(flashIndex[index]);
+    else flashLive++;
+    flashIndex[index] = block.header;
+    flashNewestSeq = block.header.seq;
+    stats.flashWrites++;
+    return true;
+}
+
+static bool readFlashSlot(File& f, uint32_t seq, HistoryFlashSlot& slot) {
+    if (!f.seek((seq % HISTORY_FLASH_BLOCKS) * sizeof(HistoryFlashSlot), SeekSet)) return false;
+    if (f.read(reinterpret_cast<uint8_t*>(&slot), sizeof(slot)) != sizeof(slot)) return false;
+    return slot.block.header.seq == seq &&
+           slot.crc == crc16(reinterpret_cast<const uint8_t*>(&slot), offsetof(HistoryFlashSlot, crc));
+}
+#endif
+
+static void evictOldest() {
+    HistoryBlock& oldest = ramBlocks[ramOldest];
+#if HISTORY_FLASH_BLOCKS > 0
+    if (!flashReady || !writeFlashSlot(oldest)) dropBlock(oldest.header);
+#else
+    dropBlock(oldest.header);
+#endif
+    ramOldest = (ramOldest + 1) % RAM_BLOCKS;
+    ramCount--;
+}
+
+// RAM blocks hold consecutive sequence numbers ending at nextSeq - 1
+static HistoryBlock* ramBlock(uint32_t seq) {
+    if (seq == 0 || nextSeq - seq > ramCount) return nullptr;
+    return &ramBlocks[(ramOldest + ramCount - (nextSeq - seq)) % RAM_BLOCKS];
+}
+
+static HistoryBlock& openBlock(const TelemetrySample& s) {
+    if (ramCount == RAM_BLOCKS) evictOldest();
+    HistoryBlock& block = ramBlocks[(ramOldest + ramCount) % RAM_BLOCKS];
+    ramCount++;
+
+    memset(&block.header, 0, sizeof(block.header));
+    block.header.seq = nextSeq++;
+    block.header.firstTimestamp = s.timestamp;
+    block.header.lastTimestamp = s.timestamp;
+    block.header.bootId = s.bootId;
+    block.header.flags = s.flags;
+    block.header.zone = s.zone;
+    openSeq[s.zone] = block.header.seq;
+    HistoryCursor& cursor = writer[s.zone];
+    memset(&cursor, 0, sizeof(cursor));
+    cursor.timestamp = s.timestamp;
+    return block;
+}
+
+// A block only holds samples with one time base that run forward in time
+static bool fitsBlock(const HistoryBlock& block, const TelemetrySample& s) {
+    const HistoryBlockHeader& h = block.header;
+    return h.used + MAX_SAMPLE_BYTES <= sizeof(block.data) &&
+           h.bootId == s.bootId && h.flags == s.flags && s.timestamp >= h.lastTimestamp;
+}
+
+void history_append(const TelemetrySample& s) {
+    if (s.zone >= ZONE_COUNT) return;
+    HistoryBlock* block = ramBlock(openSeq[s.zone]);
+    if (block == nullptr || !fitsBlock(*block, s)) block = &openBlock(s);
+    HistoryCursor& cursor = writer[s.zone];
+
+    HistoryBlockHeader& h = block->header;
+    uint8_t* out = block->data + h.used;
+    uint8_t* p = out + 1;
+    uint8_t tag = s.pumpOn ? TAG_PUMP_ON : 0;
+
+    uint32_t step = s.timestamp - cursor.timestamp;
+    if (step != cursor.step) {
+        tag |= TAG_NEW_STEP;
+        p += putVarint(p, step);
+    }
+    int32_t values[CHANNELS];
+    sampleValues(s, values);
+    for (int c = 0; c < CHANNELS; c++) {
+        int32_t delta = values[c] - cursor.values[c];
+        if (delta != 0) {
+            tag |= 1 << c;
+            p += putVarint(p, zigzag(delta));
+        }
+        cursor.values[c] = values[c];
+    }
+    *out = tag;
+
+    cursor.timestamp = s.timestamp;
+    cursor.step = step;
+    size_t bytes = p - out;
+    h.used += bytes;
+    h.count++;
+    h.lastTimestamp = s.timestamp;
+    stats.samples++;
+    stats.encodedBytes += bytes;
+}
+
+static size_t visitBlock(const HistoryBlock& block, uint8_t zone, uint32_t from, uint32_t to,
+                         HistoryVisitor visitor, void* ctx) {
+    const HistoryBlockHeader& h = block.header;
+    uint32_t offset;
+    if (h.zone != zone) return 0;
+    if (!epochOffset(h, offset)) return 0;
+    if (h.lastTimestamp + offset < from || h.firstTimestamp + offset > to) return 0;
+
+    HistoryCursor cursor = {};
+    cursor.timestamp = h.firstTimestamp;
+    TelemetrySample sample = {};
+    sample.bootId = h.bootId;
+    sample.zone = h.zone;
+
+    size_t visited = 0;
+    const uint8_t* p = block.data;
+    const uint8_t* end = block.data + h.used;
+    for (uint16_t i = 0; i < h.count && p < end; i++) {
+        uint8_t tag = *p++;
+        uint32_t v;
+        if (tag & TAG_NEW_STEP) {
+            if (!readVarint(p, end, v)) break;
+            cursor.step = v;
+        }
+        cursor.timestamp += cursor.step;
+        for (int c = 0; c < CHANNELS; c++) {
+            if (!(tag & (1 << c))) continue;
+            if (!readVarint(p, end, v)) return visited;
+            cursor.values[c] += unzigzag(v);
+        }
+
+        uint32_t ts = cursor.timestamp + offset;
+        if (ts < from) continue;
+        if (ts > to) break;
+        sample.timestamp = ts;
+        sample.moistureX10 = (uint16_t)cursor.values[0];
+        sample.temperatureX10 = (int16_t)cursor.values[1];
+        sample.humidityX10 = (uint16_t)cursor.values[2];
+        sample.pumpOn = (tag & TAG_PUMP_ON) ? 1 : 0;
+        visitor(sample, ctx);
+        visited++;
+    }
+    return visited;
+}
+
+size_t history_query(uint8_t zone, uint32_t from, uint32_t to, HistoryVisitor visitor, void* ctx) {
+    unsigned long start = micros();
+    size_t visited = 0;
+
+#if HISTORY_FLASH_BLOCKS > 0
+    if (flashReady && flashLive > 0) {
+        File f = LittleFS.open(HISTORY_PATH, "r");
+        if (f) {
+            static HistoryFlashSlot slot;
+            uint32_t seq = flashNewestSeq >= HISTORY_FLASH_BLOCKS ? flashNewestSeq - HISTORY_FLASH_BLOCKS + 1 : 1;
+            for (; seq <= flashNewestSeq; seq++) {
+                const HistoryBlockHeader& h = flashIndex[seq % HISTORY_FLASH_BLOCKS];
+                uint32_t offset;
+                if (h.seq != seq || h.zone != zone || !epochOffset(h, offset)) continue;
+                if (h.lastTimestamp + offset < from || h.firstTimestamp + offset > to) continue;
+                if (readFlashSlot(f, seq, slot)) visited += visitBlock(slot.block, zone, from, to, visitor, ctx);
+            }
+            f.close();
+        }
+    }
+#endif
+    for (size_t i = 0; i < ramCount; i++) {
+        visited += visitBlock(ramBlocks[(ramOldest + i) % RAM_BLOCKS], zone, from, to, visitor, ctx);
+    }
+
+    unsigned long elapsed = micros() - start;
+    stats.queries++;
+    stats.lastQueryUs = elapsed;
+    if (elapsed > stats.maxQueryUs) stats.maxQueryUs = elapsed;
+    return visited;
+}
+
+bool history_begin() {
+#if HISTORY_FLASH_BLOCKS > 0
+    if (!LittleFS.begin(true)) {
+        LOG_WARN(LOG_TAG_MQTT, "LittleFS mount gagal - history kept in RAM only");
+        return false;
+    }
+
+    const size_t fileSize = HISTORY_FLASH_BLOCKS * sizeof(HistoryFlashSlot);
+    File f = LittleFS.open(HISTORY_PATH, "r");
+    if (!f || f.size() != fileSize) {
+        if (f) f.close();
+        // Preallocate the ring once; blank slots never pass the CRC check
+        f = LittleFS.open(HISTORY_PATH, "w");
+        if (!f) return false;
+        uint8_t zeros[64] = {};
+        for (size_t written = 0; written < fileSize; written += sizeof(zeros)) {
+            f.write(zeros, min(sizeof(zeros), fileSize - written));
+        }
+        f.close();
+        flashReady = true;
+        return true;
+    }
+
+    // Rebuild the header index from the slots
+    static HistoryFlashSlot slot;
+    for (uint32_t i = 0; i < HISTORY_FLASH_BLOCKS; i++) {
+        if (f.read(reinterpret_cast<uint8_t*>(&slot), sizeof(slot)) != sizeof(slot)) break;
+        const HistoryBlockHeader& h = slot.block.header;
+        if (h.seq == 0 || h.seq % HISTORY_FLASH_BLOCKS != i) continue;
+        if (slot.crc != crc16(reinterpret_cast<const uint8_t*>(&slot), offsetof(HistoryFlashSlot, crc))) continue;
+        flashIndex[i] = h;
+        if (h.seq > flashNewestSeq) flashNewestSeq = h.seq;
+    }
+    f.close();
+
+    for (uint32_t i = 0; i < HISTORY_FLASH_BLOCKS; i++) {
+        HistoryBlockHeader& h = flashIndex[i];
+        if (h.seq == 0) continue;
+        if (h.seq + HISTORY_FLASH_BLOCKS <= flashNewestSeq) { // stale leftover
+            h.seq = 0;
+            continue;
+        }
+        flashLive++;
+        stats.samples += h.count;
+        stats.encodedBytes += h.used;
+    }
+    nextSeq = flashNewestSeq + 1;
+    flashReady = true;
+    if (flashLive > 0) {
+        LOG_INFO(LOG_TAG_MQTT, "History restored: %lu samples in %u blocks", (unsigned long)stats.samples, flashLive);
+    }
+#endif
+    return true;
+}
+
+void history_getStats(HistoryStats& out) {
+    out = stats;
+    out.bytesPerSample = stats.samples ? (float)stats.encodedBytes / stats.samples : 0.0f;
+    out.ramBlocks = ramCount;
+    out.flashBlocks = 0;
+    out.oldestTimestamp = 0;
+
+    uint32_t offset;
+#if HISTORY_FLASH_BLOCKS > 0
+    out.flashBlocks = flashLive;
+    uint32_t seq = flashNewestSeq >= HISTORY_FLASH_BLOCKS ? flashNewestSeq - HISTORY_FLASH_BLOCKS + 1 : 1;
+    for (; flashLive > 0 && seq <= flashNewestSeq; seq++) {
+        const HistoryBlockHeader& h = flashIndex[seq % HISTORY_FLASH_BLOCKS];
+        if (h.seq == seq && epochOffset(h, offset)) {
+            out.oldestTimestamp = h.firstTimestamp + offset;
+            return;
+        }
+    }
+#endif
+    for (size_t i = 0; i < ramCount; i++) {
+        const HistoryBlockHeader& h = ramBlocks[(ramOldest + i) % RAM_BLOCKS].header;
+        if (epochOffset(h, offset)) {
+            out.oldestTimestamp = h.firstTimestamp + offset;
+            return;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include "json_arena.h"
+
+// Each block is prefixed with its size so reallocate() can copy old contents.
+struct ArenaHeader {
+    size_t size;
+};
+
+static const size_t ARENA_ALIGN = sizeof(void*);
+
+static inline size_t alignUp(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+JsonArena::JsonArena(uint8_t* buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity), offset(0), lastBlock(0), peak(0), fallbacks(0) {}
+
+bool JsonArena::owns(const void* ptr) const {
+    const uint8_t* p = static_cast<const uint8_t*>(ptr);
+    return p >= buffer && p < buffer + capacity;
+}
+
+void* JsonArena::allocate(size_t size) {
+    size_t need = alignUp(sizeof(ArenaHeader)) + alignUp(size);
+    if (offset + need > capacity) {
+        fallbacks++;
+        return malloc(size);
+    }
+    ArenaHeader* h = reinterpret_cast<ArenaHeader*>(buffer + offset);
+    h->size = size;
+    lastBlock = offset;
+    offset += need;
+    if (offset > peak) peak = offset;
+    return buffer + lastBlock + alignUp(sizeof(ArenaHeader));
+}
+
+void JsonArena::deallocate(void* ptr) {
+    if (ptr == nullptr) return;
+    if (!owns(ptr)) {
+        free(ptr);
+        return;
+    }
+    // Arena memory is released by reset(); only the newest block can be rolled back.
+    size_t blockStart = static_cast<uint8_t*>(ptr) - buffer - alignUp(sizeof(ArenaHeader));
+    if (blockStart == lastBlock) offset = lastBlock;
+}
+
+void* JsonArena::reallocate(void* ptr, size_t newSize) {
+    if (ptr == nullptr) return allocate(newSize);
+    if (!owns(ptr)) {
+        fallbacks++;
+        return realloc(ptr, newSize);
+    }
+
+    size_t dataStart = static_cast<uint8_t*>(ptr) - buffer;
+    size_t blockStart = dataStart - alignUp(sizeof(ArenaHeader));
+    ArenaHeader* h = reinterpret_cast<ArenaHeader*>(buffer + blockStart);
+
+    // Newest block: grow or shrink in place
+    if (blockStart == lastBlock && dataStart + alignUp(newSize) <= capacity) {
+        h->size = newSize;
+        offset = dataStart + alignUp(newSize);
+        if (offset > peak) peak = offset;
+        return ptr;
+    }
+    if (newSize <= h->size) {
+        h->size = newSize;
+        return ptr;
+    }
+
+    void* moved = allocate(newSize);
+    if (moved != nullptr) memcpy(moved, ptr, h->size);
+    return moved;
+}
+
+void JsonArena::reset() {
+    offset = 0;
+    lastBlock = 0;
+}
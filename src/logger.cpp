@@ -0,0 +1,204 @@
+#include "logger.h"
+#include "config.h"
+#include "mem_diag.h"
+
+static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "LOG_RING_SLOTS must be a power of two");
+
+// Bounded multi-producer / single-consumer ring. Each slot carries a
+// sequence number: producers claim a position with a CAS on enqueuePos and
+// publish the slot by advancing its sequence, so they never wait for each
+// other or for the log task.
+struct LogSlot {
+    std::atomic<uint32_t> sequence;
+    LogRecord record;
+};
+
+static LogSlot slots[LOG_RING_SLOTS];
+static std::atomic<uint32_t> enqueuePos(0);
+static uint32_t dequeuePos = 0; // log task only
+static std::atomic<unsigned long> dropped(0);
+static std::atomic<unsigned long> written(0); // log task only; read by log_getStats
+
+std::atomic<uint8_t> logRuntimeLevel[LOG_TAG_COUNT];
+
+static const char* const TAG_NAMES[LOG_TAG_COUNT] = { "main", "ctrl", "mqtt", "net", "diag" };
+static const char* const LEVEL_NAMES[] = { "none", "error", "warn", "info", "debug" };
+static const char LEVEL_CHARS[] = { '-', 'E', 'W', 'I', 'D' };
+
+// Static initializer so LOG_* works before log_begin(), e.g. early in setup()
+namespace {
+struct RingInit {
+    RingInit() {
+        for (uint32_t i = 0; i < LOG_RING_SLOTS; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+        for (uint8_t t = 0; t < LOG_TAG_COUNT; t++) logRuntimeLevel[t].store(LOG_COMPILE_LEVEL, std::memory_order_relaxed);
+    }
+} ringInit;
+}
+
+void logdetail::put(LogRecord& r, const char* s) {
+    if (s == nullptr) s = "(null)";
+    uint8_t offset = r.textUsed < LOG_TEXT_BYTES ? r.textUsed : LOG_TEXT_BYTES - 1;
+    size_t room = LOG_TEXT_BYTES - offset;
+    size_t n = strnlen(s, room - 1);
+    memcpy(r.text + offset, s, n);
+    r.text[offset + n] = '\0';
+    r.textUsed = offset + n + 1 <= LOG_TEXT_BYTES ? offset + n + 1 : LOG_TEXT_BYTES;
+    r.args[r.argCount++] = offset;
+}
+
+bool log_push(LogRecord& record) {
+    record.timestampMs = millis();
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    for (;;) {
+        slot = &slots[pos & (LOG_RING_SLOTS - 1)];
+        uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->record = record;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+static bool popRecord(LogRecord& out) {
+    LogSlot& slot = slots[dequeuePos & (LOG_RING_SLOTS - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) return false;
+    out = slot.record;
+    slot.sequence.store(dequeuePos + LOG_RING_SLOTS, std::memory_order_release);
+    dequeuePos++;
+    return true;
+}
+
+// Formats the record by walking its format string and handing each
+// conversion to snprintf with the stored argument. Length modifiers are
+// dropped since every argument was stored as 32 bits.
+size_t log_format(const LogRecord& r, char* out, size_t len) {
+    const LogSite* site = r.site;
+    int n = snprintf(out, len, "[%lu] %c %s: ", (unsigned long)r.timestampMs, LEVEL_CHARS[site->level], TAG_NAMES[site->tag]);
+    size_t pos = (n > 0 && (size_t)n < len) ? n : 0;
+    size_t limit = len - 2; // room for "\n\0"
+    uint8_t arg = 0;
+
+    const char* f = site->fmt;
+    while (*f && pos < limit) {
+        if (*f != '%') {
+            out[pos++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[pos++] = '%';
+            f += 2;
+            continue;
+        }
+
+        char spec[12];
+        size_t s = 0;
+        spec[s++] = *f++;
+        while (*f && strchr("-+ #0123456789.", *f) && s < sizeof(spec) - 2) spec[s++] = *f++;
+        while (*f && strchr("hlLzjt", *f)) f++;
+        char conv = *f;
+        if (conv == '\0') break;
+        f++;
+        spec[s++] = conv;
+        spec[s] = '\0';
+
+        if (arg >= r.argCount) {
+            out[pos++] = '?';
+            continue;
+        }
+        uint32_t v = r.args[arg++];
+        size_t room = limit + 1 - pos;
+        int w = 0;
+        switch (conv) {
+            case 'd': case 'i': case 'c':
+                w = snprintf(out + pos, room, spec, (int)v);
+                break;
+            case 'u': case 'x': case 'X': case 'o':
+                w = snprintf(out + pos, room, spec, (unsigned)v);
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+                float value;
+                memcpy(&value, &v, sizeof(value));
+                w = snprintf(out + pos, room, spec, (double)value);
+                break;
+            }
+            case 's':
+                w = snprintf(out + pos, room, spec, v < LOG_TEXT_BYTES ? r.text + v : "?");
+                break;
+            default:
+                break;
+        }
+        if (w > 0) pos += ((size_t)w < room) ? (size_t)w : room - 1;
+    }
+    out[pos++] = '\n';
+    out[pos] = '\0';
+    return pos;
+}
+
+void log_setLevel(LogTag tag, LogLevel level) {
+    if (tag < LOG_TAG_COUNT) logRuntimeLevel[tag].store(level, std::memory_order_relaxed);
+}
+
+static bool matchName(const char* const* names, size_t count, const char* name, size_t len, uint8_t* index) {
+    for (size_t i = 0; i < count; i++) {
+        if (strlen(names[i]) == len && memcmp(names[i], name, len) == 0) {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool log_parseLevel(const char* name, size_t len, LogLevel* level) {
+    uint8_t i;
+    if (!matchName(LEVEL_NAMES, sizeof(LEVEL_NAMES) / sizeof(LEVEL_NAMES[0]), name, len, &i)) return false;
+    *level = (LogLevel)i;
+    return true;
+}
+
+bool log_parseTag(const char* name, size_t len, LogTag* tag) {
+    uint8_t i;
+    if (!matchName(TAG_NAMES, LOG_TAG_COUNT, name, len, &i)) return false;
+    *tag = (LogTag)i;
+    return true;
+}
+
+void log_getStats(LogStats& out) {
+    out.written = written.load(std::memory_order_relaxed);
+    out.dropped = dropped.load(std::memory_order_relaxed);
+}
+
+// Log task: the only place that formats and waits for the UART
+static void logTask(void* arg) {
+    memDiag_registerCurrentTask();
+    static char line[LOG_LINE_MAX];
+    unsigned long reportedDrops = 0;
+    LogRecord record;
+    for (;;) {
+        while (popRecord(record)) {
+            size_t len = log_format(record, line, sizeof(line));
+            Serial.write(reinterpret_cast<const uint8_t*>(line), len);
+            written.store(written.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        unsigned long drops = dropped.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            int len = snprintf(line, sizeof(line), "[%lu] W log: %lu messages dropped (ring full)\n",
+                               millis(), drops - reportedDrops);
+            Serial.write(reinterpret_cast<const uint8_t*>(line), len);
+            reportedDrops = drops;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LOG_FLUSH_PERIOD_MS));
+    }
+}
+
+void log_begin() {
+    xTaskCreatePinnedToCore(logTask, "log", LOG_TASK_STACK, nullptr, LOG_TASK_PRIORITY, nullptr, LOG_TASK_CORE);
+}
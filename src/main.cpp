@@ -1,158 +1,287 @@
 #include <Arduino.h>
-#include <DHT.h>
+#include "actuation_trace.h"
+#include "boot_timing.h"
+#include "command_queue.h"
 #include "config.h"
+#include "device_state.h"
+#include "dht_reader.h"
 #include "display.h"
+#include "logger.h"
+#include "mem_diag.h"
 #include "mqtt_handler.h"
-#include "utils.h"
+#include "profiler.h"
+#include "rule_engine.h"
+#include "scheduler.h"
+#include "soil_sensor.h"
+#include "state_store.h"
+#include "zones.h"
 
 // Global variables (bisa dipakai di modul lain via extern)
-String currentPlantType = "chili";
-String actuatorMode = "manual";  // "manual" | "auto" - controlled via MQTT
-String actuatorStatus = "off";    // "on" | "off" - controlled via MQTT subscription
-bool lowMoistureAlert = false;
+ActuatorMode actuatorMode[ZONE_COUNT];   // controlled via MQTT commands, restored from NVS at boot
+bool actuatorStatusOn[ZONE_COUNT];       // controlled via MQTT commands
+bool lowMoistureAlert = false;           // any zone below its min moisture
 unsigned long lastBlinkTime = 0;
 bool blinkState = false;
 
-// DHT sensor state management
-bool dhtReadingEnabled = true;
+// Rule state per zone, updated via CMD_SET_RULE (defaults or NVS in setup())
+int ruleMinMoisture[ZONE_COUNT];
+int ruleMaxMoisture[ZONE_COUNT];
+char rulePlantName[ZONE_COUNT][PLANT_NAME_MAX];
+int rulePreferredHumidity[ZONE_COUNT];
+int rulePreferredTemp[ZONE_COUNT];
+
+// Last valid DHT readings
 float lastTemperature = 0.0;
 float lastHumidity = 0.0;
 
-// MQTT sensor publishing timing
-unsigned long lastMqttPublishTime = 0;
-const unsigned long MQTT_PUBLISH_INTERVAL = 5000; // 5 seconds in milliseconds
+// Latest values produced by the sensing stages and consumed by the others
+float currentMoisture[ZONE_COUNT];
+float currentTemperature = 0.0;
+float currentHumidity = 0.0;
+ZoneMask pumpOn = 0;
 
-// DHT & sensor
-DHT dht(DHTPIN, DHTTYPE);
+// --- Scheduler stages ---
 
-void setup() {
-    Serial.begin(115200);
+static void readSoilStage() {
+    PROFILE_SCOPE(PROF_SOIL_STAGE);
+    // Oversampled and filtered in the background; these are just loads
+    soilSensor_readAll(currentMoisture);
+}
 
-    pinMode(RELAY_PIN, OUTPUT);
-    digitalWrite(RELAY_PIN, LOW);
-    analogReadResolution(12);
-    dht.begin();
+static void readDhtStage() {
+    PROFILE_SCOPE(PROF_DHT_STAGE);
+    // The RMT reader runs in the background; just pick up its latest frame.
+    // A missing or stale frame reads as 0 (treated as invalid downstream).
+    DhtReading reading;
+    bool fresh = dhtReader_latest(reading) && millis() - reading.timestamp < DHT_STALE_MS;
+    float temperature = fresh ? reading.temperature : 0.0;
+    float humidity = fresh ? reading.humidity : 0.0;
 
-    initDisplay();
-    setup_wifi();
+    // Store the latest valid readings
+    if (temperature > 0.0) lastTemperature = temperature;
+    if (humidity > 0.0) lastHumidity = humidity;
+
+    currentTemperature = temperature;
+    currentHumidity = humidity;
+    soilSensor_setTemperature(fresh ? reading.temperature : NAN);
 }
 
-void loop() {
-    mqtt_loop();
-
-    int sensorValue = analogRead(SOIL_PIN);
-    float moisturePercent = map(sensorValue, 0, 4095, 100, 0);
-    moisturePercent = constrain(moisturePercent, 0, 100);
-
-    float temperature, humidity;
-    
-    // Only read DHT sensor when pump is off or when dhtReadingEnabled is true
-    if (dhtReadingEnabled) {
-        temperature = dht.readTemperature();
-        humidity = dht.readHumidity();
-        if (isnan(temperature)) temperature = 0.0;
-        if (isnan(humidity)) humidity = 0.0;
-        
-        // Store the latest valid readings
-        if (temperature > 0.0) lastTemperature = temperature;
-        if (humidity > 0.0) lastHumidity = humidity;
-    } else {
-        // Use stored values when DHT reading is disabled
-        temperature = lastTemperature;
-        humidity = lastHumidity;
+// Calibration commands edit the zone's table in order: reset, upload,
+// temperature coefficient, capture. A result that is not a valid table is
+// dropped as a whole.
+static void applyCalibration(uint8_t z, const CalibrationUpdate& update) {
+    SoilCalibration cal;
+    soilSensor_getCalibration(z, cal);
+    if (update.fields & CAL_FIELD_RESET) soilCalibration_default(cal);
+    if (update.fields & CAL_FIELD_POINTS) {
+        SoilCalibration uploaded;
+        memset(&uploaded, 0, sizeof(uploaded));
+        uploaded.pointCount = min(update.pointCount, (uint8_t)SOIL_CAL_MAX_POINTS);
+        uploaded.tempCoeffQ8 = cal.tempCoeffQ8;
+        memcpy(uploaded.points, update.points, uploaded.pointCount * sizeof(SoilCalPoint));
+        cal = uploaded;
+    }
+    if (update.fields & CAL_FIELD_TEMP_COEFF) cal.tempCoeffQ8 = update.tempCoeffQ8;
+    bool ok = soilCalibration_isValid(cal);
+    if (ok && (update.fields & CAL_FIELD_CAPTURE)) {
+        SoilReading reading;
+        soilSensor_read(z, reading);
+        ok = soilCalibration_setPoint(cal, reading.compensatedRaw, update.captureMoistureX100);
+        LOG_INFO(LOG_TAG_CONTROL, "Zone %u calibration capture: %u counts (%u at %d C) = %.2f%%", z, reading.filteredRaw,
+                 reading.compensatedRaw, SOIL_CAL_REF_TEMP_C, update.captureMoistureX100 * 0.01f);
+    }
+    if (!ok || !soilSensor_setCalibration(z, cal)) {
+        LOG_WARN(LOG_TAG_CONTROL, "Zone %u calibration rejected (counts must rise, moisture must be monotonic)", z);
+        return;
     }
 
-    // Use dynamic rule thresholds (received via MQTT) instead of static plant type function.
-    extern int ruleMinMoisture;
-    extern int ruleMaxMoisture;
-    int threshold = ruleMinMoisture; // Use min as trigger threshold (pump turns on below this)
-    bool pumpOn = false;
-
-    // Auto mode: non-blocking state machine.
-    // Behavior: when moisture < ruleMinMoisture start a cycle: run pump for 10s, then turn off and wait 60s.
-    // If moisture goes above ruleMaxMoisture the cycle stops and pump stays off until re-triggered.
-    const unsigned long PUMP_RUN_MS = 10UL * 1000UL;      // 10 seconds
-    const unsigned long PUMP_COOLDOWN_MS = 60UL * 1000UL; // 60 seconds
-
-    if (actuatorMode == "auto") {
-        static uint8_t pumpState = 0; // 0=idle,1=running,2=cooldown
-        static unsigned long stateStart = 0;
-        unsigned long now = millis();
-
-        // If soil sufficiently moist, reset to idle and stop the pump
-        if (moisturePercent > ruleMaxMoisture) {
-            pumpState = 0;
-        }
+    stateStore_markCalibrationDirty(millis()); // written by persistStage, off the control deadline
+    LOG_INFO(LOG_TAG_CONTROL, "Zone %u calibration: %u points, %.2f counts/C", z, cal.pointCount,
+             cal.tempCoeffQ8 / 256.0f);
+}
 
-        if (moisturePercent < ruleMinMoisture) {
-            if (pumpState == 0) {
-                // Start running immediately when first detected below threshold
-                pumpState = 1;
-                stateStart = now;
-            } else if (pumpState == 1) {
-                // Running: check run timeout
-                if (now - stateStart >= PUMP_RUN_MS) {
-                    pumpState = 2; // enter cooldown
-                    stateStart = now;
-                }
-            } else if (pumpState == 2) {
-                // Cooldown: wait then re-evaluate
-                if (now - stateStart >= PUMP_COOLDOWN_MS) {
-                    if (moisturePercent < ruleMinMoisture) {
-                        pumpState = 1; // run again
-                        stateStart = now;
-                    } else {
-                        pumpState = 0; // go idle
-                    }
+// Apply commands queued by the network task. Runs on the control core only.
+// Only the ones that change the persisted state (state_store.h) schedule a save.
+static void applyCommands() {
+    Command cmd;
+    while (commandQueue_pop(cmd)) {
+        uint8_t z = cmd.zone;
+        if (z >= ZONE_COUNT) continue;
+        switch (cmd.type) {
+            case CMD_SET_MODE:
+                if (actuatorMode[z] != cmd.mode) stateStore_markDirty(millis());
+                actuatorMode[z] = cmd.mode;
+                if (cmd.traceId[0]) actuationTrace_commandApplied(z, cmd.traceId, cmd.receivedUs);
+                LOG_INFO(LOG_TAG_CONTROL, "Zone %u actuator mode updated to: %s", z, actuatorModeName(actuatorMode[z]));
+                break;
+            case CMD_SET_STATUS:
+                if (actuatorStatusOn[z] != cmd.on) stateStore_markDirty(millis());
+                actuatorStatusOn[z] = cmd.on;
+                if (cmd.traceId[0]) actuationTrace_commandApplied(z, cmd.traceId, cmd.receivedUs);
+                LOG_INFO(LOG_TAG_CONTROL, "Zone %u actuator status updated to: %s", z, actuatorStatusOn[z] ? "on" : "off");
+                break;
+            case CMD_SET_RULE: {
+                const RuleUpdate& rule = cmd.rule;
+                if (rule.fields) stateStore_markDirty(millis());
+                if (rule.fields & RULE_FIELD_MIN_MOISTURE) {
+                    ruleMinMoisture[z] = rule.minMoisture;
+                    ruleEngine_minMoistureChanged(z);
                 }
+                if (rule.fields & RULE_FIELD_MAX_MOISTURE) ruleMaxMoisture[z] = rule.maxMoisture;
+                if (rule.fields & RULE_FIELD_PLANT_NAME) strlcpy(rulePlantName[z], rule.plantName, sizeof(rulePlantName[z]));
+                if (rule.fields & RULE_FIELD_PREFERRED_HUMIDITY) rulePreferredHumidity[z] = rule.preferredHumidity;
+                if (rule.fields & RULE_FIELD_PREFERRED_TEMP) rulePreferredTemp[z] = rule.preferredTemp;
+                if (rule.fields & RULE_FIELD_PUMP_TIMING) ruleEngine_setDefaultTiming(z, rule.runS, rule.cooldownS);
+                LOG_INFO(LOG_TAG_CONTROL, "Zone %u updated rule: min=%d max=%d plant=%s prefHum=%d prefTemp=%d", z,
+                         ruleMinMoisture[z], ruleMaxMoisture[z], rulePlantName[z],
+                         rulePreferredHumidity[z], rulePreferredTemp[z]);
+                break;
             }
-        } else {
-            // Not below min threshold and not above max hysteresis: ensure pump is off
-            if (pumpState != 0) pumpState = 0;
+            case CMD_SET_PROGRAM:
+                ruleEngine_load(z, cmd.program);
+                stateStore_markDirty(millis());
+                LOG_INFO(LOG_TAG_CONTROL, "Zone %u rule program loaded: %u rules, %u conditions%s", z,
+                         cmd.program.ruleCount, cmd.program.conditionCount,
+                         cmd.program.custom ? "" : " (default)");
+                break;
+            case CMD_SET_CALIBRATION:
+                applyCalibration(z, cmd.calibration);
+                break;
         }
+    }
+}
 
-        pumpOn = (pumpState == 1);
-    } else { // manual
-        pumpOn = (actuatorStatus == "on");
+static void publishDeviceState() {
+    DeviceState state;
+    state.temperature = currentTemperature;
+    state.humidity = currentHumidity;
+    state.pumpOn = pumpOn;
+    state.autoMode = 0;
+    state.manualStatusOn = 0;
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        state.moisture[z] = currentMoisture[z];
+        if (actuatorMode[z] == MODE_AUTO) state.autoMode |= ZONE_BIT(z);
+        if (actuatorStatusOn[z]) state.manualStatusOn |= ZONE_BIT(z);
+        state.ruleMinMoisture[z] = ruleMinMoisture[z];
+        state.ruleMaxMoisture[z] = ruleMaxMoisture[z];
     }
+    memcpy(state.plantName, rulePlantName, sizeof(state.plantName));
+    state.updatedAt = millis();
+    deviceState_publish(state);
+}
+
+static void controlStage() {
+    PROFILE_SCOPE(PROF_CONTROL);
+    applyCommands();
 
-    digitalWrite(RELAY_PIN, pumpOn ? HIGH : LOW);
-    String pumpStatus = pumpOn ? "1" : "0";
+    // No decisions on the zero readings before the first soil frame
+    if (soilSensor_frameCount() == 0) {
+        actuationTrace_endTick(pumpOn);
+        publishDeviceState();
+        return;
+    }
 
-    // Control DHT reading based on pump status
-    // Disable DHT reading when pump is on to prevent ESP restart
-    dhtReadingEnabled = !pumpOn;
+    // Every zone's rule program and pump state machine in one pass (see
+    // zones.h); the global MAX_ACTIVE_PUMPS cap is enforced there.
+    pumpOn = zones_control(currentMoisture, currentTemperature, currentHumidity, millis());
+    actuationTrace_endTick(pumpOn);
+    bootTiming_mark(BOOT_FIRST_DECISION);
 
-    lowMoistureAlert = (moisturePercent < threshold);
+    // Use min as trigger threshold (pump turns on below this)
+    bool low = false;
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) low |= currentMoisture[z] < ruleMinMoisture[z];
+    lowMoistureAlert = low;
 
+    publishDeviceState();
+}
+
+static void persistStage() {
+    stateStore_service(millis());
+}
+
+static void displayStage() {
+    PROFILE_SCOPE(PROF_DISPLAY_DRAW);
+    // With several zones the display steps to the next one every DISPLAY_ZONE_PERIOD_MS
+    uint8_t z = (millis() / DISPLAY_ZONE_PERIOD_MS) % ZONE_COUNT;
     // Use scene-based display instead of the old updateDisplay
-    updateDisplayScenes(temperature, moisturePercent, threshold, humidity);
-    
-    // Publish MQTT sensor data only every 5 seconds
-    unsigned long currentTime = millis();
-    if (currentTime - lastMqttPublishTime >= MQTT_PUBLISH_INTERVAL) {
-        mqtt_publishSensors(temperature, moisturePercent, humidity);
-        mqtt_publishActualActuatorStatus(pumpStatus == "1");
-        lastMqttPublishTime = currentTime;
+    updateDisplayScenes(z, currentTemperature, currentMoisture[z], ruleMinMoisture[z], currentHumidity,
+                        pumpOn & ZONE_BIT(z));
+}
+
+static void statusLogStage() {
+    PROFILE_SCOPE(PROF_STATUS_LOG);
+    RuleEngineStats rules;
+    ruleEngine_getStats(rules);
+    // Only the arguments are captured here; the log task formats the line
+    LOG_INFO(LOG_TAG_MAIN, "Plant:%s, Mode:%s, Moisture:%.1f%%, Temp:%.1fC, Hum:%.1f%%, Pump:%s, Thr:%d%%, Missed:%lu, Rules:%lucyc, Net:%s",
+             rulePlantName[0],
+             (actuatorMode[0] == MODE_AUTO ? "Auto" : "Manual"),
+             currentMoisture[0],
+             currentTemperature,
+             currentHumidity,
+             (pumpOn & ZONE_BIT(0) ? "ON" : "OFF"),
+             ruleMinMoisture[0],
+             scheduler_totalMissedDeadlines(),
+             (unsigned long)rules.lastTickCycles,
+             (mqtt_connectionState() == NET_MQTT_CONNECTED ? "online" : "offline"));
+    for (uint8_t z = 1; z < ZONE_COUNT; z++) {
+        LOG_INFO(LOG_TAG_MAIN, "  Zone %u: Plant:%s, Mode:%s, Moisture:%.1f%%, Pump:%s, Thr:%d%%", z, rulePlantName[z],
+                 (actuatorMode[z] == MODE_AUTO ? "Auto" : "Manual"), currentMoisture[z],
+                 (pumpOn & ZONE_BIT(z) ? "ON" : "OFF"), ruleMinMoisture[z]);
     }
-    
-    // Debug info for DHT reading state
-    if (!dhtReadingEnabled) {
-        Serial.println("DHT reading paused (pump active) - using stored values");
+}
+
+static void loadDefaultRules() {
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        actuatorMode[z] = MODE_MANUAL;
+        actuatorStatusOn[z] = false;
+        ruleMinMoisture[z] = 40;
+        ruleMaxMoisture[z] = 80;
+        strlcpy(rulePlantName[z], "Chili", sizeof(rulePlantName[z]));
+        rulePreferredHumidity[z] = 70;
+        rulePreferredTemp[z] = 25;
+    }
+}
+
+void setup() {
+    bootTiming_mark(BOOT_SETUP_START);
+    Serial.begin(115200);
+    log_begin();
+    profiler_begin();
+    memDiag_registerCurrentTask(); // the Arduino loop task
+
+    // Control resumes from the saved state before anything touches the network
+    loadDefaultRules();
+    ruleEngine_begin();
+    stateStore_load();
+    static SoilCalibration savedCalibration[ZONE_COUNT];
+    if (stateStore_loadCalibration(savedCalibration)) {
+        for (uint8_t z = 0; z < ZONE_COUNT; z++) soilSensor_setCalibration(z, savedCalibration[z]);
     }
+    bootTiming_mark(BOOT_STATE_RESTORED);
 
-    // Example rule publish (static for now - could be dynamic/config-driven)
-    // Rule now subscribed; no longer publishing rule JSON here.
+    zones_begin();
+    analogReadResolution(12);
+    soilSensor_begin();
+    dhtReader_begin(DHTPIN);
 
-    Serial.printf("Plant:%s, Mode:%s, Moisture:%.1f%%, Temp:%.1fC, Hum:%.1f%%, Pump:%s, Thr:%d%%\n",
-                  currentPlantType.c_str(),
-                  (actuatorMode == "auto" ? "Auto" : "Manual"),
-                  moisturePercent,
-                  temperature,
-                  humidity,
-                  (pumpStatus == "1" ? "ON" : "OFF"),
-                  threshold);
+    // WiFi/MQTT live on core 0; this loop() (core 1) only senses, controls and
+    // draws. Started before the display so association overlaps its setup.
+    publishDeviceState();
+    mqtt_startTask();
 
+    initDisplay();
+
+    // Sensing first so the control stage sees a fresh value on its first run
+    scheduler_addTask("soil", readSoilStage, SOIL_READ_PERIOD_MS, SOIL_READ_DEADLINE_MS);
+    scheduler_addTask("dht", readDhtStage, DHT_READ_PERIOD_MS, DHT_READ_DEADLINE_MS);
+    scheduler_addTask("control", controlStage, CONTROL_PERIOD_MS, CONTROL_DEADLINE_MS);
+    scheduler_addTask("display", displayStage, DISPLAY_PERIOD_MS, DISPLAY_DEADLINE_MS);
+    scheduler_addTask("status", statusLogStage, STATUS_LOG_PERIOD_MS, STATUS_LOG_DEADLINE_MS);
+    scheduler_addTask("persist", persistStage, PERSIST_PERIOD_MS, PERSIST_DEADLINE_MS);
+    bootTiming_mark(BOOT_SETUP_DONE);
+}
 
-    delay(2000);
+void loop() {
+    scheduler_run();
 }
@@ -0,0 +1,130 @@
+#include "mem_diag.h"
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "config.h"
+#include "esp_heap_caps.h"
+
+static TaskHandle_t taskHandles[MEM_DIAG_MAX_TASKS];
+static const char* taskNames[MEM_DIAG_MAX_TASKS];
+static std::atomic<uint8_t> taskCount(0);
+
+void memDiag_registerCurrentTask() {
+    uint8_t slot = taskCount.load(std::memory_order_relaxed);
+    do {
+        if (slot >= MEM_DIAG_MAX_TASKS) return;
+    } while (!taskCount.compare_exchange_weak(slot, slot + 1, std::memory_order_relaxed));
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    taskNames[slot] = pcTaskGetName(self);
+    taskHandles[slot] = self;
+}
+
+void memDiag_sample(MemStats& out) {
+    memset(&out, 0, sizeof(out));
+    out.freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    out.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    out.minFreeHeap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    out.fragmentationPct = out.freeHeap ? 100 - (uint8_t)((uint64_t)out.largestBlock * 100 / out.freeHeap) : 0;
+
+    if (out.freeHeap < MEM_ALERT_FREE_HEAP) out.alerts |= MEM_ALERT_LOW_HEAP;
+    if (out.largestBlock < MEM_ALERT_LARGEST_BLOCK || out.fragmentationPct > MEM_ALERT_FRAGMENTATION_PCT) {
+        out.alerts |= MEM_ALERT_FRAGMENTED;
+    }
+
+    uint8_t count = taskCount.load(std::memory_order_relaxed);
+    for (uint8_t i = 0; i < count && taskHandles[i] != nullptr; i++) {
+        MemTaskStack& t = out.tasks[out.taskCount++];
+        t.name = taskNames[i];
+        t.minFreeBytes = uxTaskGetStackHighWaterMark(taskHandles[i]); // bytes on ESP-IDF
+        if (t.minFreeBytes < MEM_ALERT_STACK_FREE) out.alerts |= MEM_ALERT_LOW_STACK;
+    }
+}
+
+uint32_t memDiag_allocationCount() {
+    return 0;
+}
+
+#else
+#include <new>
+#include <stdlib.h>
+
+static std::atomic<uint32_t> allocations(0);
+
+// Count every heap allocation the host build makes
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+void memDiag_registerCurrentTask() {}
+
+void memDiag_sample(MemStats& out) {
+    memset(&out, 0, sizeof(out));
+    out.allocations = allocations.load(std::memory_order_relaxed);
+}
+
+uint32_t memDiag_allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+#endif
+
+size_t memDiag_format(const MemStats& stats, char* buf, size_t len) {
+    int n = snprintf(buf, len, "{\"free\":%u,\"largest\":%u,\"min_free\":%u,\"frag_pct\":%u,\"alerts\":[",
+                     (unsigned)stats.freeHeap, (unsigned)stats.largestBlock,
+                     (unsigned)stats.minFreeHeap, (unsigned)stats.fragmentationPct);
+    if (n < 0 || (size_t)n >= len) return 0;
+    size_t pos = n;
+
+    static const char* const ALERT_NAMES[] = { "low_heap", "fragmented", "low_stack" };
+    bool first = true;
+    for (uint8_t i = 0; i < sizeof(ALERT_NAMES) / sizeof(ALERT_NAMES[0]); i++) {
+        if (!(stats.alerts & (1 << i))) continue;
+        n = snprintf(buf + pos, len - pos, first ? "\"%s\"" : ",\"%s\"", ALERT_NAMES[i]);
+        if (n < 0 || (size_t)n >= len - pos) return 0;
+        pos += n;
+        first = false;
+    }
+
+    n = snprintf(buf + pos, len - pos, "],\"stack_free\":{");
+    if (n < 0 || (size_t)n >= len - pos) return 0;
+    pos += n;
+    for (uint8_t i = 0; i < stats.taskCount; i++) {
+        n = snprintf(buf + pos, len - pos, i ? ",\"%s\":%u" : "\"%s\":%u",
+                     stats.tasks[i].name, (unsigned)stats.tasks[i].minFreeBytes);
+        if (n < 0 || (size_t)n >= len - pos) return 0;
+        pos += n;
+    }
+
+#ifdef ARDUINO
+    n = snprintf(buf + pos, len - pos, "}}");
+#else
+    n = snprintf(buf + pos, len - pos, "},\"allocs\":%u}", (unsigned)stats.allocations);
+#endif
+    if (n < 0 || (size_t)n >= len - pos) return 0;
+    return pos + n;
+}
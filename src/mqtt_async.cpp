@@ -0,0 +1,605 @@
+#include "mqtt_async.h"
+#include <algorithm>
+#include <atomic>
+#include "config.h"
+#include "mqtt_link.h"
+
+// MQTT 3.1.1 packet types (high nibble of the fixed header)
+#define MQTT_CONNECT     0x10
+#define MQTT_CONNACK     0x20
+#define MQTT_PUBLISH     0x30
+#define MQTT_PUBACK      0x40
+#define MQTT_SUBSCRIBE   0x82 // with the reserved flags
+#define MQTT_SUBACK      0x90
+#define MQTT_PINGREQ     0xC0
+#define MQTT_PINGRESP    0xD0
+#define MQTT_DISCONNECT  0xE0
+#define MQTT_DUP_FLAG    0x08
+
+#define MQTT_MAX_SUBSCRIPTIONS 2
+#define MQTT_FILTER_MAX        64
+#define MQTT_TOPIC_MAX         128  // incoming topics; longer ones are skipped
+#define MQTT_CONTROL_BYTES     256  // CONNECT, SUBSCRIBE, PUBACK, PINGREQ waiting to be written
+
+// --- Outbox -------------------------------------------------------------------
+// Records are [header][PUBLISH packet] at 4-byte aligned positions that
+// only grow (ring offset = position % size). A producer claims a record's
+// span by moving `head` with a CAS, writes it and marks it ready; the
+// network task sends records in claim order, and `tail` passes a record
+// once it is written (QoS 0) or acknowledged (QoS 1). Released bytes are
+// zeroed, so an unwritten header never reads as ready. A record that would
+// wrap is preceded by padding up to the end of the ring.
+
+#define RECORD_READY 0x52454459u // "REDY"
+#define RECORD_PAD   0x50414444u // "PADD"
+
+// Consumer flags
+#define RECORD_SENT  0x01
+#define RECORD_ACKED 0x02
+
+struct RecordHeader {
+    std::atomic<uint32_t> state;  // 0 while being written, then READY or PAD
+    uint16_t length;              // packet bytes after the header
+    uint16_t packetId;            // 0 for QoS 0
+    uint8_t flags;
+    uint32_t sentUs;
+};
+
+static const size_t HEADER_BYTES = (sizeof(RecordHeader) + 3) & ~(size_t)3;
+
+// Positions wrap at 2^32, so the ring size must divide it
+static_assert((MQTT_OUTBOX_BYTES & (MQTT_OUTBOX_BYTES - 1)) == 0, "MQTT_OUTBOX_BYTES must be a power of two");
+static_assert(MQTT_OUTBOX_BYTES >= 2 * (MQTT_BUFFER_SIZE + 16), "outbox must hold two full-size packets");
+
+alignas(4) static uint8_t outbox[MQTT_OUTBOX_BYTES];
+static std::atomic<uint32_t> head(0);   // next position to claim (producers)
+static std::atomic<uint32_t> tail(0);   // oldest record still needed (network task)
+static std::atomic<uint16_t> nextPacketId(1);
+
+// Network task state
+static uint32_t sendPos = 0;     // next record to write
+static uint32_t writePos = 0;    // record being written, valid while writeOffset > 0
+static size_t writeOffset = 0;
+static uint8_t inflight = 0;
+
+static uint8_t control[MQTT_CONTROL_BYTES];
+static size_t controlLen = 0;
+static size_t controlSent = 0;
+
+static uint8_t rx[MQTT_BUFFER_SIZE];
+static size_t rxLen = 0;
+static size_t rxSkip = 0;        // bytes of an oversized packet still to discard
+
+static const char* brokerHost = nullptr;
+static uint16_t brokerPort = 0;
+static char clientId[32];
+static MqttMessageHandler messageHandler = nullptr;
+static char filters[MQTT_MAX_SUBSCRIPTIONS][MQTT_FILTER_MAX];
+static uint8_t filterQos[MQTT_MAX_SUBSCRIPTIONS];
+static uint8_t filterCount = 0;
+
+static MqttAsyncState state = MQTT_ASYNC_DISCONNECTED;
+static unsigned long attemptStart = 0;
+static unsigned long lastTx = 0;
+static unsigned long pingSentAt = 0;
+static bool pingOutstanding = false;
+static MqttAsyncStats stats = {};
+static std::atomic<uint32_t> enqueued(0);
+static std::atomic<uint32_t> rejected(0);
+static std::atomic<uint32_t> maxEnqueueUs(0);
+static std::atomic<uint32_t> outboxPeak(0);
+
+static inline void raiseMax(std::atomic<uint32_t>& max, uint32_t value) {
+    uint32_t seen = max.load(std::memory_order_relaxed);
+    while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+static inline RecordHeader* headerAt(uint32_t pos) {
+    return reinterpret_cast<RecordHeader*>(&outbox[pos % MQTT_OUTBOX_BYTES]);
+}
+
+static inline size_t recordSpan(size_t packetBytes) {
+    return (HEADER_BYTES + packetBytes + 3) & ~(size_t)3;
+}
+
+// Bytes from pos to the end of the ring; a header needs HEADER_BYTES of them
+static inline size_t untilWrap(uint32_t pos) {
+    return MQTT_OUTBOX_BYTES - pos % MQTT_OUTBOX_BYTES;
+}
+
+static size_t encodeLength(uint8_t* out, size_t length) {
+    size_t n = 0;
+    do {
+        uint8_t digit = length % 128;
+        length /= 128;
+        out[n++] = digit | (length ? 0x80 : 0);
+    } while (length);
+    return n;
+}
+
+static inline size_t lengthBytes(size_t length) {
+    return length < 128 ? 1 : length < 16384 ? 2 : 3;
+}
+
+// Claims span bytes (plus padding to the wrap point when needed). Returns
+// the record position, or false when the outbox has no room.
+static bool claim(size_t span, uint32_t& pos) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    for (;;) {
+        size_t pad = untilWrap(h) < span ? untilWrap(h) : 0;
+        if (h + pad + span - tail.load(std::memory_order_acquire) > MQTT_OUTBOX_BYTES) return false;
+        if (head.compare_exchange_weak(h, h + pad + span, std::memory_order_relaxed)) {
+            if (pad >= HEADER_BYTES) headerAt(h)->state.store(RECORD_PAD, std::memory_order_release);
+            pos = h + pad;
+            raiseMax(outboxPeak, h + pad + span - tail.load(std::memory_order_relaxed));
+            return true;
+        }
+    }
+}
+
+bool mqttAsync_publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retained) {
+    uint32_t start = micros();
+    size_t topicLen = strlen(topic);
+    size_t remaining = 2 + topicLen + (qos ? 2 : 0) + length;
+    size_t packetBytes = 1 + lengthBytes(remaining) + remaining;
+    uint32_t pos;
+    if (packetBytes > MQTT_BUFFER_SIZE || !claim(recordSpan(packetBytes), pos)) {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    RecordHeader* h = headerAt(pos);
+    uint8_t* p = reinterpret_cast<uint8_t*>(h) + HEADER_BYTES;
+    uint16_t packetId = 0;
+    if (qos) {
+        packetId = nextPacketId.fetch_add(1, std::memory_order_relaxed);
+        if (packetId == 0) packetId = nextPacketId.fetch_add(1, std::memory_order_relaxed);
+    }
+    *p++ = MQTT_PUBLISH | (qos ? 0x02 : 0) | (retained ? 0x01 : 0);
+    p += encodeLength(p, remaining);
+    *p++ = topicLen >> 8;
+    *p++ = topicLen & 0xFF;
+    memcpy(p, topic, topicLen);
+    p += topicLen;
+    if (qos) {
+        *p++ = packetId >> 8;
+        *p++ = packetId & 0xFF;
+    }
+    memcpy(p, payload, length);
+    h->length = packetBytes;
+    h->packetId = packetId;
+    h->flags = 0;
+    h->sentUs = 0;
+    h->state.store(RECORD_READY, std::memory_order_release);
+
+    enqueued.fetch_add(1, std::memory_order_relaxed);
+    raiseMax(maxEnqueueUs, micros() - start);
+    return true;
+}
+
+bool mqttAsync_publish(const char* topic, const char* payload, uint8_t qos, bool retained) {
+    return mqttAsync_publish(topic, reinterpret_cast<const uint8_t*>(payload), strlen(payload), qos, retained);
+}
+
+// The record at pos, skipping padding; nullptr when none is ready yet
+static RecordHeader* readyRecord(uint32_t& pos) {
+    uint32_t end = head.load(std::memory_order_acquire);
+    while (pos != end) {
+        if (untilWrap(pos) < HEADER_BYTES) {
+            pos += untilWrap(pos);
+            continue;
+        }
+        RecordHeader* h = headerAt(pos);
+        uint32_t s = h->state.load(std::memory_order_acquire);
+        if (s == RECORD_PAD) {
+            pos += untilWrap(pos);
+            continue;
+        }
+        return s == RECORD_READY ? h : nullptr;
+    }
+    return nullptr;
+}
+
+// Releases written QoS 0 and acknowledged QoS 1 records at the tail
+static void releaseDone() {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    for (;;) {
+        uint32_t pos = t;
+        RecordHeader* h = readyRecord(pos);
+        if (h == nullptr || pos == sendPos || !(h->flags & RECORD_SENT)) break;
+        if (h->packetId != 0 && !(h->flags & RECORD_ACKED)) break;
+        uint32_t end = pos + recordSpan(h->length);
+        // Zero everything up to the next record, padding included
+        for (uint32_t z = t; z != end;) {
+            size_t n = std::min((size_t)(end - z), untilWrap(z));
+            memset(&outbox[z % MQTT_OUTBOX_BYTES], 0, n);
+            z += n;
+        }
+        t = end;
+        tail.store(t, std::memory_order_release);
+    }
+}
+
+// --- Control packets ------------------------------------------------------------
+
+static bool queueControl(const uint8_t* packet, size_t len) {
+    if (controlLen + len > sizeof(control)) return false;
+    memcpy(control + controlLen, packet, len);
+    controlLen += len;
+    return true;
+}
+
+static void queueConnect() {
+    uint8_t packet[64];
+    size_t idLen = strlen(clientId);
+    size_t remaining = 10 + 2 + idLen;
+    size_t n = 0;
+    packet[n++] = MQTT_CONNECT;
+    n += encodeLength(packet + n, remaining);
+    static const uint8_t variable[] = { 0, 4, 'M', 'Q', 'T', 'T', 4 };
+    memcpy(packet + n, variable, sizeof(variable));
+    n += sizeof(variable);
+    packet[n++] = 0x00; // flags: clean session off, no will, no credentials
+    packet[n++] = MQTT_KEEPALIVE_S >> 8;
+    packet[n++] = MQTT_KEEPALIVE_S & 0xFF;
+    packet[n++] = idLen >> 8;
+    packet[n++] = idLen & 0xFF;
+    memcpy(packet + n, clientId, idLen);
+    queueControl(packet, n + idLen);
+}
+
+static void queueSubscribe(uint8_t index) {
+    uint8_t packet[MQTT_FILTER_MAX + 8];
+    size_t len = strlen(filters[index]);
+    uint16_t id = nextPacketId.fetch_add(1, std::memory_order_relaxed);
+    if (id == 0) id = nextPacketId.fetch_add(1, std::memory_order_relaxed);
+    size_t n = 0;
+    packet[n++] = MQTT_SUBSCRIBE;
+    n += encodeLength(packet + n, 2 + 2 + len + 1);
+    packet[n++] = id >> 8;
+    packet[n++] = id & 0xFF;
+    packet[n++] = len >> 8;
+    packet[n++] = len & 0xFF;
+    memcpy(packet + n, filters[index], len);
+    n += len;
+    packet[n++] = filterQos[index];
+    queueControl(packet, n);
+}
+
+// --- Connection -------------------------------------------------------------------
+
+void mqttAsync_begin(const char* host, uint16_t port, const char* id, MqttMessageHandler handler) {
+    brokerHost = host;
+    brokerPort = port;
+    strlcpy(clientId, id, sizeof(clientId));
+    messageHandler = handler;
+}
+
+static void closeSession(int8_t error) {
+    mqttLink_close();
+    state = MQTT_ASYNC_DISCONNECTED;
+    stats.lastError = error;
+    controlLen = controlSent = 0;
+    rxLen = rxSkip = 0;
+    writeOffset = 0;
+    inflight = 0;
+    pingOutstanding = false;
+}
+
+bool mqttAsync_connect() {
+    closeSession(MQTT_ASYNC_OK);
+    if (!mqttLink_open(brokerHost, brokerPort)) {
+        stats.lastError = MQTT_ASYNC_ERR_LINK;
+        return false;
+    }
+    state = MQTT_ASYNC_CONNECTING;
+    attemptStart = millis();
+    queueConnect();
+    return true;
+}
+
+void mqttAsync_disconnect() {
+    if (state == MQTT_ASYNC_CONNECTED) {
+        static const uint8_t packet[] = { MQTT_DISCONNECT, 0 };
+        mqttLink_send(packet, sizeof(packet)); // best effort
+    }
+    closeSession(MQTT_ASYNC_OK);
+}
+
+MqttAsyncState mqttAsync_state() {
+    return state;
+}
+
+bool mqttAsync_connected() {
+    return state == MQTT_ASYNC_CONNECTED;
+}
+
+int8_t mqttAsync_lastError() {
+    return stats.lastError;
+}
+
+bool mqttAsync_subscribe(const char* filter, uint8_t qos) {
+    for (uint8_t i = 0; i < filterCount; i++) {
+        if (strcmp(filters[i], filter) == 0) return true;
+    }
+    if (filterCount >= MQTT_MAX_SUBSCRIPTIONS || strlen(filter) >= MQTT_FILTER_MAX) return false;
+    strlcpy(filters[filterCount], filter, MQTT_FILTER_MAX);
+    filterQos[filterCount] = qos;
+    if (state == MQTT_ASYNC_CONNECTED) queueSubscribe(filterCount);
+    filterCount++;
+    return true;
+}
+
+// Every record not yet acknowledged goes out again on the new connection
+static void rewindOutbox() {
+    sendPos = tail.load(std::memory_order_relaxed);
+    uint32_t pos = sendPos;
+    RecordHeader* h;
+    while ((h = readyRecord(pos)) != nullptr) {
+        if (h->packetId != 0 && (h->flags & RECORD_SENT) && !(h->flags & RECORD_ACKED)) {
+            reinterpret_cast<uint8_t*>(h)[HEADER_BYTES] |= MQTT_DUP_FLAG;
+            h->flags &= ~RECORD_SENT;
+            stats.retransmits++;
+        }
+        pos += recordSpan(h->length);
+    }
+}
+
+// --- Incoming -------------------------------------------------------------------
+
+static void handleAck(uint16_t packetId) {
+    uint32_t pos = tail.load(std::memory_order_relaxed);
+    RecordHeader* h;
+    while (pos != sendPos && (h = readyRecord(pos)) != nullptr) {
+        if (h->packetId == packetId && (h->flags & RECORD_SENT) && !(h->flags & RECORD_ACKED)) {
+            h->flags |= RECORD_ACKED;
+            inflight--;
+            stats.sent++;
+            stats.lastAckUs = micros() - h->sentUs;
+            if (stats.lastAckUs > stats.maxAckUs) stats.maxAckUs = stats.lastAckUs;
+            releaseDone();
+            return;
+        }
+        pos += recordSpan(h->length);
+    }
+}
+
+static void handlePublish(uint8_t flags, const uint8_t* body, size_t len, bool complete) {
+    uint8_t qos = (flags >> 1) & 0x03;
+    if (len < 2) return;
+    size_t topicLen = (body[0] << 8) | body[1];
+    size_t offset = 2 + topicLen;
+    if (offset + (qos ? 2 : 0) > len) return;
+    if (qos) {
+        uint8_t ack[] = { MQTT_PUBACK, 2, body[offset], body[offset + 1] };
+        queueControl(ack, sizeof(ack));
+        offset += 2;
+    }
+    stats.received++;
+    if (!complete) {
+        stats.oversized++;
+        return;
+    }
+    if (topicLen >= MQTT_TOPIC_MAX || messageHandler == nullptr) return;
+    char topic[MQTT_TOPIC_MAX];
+    memcpy(topic, body + 2, topicLen);
+    topic[topicLen] = '\0';
+    messageHandler(topic, const_cast<uint8_t*>(body + offset), len - offset);
+}
+
+// One packet from the front of buf. Returns its size, 0 if more bytes are
+// needed, -1 on a protocol error or a refused connection.
+static int handlePacket(const uint8_t* buf, size_t len) {
+    if (len < 2) return 0;
+    size_t remaining = 0;
+    size_t n = 1;
+    for (uint8_t shift = 0;; shift += 7) {
+        if (n >= len) return 0;
+        if (n > 4) return -1;
+        remaining |= (size_t)(buf[n] & 0x7F) << shift;
+        if (!(buf[n++] & 0x80)) break;
+    }
+    size_t total = n + remaining;
+    uint8_t type = buf[0] & 0xF0;
+
+    if (total > sizeof(rx)) {
+        // Only publishes can be that big: acknowledge it, skip the rest
+        if (type != MQTT_PUBLISH) return -1;
+        if (len < sizeof(rx)) return 0;
+        handlePublish(buf[0] & 0x0F, buf + n, len - n, false);
+        rxSkip = total - len;
+        return len;
+    }
+    if (len < total) return 0;
+
+    const uint8_t* body = buf + n;
+    switch (type) {
+        case MQTT_CONNACK:
+            if (state != MQTT_ASYNC_CONNECTING || remaining != 2) return -1;
+            if (body[1] != 0) {
+                closeSession((int8_t)body[1]);
+                return -1;
+            }
+            state = MQTT_ASYNC_CONNECTED;
+            stats.sessionPresent = body[0] & 0x01;
+            stats.lastError = MQTT_ASYNC_OK;
+            for (uint8_t i = 0; i < filterCount; i++) queueSubscribe(i);
+            rewindOutbox();
+            break;
+        case MQTT_PUBLISH:
+            handlePublish(buf[0] & 0x0F, body, remaining, true);
+            break;
+        case MQTT_PUBACK:
+            if (remaining == 2) handleAck((body[0] << 8) | body[1]);
+            break;
+        case MQTT_PINGRESP:
+            pingOutstanding = false;
+            break;
+        case MQTT_SUBACK:
+            break;
+        default:
+            return -1;
+    }
+    return total;
+}
+
+static bool readIncoming() {
+    for (;;) {
+        if (rxSkip > 0) {
+            uint8_t scratch[64];
+            int n = mqttLink_recv(scratch, std::min(rxSkip, sizeof(scratch)));
+            if (n < 0) return false;
+            if (n == 0) return true;
+            rxSkip -= n;
+            continue;
+        }
+        // Leave room for the acknowledgements the packets may need
+        if (sizeof(control) - controlLen < 16) return true;
+        int n = mqttLink_recv(rx + rxLen, sizeof(rx) - rxLen);
+        if (n <= 0) return n == 0;
+        rxLen += n;
+
+        size_t offset = 0;
+        int used;
+        while ((used = handlePacket(rx + offset, rxLen - offset)) > 0) {
+            offset += used;
+            if (rxSkip > 0) break;
+        }
+        if (used < 0) return false;
+        rxLen -= offset;
+        memmove(rx, rx + offset, rxLen);
+    }
+}
+
+// --- Outgoing -------------------------------------------------------------------
+
+// Writes control packets first, then queued publishes, until the socket is
+// full or nothing is left. Never splits a packet by starting another one.
+static bool writeOutgoing() {
+    for (;;) {
+        if (writeOffset > 0) {
+            RecordHeader* h = headerAt(writePos);
+            const uint8_t* packet = reinterpret_cast<const uint8_t*>(h) + HEADER_BYTES;
+            int n = mqttLink_send(packet + writeOffset, h->length - writeOffset);
+            if (n < 0) return false;
+            if (n == 0) return true;
+            lastTx = millis();
+            writeOffset += n;
+            if (writeOffset < h->length) return true;
+            writeOffset = 0;
+            h->flags |= RECORD_SENT;
+            if (h->packetId == 0) stats.sent++;
+            releaseDone();
+            continue;
+        }
+        if (controlSent < controlLen) {
+            int n = mqttLink_send(control + controlSent, controlLen - controlSent);
+            if (n < 0) return false;
+            if (n == 0) return true;
+            lastTx = millis();
+            controlSent += n;
+            if (controlSent < controlLen) return true;
+            controlLen = controlSent = 0;
+            continue;
+        }
+        if (state != MQTT_ASYNC_CONNECTED || inflight >= MQTT_MAX_INFLIGHT) return true;
+
+        uint32_t pos = sendPos;
+        RecordHeader* h = readyRecord(pos);
+        if (h == nullptr) return true;
+        sendPos = pos + recordSpan(h->length);
+        if (h->packetId != 0 && (h->flags & RECORD_ACKED)) continue;
+        if (h->packetId == 0 && (h->flags & RECORD_SENT)) continue; // went out before the reconnect
+        if (h->packetId != 0) {
+            inflight++;
+            h->sentUs = micros();
+        }
+        writePos = pos;
+        writeOffset = 0;
+        const uint8_t* packet = reinterpret_cast<const uint8_t*>(h) + HEADER_BYTES;
+        int n = mqttLink_send(packet, h->length);
+        if (n < 0) return false;
+        if (n == 0) {
+            // Nothing taken yet: retry this record next time
+            sendPos = pos;
+            if (h->packetId != 0) inflight--;
+            return true;
+        }
+        lastTx = millis();
+        writeOffset = n;
+        if (writeOffset < h->length) return true;
+        writeOffset = 0;
+        h->flags |= RECORD_SENT;
+        if (h->packetId == 0) stats.sent++;
+        releaseDone();
+    }
+}
+
+// Oldest QoS 1 publish still waiting for its PUBACK, in us
+static uint32_t oldestUnackedUs() {
+    uint32_t pos = tail.load(std::memory_order_relaxed);
+    RecordHeader* h;
+    while (pos != sendPos && (h = readyRecord(pos)) != nullptr) {
+        if (h->packetId != 0 && (h->flags & RECORD_SENT) && !(h->flags & RECORD_ACKED)) return micros() - h->sentUs;
+        pos += recordSpan(h->length);
+    }
+    return 0;
+}
+
+void mqttAsync_service() {
+    if (state == MQTT_ASYNC_DISCONNECTED) return;
+    unsigned long now = millis();
+
+    if (state == MQTT_ASYNC_CONNECTING) {
+        MqttLinkState link = mqttLink_poll();
+        if (link == LINK_FAILED) {
+            closeSession(MQTT_ASYNC_ERR_LINK);
+            return;
+        }
+        if (now - attemptStart >= MQTT_CONNECT_TIMEOUT_MS) {
+            closeSession(MQTT_ASYNC_ERR_TIMEOUT);
+            return;
+        }
+        if (link != LINK_OPEN) return;
+    }
+
+    if (!readIncoming()) {
+        if (state != MQTT_ASYNC_DISCONNECTED) closeSession(MQTT_ASYNC_ERR_LINK);
+        return;
+    }
+
+    if (state == MQTT_ASYNC_CONNECTED) {
+        if (pingOutstanding && now - pingSentAt >= MQTT_KEEPALIVE_S * 1000UL) {
+            closeSession(MQTT_ASYNC_ERR_TIMEOUT);
+            return;
+        }
+        if (inflight > 0 && oldestUnackedUs() >= MQTT_ACK_TIMEOUT_MS * 1000UL) {
+            closeSession(MQTT_ASYNC_ERR_TIMEOUT);
+            return;
+        }
+        if (!pingOutstanding && now - lastTx >= MQTT_KEEPALIVE_S * 500UL) {
+            static const uint8_t ping[] = { MQTT_PINGREQ, 0 };
+            if (queueControl(ping, sizeof(ping))) {
+                pingOutstanding = true;
+                pingSentAt = now;
+            }
+        }
+    }
+
+    if (!writeOutgoing()) closeSession(MQTT_ASYNC_ERR_LINK);
+}
+
+void mqttAsync_wait(uint32_t timeoutMs) {
+    mqttLink_wait(timeoutMs);
+}
+
+void mqttAsync_getStats(MqttAsyncStats& out) {
+    out = stats;
+    out.enqueued = enqueued.load(std::memory_order_relaxed);
+    out.rejected = rejected.load(std::memory_order_relaxed);
+    out.maxEnqueueUs = maxEnqueueUs.load(std::memory_order_relaxed);
+    out.inflight = inflight;
+    size_t used = head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+    out.outboxUsed = used;
+    out.outboxPeak = outboxPeak.load(std::memory_order_relaxed);
+}
@@ -1,214 +1,1277 @@
 #include "mqtt_handler.h"
+#include "actuation_trace.h"
+#include "command_queue.h"
 #include "config.h"
+#include "mqtt_schema.h"
+#include "plant_profiles.h"
 #include <WiFi.h>
-#include <PubSubClient.h>
+#include "mqtt_async.h"
 #include <ArduinoJson.h>
-
-extern String currentPlantType;
-extern String actuatorMode;    // "manual" | "auto"
-extern String actuatorStatus;  // "on" | "off" (desired when manual)
+#include "boot_timing.h"
+#include "display.h"
+#include "json_arena.h"
+#include "logger.h"
+#include "mem_diag.h"
+#include "profiler.h"
+#include "report_gate.h"
+#include "state_store.h"
+#include "telemetry_store.h"
+#include "history_store.h"
+#include <time.h>
 
 // New device/topic constants
 const char* DEVICE_CODE = "GH-001";
 const int ACTUATOR_ID = 1; // pump
 
-// Rule state variables (defaults)
-int ruleMinMoisture = 40;
-int ruleMaxMoisture = 80;
-String rulePlantName = "Chili";
-int rulePreferredHumidity = 70;
-int rulePreferredTemp = 25;
-
-// Helper to build topic strings
-static String topicDeviceBase() { return String("device/") + DEVICE_CODE; }
-static String topicActuatorBase() { return topicDeviceBase() + "/actuator/" + ACTUATOR_ID; }
-
 const char* ssid = "AgrisenseAI"; // TODO: move to config/secret store
 const char* password = "abcdefgh"; // TODO: move to config/secret store
 const char* mqtt_server = "202.10.48.12";
 const int mqtt_port = 1883;
 
-WiFiClient espClient;
-PubSubClient client(espClient);
+// Topics are built once by initTopics(); schema in mqtt_schema.h
+static MqttTopics topics;
 
-void callback(char* topic, byte* payload, unsigned int length) {
-    String msg;
-    for (unsigned int i = 0; i < length; i++) msg += (char)payload[i];
-    String topicStr(topic);
-
-    Serial.printf("MQTT IN [%s]: %s\n", topic, msg.c_str());
-
-    // Topic patterns:
-    // device/{device_code}/actuator/{actuator_id}/mode   value: manual|auto
-    // device/{device_code}/actuator/{actuator_id}/status value: on|off (only applied in manual mode)
-    // device/{device_code}/rule JSON rule object (SUBSCRIBE)
-    String actuatorModeTopic = topicActuatorBase() + "/mode";
-    String actuatorStatusTopic = topicActuatorBase() + "/status";
-    String ruleTopic = topicDeviceBase() + "/rule";
-
-    if (topicStr == actuatorModeTopic) {
-        // Accept either plain text payloads: "manual" | "auto"
-        if (msg == "manual" || msg == "auto") {
-            actuatorMode = msg;
-            Serial.printf("Actuator mode updated to: %s\n", actuatorMode.c_str());
-            return;
+// Ingest dispatch table: suffixes after topics.base, matched by length then bytes
+typedef void (*TopicHandler)(const byte* payload, unsigned int length);
+
+struct TopicRoute {
+    char suffix[TOPIC_MAX];
+    size_t suffixLen;
+    TopicHandler handler;
+};
+
+static void handleRuleMessage(const byte* payload, unsigned int length);
+static void handleHistoryQuery(const byte* payload, unsigned int length);
+static void handleLogLevel(const byte* payload, unsigned int length);
+static void handleCalibrationMessage(const byte* payload, unsigned int length);
+
+static TopicRoute routes[] = {
+    { "", 0, handleRuleMessage },   // rule
+    { "", 0, handleHistoryQuery },  // history/query
+    { "", 0, handleLogLevel },      // log/level
+    { "", 0, handleCalibrationMessage }, // calibration
+};
+static const size_t ROUTE_COUNT = sizeof(routes) / sizeof(routes[0]);
+
+// actuator/{id}/{action}: the id indexes the zone directly (zone = id -
+// ACTUATOR_ID), so dispatch cost does not grow with the number of zones
+typedef void (*ActuatorHandler)(uint8_t zone, const byte* payload, unsigned int length);
+
+struct ActuatorRoute {
+    const char* action;
+    ActuatorHandler handler;
+};
+
+static void handleModeMessage(uint8_t zone, const byte* payload, unsigned int length);
+static void handleStatusMessage(uint8_t zone, const byte* payload, unsigned int length);
+
+static const ActuatorRoute actuatorRoutes[] = {
+    { "mode", handleModeMessage },
+    { "status", handleStatusMessage },
+};
+
+// Ingest statistics
+static unsigned long ingestMessages = 0;
+static unsigned long ingestUnrouted = 0;
+
+// Static arena for rule JSON documents: the ingest path never touches the heap
+static uint8_t ingestArenaBuffer[4096];
+static JsonArena ingestArena(ingestArenaBuffer, sizeof(ingestArenaBuffer));
+
+static void setRoute(size_t index, const char* fmt, int arg) {
+    int n = snprintf(routes[index].suffix, TOPIC_MAX, fmt, arg);
+    routes[index].suffixLen = (n > 0 && n < TOPIC_MAX) ? n : 0;
+}
+
+static bool initTopics() {
+    if (!mqttSchema_buildTopics(topics, DEVICE_CODE, ACTUATOR_ID)) return false;
+    setRoute(0, "rule", 0);
+    setRoute(1, "history/query", 0);
+    setRoute(2, "log/level", 0);
+    setRoute(3, "calibration", 0);
+    return true;
+}
+
+// Optional "id" of a status or mode command: the command is traced to the
+// relay and acknowledged right away (see actuation_trace.h)
+static void takeTraceId(Command& cmd, const byte* payload, unsigned int length) {
+    const char* id;
+    size_t idLen;
+    if (!mqttSchema_findString(payload, length, "id", &id, &idLen) || idLen == 0) return;
+    actuationTrace_copyId(cmd.traceId, id, idLen);
+    cmd.receivedUs = micros();
+}
+
+static inline bool payloadEquals(const byte* payload, unsigned int length, const char* literal) {
+    size_t n = strlen(literal);
+    return length == n && memcmp(payload, literal, n) == 0;
+}
+
+static void handleModeMessage(uint8_t zone, const byte* payload, unsigned int length) {
+    Command cmd = {};
+    cmd.type = CMD_SET_MODE;
+    cmd.zone = zone;
+
+    // Accept either plain text payloads: "manual" | "auto"
+    // or JSON payload: {"value":"manual"} or {"value":"auto"}
+    const char* value = reinterpret_cast<const char*>(payload);
+    size_t valueLen = length;
+    bool isJson = mqttSchema_findString(payload, length, "value", &value, &valueLen);
+
+    if (!mqttSchema_parseMode(value, valueLen, &cmd.mode)) {
+        LOG_WARN(LOG_TAG_MQTT, "%s", isJson ? "Unknown mode value in JSON" : "Unknown mode payload");
+        return;
+    }
+    if (isJson) takeTraceId(cmd, payload, length);
+    if (commandQueue_push(cmd)) {
+        LOG_INFO(LOG_TAG_MQTT, "Zone %u mode command queued: %s%s", zone, actuatorModeName(cmd.mode), isJson ? " (from JSON)" : "");
+    } else {
+        LOG_WARN(LOG_TAG_MQTT, "Command queue full - mode command dropped");
+    }
+}
+
+static void handleStatusMessage(uint8_t zone, const byte* payload, unsigned int length) {
+    // Parse JSON format: {"value":"on"} or {"value":"off"}, optionally with "id"
+    const char* value;
+    size_t valueLen;
+    if (!mqttSchema_findString(payload, length, "value", &value, &valueLen)) {
+        LOG_WARN(LOG_TAG_MQTT, "Missing 'value' field in status JSON");
+        return;
+    }
+
+    Command cmd = {};
+    cmd.type = CMD_SET_STATUS;
+    cmd.zone = zone;
+    if (!mqttSchema_parseOnOff(value, valueLen, &cmd.on)) {
+        LOG_WARN(LOG_TAG_MQTT, "Unknown status value in JSON");
+        return;
+    }
+    takeTraceId(cmd, payload, length);
+
+    // The relay itself is driven by the control loop (only in manual mode)
+    if (commandQueue_push(cmd)) LOG_INFO(LOG_TAG_MQTT, "Zone %u status command queued: %s", zone, cmd.on ? "on" : "off");
+    else LOG_WARN(LOG_TAG_MQTT, "Command queue full - status command dropped");
+}
+
+// Optional "deadband" object in the rule JSON, e.g.
+// {"deadband":{"moisture":{"abs":2,"rel":0.05,"heartbeat_s":300},"pump":{"heartbeat_s":600}}}
+// Report-by-exception settings live on the network task, so they are applied
+// here directly instead of going through the control command queue.
+static void applyDeadbandRule(JsonVariant deadband) {
+    static const char* const names[REPORT_ZONE_MOISTURE] = { "moisture", "temperature", "humidity", "pump" };
+    for (uint8_t ch = 0; ch < REPORT_ZONE_MOISTURE; ch++) {
+        JsonVariant entry = deadband[names[ch]];
+        if (entry.isNull()) continue;
+        DeadbandConfig cfg = reportGate_config((ReportChannel)ch);
+        if (entry["abs"].is<float>()) cfg.absolute = entry["abs"].as<float>();
+        if (entry["rel"].is<float>()) cfg.relative = entry["rel"].as<float>();
+        if (entry["heartbeat_s"].is<unsigned long>()) cfg.heartbeatMs = entry["heartbeat_s"].as<unsigned long>() * 1000UL;
+        reportGate_configure((ReportChannel)ch, cfg);
+        LOG_INFO(LOG_TAG_MQTT, "Deadband %s: abs=%.2f rel=%.3f heartbeat=%lus", names[ch], cfg.absolute, cfg.relative, cfg.heartbeatMs / 1000);
+    }
+}
+
+// A known plant_name fills in whatever the rule message leaves out
+static void handleRuleMessage(const byte* payload, unsigned int length) {
+    ingestArena.reset();
+    JsonDocument doc(&ingestArena);
+    DeserializationError err = deserializeJson(doc, reinterpret_cast<const char*>(payload), length);
+    if (err) {
+        LOG_WARN(LOG_TAG_MQTT, "Rule JSON parse error: %s", err.c_str());
+        return;
+    }
+
+    Command cmd = {};
+    cmd.type = CMD_SET_RULE;
+    uint32_t zone = (doc["actuator_id"] | ACTUATOR_ID) - ACTUATOR_ID;
+    if (zone >= ZONE_COUNT) {
+        LOG_WARN(LOG_TAG_MQTT, "Rule for unknown actuator_id %d ignored", doc["actuator_id"].as<int>());
+        return;
+    }
+    cmd.zone = zone;
+    RuleUpdate& rule = cmd.rule;
+    if (doc["min_moisture"].is<int>()) {
+        rule.minMoisture = doc["min_moisture"].as<int>();
+        rule.fields |= RULE_FIELD_MIN_MOISTURE;
+    }
+    if (doc["max_moisture"].is<int>()) {
+        rule.maxMoisture = doc["max_moisture"].as<int>();
+        rule.fields |= RULE_FIELD_MAX_MOISTURE;
+    }
+    const PlantProfile* profile = nullptr;
+    if (doc["plant_name"].is<const char*>()) {
+        const char* name = doc["plant_name"].as<const char*>();
+        profile = plantProfile_find(name);
+        // Known species keep their canonical spelling on the display and in NVS
+        strlcpy(rule.plantName, profile != nullptr ? profile->name : name, sizeof(rule.plantName));
+        rule.fields |= RULE_FIELD_PLANT_NAME;
+        if (profile == nullptr) LOG_INFO(LOG_TAG_MQTT, "No plant profile for \"%s\"", name);
+    }
+    if (doc["preferred_humidity"].is<int>()) {
+        rule.preferredHumidity = doc["preferred_humidity"].as<int>();
+        rule.fields |= RULE_FIELD_PREFERRED_HUMIDITY;
+    }
+    if (doc["preferred_temp"].is<int>()) {
+        rule.preferredTemp = doc["preferred_temp"].as<int>();
+        rule.fields |= RULE_FIELD_PREFERRED_TEMP;
+    }
+    if (profile != nullptr) plantProfile_fillRule(*profile, rule);
+    applyDeadbandRule(doc["deadband"]);
+
+    // Compile the watering rules here so the control loop only loads a table
+    JsonVariantConst rules = doc["rules"];
+    if (!rules.isNull()) {
+        Command programCmd = {};
+        programCmd.type = CMD_SET_PROGRAM;
+        programCmd.zone = zone;
+        char error[64];
+        if (!ruleEngine_compile(rules, programCmd.program, error, sizeof(error))) {
+            LOG_WARN(LOG_TAG_MQTT, "Zone %u rules rejected: %s", programCmd.zone, error);
+        } else if (commandQueue_push(programCmd)) {
+            LOG_INFO(LOG_TAG_MQTT, "Zone %u rules compiled: %u rules, %u conditions", programCmd.zone,
+                      programCmd.program.ruleCount, programCmd.program.conditionCount);
+        } else {
+            LOG_WARN(LOG_TAG_MQTT, "Command queue full - rule program dropped");
         }
+    }
 
-        // Or accept JSON payload: {"value":"manual"} or {"value":"auto"}
-        {
-            JsonDocument doc;
-            DeserializationError err = deserializeJson(doc, msg);
-            if (!err && doc["value"].is<const char*>()) {
-                String mode = String(doc["value"].as<const char *>());
-                if (mode == "manual" || mode == "auto") {
-                    actuatorMode = mode;
-                    Serial.printf("Actuator mode updated to: %s (from JSON)\n", actuatorMode.c_str());
-                    return;
-                } else {
-                    Serial.println("Unknown mode value in JSON");
-                    return;
-                }
+    if (commandQueue_push(cmd)) {
+        LOG_INFO(LOG_TAG_MQTT, "Zone %u rule command queued: min=%d max=%d plant=%s prefHum=%d prefTemp=%d%s",
+                  cmd.zone, rule.minMoisture, rule.maxMoisture, rule.plantName, rule.preferredHumidity, rule.preferredTemp,
+                  profile != nullptr ? " (profile)" : "");
+    } else {
+        LOG_WARN(LOG_TAG_MQTT, "Command queue full - rule command dropped");
+    }
+}
+
+// Soil calibration, e.g.
+// {"actuator_id":1,"capture":"dry"}                   current reading is 0 %
+// {"actuator_id":1,"capture":"wet"} or "capture":35   ... 100 %, or 35 %
+// {"actuator_id":1,"points":[[1320,100],[2100,45],[3290,0]],"temp_coeff":6.5}
+// {"actuator_id":1,"reset":true}
+// Points are [counts at SOIL_CAL_REF_TEMP_C, moisture %]; temp_coeff is the
+// probe's drift in counts per C. The control loop applies it and saves it.
+static bool parseMoistureX100(JsonVariantConst value, uint16_t& out) {
+    if (!value.is<float>()) return false;
+    float percent = value.as<float>();
+    if (!(percent >= 0.0f && percent <= 100.0f)) return false;
+    out = (uint16_t)lroundf(percent * 100);
+    return true;
+}
+
+static void handleCalibrationMessage(const byte* payload, unsigned int length) {
+    ingestArena.reset();
+    JsonDocument doc(&ingestArena);
+    DeserializationError err = deserializeJson(doc, reinterpret_cast<const char*>(payload), length);
+    if (err) {
+        LOG_WARN(LOG_TAG_MQTT, "Calibration JSON parse error: %s", err.c_str());
+        return;
+    }
+
+    Command cmd = {};
+    cmd.type = CMD_SET_CALIBRATION;
+    uint32_t zone = (doc["actuator_id"] | ACTUATOR_ID) - ACTUATOR_ID;
+    if (zone >= ZONE_COUNT) {
+        LOG_WARN(LOG_TAG_MQTT, "Calibration for unknown actuator_id %d ignored", doc["actuator_id"].as<int>());
+        return;
+    }
+    cmd.zone = zone;
+    CalibrationUpdate& cal = cmd.calibration;
+    if (doc["reset"] | false) cal.fields |= CAL_FIELD_RESET;
+
+    if (doc["points"].is<JsonArrayConst>()) {
+        JsonArrayConst points = doc["points"].as<JsonArrayConst>();
+        if (points.size() < 2 || points.size() > SOIL_CAL_MAX_POINTS) {
+            LOG_WARN(LOG_TAG_MQTT, "Calibration needs 2..%u points", (unsigned)SOIL_CAL_MAX_POINTS);
+            return;
+        }
+        for (JsonVariantConst point : points) {
+            SoilCalPoint& p = cal.points[cal.pointCount++];
+            JsonVariantConst raw = point[0];
+            if (!raw.is<unsigned>() || raw.as<unsigned>() > SOIL_CAL_ADC_MAX || !parseMoistureX100(point[1], p.moistureX100)) {
+                LOG_WARN(LOG_TAG_MQTT, "Calibration point %u: need [counts 0..%u, moisture 0..100]", cal.pointCount,
+                         (unsigned)SOIL_CAL_ADC_MAX);
+                return;
             }
+            p.raw = raw.as<unsigned>();
+        }
+        cal.fields |= CAL_FIELD_POINTS;
+    }
+
+    if (doc["temp_coeff"].is<float>()) {
+        float coeff = doc["temp_coeff"].as<float>();
+        if (!(fabsf(coeff) < 127.0f)) {
+            LOG_WARN(LOG_TAG_MQTT, "Calibration temp_coeff out of range");
+            return;
+        }
+        cal.tempCoeffQ8 = (int16_t)lroundf(coeff * 256);
+        cal.fields |= CAL_FIELD_TEMP_COEFF;
+    }
+
+    JsonVariant capture = doc["capture"];
+    if (!capture.isNull()) {
+        const char* which = capture.as<const char*>();
+        if (which != nullptr && strcmp(which, "dry") == 0) cal.captureMoistureX100 = 0;
+        else if (which != nullptr && strcmp(which, "wet") == 0) cal.captureMoistureX100 = 10000;
+        else if (!parseMoistureX100(capture, cal.captureMoistureX100)) {
+            LOG_WARN(LOG_TAG_MQTT, "Calibration capture must be \"dry\", \"wet\" or a moisture %%");
+            return;
+        }
+        cal.fields |= CAL_FIELD_CAPTURE;
+    }
+
+    if (cal.fields == 0) {
+        LOG_WARN(LOG_TAG_MQTT, "Calibration message without capture, points, temp_coeff or reset");
+        return;
+    }
+    if (commandQueue_push(cmd)) LOG_INFO(LOG_TAG_MQTT, "Zone %u calibration command queued", cmd.zone);
+    else LOG_WARN(LOG_TAG_MQTT, "Command queue full - calibration command dropped");
+}
+
+// History queries ------------------------------------------------------------
+// The requested range is scanned once when the query arrives, averaged into
+// at most HISTORY_QUERY_MAX_POINTS buckets of "step" seconds (pump = on if it
+// ran at any point in the bucket), and sent back HISTORY_CHUNK_POINTS points
+// per message, one message per network loop iteration.
+struct HistoryBucket {
+    uint32_t timestamp;    // bucket start
+    int32_t sum[3];        // moisture, temperature, humidity (x10)
+    uint16_t count;
+    uint8_t pumpOn;
+};
+
+struct HistoryQuery {
+    bool active;
+    uint8_t zone;
+    char id[ACTUATION_ID_MAX];  // echoed into every chunk, sanitized like a trace id
+    uint32_t from;
+    uint32_t to;
+    uint32_t step;
+    size_t samples;
+    uint16_t points;       // non-empty buckets, compacted to the front
+    uint16_t nextPoint;
+    uint16_t chunk;
+    unsigned long receivedAt;
+};
+
+static HistoryBucket historyBuckets[HISTORY_QUERY_MAX_POINTS];
+static HistoryQuery historyQuery = {};
+
+static void collectHistorySample(const TelemetrySample& s, void* ctx) {
+    HistoryQuery& q = *static_cast<HistoryQuery*>(ctx);
+    HistoryBucket& b = historyBuckets[(s.timestamp - q.from) / q.step];
+    b.sum[0] += s.moistureX10;
+    b.sum[1] += s.temperatureX10;
+    b.sum[2] += s.humidityX10;
+    b.count++;
+    b.pumpOn |= s.pumpOn;
+}
+
+static void handleHistoryQuery(const byte* payload, unsigned int length) {
+    ingestArena.reset();
+    JsonDocument doc(&ingestArena);
+    DeserializationError err = deserializeJson(doc, reinterpret_cast<const char*>(payload), length);
+    if (err) {
+        LOG_WARN(LOG_TAG_MQTT, "History query parse error: %s", err.c_str());
+        return;
+    }
+
+    uint32_t zone = (doc["actuator_id"] | ACTUATOR_ID) - ACTUATOR_ID;
+    if (zone >= ZONE_COUNT) {
+        LOG_WARN(LOG_TAG_MQTT, "History query for unknown actuator_id %d ignored", doc["actuator_id"].as<int>());
+        return;
+    }
+    if (historyQuery.active) LOG_INFO(LOG_TAG_MQTT, "History query %s superseded", historyQuery.id);
+
+    HistoryQuery& q = historyQuery;
+    memset(&q, 0, sizeof(q));
+    q.zone = zone;
+    q.receivedAt = millis();
+    const char* id = doc["id"] | "";
+    actuationTrace_copyId(q.id, id, strlen(id));
+    uint32_t now = (uint32_t)time(nullptr);
+    q.to = doc["to"] | now;
+    q.from = doc["from"] | (q.to > HISTORY_DEFAULT_RANGE_S ? q.to - HISTORY_DEFAULT_RANGE_S : 0);
+    if (q.from > q.to) {
+        LOG_INFO(LOG_TAG_MQTT, "History query %s: empty range", q.id);
+        q.from = q.to;
+    }
+    // Widen the step until the range fits in the bucket table
+    uint32_t minStep = (q.to - q.from) / HISTORY_QUERY_MAX_POINTS + 1;
+    q.step = doc["step"] | minStep;
+    if (q.step < minStep) q.step = minStep;
+
+    memset(historyBuckets, 0, sizeof(historyBuckets));
+    q.samples = history_query(q.zone, q.from, q.to, collectHistorySample, &q);
+    uint32_t buckets = (q.to - q.from) / q.step + 1;
+    for (uint32_t i = 0; i < buckets; i++) {
+        if (historyBuckets[i].count == 0) continue;
+        HistoryBucket& out = historyBuckets[q.points++];
+        out = historyBuckets[i];
+        out.timestamp = q.from + i * q.step;
+    }
+    q.active = true;
+}
+
+// log/level: "debug" or {"level":"debug","tag":"mqtt"}; without a tag every
+// tag is set
+static void handleLogLevel(const byte* payload, unsigned int length) {
+    const char* value = reinterpret_cast<const char*>(payload);
+    size_t valueLen = length;
+    mqttSchema_findString(payload, length, "level", &value, &valueLen);
+    LogLevel level;
+    if (!log_parseLevel(value, valueLen, &level)) {
+        LOG_WARN(LOG_TAG_MQTT, "Unknown log level");
+        return;
+    }
+
+    const char* tagName;
+    size_t tagLen;
+    LogTag tag;
+    if (!mqttSchema_findString(payload, length, "tag", &tagName, &tagLen)) {
+        for (uint8_t t = 0; t < LOG_TAG_COUNT; t++) log_setLevel((LogTag)t, level);
+    } else if (log_parseTag(tagName, tagLen, &tag)) {
+        log_setLevel(tag, level);
+    } else {
+        LOG_WARN(LOG_TAG_MQTT, "Unknown log tag");
+        return;
+    }
+    LOG_INFO(LOG_TAG_MQTT, "Log level set to %u", (unsigned)level);
+}
+
+// Payload dumps are debug level; the copy is only made when that is enabled
+static void logIngest(const char* topic, const byte* payload, unsigned int length) {
+    if (!LOG_ENABLED(LOG_TAG_MQTT, LOG_LEVEL_DEBUG)) return;
+    char preview[48];
+    size_t n = length < sizeof(preview) - 1 ? length : sizeof(preview) - 1;
+    memcpy(preview, payload, n);
+    preview[n] = '\0';
+    LOG_DEBUG(LOG_TAG_MQTT, "IN [%s] %u bytes: %s", topic, length, preview);
+}
+
+static bool routeActuator(const char* topic, const char* suffix, size_t suffixLen,
+                          const byte* payload, unsigned int length) {
+    uint8_t zone;
+    const char* action;
+    size_t actionLen;
+    if (!mqttSchema_parseActuatorTopic(suffix, suffixLen, ACTUATOR_ID, zone, action, actionLen)) return false;
+    for (size_t i = 0; i < sizeof(actuatorRoutes) / sizeof(actuatorRoutes[0]); i++) {
+        const ActuatorRoute& route = actuatorRoutes[i];
+        if (strlen(route.action) == actionLen && memcmp(route.action, action, actionLen) == 0) {
+            logIngest(topic, payload, length);
+            route.handler(zone, payload, length);
+            return true;
         }
+    }
+    return false;
+}
+
+void callback(char* topic, byte* payload, unsigned int length) {
+    ingestMessages++;
 
-        Serial.println("Unknown mode payload");
+    // Everything under device/{code}/# arrives here, including our own
+    // retained sensor publishes; those fall through the table unrouted.
+    if (strncmp(topic, topics.base, topics.baseLen) != 0) {
+        ingestUnrouted++;
         return;
     }
+    const char* suffix = topic + topics.baseLen;
+    size_t suffixLen = strlen(suffix);
+    if (routeActuator(topic, suffix, suffixLen, payload, length)) return;
 
-    if (topicStr == actuatorStatusTopic) {
-        // Parse JSON format: {"value":"on"} or {"value":"off"}
-        JsonDocument doc;
-        DeserializationError err = deserializeJson(doc, msg);
-        if (err) {
-            Serial.print("Status JSON parse error: ");
-            Serial.println(err.c_str());
+    for (size_t i = 0; i < ROUTE_COUNT; i++) {
+        const TopicRoute& route = routes[i];
+        if (route.suffixLen == suffixLen && memcmp(route.suffix, suffix, suffixLen) == 0) {
+            logIngest(topic, payload, length);
+            route.handler(payload, length);
             return;
         }
-        
-        if (doc["value"].is<const char*>()) {
-            String status = String(doc["value"].as<const char*>());
-            if (status == "on" || status == "off") {
-                actuatorStatus = status;
-                Serial.printf("Actuator status updated to: %s\n", actuatorStatus.c_str());
-                if (actuatorMode == "manual") {
-                    digitalWrite(RELAY_PIN, actuatorStatus == "on" ? HIGH : LOW);
-                    Serial.printf("Relay set to: %s\n", actuatorStatus == "on" ? "HIGH" : "LOW");
+    }
+    ingestUnrouted++;
+}
+
+unsigned long mqtt_ingestMessageCount() {
+    return ingestMessages;
+}
+
+unsigned long mqtt_ingestUnroutedCount() {
+    return ingestUnrouted;
+}
+
+unsigned long mqtt_ingestHeapAllocations() {
+    return ingestArena.heapFallbacks();
+}
+
+// Connection state machine -------------------------------------------------
+// Driven one step at a time from mqtt_loop(); nothing here waits for the
+// network. Failed attempts back off exponentially with jitter.
+static NetStats netStats = {};
+static unsigned long stateSince = 0;     // millis() when the current state was entered
+static unsigned long nextAttemptAt = 0;  // earliest millis() for the next attempt
+static unsigned long outageStart = 0;    // millis() when the link was lost
+static bool outageActive = true;         // boot counts as an outage until first connect
+static bool ntpStarted = false;
+
+static void requestStatsReport(); // runtime counters go out after every reconnect
+
+static void setNetState(NetState state) {
+    netStats.state = state;
+    stateSince = millis();
+}
+
+// Equal-jitter exponential backoff: half the window fixed, half random
+static unsigned long backoffDelay(uint8_t attempt, unsigned long baseMs, unsigned long maxMs) {
+    unsigned long window = baseMs;
+    for (uint8_t i = 0; i < attempt && window < maxMs; i++) window *= 2;
+    if (window > maxMs) window = maxMs;
+    return window / 2 + esp_random() % (window / 2 + 1);
+}
+
+static void scheduleRetry(unsigned long baseMs, unsigned long maxMs) {
+    unsigned long wait = backoffDelay(netStats.failedAttempts, baseMs, maxMs);
+    if (netStats.failedAttempts < 16) netStats.failedAttempts++;
+    nextAttemptAt = millis() + wait;
+    netStats.nextRetryInMs = wait;
+}
+
+static void markLinkLost() {
+    if (!outageActive) {
+        outageActive = true;
+        outageStart = millis();
+    }
+}
+
+// Fast reconnect: join the last access point directly on its channel,
+// skipping the scan; fall back to a normal scan if that attempt times out
+static WifiCache wifiCache;
+static bool wifiCacheValid = false;
+static bool wifiFastAttempt = false;
+
+static void rememberAccessPoint() {
+    const uint8_t* bssid = WiFi.BSSID();
+    uint8_t channel = WiFi.channel();
+    if (bssid == nullptr || channel == 0) return;
+    if (wifiCacheValid && channel == wifiCache.channel && memcmp(bssid, wifiCache.bssid, 6) == 0) return;
+    memcpy(wifiCache.bssid, bssid, 6);
+    wifiCache.channel = channel;
+    wifiCacheValid = true;
+    stateStore_saveWifi(wifiCache);
+}
+
+static void markLinkRestored() {
+    if (outageActive) {
+        outageActive = false;
+        unsigned long outage = millis() - outageStart;
+        netStats.lastReconnectMs = outage;
+        if (outage > netStats.maxReconnectMs) netStats.maxReconnectMs = outage;
+    }
+    netStats.failedAttempts = 0;
+    netStats.nextRetryInMs = 0;
+}
+
+void setup_wifi() {
+    mqttAsync_begin(mqtt_server, mqtt_port, MQTT_CLIENT_ID, callback);
+    // One wildcard subscription; callback() routes actuator & rule topics.
+    // QoS 1 so commands sent while we are away wait in the broker session.
+    mqttAsync_subscribe(topics.subscribe, 1);
+
+    // The state machine below owns reconnects; don't let the driver race it
+    // (nor rewrite its own flash config on every begin)
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false);
+#ifdef WIFI_STATIC_IP
+    WiFi.config(IPAddress(WIFI_STATIC_IP), IPAddress(WIFI_GATEWAY), IPAddress(WIFI_SUBNET), IPAddress(WIFI_DNS));
+#endif
+    wifiCacheValid = stateStore_loadWifi(wifiCache);
+    setNetState(NET_WIFI_DOWN);
+    outageStart = millis();
+    nextAttemptAt = millis();
+}
+
+// One non-blocking step of the WiFi/MQTT reconnect state machine.
+void mqtt_reconnect() {
+    unsigned long now = millis();
+    bool wifiUp = (WiFi.status() == WL_CONNECTED);
+
+    if (!wifiUp && netStats.state >= NET_WIFI_UP) {
+        LOG_WARN(LOG_TAG_NET, "WiFi terputus");
+        if (netStats.state >= NET_MQTT_CONNECTING) mqttAsync_disconnect();
+        markLinkLost();
+        setNetState(NET_WIFI_DOWN);
+        nextAttemptAt = now;
+    }
+
+    switch (netStats.state) {
+        case NET_WIFI_DOWN:
+            if ((long)(now - nextAttemptAt) < 0) break;
+            wifiFastAttempt = wifiCacheValid;
+            LOG_INFO(LOG_TAG_NET, "Menghubungkan ke WiFi%s...", wifiFastAttempt ? " (BSSID tersimpan)" : "");
+            WiFi.disconnect();
+            if (wifiFastAttempt) WiFi.begin(ssid, password, wifiCache.channel, wifiCache.bssid);
+            else WiFi.begin(ssid, password);
+            netStats.wifiAttempts++;
+            setNetState(NET_WIFI_CONNECTING);
+            break;
+
+        case NET_WIFI_CONNECTING:
+            if (wifiUp) {
+                IPAddress ip = WiFi.localIP();
+                LOG_INFO(LOG_TAG_NET, "WiFi terhubung! ESP32 IP: %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+                bootTiming_mark(BOOT_WIFI_UP);
+                rememberAccessPoint();
+                netStats.failedAttempts = 0;
+                nextAttemptAt = now;
+                if (!ntpStarted) {
+                    // Background SNTP; telemetry timestamps switch to epoch once synced.
+                    // TIME_ZONE makes localtime() match the rule windows' wall clock.
+                    configTzTime(TIME_ZONE, NTP_SERVER);
+                    ntpStarted = true;
                 }
+                setNetState(NET_WIFI_UP);
+            } else if (now - stateSince >= WIFI_CONNECT_TIMEOUT_MS) {
+                scheduleRetry(WIFI_BACKOFF_BASE_MS, WIFI_BACKOFF_MAX_MS);
+                if (wifiFastAttempt) wifiCacheValid = false; // AP moved or gone: scan next time
+                LOG_WARN(LOG_TAG_NET, "WiFi timeout, coba lagi dalam %lu ms", netStats.nextRetryInMs);
+                setNetState(NET_WIFI_DOWN);
+            }
+            break;
+
+        case NET_WIFI_UP:
+            if ((long)(now - nextAttemptAt) < 0) break;
+            LOG_INFO(LOG_TAG_NET, "Mencoba koneksi MQTT...");
+            netStats.mqttAttempts++;
+            // Tanpa username & password. Only starts the TCP handshake;
+            // mqttAsync_service() carries it through CONNECT/CONNACK.
+            if (mqttAsync_connect()) {
+                setNetState(NET_MQTT_CONNECTING);
             } else {
-                Serial.println("Unknown status value in JSON");
+                scheduleRetry(MQTT_BACKOFF_BASE_MS, MQTT_BACKOFF_MAX_MS);
+                LOG_WARN(LOG_TAG_NET, "MQTT gagal, rc=%d coba lagi dalam %lu ms", mqttAsync_lastError(), netStats.nextRetryInMs);
+            }
+            break;
+
+        case NET_MQTT_CONNECTING:
+            if (mqttAsync_connected()) {
+                MqttAsyncStats ms;
+                mqttAsync_getStats(ms);
+                LOG_INFO(LOG_TAG_NET, "MQTT terhubung (sesi %s, %u byte antre)",
+                         ms.sessionPresent ? "lanjut" : "baru", (unsigned)ms.outboxUsed);
+                LOG_INFO(LOG_TAG_NET, "Subscribed to: %s", topics.subscribe);
+                markLinkRestored();
+                bootTiming_mark(BOOT_MQTT_UP);
+                netStats.reconnects++;
+                setNetState(NET_MQTT_CONNECTED);
+                requestStatsReport();
+            } else if (mqttAsync_state() == MQTT_ASYNC_DISCONNECTED) {
+                // Refused, timed out or the link broke (see MqttAsyncError)
+                scheduleRetry(MQTT_BACKOFF_BASE_MS, MQTT_BACKOFF_MAX_MS);
+                LOG_WARN(LOG_TAG_NET, "MQTT gagal, rc=%d coba lagi dalam %lu ms", mqttAsync_lastError(), netStats.nextRetryInMs);
+                setNetState(NET_WIFI_UP);
+            }
+            break;
+
+        case NET_MQTT_CONNECTED:
+            if (!mqttAsync_connected()) {
+                LOG_WARN(LOG_TAG_NET, "MQTT terputus");
+                markLinkLost();
+                nextAttemptAt = now;
+                setNetState(NET_WIFI_UP);
             }
+            break;
+    }
+}
+
+NetState mqtt_connectionState() {
+    return netStats.state;
+}
+
+void mqtt_getNetStats(NetStats& out) {
+    out = netStats;
+    out.currentOutageMs = outageActive ? millis() - outageStart : 0;
+}
+
+// Legacy per-sensor topics ---------------------------------------------------
+// Kept for backward compatibility (TELEMETRY_LEGACY_TOPICS). Payloads keep
+// the original {"value":"12.3"} shape (number as a quoted string).
+#if TELEMETRY_LEGACY_TOPICS
+static size_t publishLegacyValue(const char* topic, const char* value) {
+    char payload[32];
+    int len = snprintf(payload, sizeof(payload), "{\"value\":\"%s\"}", value);
+    mqttAsync_publish(topic, payload, 0, true);
+    return len;
+}
+
+static size_t publishLegacyFloat(const char* topic, float value) {
+    char text[12];
+    snprintf(text, sizeof(text), "%.1f", value);
+    return publishLegacyValue(topic, text);
+}
+#endif
+
+// Traced actuations (see actuation_trace.h): acknowledged on actual-status as
+// soon as the control stage hands them over, with the hop latencies
+static void publishActuationTraces() {
+    ActuationTrace trace;
+    while (actuationTrace_pop(trace)) {
+        char payload[224];
+        uint32_t publishUs = micros();
+        size_t len = actuationTrace_format(trace, publishUs, payload, sizeof(payload));
+        // QoS 1: the acknowledgement survives a reconnect in the outbox
+        bool published = len > 0 && mqttAsync_connected() && trace.zone < ZONE_COUNT &&
+                         mqttAsync_publish(topics.actualStatus[trace.zone], payload, 1, true);
+        actuationTrace_recordPublished(trace, publishUs, published);
+        if (!published) continue;
+
+        uint32_t total = actuationTrace_totalUs(trace, publishUs);
+        if (total > ACTUATION_SLO_US) {
+            LOG_WARN(LOG_TAG_MQTT, "Zone %u actuation seq=%lu took %lu us (SLO %lu us)", trace.zone,
+                     (unsigned long)trace.seq, (unsigned long)total, (unsigned long)ACTUATION_SLO_US);
         } else {
-            Serial.println("Missing 'value' field in status JSON");
+            LOG_DEBUG(LOG_TAG_MQTT, "Zone %u actuation seq=%lu acknowledged: %s, %lu us", trace.zone,
+                      (unsigned long)trace.seq, trace.on ? "on" : "off", (unsigned long)total);
         }
-        return;
     }
+}
 
-    if (topicStr == ruleTopic) {
-        JsonDocument doc;
-        DeserializationError err = deserializeJson(doc, msg);
-        if (err) {
-            Serial.print("Rule JSON parse error: ");
-            Serial.println(err.c_str());
-            return;
+// Batched telemetry: one message per cycle with every reading, a timestamp
+// and a sequence number, encoded from a static arena into a static buffer.
+static uint8_t telemetryArenaBuffer[1024 + (ZONE_COUNT - 1) * 96];
+static JsonArena telemetryArena(telemetryArenaBuffer, sizeof(telemetryArenaBuffer));
+static uint8_t telemetryPayload[256 + (ZONE_COUNT - 1) * 32];
+static uint32_t telemetrySeq = 0;
+static TelemetryFormatStats formatStats[TELEMETRY_FORMAT_COUNT] = {};
+
+static void recordFormatStats(TelemetryFormat format, size_t bytes, unsigned long encodeUs) {
+    TelemetryFormatStats& st = formatStats[format];
+    st.messages++;
+    st.lastBytes = bytes;
+    st.lastEncodeUs = encodeUs;
+    st.totalBytes += bytes;
+    st.totalEncodeUs += encodeUs;
+}
+
+// Moisture channels of every zone
+static const ReportMask MOISTURE_MASK = REPORT_MASK(REPORT_MOISTURE) |
+    (REPORT_MASK_ALL & ~(REPORT_MASK(REPORT_ZONE_MOISTURE) - 1));
+
+static bool publishTelemetryBatch(const DeviceState& state, ReportMask mask) {
+    TelemetrySample sample = telemetryStore_makeSample(0, state.temperature, state.moisture[0], state.humidity,
+                                                       state.pumpOn & ZONE_BIT(0));
+
+    unsigned long start = micros();
+    telemetryArena.reset();
+    JsonDocument doc(&telemetryArena);
+    doc[(sample.flags & TELEMETRY_TS_UPTIME) ? "uptime" : "ts"] = sample.timestamp;
+    doc["seq"] = telemetrySeq;
+    // Only channels that changed past their deadband (or hit their heartbeat)
+    if (mask & REPORT_MASK(REPORT_TEMPERATURE)) doc["temperature"] = sample.temperatureX10 / 10.0f;
+    if (mask & REPORT_MASK(REPORT_HUMIDITY)) doc["humidity"] = sample.humidityX10 / 10.0f;
+#if ZONE_COUNT == 1
+    if (mask & REPORT_MASK(REPORT_MOISTURE)) doc["moisture"] = sample.moistureX10 / 10.0f;
+    if (mask & REPORT_MASK(REPORT_PUMP)) doc["pump"] = state.pumpOn ? "on" : "off";
+    doc["mode"] = actuatorModeName(state.autoMode ? MODE_AUTO : MODE_MANUAL);
+#else
+    // Several zones: arrays indexed by zone (actuator id = ACTUATOR_ID + index)
+    if (mask & MOISTURE_MASK) {
+        JsonArray moisture = doc["moisture"].to<JsonArray>();
+        for (uint8_t z = 0; z < ZONE_COUNT; z++) moisture.add(lroundf(state.moisture[z] * 10) / 10.0f);
+    }
+    if (mask & REPORT_MASK(REPORT_PUMP)) {
+        JsonArray pump = doc["pump"].to<JsonArray>();
+        for (uint8_t z = 0; z < ZONE_COUNT; z++) pump.add((state.pumpOn & ZONE_BIT(z)) ? "on" : "off");
+    }
+    JsonArray mode = doc["mode"].to<JsonArray>();
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        mode.add(actuatorModeName((state.autoMode & ZONE_BIT(z)) ? MODE_AUTO : MODE_MANUAL));
+    }
+#endif
+
+#if TELEMETRY_MSGPACK
+    const TelemetryFormat format = TELEMETRY_FORMAT_MSGPACK;
+    size_t len = serializeMsgPack(doc, telemetryPayload, sizeof(telemetryPayload));
+    const char* topic = topics.telemetryMsgPack;
+#else
+    const TelemetryFormat format = TELEMETRY_FORMAT_JSON;
+    size_t len = serializeJson(doc, reinterpret_cast<char*>(telemetryPayload), sizeof(telemetryPayload));
+    const char* topic = topics.telemetry;
+#endif
+    unsigned long encodeUs = micros() - start;
+
+    if (len == 0 || len >= sizeof(telemetryPayload)) {
+        LOG_ERROR(LOG_TAG_MQTT, "Telemetry encode overflow");
+        return false;
+    }
+    if (!mqttAsync_publish(topic, telemetryPayload, len, 0, false)) return false;
+    recordFormatStats(format, len, encodeUs);
+    bootTiming_mark(BOOT_FIRST_PUBLISH);
+    LOG_DEBUG(LOG_TAG_MQTT, "Published telemetry seq=%lu: %u bytes, encoded in %lu us",
+              (unsigned long)telemetrySeq, (unsigned)len, encodeUs);
+    telemetrySeq++;
+    return true;
+}
+
+bool mqtt_publishTelemetry(const DeviceState& state, ReportMask mask) {
+    if (!mqttAsync_connected() || mask == 0) return false;
+    if (!publishTelemetryBatch(state, mask)) return false;
+
+#if TELEMETRY_LEGACY_TOPICS
+    unsigned long start = micros();
+    size_t bytes = 0;
+    // sensor/{id} only describes one zone; zone 0 keeps it
+    if (mask & REPORT_MASK(REPORT_MOISTURE)) bytes += publishLegacyFloat(topics.sensor[0], state.moisture[0]);
+    if (mask & REPORT_MASK(REPORT_TEMPERATURE)) bytes += publishLegacyFloat(topics.sensor[1], state.temperature);
+    if (mask & REPORT_MASK(REPORT_HUMIDITY)) bytes += publishLegacyFloat(topics.sensor[2], state.humidity);
+    if (mask & REPORT_MASK(REPORT_PUMP)) {
+        for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+            bytes += publishLegacyValue(topics.actualStatus[z], (state.pumpOn & ZONE_BIT(z)) ? "on" : "off");
+        }
+    }
+    recordFormatStats(TELEMETRY_FORMAT_LEGACY, bytes, micros() - start);
+#endif
+    return true;
+}
+
+// Fill the report-gate channels from a snapshot. DHT zeros mean "no valid
+// reading" (same rule as the per-sensor topics) and are never reported.
+static void reportValues(const DeviceState& state, float values[REPORT_CHANNEL_COUNT]) {
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) values[reportMoistureChannel(z)] = state.moisture[z];
+    values[REPORT_TEMPERATURE] = state.temperature > 0.1 ? state.temperature : NAN;
+    values[REPORT_HUMIDITY] = state.humidity > 0.1 ? state.humidity : NAN;
+    values[REPORT_PUMP] = (float)state.pumpOn; // ZoneMask, exact in a float
+}
+
+void mqtt_getTelemetryFormatStats(TelemetryFormat format, TelemetryFormatStats& out) {
+    out = formatStats[format];
+}
+
+// Store-and-forward --------------------------------------------------------
+static unsigned long lastDrainAt = 0;
+static unsigned long backlogOversizeDrops = 0; // samples that could not fit a message on their own
+
+// Publish one rate-limited batch of samples recorded while offline. A batch
+// is cut short at the last sample that fits the MQTT buffer; the rest goes
+// out with the next one.
+static void drainBacklog() {
+    if (netStats.state != NET_MQTT_CONNECTED || telemetryStore_count() == 0) return;
+    unsigned long now = millis();
+    if (now - stateSince < TELEMETRY_DRAIN_HOLDOFF_MS) return;
+    if (now - lastDrainAt < TELEMETRY_DRAIN_INTERVAL_MS) return;
+    lastDrainAt = now;
+
+    static TelemetrySample batch[TELEMETRY_DRAIN_BATCH];
+    static char payload[MQTT_BUFFER_SIZE - TOPIC_MAX - 8];
+    size_t n = telemetryStore_peek(batch, TELEMETRY_DRAIN_BATCH);
+    if (n == 0) return;
+
+    // Uptime stamps from this boot can be converted once the clock is synced
+    time_t epochNow = time(nullptr);
+    bool clockSynced = epochNow > EPOCH_VALID_AFTER;
+    uint32_t uptimeNow = millis() / 1000;
+
+    size_t len = snprintf(payload, sizeof(payload), "{\"actuator_id\":%d,\"samples\":[", ACTUATOR_ID);
+    size_t sent = 0;
+    for (size_t i = 0; i < n; i++) {
+        const TelemetrySample& s = batch[i];
+        const char* tsKey = "ts";
+        uint32_t ts = s.timestamp;
+        if (s.flags & TELEMETRY_TS_UPTIME) {
+            if (clockSynced && s.bootId == telemetryStore_bootId()) ts = (uint32_t)epochNow - (uptimeNow - s.timestamp);
+            else tsKey = "uptime";
         }
-        if (doc["min_moisture"].is<int>()) ruleMinMoisture = doc["min_moisture"].as<int>();
-        if (doc["max_moisture"].is<int>()) ruleMaxMoisture = doc["max_moisture"].as<int>();
-        if (doc["plant_name"].is<const char*>()) rulePlantName = String(doc["plant_name"].as<const char*>());
-        if (doc["preferred_humidity"].is<int>()) rulePreferredHumidity = doc["preferred_humidity"].as<int>();
-        if (doc["preferred_temp"].is<int>()) rulePreferredTemp = doc["preferred_temp"].as<int>();
-        Serial.printf("Updated rule: min=%d max=%d plant=%s prefHum=%d prefTemp=%d\n", ruleMinMoisture, ruleMaxMoisture, rulePlantName.c_str(), rulePreferredHumidity, rulePreferredTemp);
+#if ZONE_COUNT > 1
+        // Several zones: every sample names its zone (actuator id = ACTUATOR_ID + index)
+        char zoneField[24];
+        snprintf(zoneField, sizeof(zoneField), "\"actuator_id\":%d,", ACTUATOR_ID + s.zone);
+#else
+        const char* zoneField = "";
+#endif
+        int written = snprintf(payload + len, sizeof(payload) - len,
+                               "%s{%s\"%s\":%lu,\"moisture\":%.1f,\"temperature\":%.1f,\"humidity\":%.1f,\"pump\":\"%s\"}",
+                               i ? "," : "", zoneField, tsKey, (unsigned long)ts,
+                               s.moistureX10 / 10.0f, s.temperatureX10 / 10.0f, s.humidityX10 / 10.0f,
+                               s.pumpOn ? "on" : "off");
+        if (written < 0 || len + written + 2 >= sizeof(payload)) break; // keep room for "]}"
+        len += written;
+        sent++;
+    }
+    if (sent == 0) {
+        // Waiting would not help: drop it so the samples behind it can go out
+        LOG_ERROR(LOG_TAG_MQTT, "Backlog sample exceeds MQTT buffer - dropped");
+        backlogOversizeDrops++;
+        telemetryStore_consume(1);
         return;
     }
+    len += snprintf(payload + len, sizeof(payload) - len, "]}");
+
+    // QoS 1: once queued, the outbox keeps the batch until the broker has it
+    if (mqttAsync_publish(topics.backlog, payload, 1, false)) {
+        telemetryStore_consume(sent);
+        LOG_INFO(LOG_TAG_MQTT, "Backlog drained: %u samples, %lu left", (unsigned)sent, (unsigned long)telemetryStore_count());
+    }
 }
 
-void setup_wifi() {
-    Serial.println("Menghubungkan ke WiFi...");
-    WiFi.begin(ssid, password);
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(500);
-        Serial.print(".");
+// Publish the next chunk of a pending history query
+static void serviceHistoryQuery() {
+    HistoryQuery& q = historyQuery;
+    if (!q.active || netStats.state != NET_MQTT_CONNECTED) return;
+
+    static char payload[MQTT_BUFFER_SIZE - TOPIC_MAX - 8];
+    uint16_t chunks = q.points ? (q.points + HISTORY_CHUNK_POINTS - 1) / HISTORY_CHUNK_POINTS : 1;
+    size_t len = snprintf(payload, sizeof(payload), "{\"id\":\"%s\",\"actuator_id\":%d,\"chunk\":%u,\"chunks\":%u",
+                          q.id, ACTUATOR_ID + q.zone, q.chunk, chunks);
+    if (q.chunk == 0) {
+        HistoryStats hs;
+        history_getStats(hs);
+        len += snprintf(payload + len, sizeof(payload) - len,
+                        ",\"from\":%lu,\"to\":%lu,\"step\":%lu,\"samples\":%u,\"scanUs\":%lu,\"bytesPerSample\":%.2f",
+                        (unsigned long)q.from, (unsigned long)q.to, (unsigned long)q.step, (unsigned)q.samples,
+                        hs.lastQueryUs, hs.bytesPerSample);
+    }
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"points\":[");
+    uint16_t end = min((uint16_t)(q.nextPoint + HISTORY_CHUNK_POINTS), q.points);
+    for (uint16_t i = q.nextPoint; i < end && len < sizeof(payload); i++) {
+        const HistoryBucket& b = historyBuckets[i];
+        len += snprintf(payload + len, sizeof(payload) - len, "%s[%lu,%.1f,%.1f,%.1f,%u]",
+                        i > q.nextPoint ? "," : "", (unsigned long)b.timestamp,
+                        b.sum[0] / (10.0f * b.count), b.sum[1] / (10.0f * b.count),
+                        b.sum[2] / (10.0f * b.count), b.pumpOn);
     }
-    Serial.print("ESP32 IP: ");
-    Serial.println(WiFi.localIP());
+    if (len + 2 >= sizeof(payload)) {
+        LOG_ERROR(LOG_TAG_MQTT, "History chunk exceeds MQTT buffer - lower HISTORY_CHUNK_POINTS");
+        q.active = false;
+        return;
+    }
+    len += snprintf(payload + len, sizeof(payload) - len, "]}");
 
-    Serial.println("\nWiFi terhubung!");
-    client.setServer(mqtt_server, mqtt_port);
-    client.setCallback(callback);
+    if (!mqttAsync_publish(topics.history, payload, 0, false)) return; // retry next iteration
+    q.nextPoint = end;
+    q.chunk++;
+    if (q.chunk >= chunks) {
+        q.active = false;
+        LOG_INFO(LOG_TAG_MQTT, "History query %s: %u samples -> %u points in %u chunks, %lu ms",
+                  q.id, (unsigned)q.samples, q.points, chunks, millis() - q.receivedAt);
+    }
 }
 
+// Memory diagnostics -----------------------------------------------------------
+// Sampled every MEM_DIAG_SAMPLE_MS and reported every MEM_DIAG_PERIOD_MS; a
+// newly raised alert is logged and reported right away.
+static MemStats memoryStats;
+static bool memorySampled = false;
+static unsigned long lastMemorySample = 0;
+static unsigned long lastMemoryReport = 0;
+static bool memoryReportPending = false;
 
-void mqtt_reconnect() {
-    while (!client.connected()) {
-        Serial.print("Mencoba koneksi MQTT...");
-        // Tanpa username & password
-        if (client.connect("ESP32_Plant_Monitor")) {
-            Serial.println("terhubung");
-            // Actuator & rule topics
-            String modeTopic = topicActuatorBase() + "/mode";
-            String statusTopic = topicActuatorBase() + "/status";
-            String ruleTopic = topicDeviceBase() + "/rule";
-            
-            client.subscribe(modeTopic.c_str());
-            client.subscribe(statusTopic.c_str());
-            client.subscribe(ruleTopic.c_str());
-            
-            Serial.printf("Subscribed to topics:\n");
-            Serial.printf("  Mode: %s\n", modeTopic.c_str());
-            Serial.printf("  Status: %s\n", statusTopic.c_str());
-            Serial.printf("  Rule: %s\n", ruleTopic.c_str());
-        } else {
-            Serial.print("gagal, rc=");
-            Serial.print(client.state());
-            Serial.println(" coba lagi dalam 5 detik");
-            delay(5000);
+static void serviceMemoryReport(unsigned long now) {
+    if (!memorySampled || now - lastMemorySample >= MEM_DIAG_SAMPLE_MS) {
+        uint8_t previousAlerts = memorySampled ? memoryStats.alerts : 0;
+        memDiag_sample(memoryStats);
+        memorySampled = true;
+        lastMemorySample = now;
+        if (memoryStats.alerts & ~previousAlerts) {
+            LOG_WARN(LOG_TAG_DIAG, "Memory alert 0x%02x: free=%u largest=%u min=%u frag=%u%%", memoryStats.alerts,
+                     (unsigned)memoryStats.freeHeap, (unsigned)memoryStats.largestBlock,
+                     (unsigned)memoryStats.minFreeHeap, (unsigned)memoryStats.fragmentationPct);
+            memoryReportPending = true;
         }
     }
+    if (now - lastMemoryReport >= MEM_DIAG_PERIOD_MS) {
+        lastMemoryReport = now;
+        memoryReportPending = true;
+    }
+    if (!memoryReportPending || netStats.state != NET_MQTT_CONNECTED) return;
+
+    char payload[320];
+    size_t len = memDiag_format(memoryStats, payload, sizeof(payload));
+    if (len > 0 && !mqttAsync_publish(topics.memory, payload, 0, false)) return; // retry next iteration
+    memoryReportPending = false;
 }
 
-// (Legacy publishing removed)
+// Boot-time breakdown, published (retained) once the first telemetry went out
+static bool bootReported = false;
 
-// New structured publish functions -----------------------------------------
-void mqtt_publishSensors(float temperature, float moisture, float humidity) {
-    if (!client.connected()) return;
-    // sensor_id: soil moisture=1, temperature=2, humidity=3
-    String base = topicDeviceBase() + "/sensor/";
+static void serviceBootReport() {
+    if (bootReported || bootTiming_ms(BOOT_FIRST_PUBLISH) == 0 || netStats.state != NET_MQTT_CONNECTED) return;
+    char payload[256];
+    size_t len = bootTiming_format(payload, sizeof(payload));
+    if (len > 0 && !mqttAsync_publish(topics.boot, payload, 1, true)) return; // retry next iteration
+    bootReported = true;
 
-    // Validate sensor values - don't send 0 or invalid values
-    // DHT22 sensors (temperature & humidity) should not send 0 values
-    if (temperature > 0.1) {  // Only send if temperature is valid (> 0.1°C)
-        String temperatureJson = "{\"value\":\"" + String(temperature, 1) + "\"}";
-        client.publish(String(base + "2").c_str(), temperatureJson.c_str(), true);
-        Serial.printf("Published temperature: %.1f°C\n", temperature);
-    } else {
-        Serial.println("Skipping temperature publish - invalid value (0 or too low)");
+    StateStoreStats store;
+    stateStore_getStats(store);
+    LOG_INFO(LOG_TAG_DIAG, "Boot: first decision %lu ms, WiFi %lu ms, MQTT %lu ms, first publish %lu ms (%s state)",
+             (unsigned long)bootTiming_ms(BOOT_FIRST_DECISION), (unsigned long)bootTiming_ms(BOOT_WIFI_UP),
+             (unsigned long)bootTiming_ms(BOOT_MQTT_UP), (unsigned long)bootTiming_ms(BOOT_FIRST_PUBLISH),
+             store.restored ? "restored" : "default");
+}
+
+// Runtime counters ---------------------------------------------------------------
+// Every STATS_PUBLISH_PERIOD_MS, and once after each reconnect, every section
+// is published to diagnostics/stats as its own {"<section>":{...}} message,
+// one per network loop iteration.
+enum StatsSection : uint8_t {
+    STATS_NET,
+    STATS_TELEMETRY,
+    STATS_SESSION,
+    STATS_STORE,
+    STATS_GATE,
+    STATS_DISPLAY,
+    STATS_LOG,
+    STATS_SECTION_COUNT
+};
+
+static uint8_t statsNext = STATS_SECTION_COUNT; // next section to send, COUNT = idle
+static unsigned long lastStatsReport = 0;
+
+static void requestStatsReport() {
+    statsNext = 0;
+}
+
+// ,"key":[v0,v1,...] with one value per report channel (ReportChannel order)
+static int formatChannelCounts(char* out, size_t size, const char* key, const unsigned long counts[REPORT_CHANNEL_COUNT]) {
+    int n = snprintf(out, size, ",\"%s\":[", key);
+    for (uint8_t ch = 0; ch < REPORT_CHANNEL_COUNT && n > 0 && (size_t)n < size; ch++) {
+        n += snprintf(out + n, size - n, "%s%lu", ch ? "," : "", counts[ch]);
     }
+    if (n > 0 && (size_t)n < size) n += snprintf(out + n, size - n, "]");
+    return n;
+}
 
-    if (humidity > 0.1) {  // Only send if humidity is valid (> 0.1%)
-        String humidityJson = "{\"value\":\"" + String(humidity, 1) + "\"}";
-        client.publish(String(base + "3").c_str(), humidityJson.c_str(), true);
-        Serial.printf("Published humidity: %.1f%%\n", humidity);
-    } else {
-        Serial.println("Skipping humidity publish - invalid value (0 or too low)");
+static size_t formatStatsSection(StatsSection section, char* out, size_t size) {
+    int n = 0;
+    switch (section) {
+        case STATS_NET: {
+            NetStats ns;
+            mqtt_getNetStats(ns);
+            n = snprintf(out, size,
+                         "{\"net\":{\"reconnects\":%lu,\"wifiAttempts\":%lu,\"mqttAttempts\":%lu,"
+                         "\"failedAttempts\":%u,\"nextRetryMs\":%lu,\"outageMs\":%lu,"
+                         "\"lastReconnectMs\":%lu,\"maxReconnectMs\":%lu}}",
+                         ns.reconnects, ns.wifiAttempts, ns.mqttAttempts, (unsigned)ns.failedAttempts,
+                         ns.nextRetryInMs, ns.currentOutageMs, ns.lastReconnectMs, ns.maxReconnectMs);
+            break;
+        }
+        case STATS_TELEMETRY: {
+            // Payload size and encode time per format, last and average
+            static const char* const NAMES[TELEMETRY_FORMAT_COUNT] = {"json", "msgpack", "legacy"};
+            n = snprintf(out, size, "{\"telemetry\":{");
+            for (uint8_t f = 0; f < TELEMETRY_FORMAT_COUNT && n > 0 && (size_t)n < size; f++) {
+                TelemetryFormatStats fs;
+                mqtt_getTelemetryFormatStats((TelemetryFormat)f, fs);
+                unsigned long count = fs.messages ? fs.messages : 1;
+                n += snprintf(out + n, size - n,
+                              "%s\"%s\":{\"messages\":%lu,\"lastBytes\":%u,\"avgBytes\":%lu,"
+                              "\"lastEncodeUs\":%lu,\"avgEncodeUs\":%lu}",
+                              f ? "," : "", NAMES[f], fs.messages, (unsigned)fs.lastBytes, fs.totalBytes / count,
+                              fs.lastEncodeUs, fs.totalEncodeUs / count);
+            }
+            if (n > 0 && (size_t)n < size) n += snprintf(out + n, size - n, "}}");
+            break;
+        }
+        case STATS_SESSION: {
+            MqttAsyncStats ms;
+            mqttAsync_getStats(ms);
+            n = snprintf(out, size,
+                         "{\"session\":{\"outboxUsed\":%u,\"outboxPeak\":%u,\"inflight\":%u,"
+                         "\"enqueued\":%lu,\"rejected\":%lu,\"sent\":%lu,\"retransmits\":%lu,"
+                         "\"received\":%lu,\"oversized\":%lu,\"maxEnqueueUs\":%lu,"
+                         "\"lastAckUs\":%lu,\"maxAckUs\":%lu,\"sessionPresent\":%s}}",
+                         (unsigned)ms.outboxUsed, (unsigned)ms.outboxPeak, (unsigned)ms.inflight,
+                         ms.enqueued, ms.rejected, ms.sent, ms.retransmits, ms.received, ms.oversized,
+                         (unsigned long)ms.maxEnqueueUs, (unsigned long)ms.lastAckUs, (unsigned long)ms.maxAckUs,
+                         ms.sessionPresent ? "true" : "false");
+            break;
+        }
+        case STATS_STORE: {
+            TelemetryStoreStats ts;
+            telemetryStore_getStats(ts);
+            n = snprintf(out, size,
+                         "{\"store\":{\"count\":%lu,\"capacity\":%lu,\"fillPercent\":%u,\"overflowDrops\":%lu,"
+                         "\"corruptSkipped\":%lu,\"oversizeDrops\":%lu,\"flashWrites\":%lu,\"drained\":%lu}}",
+                         (unsigned long)ts.count, (unsigned long)ts.capacity, (unsigned)ts.fillPercent,
+                         ts.overflowDrops, ts.corruptSkipped, backlogOversizeDrops, ts.flashWrites, ts.drained);
+            break;
+        }
+        case STATS_GATE: {
+            // Readings sent, held back by their deadband, and sent only for the heartbeat
+            ReportGateStats gs;
+            reportGate_getStats(gs);
+            n = snprintf(out, size, "{\"gate\":{\"channels\":%u", (unsigned)REPORT_CHANNEL_COUNT);
+            if (n > 0 && (size_t)n < size) n += formatChannelCounts(out + n, size - n, "published", gs.published);
+            if (n > 0 && (size_t)n < size) n += formatChannelCounts(out + n, size - n, "suppressed", gs.suppressed);
+            if (n > 0 && (size_t)n < size) n += formatChannelCounts(out + n, size - n, "heartbeats", gs.heartbeats);
+            if (n > 0 && (size_t)n < size) n += snprintf(out + n, size - n, "}}");
+            break;
+        }
+        case STATS_DISPLAY: {
+            // Frames skipped while the previous flush was still on the bus;
+            // I2C bytes per frame are averaged over the frames actually sent
+            DisplayStats ds;
+            getDisplayStats(ds);
+            n = snprintf(out, size,
+                         "{\"display\":{\"frames\":%lu,\"fullRedraws\":%lu,\"flushes\":%lu,\"droppedFrames\":%lu,"
+                         "\"lastFrameUs\":%lu,\"maxFrameUs\":%lu,\"avgFrameUs\":%lu,"
+                         "\"lastFlushUs\":%lu,\"maxFlushUs\":%lu,\"lastI2cBytes\":%u,\"i2cBytesPerFrame\":%lu}}",
+                         ds.frames, ds.fullRedraws, ds.flushes, ds.droppedFrames,
+                         ds.lastFrameUs, ds.maxFrameUs, ds.frames ? ds.totalFrameUs / ds.frames : 0,
+                         ds.lastFlushUs, ds.maxFlushUs, (unsigned)ds.lastI2cBytes,
+                         ds.flushes ? ds.totalI2cBytes / ds.flushes : 0);
+            break;
+        }
+        case STATS_LOG: {
+            LogStats ls;
+            log_getStats(ls);
+            n = snprintf(out, size, "{\"log\":{\"written\":%lu,\"dropped\":%lu}}", ls.written, ls.dropped);
+            break;
+        }
+        default:
+            break;
     }
+    return n > 0 && (size_t)n < size ? n : 0;
+}
+
+static void serviceStatsReport(unsigned long now) {
+    if (now - lastStatsReport >= STATS_PUBLISH_PERIOD_MS) {
+        lastStatsReport = now;
+        requestStatsReport();
+    }
+    if (statsNext >= STATS_SECTION_COUNT || netStats.state != NET_MQTT_CONNECTED) return;
 
-    // Soil moisture can be 0 (completely dry), so we allow it
-    String moistureJson = "{\"value\":\"" + String(moisture, 1) + "\"}";
-    client.publish(String(base + "1").c_str(), moistureJson.c_str(), true);
-    Serial.printf("Published moisture: %.1f%%\n", moisture);
+    char payload[384];
+    size_t len = formatStatsSection((StatsSection)statsNext, payload, sizeof(payload));
+    if (len > 0 && !mqttAsync_publish(topics.stats, payload, 0, false)) return; // retry next iteration
+    statsNext++;
 }
 
-void mqtt_publishActualActuatorStatus(bool isOn) {
-    if (!client.connected()) return;
-    String topic = topicActuatorBase() + "/actual-status";
+#if PROFILER_ENABLED
+// Hot-path profile -------------------------------------------------------------
+// Every PROFILE_PUBLISH_PERIOD_MS all stages are snapshotted and a new window
+// starts; the snapshot goes out one stage per network loop iteration. Windows
+// that end while offline are dropped.
+static ProfileStats profileSnapshot[PROF_STAGE_COUNT];
+static uint8_t profileNext = PROF_STAGE_COUNT; // next stage to send, COUNT = idle
+static unsigned long profileWindowStart = 0;
+static unsigned long profileWindowMs = 0;
+
+static void serviceProfileReport(unsigned long now) {
+    if (profileNext >= PROF_STAGE_COUNT) {
+        if (now - profileWindowStart < PROFILE_PUBLISH_PERIOD_MS) return;
+        for (uint8_t s = 0; s < PROF_STAGE_COUNT; s++) profiler_snapshot((ProfileStage)s, profileSnapshot[s]);
+        profiler_resetWindow();
+        profileWindowMs = now - profileWindowStart;
+        profileWindowStart = now;
+        profileNext = 0;
+    }
+    if (netStats.state != NET_MQTT_CONNECTED) {
+        profileNext = PROF_STAGE_COUNT;
+        return;
+    }
 
-    // Bungkus dalam JSON
-    String payload = "{\"value\":\"" + String(isOn ? "on" : "off") + "\"}";
+    char payload[256];
+    ProfileStage stage = (ProfileStage)profileNext;
+    size_t len = profiler_formatStage(stage, profileSnapshot[stage], profileWindowMs, payload, sizeof(payload));
+    if (len > 0 && !mqttAsync_publish(topics.profile, payload, 0, false)) return; // retry next iteration
+    profileNext++;
+}
+#endif
 
-    client.publish(topic.c_str(), payload.c_str(), true);
+void mqtt_loop() {
+    mqttAsync_service();
+    mqtt_reconnect();
 }
 
+// WiFi/MQTT task on core 0. Socket calls stay here, away from the control
+// loop that owns the relay on core 1, which keeps running while offline.
+static void networkTask(void* arg) {
+    memDiag_registerCurrentTask();
+    reportGate_begin();
+    telemetryStore_begin();
+    history_begin();
+    // A device code the topics cannot hold would publish under a cut-off
+    // name; stay offline instead (control does not depend on this task)
+    if (!initTopics()) {
+        LOG_ERROR(LOG_TAG_MQTT, "DEVICE_CODE \"%s\" longer than %d characters - network disabled", DEVICE_CODE,
+                  DEVICE_CODE_MAX);
+        vTaskDelete(nullptr);
+        return;
+    }
+    setup_wifi();
 
-void mqtt_loop() {
-    if (!client.connected()) mqtt_reconnect();
-    client.loop();
+    unsigned long lastSample = 0;
+    ZoneMask lastReportedPump = 0;
+    unsigned long lastHistorySample = 0;
+    ZoneMask lastHistoryPump = 0;
+    for (;;) {
+        {
+            PROFILE_SCOPE(PROF_MQTT_LOOP);
+            mqtt_loop();
+        }
+        publishActuationTraces();
+
+        // Sensors are checked against their deadbands every publish period;
+        // a pump state change reports on the next iteration.
+        unsigned long now = millis();
+        DeviceState state;
+        deviceState_read(state);
+        bool pumpChanged = (state.pumpOn != lastReportedPump);
+        if (pumpChanged || now - lastSample >= MQTT_PUBLISH_PERIOD_MS) {
+            if (!pumpChanged) lastSample = now;
+
+            float values[REPORT_CHANNEL_COUNT];
+            reportValues(state, values);
+            ReportMask mask = reportGate_due(values, now);
+            if (mask != 0) {
+                bool published = false;
+                if (mqttAsync_connected()) {
+                    PROFILE_SCOPE(PROF_PUBLISH);
+                    published = mqtt_publishTelemetry(state, mask);
+                }
+                if (published) {
+                    reportGate_commit(mask, values, now);
+                } else {
+                    // Offline or the outbox is full: keep every zone's reading
+                    // for later instead of dropping it. The gate still holds the
+                    // last published values, so the next period tries again.
+                    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+                        telemetryStore_append(telemetryStore_makeSample(z, state.temperature, state.moisture[z],
+                                                                        state.humidity, state.pumpOn & ZONE_BIT(z)));
+                    }
+                }
+            }
+            // Published or kept in the backlog: the edge is recorded either way
+            lastReportedPump = state.pumpOn;
+        }
+
+        // History: one sample per zone and period, plus one for a zone
+        // whose pump switched
+        bool historyDue = lastHistorySample == 0 || now - lastHistorySample >= HISTORY_SAMPLE_PERIOD_MS;
+        if (historyDue) lastHistorySample = now;
+        ZoneMask historyEdges = state.pumpOn ^ lastHistoryPump;
+        lastHistoryPump = state.pumpOn;
+        for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+            if (!historyDue && !(historyEdges & ZONE_BIT(z))) continue;
+            history_append(telemetryStore_makeSample(z, state.temperature, state.moisture[z],
+                                                     state.humidity, state.pumpOn & ZONE_BIT(z)));
+        }
+
+        drainBacklog();
+        telemetryStore_service(millis());
+        serviceHistoryQuery();
+        serviceMemoryReport(now);
+        serviceBootReport();
+        serviceStatsReport(now);
+#if PROFILER_ENABLED
+        serviceProfileReport(now);
+#endif
+
+        // Write what this iteration queued, then sleep until the broker
+        // sends something or the loop period passes
+        mqttAsync_service();
+        mqttAsync_wait(MQTT_LOOP_PERIOD_MS);
+    }
+}
+
+void mqtt_startTask() {
+    xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK, nullptr, NETWORK_TASK_PRIORITY, nullptr, NETWORK_TASK_CORE);
 }
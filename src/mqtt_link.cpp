@@ -0,0 +1,86 @@
+#include "mqtt_link.h"
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <lwip/inet.h>
+#include <errno.h>
+
+static int sock = -1;
+static MqttLinkState state = LINK_CLOSED;
+
+bool mqttLink_open(const char* host, uint16_t port) {
+    mqttLink_close();
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        // Names still go through the (blocking) resolver; use an IP literal to avoid it
+        IPAddress ip;
+        if (!WiFi.hostByName(host, ip)) return false;
+        addr.sin_addr.s_addr = (uint32_t)ip;
+    }
+
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) return false;
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // small packets, send now
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    if (connect(sock, (sockaddr*)&addr, sizeof(addr)) == 0) {
+        state = LINK_OPEN;
+    } else if (errno == EINPROGRESS) {
+        state = LINK_CONNECTING;
+    } else {
+        mqttLink_close();
+        return false;
+    }
+    return true;
+}
+
+MqttLinkState mqttLink_poll() {
+    if (state != LINK_CONNECTING) return state;
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(sock, &writable);
+    timeval zero = { 0, 0 };
+    if (select(sock + 1, nullptr, &writable, nullptr, &zero) <= 0) return state;
+    int error = 0;
+    socklen_t len = sizeof(error);
+    getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &len);
+    state = error == 0 ? LINK_OPEN : LINK_FAILED;
+    return state;
+}
+
+int mqttLink_send(const uint8_t* data, size_t len) {
+    if (state != LINK_OPEN) return -1;
+    int n = send(sock, data, len, 0);
+    if (n >= 0) return n;
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+    state = LINK_FAILED;
+    return -1;
+}
+
+int mqttLink_recv(uint8_t* data, size_t len) {
+    if (state != LINK_OPEN) return -1;
+    int n = recv(sock, data, len, 0);
+    if (n > 0) return n;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    state = LINK_FAILED; // 0 = orderly close by the broker
+    return -1;
+}
+
+void mqttLink_wait(uint32_t timeoutMs) {
+    if (state != LINK_OPEN) {
+        vTaskDelay(pdMS_TO_TICKS(timeoutMs));
+        return;
+    }
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(sock, &readable);
+    timeval timeout = { (long)(timeoutMs / 1000), (long)(timeoutMs % 1000) * 1000 };
+    select(sock + 1, &readable, nullptr, nullptr, &timeout);
+}
+
+void mqttLink_close() {
+    if (sock >= 0) close(sock);
+    sock = -1;
+    state = LINK_CLOSED;
+}
@@ -0,0 +1,93 @@
+#include "mqtt_schema.h"
+
+// Base plus suffix; false if it was cut short
+static bool topic(char out[TOPIC_MAX], const MqttTopics& t, const char* suffix, int id = -1) {
+    int n = id < 0 ? snprintf(out, TOPIC_MAX, "%s%s", t.base, suffix)
+                   : snprintf(out, TOPIC_MAX, "%s%s/%d/actual-status", t.base, suffix, id);
+    return n > 0 && n < TOPIC_MAX;
+}
+
+bool mqttSchema_buildTopics(MqttTopics& out, const char* deviceCode, int actuatorId) {
+    if (strlen(deviceCode) > DEVICE_CODE_MAX || actuatorId < 0 || actuatorId + ZONE_COUNT > 65536) return false;
+    int n = snprintf(out.base, TOPIC_MAX, "device/%s/", deviceCode);
+    if (n <= 0 || n >= TOPIC_MAX) return false;
+    out.baseLen = n;
+    bool ok = topic(out.subscribe, out, "#");
+    static const char* const SENSORS[3] = {"sensor/1", "sensor/2", "sensor/3"};
+    for (int i = 0; i < 3; i++) ok &= topic(out.sensor[i], out, SENSORS[i]);
+    for (int z = 0; z < ZONE_COUNT; z++) ok &= topic(out.actualStatus[z], out, "actuator", actuatorId + z);
+    ok &= topic(out.backlog, out, "telemetry/backlog");
+    ok &= topic(out.telemetry, out, "telemetry");
+    ok &= topic(out.telemetryMsgPack, out, "telemetry/msgpack");
+    ok &= topic(out.history, out, "history");
+    ok &= topic(out.profile, out, "diagnostics/profile");
+    ok &= topic(out.memory, out, "diagnostics/memory");
+    ok &= topic(out.boot, out, "diagnostics/boot");
+    ok &= topic(out.stats, out, "diagnostics/stats");
+    return ok;
+}
+
+bool mqttSchema_parseActuatorTopic(const char* suffix, size_t suffixLen, int actuatorId,
+                                   uint8_t& zone, const char*& action, size_t& actionLen) {
+    static const char PREFIX[] = "actuator/";
+    const size_t prefixLen = sizeof(PREFIX) - 1;
+    if (suffixLen <= prefixLen || memcmp(suffix, PREFIX, prefixLen) != 0) return false;
+
+    const char* p = suffix + prefixLen;
+    const char* end = suffix + suffixLen;
+    const char* digits = p;
+    uint32_t id = 0;
+    while (p < end && p - digits < 5 && *p >= '0' && *p <= '9') id = id * 10 + (*p++ - '0');
+    if (p == digits || p >= end || *p != '/') return false;
+    p++;
+
+    uint32_t z = id - actuatorId; // ids below actuatorId wrap and fail the check
+    if (z >= ZONE_COUNT) return false;
+    zone = (uint8_t)z;
+    action = p;
+    actionLen = end - p;
+    return true;
+}
+
+bool mqttSchema_findString(const byte* payload, unsigned int length, const char* key,
+                           const char** value, size_t* valueLen) {
+    const char* p = reinterpret_cast<const char*>(payload);
+    const char* end = p + length;
+    size_t keyLen = strlen(key);
+
+    while (p < end) {
+        if (*p != '"') { p++; continue; }
+        const char* k = ++p;
+        while (p < end && *p != '"') p++;
+        if (p >= end) return false;
+        bool match = (size_t)(p - k) == keyLen && memcmp(k, key, keyLen) == 0;
+        p++;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+        if (p >= end || *p != ':') continue; // that was a value, not a key
+        p++;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+        if (p >= end || *p != '"') continue;
+        const char* v = ++p;
+        while (p < end && *p != '"') p++;
+        if (p >= end) return false;
+        if (match) {
+            *value = v;
+            *valueLen = p - v;
+            return true;
+        }
+        p++;
+    }
+    return false;
+}
+
+bool mqttSchema_parseMode(const char* value, size_t len, ActuatorMode* mode) {
+    if (len == 4 && memcmp(value, "auto", 4) == 0) { *mode = MODE_AUTO; return true; }
+    if (len == 6 && memcmp(value, "manual", 6) == 0) { *mode = MODE_MANUAL; return true; }
+    return false;
+}
+
+bool mqttSchema_parseOnOff(const char* value, size_t len, bool* on) {
+    if (len == 2 && memcmp(value, "on", 2) == 0) { *on = true; return true; }
+    if (len == 3 && memcmp(value, "off", 3) == 0) { *on = false; return true; }
+    return false;
+}
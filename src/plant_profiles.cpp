@@ -0,0 +1,56 @@
+#include "plant_profiles.h"
+#include "command_queue.h"
+#include "device_state.h"
+#include "plant_profiles_table.h"
+
+// Two-level lookup: the name's bucket picks a seed, the seeded hash picks the slot
+constexpr size_t plantSlot(const char* name) {
+    return plantHash(name, PLANT_SEEDS[plantHash(name, 0) % PLANT_BUCKET_COUNT]) % PLANT_PROFILE_COUNT;
+}
+
+constexpr size_t plantNameLength(const char* s) {
+    return *s ? 1 + plantNameLength(s + 1) : 0;
+}
+
+constexpr bool plantEntryValid(size_t i) {
+    return plantSlot(PLANT_PROFILES[i].name) == i && plantNameLength(PLANT_PROFILES[i].name) < PLANT_NAME_MAX &&
+           PLANT_PROFILES[i].minMoisture < PLANT_PROFILES[i].maxMoisture && PLANT_PROFILES[i].runS > 0;
+}
+
+// Halves the range each step, so the recursion stays log2(count) deep
+constexpr bool plantEntriesValid(size_t from, size_t to) {
+    return to - from == 1 ? plantEntryValid(from)
+                          : plantEntriesValid(from, (from + to) / 2) && plantEntriesValid((from + to) / 2, to);
+}
+
+static_assert(PLANT_PROFILE_COUNT > 0, "empty plant profile table");
+static_assert(plantEntriesValid(0, PLANT_PROFILE_COUNT),
+              "plant_profiles_table.h does not match its hash; run tools/plant_db/gen_plant_profiles.py");
+
+const PlantProfile* plantProfile_find(const char* name) {
+    const PlantProfile& candidate = PLANT_PROFILES[plantSlot(name)];
+    return strcasecmp(candidate.name, name) == 0 ? &candidate : nullptr;
+}
+
+size_t plantProfile_slot(const char* name) {
+    return plantSlot(name);
+}
+
+void plantProfile_fillRule(const PlantProfile& profile, RuleUpdate& rule) {
+    if (!(rule.fields & RULE_FIELD_MIN_MOISTURE)) rule.minMoisture = profile.minMoisture;
+    if (!(rule.fields & RULE_FIELD_MAX_MOISTURE)) rule.maxMoisture = profile.maxMoisture;
+    if (!(rule.fields & RULE_FIELD_PREFERRED_HUMIDITY)) rule.preferredHumidity = profile.preferredHumidity;
+    if (!(rule.fields & RULE_FIELD_PREFERRED_TEMP)) rule.preferredTemp = profile.preferredTemp;
+    rule.runS = profile.runS;
+    rule.cooldownS = profile.cooldownS;
+    rule.fields |= RULE_FIELD_MIN_MOISTURE | RULE_FIELD_MAX_MOISTURE | RULE_FIELD_PREFERRED_HUMIDITY |
+                   RULE_FIELD_PREFERRED_TEMP | RULE_FIELD_PUMP_TIMING;
+}
+
+size_t plantProfile_count() {
+    return PLANT_PROFILE_COUNT;
+}
+
+const PlantProfile& plantProfile_at(size_t index) {
+    return PLANT_PROFILES[index < PLANT_PROFILE_COUNT ? index : 0];
+}
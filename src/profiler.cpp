@@ -0,0 +1,130 @@
+#include "profiler.h"
+
+#if PROFILER_ENABLED
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+struct StageRecord {
+    uint32_t window;  // window this record belongs to
+    ProfileStats stats;
+};
+
+static StageRecord records[PROF_STAGE_COUNT];
+static std::atomic<uint32_t> currentWindow(1);
+
+static const char* const STAGE_NAMES[PROF_STAGE_COUNT] = {
+    "soil", "soil_filter", "dht", "control", "display_draw",
+    "display_flush", "status_log", "mqtt_loop", "publish"
+};
+
+#ifdef ARDUINO
+static uint32_t cyclesPerUs = 240;
+
+void profiler_begin() {
+    cyclesPerUs = ESP.getCpuFreqMHz();
+}
+
+uint32_t profiler_now() {
+    return ESP.getCycleCount();
+}
+
+static inline uint32_t elapsedUs(uint32_t startTicks) {
+    return (ESP.getCycleCount() - startTicks) / cyclesPerUs;
+}
+#else
+void profiler_begin() {}
+
+uint32_t profiler_now() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static inline uint32_t elapsedUs(uint32_t startTicks) {
+    return profiler_now() - startTicks;
+}
+#endif
+
+static inline uint8_t bucketOf(uint32_t us) {
+    if (us == 0) return 0;
+    uint8_t bucket = 32 - __builtin_clz(us);
+    return bucket < PROFILE_BUCKETS ? bucket : PROFILE_BUCKETS - 1;
+}
+
+void profiler_record(ProfileStage stage, uint32_t startTicks) {
+    uint32_t us = elapsedUs(startTicks);
+    StageRecord& r = records[stage];
+
+    // Only the stage's own task writes its record, so a window reset
+    // requested by the reader is applied here
+    uint32_t window = currentWindow.load(std::memory_order_relaxed);
+    if (r.window != window) {
+        memset(&r.stats, 0, sizeof(r.stats));
+        r.window = window;
+    }
+
+    ProfileStats& s = r.stats;
+    if (s.count == 0 || us < s.minUs) s.minUs = us;
+    if (us > s.maxUs) s.maxUs = us;
+    s.count++;
+    s.totalUs += us;
+    s.buckets[bucketOf(us)]++;
+}
+
+// Called right after profiler_record, so the window is already current
+void profiler_recordAllocations(ProfileStage stage, uint32_t count) {
+    records[stage].stats.allocations += count;
+}
+
+void profiler_snapshot(ProfileStage stage, ProfileStats& out) {
+    const StageRecord& r = records[stage];
+    if (r.window != currentWindow.load(std::memory_order_relaxed)) {
+        memset(&out, 0, sizeof(out)); // not run since the last reset
+        return;
+    }
+    // May be one sample apart between fields; fine for diagnostics
+    out = r.stats;
+}
+
+void profiler_resetWindow() {
+    currentWindow.fetch_add(1, std::memory_order_relaxed);
+}
+
+const char* profiler_stageName(ProfileStage stage) {
+    return stage < PROF_STAGE_COUNT ? STAGE_NAMES[stage] : "?";
+}
+
+size_t profiler_formatStage(ProfileStage stage, const ProfileStats& stats, unsigned long windowMs,
+                            char* buf, size_t len) {
+    uint32_t mean = stats.count ? (uint32_t)(stats.totalUs / stats.count) : 0;
+    int n = snprintf(buf, len, "{\"stage\":\"%s\",\"window_ms\":%lu,\"n\":%u,\"min_us\":%u,\"max_us\":%u,\"mean_us\":%u,\"hist\":[",
+                     profiler_stageName(stage), windowMs, (unsigned)stats.count, (unsigned)stats.minUs,
+                     (unsigned)stats.maxUs, (unsigned)mean);
+    if (n < 0 || (size_t)n >= len) return 0;
+    size_t pos = n;
+
+    // Trailing empty buckets are left out
+    int last = PROFILE_BUCKETS - 1;
+    while (last >= 0 && stats.buckets[last] == 0) last--;
+    for (int i = 0; i <= last; i++) {
+        n = snprintf(buf + pos, len - pos, i ? ",%u" : "%u", (unsigned)stats.buckets[i]);
+        if (n < 0 || (size_t)n >= len - pos) return 0;
+        pos += n;
+    }
+#ifdef ARDUINO
+    n = snprintf(buf + pos, len - pos, "]}");
+#else
+    n = snprintf(buf + pos, len - pos, "],\"allocs\":%u}", (unsigned)stats.allocations);
+#endif
+    if (n < 0 || (size_t)n >= len - pos) return 0;
+    return pos + n;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#include "pump_cycle.h"
+
+bool pumpCycle_step(PumpCycle& cycle, int8_t matchedRule, bool aboveMax, unsigned long now) {
+    // Soil sufficiently moist: idle, pump off
+    if (aboveMax) {
+        cycle.phase = PUMP_IDLE;
+        return false;
+    }
+    switch (cycle.phase) {
+        case PUMP_RUNNING:
+            // A started run lasts its run_s even if the reading crosses back
+            // over the threshold, so the relay cannot chatter
+            if (now - cycle.phaseStart >= cycle.runMs) {
+                cycle.phase = PUMP_COOLDOWN;
+                cycle.phaseStart = now;
+            }
+            return false;
+        case PUMP_COOLDOWN:
+            if (now - cycle.phaseStart < cycle.cooldownMs) return false;
+            if (matchedRule >= 0) return true;
+            cycle.phase = PUMP_IDLE;
+            return false;
+        default:
+            return matchedRule >= 0; // rule just started matching
+    }
+}
+
+void pumpCycle_start(PumpCycle& cycle, const CompiledRule& rule, unsigned long now) {
+    cycle.phase = PUMP_RUNNING;
+    cycle.phaseStart = now;
+    cycle.runMs = rule.runS * 1000UL;
+    cycle.cooldownMs = rule.cooldownS * 1000UL;
+}
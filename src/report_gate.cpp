@@ -0,0 +1,71 @@
+#include "report_gate.h"
+#include "config.h"
+#include <math.h>
+
+static DeadbandConfig configs[REPORT_CHANNEL_COUNT];
+static float lastValue[REPORT_CHANNEL_COUNT];
+static unsigned long lastPublishAt[REPORT_CHANNEL_COUNT] = {};
+static ReportGateStats stats = {};
+
+void reportGate_begin() {
+    static const DeadbandConfig moisture = { REPORT_MOISTURE_DEADBAND_ABS, 0.0f, REPORT_HEARTBEAT_MS };
+    configs[REPORT_TEMPERATURE] = { REPORT_TEMPERATURE_DEADBAND_ABS, 0.0f, REPORT_HEARTBEAT_MS };
+    configs[REPORT_HUMIDITY] = { REPORT_HUMIDITY_DEADBAND_ABS, 0.0f, REPORT_HEARTBEAT_MS };
+    configs[REPORT_PUMP] = { 0.0f, 0.0f, REPORT_HEARTBEAT_MS };
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) configs[reportMoistureChannel(z)] = moisture;
+    for (uint8_t ch = 0; ch < REPORT_CHANNEL_COUNT; ch++) lastValue[ch] = NAN;
+}
+
+void reportGate_configure(ReportChannel channel, const DeadbandConfig& config) {
+    if (channel >= REPORT_CHANNEL_COUNT) return;
+    if (channel == REPORT_MOISTURE) {
+        for (uint8_t z = 0; z < ZONE_COUNT; z++) configs[reportMoistureChannel(z)] = config;
+        return;
+    }
+    configs[channel] = config;
+}
+
+const DeadbandConfig& reportGate_config(ReportChannel channel) {
+    return configs[channel];
+}
+
+static bool outsideDeadband(const DeadbandConfig& cfg, float last, float value) {
+    float delta = fabsf(value - last);
+    if (cfg.absolute <= 0.0f && cfg.relative <= 0.0f) return delta > 0.0f;
+    if (cfg.absolute > 0.0f && delta >= cfg.absolute) return true;
+    if (cfg.relative > 0.0f && delta >= cfg.relative * fabsf(last)) return true;
+    return false;
+}
+
+ReportMask reportGate_due(const float values[REPORT_CHANNEL_COUNT], unsigned long now) {
+    ReportMask mask = 0;
+    for (uint8_t ch = 0; ch < REPORT_CHANNEL_COUNT; ch++) {
+        float value = values[ch];
+        if (isnan(value)) continue;
+
+        const DeadbandConfig& cfg = configs[ch];
+        if (isnan(lastValue[ch]) || outsideDeadband(cfg, lastValue[ch], value)) {
+            mask |= REPORT_MASK(ch);
+        } else if (cfg.heartbeatMs > 0 && now - lastPublishAt[ch] >= cfg.heartbeatMs) {
+            mask |= REPORT_MASK(ch);
+            stats.heartbeats[ch]++;
+        } else {
+            stats.suppressed[ch]++;
+        }
+    }
+    if (mask == 0) stats.messagesSuppressed++;
+    return mask;
+}
+
+void reportGate_commit(ReportMask mask, const float values[REPORT_CHANNEL_COUNT], unsigned long now) {
+    for (uint8_t ch = 0; ch < REPORT_CHANNEL_COUNT; ch++) {
+        if (!(mask & REPORT_MASK(ch))) continue;
+        lastValue[ch] = values[ch];
+        lastPublishAt[ch] = now;
+        stats.published[ch]++;
+    }
+}
+
+void reportGate_getStats(ReportGateStats& out) {
+    out = stats;
+}
@@ -0,0 +1,292 @@
+#include "rule_engine.h"
+#include "config.h"
+#include <stdarg.h>
+#include <time.h>
+
+static const char* const INPUT_NAMES[RULE_INPUT_COUNT] = { "moisture", "temperature", "humidity" };
+static const char* const COMPARISON_NAMES[] = { "lt", "le", "gt", "ge" };
+// Accepted thresholds per input, in the input's own unit
+static const float INPUT_MIN[RULE_INPUT_COUNT] = { 0.0f, -40.0f, 0.0f };
+static const float INPUT_MAX[RULE_INPUT_COUNT] = { 100.0f, 80.0f, 100.0f };
+
+static RuleProgram programs[ZONE_COUNT];
+// Run/cooldown of each zone's default program (its plant profile's)
+static uint16_t defaultRunS[ZONE_COUNT];
+static uint16_t defaultCooldownS[ZONE_COUNT];
+static RuleEngineStats stats = {};
+static time_t cachedEpochMinute = 0;
+static int16_t cachedMinuteOfDay = -1;
+
+// --- Compiler (network task) ---
+
+static bool fail(char* error, size_t errorLen, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(error, errorLen, fmt, args);
+    va_end(args);
+    return false;
+}
+
+static int indexOf(const char* const* names, size_t count, const char* name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) return (int)i;
+    }
+    return -1;
+}
+
+// "HH:MM" -> minute of day
+static bool parseClock(const char* text, uint16_t& minute) {
+    if (!isdigit(text[0]) || !isdigit(text[1]) || text[2] != ':' || !isdigit(text[3]) || !isdigit(text[4])) return false;
+    int hour = (text[0] - '0') * 10 + (text[1] - '0');
+    int min = (text[3] - '0') * 10 + (text[4] - '0');
+    if (hour > 23 || min > 59) return false;
+    minute = hour * 60 + min;
+    return true;
+}
+
+// "HH:MM-HH:MM", end exclusive, may wrap past midnight
+static bool parseWindow(const char* text, CompiledRule& rule) {
+    if (strlen(text) != 11 || text[5] != '-') return false;
+    if (!parseClock(text, rule.windowStart) || !parseClock(text + 6, rule.windowEnd)) return false;
+    return rule.windowStart != rule.windowEnd;
+}
+
+bool ruleEngine_compile(JsonVariantConst rules, RuleProgram& out, char* error, size_t errorLen) {
+    memset(&out, 0, sizeof(out));
+    if (!rules.is<JsonArrayConst>()) return fail(error, errorLen, "\"rules\" must be an array");
+    JsonArrayConst list = rules.as<JsonArrayConst>();
+    if (list.size() > RULE_MAX_RULES) return fail(error, errorLen, "at most %d rules", RULE_MAX_RULES);
+    out.custom = list.size() > 0;
+
+    for (JsonVariantConst item : list) {
+        unsigned r = out.ruleCount;
+        if (!item.is<JsonObjectConst>()) return fail(error, errorLen, "rule %u: not an object", r);
+        CompiledRule& rule = out.rules[r];
+        rule.firstCondition = out.conditionCount;
+        rule.windowStart = RULE_NO_WINDOW;
+        rule.windowEnd = RULE_NO_WINDOW;
+        rule.runS = PUMP_RUN_MS / 1000;
+        rule.cooldownS = PUMP_COOLDOWN_MS / 1000;
+
+        JsonVariantConst conditions = item["if"];
+        if (!conditions.isNull() && !conditions.is<JsonObjectConst>()) {
+            return fail(error, errorLen, "rule %u: \"if\" must be an object", r);
+        }
+        for (JsonPairConst input : conditions.as<JsonObjectConst>()) {
+            int in = indexOf(INPUT_NAMES, RULE_INPUT_COUNT, input.key().c_str());
+            if (in < 0) return fail(error, errorLen, "rule %u: unknown input %s", r, input.key().c_str());
+            if (!input.value().is<JsonObjectConst>()) {
+                return fail(error, errorLen, "rule %u: %s needs {\"lt\"|\"le\"|\"gt\"|\"ge\": value}", r, INPUT_NAMES[in]);
+            }
+            for (JsonPairConst cmp : input.value().as<JsonObjectConst>()) {
+                int op = indexOf(COMPARISON_NAMES, sizeof(COMPARISON_NAMES) / sizeof(COMPARISON_NAMES[0]), cmp.key().c_str());
+                if (op < 0) return fail(error, errorLen, "rule %u: unknown operator %s", r, cmp.key().c_str());
+                if (!cmp.value().is<float>()) return fail(error, errorLen, "rule %u: %s.%s is not a number", r, INPUT_NAMES[in], COMPARISON_NAMES[op]);
+                float value = cmp.value().as<float>();
+                if (value < INPUT_MIN[in] || value > INPUT_MAX[in]) {
+                    return fail(error, errorLen, "rule %u: %s threshold out of range", r, INPUT_NAMES[in]);
+                }
+                if (out.conditionCount == RULE_MAX_CONDITIONS) {
+                    return fail(error, errorLen, "at most %d conditions in total", RULE_MAX_CONDITIONS);
+                }
+                RuleCondition& c = out.conditions[out.conditionCount++];
+                c.input = (uint8_t)in;
+                c.comparison = (uint8_t)op;
+                c.thresholdX10 = (int16_t)lroundf(value * 10);
+            }
+        }
+        rule.conditionCount = out.conditionCount - rule.firstCondition;
+
+        JsonVariantConst window = item["window"];
+        if (!window.isNull() && !(window.is<const char*>() && parseWindow(window.as<const char*>(), rule))) {
+            return fail(error, errorLen, "rule %u: window must be \"HH:MM-HH:MM\"", r);
+        }
+        if (rule.conditionCount == 0 && rule.windowStart == RULE_NO_WINDOW) {
+            return fail(error, errorLen, "rule %u: needs a condition or a window", r);
+        }
+
+        JsonVariantConst run = item["run_s"];
+        if (!run.isNull()) {
+            if (!run.is<unsigned>() || run.as<unsigned>() < 1 || run.as<unsigned>() > 3600) {
+                return fail(error, errorLen, "rule %u: run_s must be 1..3600", r);
+            }
+            rule.runS = run.as<unsigned>();
+        }
+        JsonVariantConst cooldown = item["cooldown_s"];
+        if (!cooldown.isNull()) {
+            if (!cooldown.is<unsigned>() || cooldown.as<unsigned>() > 65535) {
+                return fail(error, errorLen, "rule %u: cooldown_s must be 0..65535", r);
+            }
+            rule.cooldownS = cooldown.as<unsigned>();
+        }
+        out.ruleCount++;
+    }
+    return true;
+}
+
+void ruleEngine_defaultProgram(int minMoisture, RuleProgram& out, uint16_t runS, uint16_t cooldownS) {
+    memset(&out, 0, sizeof(out));
+    out.ruleCount = 1;
+    out.conditionCount = 1;
+    out.conditions[0].input = RULE_IN_MOISTURE;
+    out.conditions[0].comparison = RULE_LT;
+    out.conditions[0].thresholdX10 = (int16_t)(minMoisture * 10);
+    CompiledRule& rule = out.rules[0];
+    rule.conditionCount = 1;
+    rule.windowStart = RULE_NO_WINDOW;
+    rule.windowEnd = RULE_NO_WINDOW;
+    rule.runS = runS;
+    rule.cooldownS = cooldownS;
+}
+
+// --- Evaluator (control loop) ---
+
+void ruleEngine_begin() {
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        defaultRunS[z] = PUMP_RUN_MS / 1000;
+        defaultCooldownS[z] = PUMP_COOLDOWN_MS / 1000;
+        ruleEngine_defaultProgram(ruleMinMoisture[z], programs[z]);
+    }
+}
+
+static void loadDefaultProgram(uint8_t zone) {
+    ruleEngine_defaultProgram(ruleMinMoisture[zone], programs[zone], defaultRunS[zone], defaultCooldownS[zone]);
+}
+
+void ruleEngine_load(uint8_t zone, const RuleProgram& program) {
+    if (zone >= ZONE_COUNT) return;
+    if (program.custom) {
+        programs[zone] = program;
+        return;
+    }
+    // A saved default program brings its timing back; an empty one keeps the zone's
+    if (program.ruleCount > 0) {
+        defaultRunS[zone] = program.rules[0].runS;
+        defaultCooldownS[zone] = program.rules[0].cooldownS;
+    }
+    loadDefaultProgram(zone);
+}
+
+void ruleEngine_minMoistureChanged(uint8_t zone) {
+    if (zone < ZONE_COUNT && !programs[zone].custom) loadDefaultProgram(zone);
+}
+
+void ruleEngine_setDefaultTiming(uint8_t zone, uint16_t runS, uint16_t cooldownS) {
+    if (zone >= ZONE_COUNT || runS == 0) return;
+    defaultRunS[zone] = runS;
+    defaultCooldownS[zone] = cooldownS;
+    if (!programs[zone].custom) loadDefaultProgram(zone);
+}
+
+// Local minute of day, recomputed once per wall-clock minute; -1 until synced
+static int16_t minuteOfDay() {
+    time_t now = time(nullptr);
+    if (now <= EPOCH_VALID_AFTER) return -1;
+    if (now / 60 != cachedEpochMinute) {
+        struct tm local;
+        localtime_r(&now, &local);
+        cachedMinuteOfDay = local.tm_hour * 60 + local.tm_min;
+        cachedEpochMinute = now / 60;
+    }
+    return cachedMinuteOfDay;
+}
+
+static inline bool inWindow(const CompiledRule& rule, int16_t minute) {
+    if (rule.windowStart == RULE_NO_WINDOW) return true;
+    if (minute < 0) return false;
+    if (rule.windowStart < rule.windowEnd) return minute >= rule.windowStart && minute < rule.windowEnd;
+    return minute >= rule.windowStart || minute < rule.windowEnd;
+}
+
+static inline bool compare(int16_t value, const RuleCondition& c) {
+    switch (c.comparison) {
+        case RULE_LT: return value < c.thresholdX10;
+        case RULE_LE: return value <= c.thresholdX10;
+        case RULE_GT: return value > c.thresholdX10;
+        default:      return value >= c.thresholdX10;
+    }
+}
+
+static int8_t evaluateProgram(const RuleProgram& program, const int16_t inputs[RULE_INPUT_COUNT],
+                              uint8_t validMask, int16_t minute) {
+    for (uint8_t r = 0; r < program.ruleCount; r++) {
+        const CompiledRule& rule = program.rules[r];
+        if (!inWindow(rule, minute)) continue;
+        const RuleCondition* c = program.conditions + rule.firstCondition;
+        uint8_t i = 0;
+        for (; i < rule.conditionCount; i++, c++) {
+            if (!(validMask & (1 << c->input)) || !compare(inputs[c->input], *c)) break;
+        }
+        if (i == rule.conditionCount) return (int8_t)r;
+    }
+    return -1;
+}
+
+// DHT zeros mean "no valid reading"; conditions on missing inputs never match
+static uint8_t airInputs(float temperature, float humidity, int16_t inputs[RULE_INPUT_COUNT]) {
+    inputs[RULE_IN_TEMPERATURE] = (int16_t)lroundf(temperature * 10);
+    inputs[RULE_IN_HUMIDITY] = (int16_t)lroundf(humidity * 10);
+    bool dhtValid = humidity > 0.1f;
+    return (1 << RULE_IN_MOISTURE) | (dhtValid ? (1 << RULE_IN_TEMPERATURE) | (1 << RULE_IN_HUMIDITY) : 0);
+}
+
+ZoneMask ruleEngine_evaluate(const float moisture[ZONE_COUNT], float temperature, float humidity,
+                             int8_t matched[ZONE_COUNT]) {
+    uint32_t start = ESP.getCycleCount();
+
+    int16_t inputs[RULE_INPUT_COUNT];
+    uint8_t validMask = airInputs(temperature, humidity, inputs);
+    int16_t minute = minuteOfDay();
+
+    ZoneMask mask = 0;
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        inputs[RULE_IN_MOISTURE] = (int16_t)lroundf(moisture[z] * 10);
+        matched[z] = evaluateProgram(programs[z], inputs, validMask, minute);
+        if (matched[z] >= 0) mask |= ZONE_BIT(z);
+    }
+
+    uint32_t cycles = ESP.getCycleCount() - start;
+    stats.ticks++;
+    stats.lastTickCycles = cycles;
+    if (cycles > stats.maxTickCycles) stats.maxTickCycles = cycles;
+    stats.totalCycles += cycles;
+    return mask;
+}
+
+int8_t ruleEngine_match(const RuleProgram& program, float moisture, float temperature, float humidity,
+                        int16_t minuteOfDay) {
+    int16_t inputs[RULE_INPUT_COUNT];
+    uint8_t validMask = airInputs(temperature, humidity, inputs);
+    inputs[RULE_IN_MOISTURE] = (int16_t)lroundf(moisture * 10);
+    return evaluateProgram(program, inputs, validMask, minuteOfDay);
+}
+
+const CompiledRule& ruleEngine_rule(uint8_t zone, uint8_t index) {
+    return programs[zone].rules[index];
+}
+
+const RuleProgram& ruleEngine_program(uint8_t zone) {
+    return programs[zone];
+}
+
+static bool validWindow(const CompiledRule& rule) {
+    if (rule.windowStart == RULE_NO_WINDOW) return rule.windowEnd == RULE_NO_WINDOW;
+    return rule.windowStart < 24 * 60 && rule.windowEnd < 24 * 60 && rule.windowStart != rule.windowEnd;
+}
+
+bool ruleEngine_isValid(const RuleProgram& program) {
+    if (program.ruleCount > RULE_MAX_RULES || program.conditionCount > RULE_MAX_CONDITIONS) return false;
+    for (uint8_t r = 0; r < program.ruleCount; r++) {
+        const CompiledRule& rule = program.rules[r];
+        if (rule.firstCondition + rule.conditionCount > program.conditionCount) return false;
+        if (!validWindow(rule) || rule.runS == 0) return false;
+    }
+    for (uint8_t c = 0; c < program.conditionCount; c++) {
+        if (program.conditions[c].input >= RULE_INPUT_COUNT || program.conditions[c].comparison > RULE_GE) return false;
+    }
+    return true;
+}
+
+void ruleEngine_getStats(RuleEngineStats& out) {
+    out = stats;
+}
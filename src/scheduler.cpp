@@ -0,0 +1,94 @@
+#include "scheduler.h"
+
+// Upper bound for the idle sleep so loop() still yields regularly to the
+// Arduino core (WiFi/watchdog housekeeping).
+static const unsigned long SCHED_MAX_IDLE_MS = 10;
+
+static SchedTask tasks[SCHEDULER_MAX_TASKS];
+static int taskCount = 0;
+
+int scheduler_addTask(const char* name, SchedTaskFn fn, unsigned long periodMs, unsigned long deadlineMs) {
+    if (taskCount >= SCHEDULER_MAX_TASKS || fn == nullptr || periodMs == 0) return -1;
+
+    SchedTask& t = tasks[taskCount];
+    t.name = name;
+    t.fn = fn;
+    t.periodMs = periodMs;
+    t.deadlineMs = deadlineMs > 0 ? deadlineMs : periodMs;
+    t.nextRelease = millis(); // first run as soon as the scheduler starts
+    t.runs = 0;
+    t.missedDeadlines = 0;
+    t.maxLatenessMs = 0;
+    return taskCount++;
+}
+
+// Signed distance so the comparisons survive millis() wrap-around.
+static inline long timeUntil(unsigned long target, unsigned long now) {
+    return (long)(target - now);
+}
+
+void scheduler_run() {
+    for (;;) {
+        unsigned long now = millis();
+
+        // Pick the due stage with the earliest absolute deadline.
+        int next = -1;
+        for (int i = 0; i < taskCount; i++) {
+            if (timeUntil(tasks[i].nextRelease, now) > 0) continue;
+            if (next < 0 ||
+                timeUntil(tasks[i].nextRelease + tasks[i].deadlineMs, tasks[next].nextRelease + tasks[next].deadlineMs) < 0) {
+                next = i;
+            }
+        }
+        if (next < 0) break;
+
+        SchedTask& t = tasks[next];
+        unsigned long release = t.nextRelease;
+        t.fn();
+        unsigned long finished = millis();
+
+        unsigned long lateness = finished - release;
+        if (lateness > t.maxLatenessMs) t.maxLatenessMs = lateness;
+        if (lateness > t.deadlineMs) t.missedDeadlines++;
+        t.runs++;
+
+        // Keep a fixed cadence, but don't burst through releases we already
+        // skipped (e.g. after a long blocking call) - resync instead.
+        t.nextRelease = release + t.periodMs;
+        if (timeUntil(t.nextRelease, finished) < 0) {
+            t.nextRelease = finished + t.periodMs;
+        }
+    }
+
+    // Sleep until the nearest release.
+    unsigned long now = millis();
+    long sleepMs = (long)SCHED_MAX_IDLE_MS;
+    for (int i = 0; i < taskCount; i++) {
+        long d = timeUntil(tasks[i].nextRelease, now);
+        if (d < sleepMs) sleepMs = d;
+    }
+    if (sleepMs > 0) delay(sleepMs);
+}
+
+int scheduler_taskCount() {
+    return taskCount;
+}
+
+const SchedTask* scheduler_getTask(int index) {
+    if (index < 0 || index >= taskCount) return nullptr;
+    return &tasks[index];
+}
+
+unsigned long scheduler_totalMissedDeadlines() {
+    unsigned long total = 0;
+    for (int i = 0; i < taskCount; i++) total += tasks[i].missedDeadlines;
+    return total;
+}
+
+void scheduler_resetStats() {
+    for (int i = 0; i < taskCount; i++) {
+        tasks[i].runs = 0;
+        tasks[i].missedDeadlines = 0;
+        tasks[i].maxLatenessMs = 0;
+    }
+}
@@ -0,0 +1,67 @@
+#include "soil_calibration.h"
+
+void soilCalibration_default(SoilCalibration& out) {
+    memset(&out, 0, sizeof(out)); // padding too, so NVS records compare byte for byte
+    out.pointCount = 2;
+    out.tempCoeffQ8 = 0;
+    out.points[0] = { 0, 10000 };
+    out.points[1] = { SOIL_CAL_ADC_MAX, 0 };
+}
+
+bool soilCalibration_isValid(const SoilCalibration& cal) {
+    if (cal.pointCount < 2 || cal.pointCount > SOIL_CAL_MAX_POINTS) return false;
+    int8_t direction = 0; // moisture falling (-1) or rising (+1) with counts
+    for (uint8_t i = 0; i < cal.pointCount; i++) {
+        const SoilCalPoint& p = cal.points[i];
+        if (p.raw > SOIL_CAL_ADC_MAX || p.moistureX100 > 10000) return false;
+        if (i == 0) continue;
+        const SoilCalPoint& prev = cal.points[i - 1];
+        if (p.raw <= prev.raw) return false;
+        if (p.moistureX100 == prev.moistureX100) continue;
+        int8_t step = p.moistureX100 > prev.moistureX100 ? 1 : -1;
+        if (direction != 0 && step != direction) return false;
+        direction = step;
+    }
+    return direction != 0;
+}
+
+bool soilCalibration_setPoint(SoilCalibration& cal, uint16_t raw, uint16_t moistureX100) {
+    SoilCalibration next;
+    memset(&next, 0, sizeof(next));
+    next.tempCoeffQ8 = cal.tempCoeffQ8;
+    bool placed = false;
+    for (uint8_t i = 0; i < cal.pointCount && i < SOIL_CAL_MAX_POINTS; i++) {
+        const SoilCalPoint& p = cal.points[i];
+        if (p.moistureX100 == moistureX100) continue; // replaced
+        if (!placed && raw <= p.raw) {
+            if (next.pointCount == SOIL_CAL_MAX_POINTS) return false;
+            next.points[next.pointCount++] = { raw, moistureX100 };
+            placed = true;
+        }
+        if (next.pointCount == SOIL_CAL_MAX_POINTS) return false;
+        next.points[next.pointCount++] = p;
+    }
+    if (!placed) {
+        if (next.pointCount == SOIL_CAL_MAX_POINTS) return false;
+        next.points[next.pointCount++] = { raw, moistureX100 };
+    }
+    if (!soilCalibration_isValid(next)) return false;
+    cal = next;
+    return true;
+}
+
+void soilCalibration_compile(const SoilCalibration& cal, SoilCalTable& out) {
+    memset(&out, 0, sizeof(out));
+    out.pointCount = cal.pointCount;
+    out.tempCoeffQ8 = cal.tempCoeffQ8;
+    for (uint8_t i = 0; i < cal.pointCount; i++) {
+        out.raw[i] = cal.points[i].raw;
+        out.moistureX100[i] = cal.points[i].moistureX100;
+    }
+    for (uint8_t i = 0; i + 1 < cal.pointCount; i++) {
+        int32_t dy = (int32_t)out.moistureX100[i + 1] - out.moistureX100[i];
+        int32_t dx = (int32_t)out.raw[i + 1] - out.raw[i];
+        // Rounded to nearest; dy << 16 fits, |dy| <= 10000
+        out.slopeQ16[i] = (dy * 65536 + (dy < 0 ? -dx / 2 : dx / 2)) / dx;
+    }
+}
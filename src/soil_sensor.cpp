@@ -0,0 +1,278 @@
+#include "soil_sensor.h"
+#include "config.h"
+#include "logger.h"
+#include "mem_diag.h"
+#include "profiler.h"
+#include "soil_calibration.h"
+#include "zones.h"
+#include <algorithm>
+#include <atomic>
+#include "driver/adc.h"
+
+// Zones map onto probes: one probe per distinct soil pin. Every probe is one
+// entry of the DMA pattern, so a frame interleaves SOIL_FRAME_SAMPLES
+// conversions of each (TYPE1 results, 2 bytes each, tagged with the channel).
+static const uint8_t MAX_PROBES = ADC1_CHANNEL_MAX; // 8 on the ESP32
+static const uint32_t RESULT_BYTES = sizeof(adc_digi_output_data_t);
+
+static uint8_t probeCount = 0;
+static uint8_t probePin[MAX_PROBES];
+static int8_t probeChannel[MAX_PROBES];        // ADC1 channel, -1 if the pin is not on ADC1
+static int8_t probeOfChannel[ADC1_CHANNEL_MAX]; // DMA result channel -> probe, -1 = not ours
+static uint8_t probeOfZone[ZONE_COUNT];
+
+static std::atomic<float> moisture[MAX_PROBES];
+static std::atomic<float> noise[MAX_PROBES];
+static std::atomic<uint16_t> filteredRaw[MAX_PROBES];
+static std::atomic<uint16_t> compensatedRaw[MAX_PROBES];
+static std::atomic<unsigned long> updatedAt[MAX_PROBES];
+static std::atomic<unsigned long> frames(0);
+static std::atomic<unsigned long> overruns(0);
+static bool dmaActive = false;
+
+// Filter state per probe, touched only by the acquisition task. Q8 fixed point.
+static int32_t emaQ8[MAX_PROBES];
+static int32_t noiseQ8[MAX_PROBES];
+
+// Calibration. The control loop owns zoneCalibration and compiles a probe's
+// table into stagedTable under a sequence count (odd while writing); the
+// acquisition task copies it into activeTable between frames, so neither
+// side ever waits. Zones sharing a probe share its calibration.
+static SoilCalibration zoneCalibration[ZONE_COUNT];
+static SoilCalTable stagedTable[MAX_PROBES];
+static std::atomic<uint32_t> stagedSeq[MAX_PROBES];
+static SoilCalTable activeTable[MAX_PROBES];   // acquisition task only
+static uint32_t activeSeq[MAX_PROBES];
+static std::atomic<int16_t> temperatureX10(SOIL_TEMP_UNKNOWN);
+static bool started = false;
+
+static void stageCalibration(uint8_t probe, const SoilCalibration& cal) {
+    uint32_t seq = stagedSeq[probe].load(std::memory_order_relaxed);
+    stagedSeq[probe].store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    soilCalibration_compile(cal, stagedTable[probe]);
+    stagedSeq[probe].store(seq + 2, std::memory_order_release);
+}
+
+static void pickUpCalibration(uint8_t probe) {
+    uint32_t seq = stagedSeq[probe].load(std::memory_order_acquire);
+    if (seq == activeSeq[probe] || (seq & 1)) return;
+    SoilCalTable copy = stagedTable[probe];
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (stagedSeq[probe].load(std::memory_order_relaxed) != seq) return; // rewritten meanwhile; next frame
+    activeTable[probe] = copy;
+    activeSeq[probe] = seq;
+}
+
+// Median + EMA over one frame of raw samples (the buffer gets reordered)
+static void processFrame(uint8_t probe, uint16_t* samples, size_t count) {
+    if (count == 0) return;
+
+    uint16_t* mid = samples + count / 2;
+    std::nth_element(samples, mid, samples + count);
+    int32_t median = *mid;
+
+    uint32_t absDev = 0;
+    for (size_t i = 0; i < count; i++) absDev += abs((int32_t)samples[i] - median);
+    int32_t madQ8 = (int32_t)((absDev << 8) / count);
+
+    int32_t& ema = emaQ8[probe];
+    int32_t& noiseState = noiseQ8[probe];
+    if (ema < 0) {
+        ema = median << 8;
+        noiseState = madQ8;
+    } else {
+        ema += ((median << 8) - ema) >> SOIL_EMA_SHIFT;
+        noiseState += (madQ8 - noiseState) >> SOIL_EMA_SHIFT;
+    }
+
+    // Temperature-compensated and looked up in the probe's calibration table
+    const SoilCalTable& cal = activeTable[probe];
+    int32_t reference = (soilCalibration_compensateQ8(cal, ema, temperatureX10.load(std::memory_order_relaxed)) + 128) >> 8;
+    reference = constrain(reference, 0, SOIL_CAL_ADC_MAX);
+    int32_t slopeQ16 = soilCalibration_slopeQ16(cal, reference);
+    filteredRaw[probe].store((uint16_t)((ema + 128) >> 8), std::memory_order_relaxed);
+    compensatedRaw[probe].store((uint16_t)reference, std::memory_order_relaxed);
+    noise[probe].store(noiseState * (abs(slopeQ16) / (100.0f * 256.0f * 65536.0f)), std::memory_order_relaxed);
+    moisture[probe].store(soilCalibration_toMoistureX100(cal, reference) * 0.01f, std::memory_order_relaxed);
+    updatedAt[probe].store(millis(), std::memory_order_relaxed);
+}
+
+static bool startDma() {
+    adc_digi_pattern_config_t pattern[MAX_PROBES] = {};
+    uint32_t channelMask = 0;
+    for (uint8_t p = 0; p < probeCount; p++) {
+        if (probeChannel[p] < 0) return false; // DMA works on ADC1 only (ADC2 is shared with WiFi)
+        pattern[p].atten = ADC_ATTEN_DB_11;
+        pattern[p].channel = probeChannel[p];
+        pattern[p].unit = 0; // ADC1
+        pattern[p].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        channelMask |= BIT(probeChannel[p]);
+    }
+
+    const uint32_t frameBytes = SOIL_FRAME_SAMPLES * probeCount * RESULT_BYTES;
+    adc_digi_init_config_t initConfig = {};
+    initConfig.max_store_buf_size = frameBytes * 4;
+    initConfig.conv_num_each_intr = frameBytes;
+    initConfig.adc1_chan_mask = channelMask;
+    initConfig.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&initConfig) != ESP_OK) return false;
+
+    adc_digi_configuration_t digConfig = {};
+    digConfig.conv_limit_en = true; // required on the original ESP32
+    digConfig.conv_limit_num = 250;
+    digConfig.pattern_num = probeCount;
+    digConfig.adc_pattern = pattern;
+    digConfig.sample_freq_hz = SOIL_SAMPLE_RATE_HZ; // shared by all probes
+    digConfig.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    digConfig.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+    if (adc_digi_controller_configure(&digConfig) != ESP_OK) {
+        adc_digi_deinitialize();
+        return false;
+    }
+    return adc_digi_start() == ESP_OK;
+}
+
+static void acquisitionTask(void* arg) {
+    memDiag_registerCurrentTask();
+    static uint8_t frame[SOIL_FRAME_SAMPLES * MAX_PROBES * RESULT_BYTES];
+    static uint16_t samples[MAX_PROBES][SOIL_FRAME_SAMPLES];
+    const uint32_t frameBytes = SOIL_FRAME_SAMPLES * probeCount * RESULT_BYTES;
+
+    for (;;) {
+        size_t count[MAX_PROBES] = {};
+        if (dmaActive) {
+            uint32_t got = 0;
+            esp_err_t err = adc_digi_read_bytes(frame, frameBytes, &got, portMAX_DELAY);
+            if (err == ESP_ERR_INVALID_STATE) overruns.fetch_add(1, std::memory_order_relaxed);
+            if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) continue;
+
+            // Demultiplex the interleaved pattern by the channel tag of each result
+            for (uint32_t i = 0; i + RESULT_BYTES <= got; i += RESULT_BYTES) {
+                const adc_digi_output_data_t* out = reinterpret_cast<const adc_digi_output_data_t*>(&frame[i]);
+                uint8_t channel = out->type1.channel;
+                if (channel >= ADC1_CHANNEL_MAX) continue;
+                int8_t p = probeOfChannel[channel];
+                if (p >= 0 && count[p] < SOIL_FRAME_SAMPLES) samples[p][count[p]++] = out->type1.data;
+            }
+        } else {
+            // Polled fallback when the DMA controller is unavailable
+            for (uint8_t p = 0; p < probeCount; p++) {
+                for (; count[p] < SOIL_FALLBACK_SAMPLES; count[p]++) samples[p][count[p]] = analogRead(probePin[p]);
+            }
+            vTaskDelay(pdMS_TO_TICKS(SOIL_FALLBACK_PERIOD_MS));
+        }
+        {
+            PROFILE_SCOPE(PROF_SOIL_FILTER);
+            for (uint8_t p = 0; p < probeCount; p++) {
+                pickUpCalibration(p);
+                processFrame(p, samples[p], count[p]);
+            }
+        }
+        frames.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Collapse the zone pin table into distinct probes
+static void mapProbes() {
+    for (uint8_t c = 0; c < ADC1_CHANNEL_MAX; c++) probeOfChannel[c] = -1;
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        uint8_t p = 0;
+        while (p < probeCount && probePin[p] != zoneSoilPin[z]) p++;
+        if (p == probeCount) {
+            if (probeCount == MAX_PROBES) {
+                LOG_WARN(LOG_TAG_MAIN, "Zone %u: more than %u soil pins, sharing probe 0", z, MAX_PROBES);
+                p = 0;
+            } else {
+                int8_t channel = digitalPinToAnalogChannel(zoneSoilPin[z]);
+                probePin[p] = zoneSoilPin[z];
+                probeChannel[p] = (channel >= 0 && channel < ADC1_CHANNEL_MAX) ? channel : -1;
+                if (probeChannel[p] >= 0) probeOfChannel[channel] = p;
+                emaQ8[p] = -1;
+                probeCount++;
+            }
+        }
+        probeOfZone[z] = p;
+    }
+}
+
+bool soilSensor_begin() {
+    mapProbes();
+
+    // Zones without a saved calibration get the default; each probe starts
+    // with the table of the last zone mapped onto it
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        if (!soilCalibration_isValid(zoneCalibration[z])) soilCalibration_default(zoneCalibration[z]);
+        soilCalibration_compile(zoneCalibration[z], activeTable[probeOfZone[z]]);
+    }
+    started = true;
+
+    // Seed the filters synchronously so the control loop never sees a bogus 0
+    static uint16_t seed[SOIL_FALLBACK_SAMPLES];
+    for (uint8_t p = 0; p < probeCount; p++) {
+        for (size_t i = 0; i < SOIL_FALLBACK_SAMPLES; i++) seed[i] = analogRead(probePin[p]);
+        processFrame(p, seed, SOIL_FALLBACK_SAMPLES);
+    }
+
+    dmaActive = startDma();
+    if (!dmaActive) LOG_WARN(LOG_TAG_MAIN, "Soil ADC DMA unavailable - using polled sampling");
+
+    xTaskCreatePinnedToCore(acquisitionTask, "soil_adc", SOIL_TASK_STACK, nullptr, SOIL_TASK_PRIORITY, nullptr, SOIL_TASK_CORE);
+    return dmaActive;
+}
+
+float soilSensor_moisture(uint8_t zone) {
+    return moisture[probeOfZone[zone]].load(std::memory_order_relaxed);
+}
+
+void soilSensor_readAll(float out[ZONE_COUNT]) {
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) out[z] = moisture[probeOfZone[z]].load(std::memory_order_relaxed);
+}
+
+void soilSensor_read(uint8_t zone, SoilReading& out) {
+    uint8_t p = probeOfZone[zone];
+    out.moisturePercent = moisture[p].load(std::memory_order_relaxed);
+    out.noisePercent = noise[p].load(std::memory_order_relaxed);
+    out.filteredRaw = filteredRaw[p].load(std::memory_order_relaxed);
+    out.compensatedRaw = compensatedRaw[p].load(std::memory_order_relaxed);
+    out.updatedAt = updatedAt[p].load(std::memory_order_relaxed);
+}
+
+unsigned long soilSensor_frameCount() {
+    return frames.load(std::memory_order_relaxed);
+}
+
+unsigned long soilSensor_overruns() {
+    return overruns.load(std::memory_order_relaxed);
+}
+
+bool soilSensor_usingDma() {
+    return dmaActive;
+}
+
+void soilSensor_setTemperature(float celsius) {
+    int16_t x10 = isnan(celsius) ? SOIL_TEMP_UNKNOWN : (int16_t)lroundf(constrain(celsius, -100.0f, 200.0f) * 10);
+    temperatureX10.store(x10, std::memory_order_relaxed);
+}
+
+bool soilSensor_setCalibration(uint8_t zone, const SoilCalibration& cal) {
+    if (zone >= ZONE_COUNT || !soilCalibration_isValid(cal)) return false;
+    if (!started) {
+        zoneCalibration[zone] = cal;
+        return true;
+    }
+    uint8_t p = probeOfZone[zone];
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        if (probeOfZone[z] == p) zoneCalibration[z] = cal;
+    }
+    stageCalibration(p, cal);
+    return true;
+}
+
+void soilSensor_getCalibration(uint8_t zone, SoilCalibration& out) {
+    if (zone >= ZONE_COUNT || !soilCalibration_isValid(zoneCalibration[zone])) {
+        soilCalibration_default(out);
+        return;
+    }
+    out = zoneCalibration[zone];
+}
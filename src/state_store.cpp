@@ -0,0 +1,269 @@
+#include "state_store.h"
+#include "config.h"
+#include "logger.h"
+#include "rule_engine.h"
+#include "soil_sensor.h"
+#include <Preferences.h>
+
+#define STATE_RECORD_MAGIC   0x5354  // "ST"
+#define STATE_RECORD_VERSION 1
+#define CALIBRATION_RECORD_MAGIC   0x4341  // "CA"
+#define CALIBRATION_RECORD_VERSION 1
+
+static const char* const NVS_NAMESPACE = "irrigation";
+static const char* const KEY_STATE = "state";
+static const char* const KEY_WIFI = "wifi";
+static const char* const KEY_CALIBRATION = "soilcal";
+
+struct PersistedZone {
+    uint8_t mode;
+    uint8_t statusOn;
+    int16_t minMoisture;
+    int16_t maxMoisture;
+    int16_t preferredHumidity;
+    int16_t preferredTemp;
+    char plantName[PLANT_NAME_MAX];
+    RuleProgram program;
+};
+
+struct StateRecord {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t zoneCount;
+    PersistedZone zones[ZONE_COUNT];
+    uint16_t crc;  // over everything before it
+};
+
+struct CalibrationRecord {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t zoneCount;
+    SoilCalibration zones[ZONE_COUNT];
+    uint16_t crc;  // over everything before it
+};
+
+struct WifiRecord {
+    WifiCache cache;
+    uint16_t crc;
+};
+
+static StateRecord scratch;    // built from the live state before each save
+static StateRecord lastSaved;  // what NVS holds, to skip unchanged writes
+static CalibrationRecord calibrationScratch;
+static CalibrationRecord lastSavedCalibration;
+static bool dirty = false;
+static bool calibrationDirty = false;
+static unsigned long firstChangeAt = 0;
+static unsigned long lastChangeAt = 0;
+static StateStoreStats stats = {};
+
+static uint16_t crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static uint16_t recordCrc(const StateRecord& r) {
+    return crc16(reinterpret_cast<const uint8_t*>(&r), offsetof(StateRecord, crc));
+}
+
+static uint16_t calibrationCrc(const CalibrationRecord& r) {
+    return crc16(reinterpret_cast<const uint8_t*>(&r), offsetof(CalibrationRecord, crc));
+}
+
+static void buildCalibrationRecord(CalibrationRecord& r) {
+    memset(&r, 0, sizeof(r));
+    r.magic = CALIBRATION_RECORD_MAGIC;
+    r.version = CALIBRATION_RECORD_VERSION;
+    r.zoneCount = ZONE_COUNT;
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) soilSensor_getCalibration(z, r.zones[z]);
+    r.crc = calibrationCrc(r);
+}
+
+static void buildRecord(StateRecord& r) {
+    memset(&r, 0, sizeof(r)); // padding too, so memcmp and the CRC are stable
+    r.magic = STATE_RECORD_MAGIC;
+    r.version = STATE_RECORD_VERSION;
+    r.zoneCount = ZONE_COUNT;
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        PersistedZone& p = r.zones[z];
+        p.mode = actuatorMode[z];
+        p.statusOn = actuatorStatusOn[z];
+        p.minMoisture = ruleMinMoisture[z];
+        p.maxMoisture = ruleMaxMoisture[z];
+        p.preferredHumidity = rulePreferredHumidity[z];
+        p.preferredTemp = rulePreferredTemp[z];
+        strlcpy(p.plantName, rulePlantName[z], sizeof(p.plantName));
+        p.program = ruleEngine_program(z);
+    }
+    r.crc = recordCrc(r);
+}
+
+static const char* checkRecord(const StateRecord& r) {
+    if (r.magic != STATE_RECORD_MAGIC) return "bad magic";
+    if (r.version != STATE_RECORD_VERSION) return "unknown version";
+    if (r.zoneCount != ZONE_COUNT) return "zone count changed";
+    if (r.crc != recordCrc(r)) return "CRC mismatch";
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        if (r.zones[z].mode > MODE_AUTO) return "bad mode";
+        if (!ruleEngine_isValid(r.zones[z].program)) return "bad rule program";
+    }
+    return nullptr;
+}
+
+bool stateStore_load() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {
+        LOG_INFO(LOG_TAG_MAIN, "No saved state, using defaults");
+        return false;
+    }
+    size_t len = prefs.getBytesLength(KEY_STATE);
+    bool read = len == sizeof(StateRecord) && prefs.getBytes(KEY_STATE, &scratch, sizeof(scratch)) == sizeof(scratch);
+    prefs.end();
+    if (!read) {
+        LOG_INFO(LOG_TAG_MAIN, "No saved state (%u bytes), using defaults", (unsigned)len);
+        return false;
+    }
+    const char* problem = checkRecord(scratch);
+    if (problem != nullptr) {
+        LOG_WARN(LOG_TAG_MAIN, "Saved state rejected: %s, using defaults", problem);
+        return false;
+    }
+
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        const PersistedZone& p = scratch.zones[z];
+        actuatorMode[z] = (ActuatorMode)p.mode;
+        actuatorStatusOn[z] = p.statusOn != 0;
+        ruleMinMoisture[z] = p.minMoisture;
+        ruleMaxMoisture[z] = p.maxMoisture;
+        rulePreferredHumidity[z] = p.preferredHumidity;
+        rulePreferredTemp[z] = p.preferredTemp;
+        strlcpy(rulePlantName[z], p.plantName, sizeof(rulePlantName[z]));
+        ruleEngine_load(z, p.program);
+    }
+    lastSaved = scratch;
+    stats.restored = true;
+    LOG_INFO(LOG_TAG_MAIN, "State restored from NVS (%u zones)", (unsigned)ZONE_COUNT);
+    return true;
+}
+
+static void touch(unsigned long now) {
+    if (!dirty && !calibrationDirty) firstChangeAt = now;
+    lastChangeAt = now;
+}
+
+void stateStore_markDirty(unsigned long now) {
+    touch(now);
+    dirty = true;
+}
+
+void stateStore_markCalibrationDirty(unsigned long now) {
+    touch(now);
+    calibrationDirty = true;
+}
+
+static bool writeRecord(const char* key, const void* record, size_t len) {
+    Preferences prefs;
+    bool ok = prefs.begin(NVS_NAMESPACE, false) && prefs.putBytes(key, record, len) == len;
+    prefs.end();
+    return ok;
+}
+
+static void saveCalibration() {
+    calibrationDirty = false;
+    buildCalibrationRecord(calibrationScratch);
+    if (memcmp(&calibrationScratch, &lastSavedCalibration, sizeof(calibrationScratch)) == 0) {
+        stats.unchanged++;
+        return;
+    }
+    if (!writeRecord(KEY_CALIBRATION, &calibrationScratch, sizeof(calibrationScratch))) {
+        LOG_ERROR(LOG_TAG_MAIN, "Soil calibration save failed");
+        return;
+    }
+    lastSavedCalibration = calibrationScratch;
+    stats.calibrationSaves++;
+    LOG_INFO(LOG_TAG_MAIN, "Soil calibration saved (%u bytes)", (unsigned)sizeof(calibrationScratch));
+}
+
+// A flash write stalls both cores' cache whichever task issues it, so it
+// runs here in the control loop, only once the state has settled (or has
+// been changing for STATE_SAVE_MAX_DELAY_MS).
+void stateStore_service(unsigned long now) {
+    if (!dirty && !calibrationDirty) return;
+    if (now - lastChangeAt < STATE_SAVE_DEBOUNCE_MS && now - firstChangeAt < STATE_SAVE_MAX_DELAY_MS) return;
+    if (calibrationDirty) saveCalibration();
+    if (!dirty) return;
+    dirty = false;
+
+    buildRecord(scratch);
+    if (memcmp(&scratch, &lastSaved, sizeof(scratch)) == 0) {
+        stats.unchanged++;
+        return;
+    }
+
+    unsigned long start = micros();
+    bool ok = writeRecord(KEY_STATE, &scratch, sizeof(scratch));
+    stats.lastSaveUs = micros() - start;
+    if (!ok) {
+        LOG_ERROR(LOG_TAG_MAIN, "State save failed");
+        return;
+    }
+    lastSaved = scratch;
+    stats.saves++;
+    LOG_INFO(LOG_TAG_MAIN, "State saved (%u bytes, %lu us)", (unsigned)sizeof(scratch), stats.lastSaveUs);
+}
+
+void stateStore_getStats(StateStoreStats& out) {
+    out = stats;
+}
+
+bool stateStore_loadCalibration(SoilCalibration out[ZONE_COUNT]) {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) return false;
+    CalibrationRecord r;
+    bool read = prefs.getBytesLength(KEY_CALIBRATION) == sizeof(r) &&
+                prefs.getBytes(KEY_CALIBRATION, &r, sizeof(r)) == sizeof(r);
+    prefs.end();
+    if (!read) return false;
+    const char* problem = nullptr;
+    if (r.magic != CALIBRATION_RECORD_MAGIC || r.version != CALIBRATION_RECORD_VERSION) problem = "unknown format";
+    else if (r.zoneCount != ZONE_COUNT) problem = "zone count changed";
+    else if (r.crc != calibrationCrc(r)) problem = "CRC mismatch";
+    for (uint8_t z = 0; problem == nullptr && z < ZONE_COUNT; z++) {
+        if (!soilCalibration_isValid(r.zones[z])) problem = "bad table";
+    }
+    if (problem != nullptr) {
+        LOG_WARN(LOG_TAG_MAIN, "Saved soil calibration rejected: %s, using defaults", problem);
+        return false;
+    }
+    memcpy(out, r.zones, sizeof(r.zones));
+    lastSavedCalibration = r;
+    LOG_INFO(LOG_TAG_MAIN, "Soil calibration restored from NVS");
+    return true;
+}
+
+bool stateStore_loadWifi(WifiCache& out) {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) return false;
+    WifiRecord r;
+    bool read = prefs.getBytesLength(KEY_WIFI) == sizeof(r) && prefs.getBytes(KEY_WIFI, &r, sizeof(r)) == sizeof(r);
+    prefs.end();
+    if (!read || r.crc != crc16(reinterpret_cast<const uint8_t*>(&r), offsetof(WifiRecord, crc))) return false;
+    out = r.cache;
+    return out.channel != 0;
+}
+
+void stateStore_saveWifi(const WifiCache& cache) {
+    WifiRecord r;
+    memset(&r, 0, sizeof(r));
+    r.cache = cache;
+    r.crc = crc16(reinterpret_cast<const uint8_t*>(&r), offsetof(WifiRecord, crc));
+    Preferences prefs;
+    if (prefs.begin(NVS_NAMESPACE, false)) {
+        prefs.putBytes(KEY_WIFI, &r, sizeof(r));
+        prefs.end();
+    }
+}
@@ -0,0 +1,255 @@
+#include "telemetry_store.h"
+#include "config.h"
+#include "logger.h"
+#include <FS.h>
+#include <LittleFS.h>
+#include <time.h>
+
+static const char* RING_PATH = "/telemetry.bin";
+static const char* TAIL_PATH = "/telemetry.tail";
+
+// Stored as is in the ring: growing it would orphan the slots already on flash
+static_assert(sizeof(TelemetrySample) == 16, "TelemetrySample layout changed");
+
+struct TelemetrySlot {
+    uint32_t seq;          // 1-based sequence number, slot index = seq % capacity
+    TelemetrySample sample;
+    uint16_t crc;
+};
+
+static TelemetrySample staging[TELEMETRY_STAGING_SAMPLES];
+static uint32_t stagingCount = 0;
+
+// Sequence numbers: [tail, flashedHead) live in flash, [flashedHead, flashedHead + stagingCount) in RAM
+static uint32_t tail = 1;
+static uint32_t flashedHead = 1;
+static bool fsReady = false;
+static uint16_t bootId = 0;
+static bool tailDirty = false;
+static unsigned long firstTailChangeAt = 0;
+static unsigned long lastTailChangeAt = 0;
+static TelemetryStoreStats stats = {};
+
+static uint16_t crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static uint16_t slotCrc(const TelemetrySlot& slot) {
+    return crc16(reinterpret_cast<const uint8_t*>(&slot), offsetof(TelemetrySlot, crc));
+}
+
+static inline uint32_t head() {
+    return flashedHead + stagingCount;
+}
+
+static void saveTail() {
+    if (!fsReady) return;
+    File f = LittleFS.open(TAIL_PATH, "w");
+    if (!f) return;
+    uint32_t record[2] = { tail, ~tail };
+    f.write(reinterpret_cast<const uint8_t*>(record), sizeof(record));
+    f.close();
+}
+
+static void markTailDirty() {
+    unsigned long now = millis();
+    if (!tailDirty) firstTailChangeAt = now;
+    lastTailChangeAt = now;
+    tailDirty = true;
+}
+
+static uint32_t loadTail() {
+    File f = LittleFS.open(TAIL_PATH, "r");
+    if (!f) return 0;
+    uint32_t record[2] = { 0, 0 };
+    size_t n = f.read(reinterpret_cast<uint8_t*>(record), sizeof(record));
+    f.close();
+    return (n == sizeof(record) && record[0] == ~record[1]) ? record[0] : 0;
+}
+
+static bool readSlot(File& f, uint32_t seq, TelemetrySample& out) {
+    TelemetrySlot slot;
+    if (!f.seek((seq % TELEMETRY_RING_CAPACITY) * sizeof(TelemetrySlot), SeekSet)) return false;
+    if (f.read(reinterpret_cast<uint8_t*>(&slot), sizeof(slot)) != sizeof(slot)) return false;
+    if (slot.seq != seq || slot.crc != slotCrc(slot)) return false;
+    out = slot.sample;
+    return true;
+}
+
+bool telemetryStore_begin() {
+    bootId = (uint16_t)(esp_random() | 1);
+    stats.capacity = TELEMETRY_RING_CAPACITY;
+
+    if (!LittleFS.begin(true)) {
+        LOG_WARN(LOG_TAG_MQTT, "LittleFS mount gagal - telemetry buffered in RAM only");
+        return false;
+    }
+    fsReady = true;
+
+    const size_t fileSize = TELEMETRY_RING_CAPACITY * sizeof(TelemetrySlot);
+    File f = LittleFS.open(RING_PATH, "r");
+    if (!f || f.size() != fileSize) {
+        if (f) f.close();
+        // Preallocate the ring once; blank slots never pass the CRC check
+        f = LittleFS.open(RING_PATH, "w");
+        if (!f) {
+            fsReady = false;
+            return false;
+        }
+        uint8_t zeros[64] = {};
+        for (size_t written = 0; written < fileSize; written += sizeof(zeros)) {
+            f.write(zeros, min(sizeof(zeros), fileSize - written));
+        }
+        f.close();
+        saveTail();
+        return true;
+    }
+
+    // Rebuild the ring from the slot sequence numbers
+    uint32_t maxSeq = 0;
+    uint32_t minSeq = UINT32_MAX;
+    TelemetrySlot slot;
+    for (uint32_t i = 0; i < TELEMETRY_RING_CAPACITY; i++) {
+        if (f.read(reinterpret_cast<uint8_t*>(&slot), sizeof(slot)) != sizeof(slot)) break;
+        if (slot.seq == 0 || slot.seq % TELEMETRY_RING_CAPACITY != i || slot.crc != slotCrc(slot)) continue;
+        if (slot.seq > maxSeq) maxSeq = slot.seq;
+        if (slot.seq < minSeq) minSeq = slot.seq;
+    }
+    f.close();
+
+    if (maxSeq == 0) return true; // empty ring
+
+    flashedHead = maxSeq + 1;
+    uint32_t savedTail = loadTail();
+    tail = savedTail != 0 ? savedTail : minSeq;
+    if (flashedHead - tail > TELEMETRY_RING_CAPACITY || (int32_t)(flashedHead - tail) < 0) {
+        tail = flashedHead > TELEMETRY_RING_CAPACITY ? flashedHead - TELEMETRY_RING_CAPACITY : minSeq;
+    }
+    LOG_INFO(LOG_TAG_MQTT, "Telemetry backlog restored: %lu samples", (unsigned long)(flashedHead - tail));
+    return true;
+}
+
+void telemetryStore_flush() {
+    if (stagingCount == 0) return;
+
+    if (fsReady) {
+        File f = LittleFS.open(RING_PATH, "r+");
+        if (f) {
+            for (uint32_t i = 0; i < stagingCount; i++) {
+                TelemetrySlot slot;
+                slot.seq = flashedHead + i;
+                slot.sample = staging[i];
+                slot.crc = slotCrc(slot);
+                f.seek((slot.seq % TELEMETRY_RING_CAPACITY) * sizeof(TelemetrySlot), SeekSet);
+                f.write(reinterpret_cast<const uint8_t*>(&slot), sizeof(slot));
+            }
+            f.close();
+            stats.flashWrites++;
+        }
+    }
+    flashedHead += stagingCount;
+    stagingCount = 0;
+    // Without flash the samples are simply gone; keep the ring indices honest
+    if (!fsReady) tail = flashedHead;
+}
+
+void telemetryStore_append(const TelemetrySample& sample) {
+    if (head() - tail >= TELEMETRY_RING_CAPACITY) {
+        tail++; // overwrite the oldest sample
+        stats.overflowDrops++;
+    }
+    staging[stagingCount++] = sample;
+    if (stagingCount >= TELEMETRY_STAGING_SAMPLES) telemetryStore_flush();
+}
+
+size_t telemetryStore_peek(TelemetrySample* out, size_t maxCount) {
+    size_t n = 0;
+    uint32_t seq = tail;
+
+    if (seq < flashedHead) {
+        // Skipping what is on flash would let consume() drop it unsent
+        File f = LittleFS.open(RING_PATH, "r");
+        if (!f) return 0;
+        while (seq < flashedHead && n < maxCount) {
+            if (readSlot(f, seq, out[n])) {
+                n++;
+                seq++;
+            } else if (n > 0) {
+                break; // end the batch here so it stays consecutive
+            } else {
+                stats.corruptSkipped++;
+                tail = ++seq;
+                markTailDirty();
+            }
+        }
+        f.close();
+        if (seq < flashedHead) return n;
+    }
+
+    while (seq < head() && n < maxCount) {
+        out[n++] = staging[seq - flashedHead];
+        seq++;
+    }
+    return n;
+}
+
+void telemetryStore_consume(size_t count) {
+    uint32_t available = head() - tail;
+    if (count > available) count = available;
+    tail += count;
+    stats.drained += count;
+
+    // Staged samples that were delivered never need to touch flash
+    if (tail > flashedHead) {
+        uint32_t dropped = tail - flashedHead;
+        memmove(staging, staging + dropped, (stagingCount - dropped) * sizeof(TelemetrySample));
+        stagingCount -= dropped;
+        flashedHead = tail;
+    }
+    if (count > 0) markTailDirty();
+}
+
+void telemetryStore_service(unsigned long now) {
+    if (!tailDirty) return;
+    if (now - lastTailChangeAt < TELEMETRY_TAIL_SAVE_DEBOUNCE_MS &&
+        now - firstTailChangeAt < TELEMETRY_TAIL_SAVE_MAX_DELAY_MS) return;
+    tailDirty = false;
+    saveTail();
+}
+
+uint32_t telemetryStore_count() {
+    return head() - tail;
+}
+
+void telemetryStore_getStats(TelemetryStoreStats& out) {
+    out = stats;
+    out.count = telemetryStore_count();
+    out.fillPercent = (uint8_t)((uint64_t)out.count * 100 / TELEMETRY_RING_CAPACITY);
+}
+
+TelemetrySample telemetryStore_makeSample(uint8_t zone, float temperature, float moisture, float humidity, bool pumpOn) {
+    TelemetrySample s = {};
+    time_t now = time(nullptr);
+    if (now > EPOCH_VALID_AFTER) {
+        s.timestamp = (uint32_t)now;
+    } else {
+        s.timestamp = millis() / 1000;
+        s.flags |= TELEMETRY_TS_UPTIME;
+    }
+    s.bootId = bootId;
+    s.moistureX10 = (uint16_t)lroundf(moisture * 10);
+    s.temperatureX10 = (int16_t)lroundf(temperature * 10);
+    s.humidityX10 = (uint16_t)lroundf(humidity * 10);
+    s.pumpOn = pumpOn ? 1 : 0;
+    s.zone = zone;
+    return s;
+}
+
+uint16_t telemetryStore_bootId() {
+    return bootId;
+}
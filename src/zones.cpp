@@ -0,0 +1,86 @@
+#include "zones.h"
+#include "actuation_trace.h"
+#include "config.h"
+#include "pump_cycle.h"
+#include "rule_engine.h"
+
+const uint8_t zoneSoilPin[ZONE_COUNT] = ZONE_SOIL_PINS;
+const uint8_t zoneRelayPin[ZONE_COUNT] = ZONE_RELAY_PINS;
+
+static_assert(ZONE_COUNT >= 1 && ZONE_COUNT <= ZONE_MAX, "ZONE_COUNT out of range");
+static_assert(sizeof((uint8_t[])ZONE_SOIL_PINS) == ZONE_COUNT, "ZONE_SOIL_PINS needs ZONE_COUNT entries");
+static_assert(sizeof((uint8_t[])ZONE_RELAY_PINS) == ZONE_COUNT, "ZONE_RELAY_PINS needs ZONE_COUNT entries");
+
+static PumpCycle pumpCycle[ZONE_COUNT]; // auto mode, see pump_cycle.h
+static ZoneMask runningMask = 0;
+static uint8_t startCursor = 0; // round-robin origin for granting pump starts
+static ZoneStats stats = {};
+
+void zones_begin() {
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        pinMode(zoneRelayPin[z], OUTPUT);
+        digitalWrite(zoneRelayPin[z], LOW);
+    }
+}
+
+static inline uint8_t countBits(ZoneMask mask) {
+    return __builtin_popcount(mask);
+}
+
+ZoneMask zones_control(const float moisture[ZONE_COUNT], float temperature, float humidity,
+                       unsigned long now) {
+    unsigned long start = micros();
+
+    int8_t matched[ZONE_COUNT];
+    ruleEngine_evaluate(moisture, temperature, humidity, matched);
+
+    // Pumps already running keep their slot; new starts compete for the rest
+    ZoneMask keep = 0;
+    ZoneMask wanted = 0;
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        ZoneMask bit = ZONE_BIT(z);
+        if (actuatorMode[z] == MODE_AUTO) {
+            bool aboveMax = moisture[z] > ruleMaxMoisture[z];
+            if (pumpCycle_step(pumpCycle[z], matched[z], aboveMax, now)) wanted |= bit;
+            else if (pumpCycle[z].phase == PUMP_RUNNING) keep |= bit;
+        } else if (actuatorStatusOn[z]) {
+            if (runningMask & bit) keep |= bit;
+            else wanted |= bit;
+        }
+    }
+
+    uint8_t active = countBits(keep);
+    uint8_t origin = startCursor;
+    for (uint8_t i = 0; wanted != 0 && i < ZONE_COUNT; i++) {
+        uint8_t z = (origin + i) % ZONE_COUNT;
+        ZoneMask bit = ZONE_BIT(z);
+        if (!(wanted & bit)) continue;
+        if (active >= MAX_ACTIVE_PUMPS) {
+            stats.deferredStarts++;
+            continue;
+        }
+        keep |= bit;
+        active++;
+        if (actuatorMode[z] == MODE_AUTO) pumpCycle_start(pumpCycle[z], ruleEngine_rule(z, matched[z]), now);
+        startCursor = (z + 1) % ZONE_COUNT;
+    }
+
+    // Only touch the relays that change
+    ZoneMask changed = keep ^ runningMask;
+    for (uint8_t z = 0; changed != 0; z++, changed >>= 1) {
+        if (!(changed & 1)) continue;
+        digitalWrite(zoneRelayPin[z], (keep & ZONE_BIT(z)) ? HIGH : LOW);
+        actuationTrace_relayWritten(z, actuatorMode[z] == MODE_AUTO, start);
+    }
+    runningMask = keep;
+
+    if (active > stats.maxActive) stats.maxActive = active;
+    unsigned long elapsed = micros() - start;
+    stats.lastTickUs = elapsed;
+    if (elapsed > stats.maxTickUs) stats.maxTickUs = elapsed;
+    return runningMask;
+}
+
+void zones_getStats(ZoneStats& out) {
+    out = stats;
+}
@@ -0,0 +1,309 @@
+// MQTT session against the simulated broker: the real firmware connects,
+// acknowledges traced commands on actual-status, rides out a broker outage
+// with unacknowledged QoS 1 publishes and a command sent while it was away,
+// and reports its runtime counters on diagnostics/stats after each connect.
+// The outbox tests then take the broker down again on their own and check
+// that publishes are queued without blocking and none are lost.
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "mem_diag.h"
+#include "mqtt_async.h"
+#include "mqtt_handler.h"
+#include "report_gate.h"
+#include "sim.h"
+#include "sim_plant.h"
+#include "telemetry_store.h"
+#include "zones.h"
+
+static const char* STATUS_TOPIC = "device/GH-001/actuator/1/status";
+static const char* ACK_TOPIC = "device/GH-001/actuator/1/actual-status";
+static const char* FILL_TOPIC = "device/GH-001/test/fill";
+static const char* STATS_TOPIC = "device/GH-001/diagnostics/stats";
+static const unsigned long OUTAGE_MS = 5000;
+static const unsigned long RECONNECT_MS = 30000;   // covers the first backoff steps
+
+// Acknowledgements seen by the broker, by trace id
+static unsigned long ackCount[4];
+static uint64_t ackAtUs[4];
+static unsigned long fillReceived = 0;
+static std::vector<std::string> statsMessages;
+
+static bool connectedAfterBoot;
+static uint64_t injectAtUs;
+static unsigned long ackedBeforeOutage;
+static MqttAsyncStats beforeOutage;
+static MqttAsyncStats afterOutage;
+static unsigned long duplicates;
+static bool reconnected;
+
+static void onPublish(const char* topic, const uint8_t* payload, size_t len, bool retained) {
+    (void)retained;
+    if (strcmp(topic, FILL_TOPIC) == 0) {
+        fillReceived++;
+        return;
+    }
+    if (strcmp(topic, STATS_TOPIC) == 0) {
+        statsMessages.push_back(std::string(reinterpret_cast<const char*>(payload), len));
+        return;
+    }
+    if (strcmp(topic, ACK_TOPIC) != 0) return;
+    std::string text(reinterpret_cast<const char*>(payload), len);
+    for (int i = 1; i < 4; i++) {
+        char id[16];
+        snprintf(id, sizeof(id), "\"id\":\"t-%d\"", i);
+        if (text.find(id) == std::string::npos) continue;
+        if (ackCount[i]++ == 0) ackAtUs[i] = sim_micros();
+    }
+}
+
+static void sendStatus(int id, bool on) {
+    char payload[64];
+    snprintf(payload, sizeof(payload), "{\"value\":\"%s\",\"id\":\"t-%d\"}", on ? "on" : "off", id);
+    sim_mqttInject(STATUS_TOPIC, payload);
+}
+
+static void runScenario() {
+    sim_begin();
+    simPlant_begin(simPlant_defaultWeather());
+    simPlant_addZone(zoneSoilPin[0], zoneRelayPin[0], simPlant_defaultSoil());
+    sim_setPublishListener(onPublish);
+    sim_setWifiAvailable(true);
+    sim_setBrokerAvailable(true);
+    setup();
+
+    sim_runFor(10000);
+    connectedAfterBoot = mqtt_connectionState() == NET_MQTT_CONNECTED;
+
+    // A traced command on a live session
+    injectAtUs = sim_micros();
+    sendStatus(1, true);
+    sim_runFor(1000);
+
+    // The next acknowledgement reaches the broker but its PUBACK never comes
+    // back before the broker goes away
+    sim_setBrokerAcks(false);
+    sendStatus(2, false);
+    sim_runFor(1000);
+    ackedBeforeOutage = ackCount[2];
+    mqttAsync_getStats(beforeOutage);
+    sim_setBrokerAvailable(false);
+    sim_setBrokerAcks(true);
+    sim_runFor(OUTAGE_MS / 2);
+
+    // Offline: a command waits in the broker session
+    sendStatus(3, true);
+    sim_runFor(OUTAGE_MS / 2);
+
+    sim_setBrokerAvailable(true);
+    sim_runFor(RECONNECT_MS);
+    reconnected = mqtt_connectionState() == NET_MQTT_CONNECTED;
+    mqttAsync_getStats(afterOutage);
+    duplicates = sim_mqttDuplicateCount();
+
+    printf("ack t-1 after %.1f ms, %lu retransmits, max ack %lu us\n", (ackAtUs[1] - injectAtUs) / 1000.0,
+           afterOutage.retransmits, (unsigned long)afterOutage.maxAckUs);
+}
+
+// Publishes to FILL_TOPIC until the outbox rejects one; returns the number
+// accepted
+static unsigned long fillOutbox(unsigned long& rejected) {
+    unsigned long accepted = 0;
+    rejected = 0;
+    for (int i = 0; i < 1000 && rejected == 0; i++) {
+        char payload[96];
+        snprintf(payload, sizeof(payload), "{\"n\":%d,\"pad\":\"0123456789012345678901234567890123456789\"}", i);
+        if (mqttAsync_publish(FILL_TOPIC, payload, 1, false)) accepted++;
+        else rejected++;
+    }
+    return accepted;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_connects_with_persistent_session() {
+    TEST_ASSERT_TRUE(connectedAfterBoot);
+    TEST_ASSERT_TRUE(reconnected);
+    TEST_ASSERT_TRUE(afterOutage.sessionPresent);
+}
+
+// Handled as soon as it arrives (the network task wakes on incoming data),
+// applied on the next control tick and acknowledged on the next iteration
+static void test_traced_command_acknowledged() {
+    TEST_ASSERT_EQUAL_UINT32(1, ackCount[1]);
+    TEST_ASSERT_LESS_THAN_UINT32((CONTROL_PERIOD_MS + 2 * MQTT_LOOP_PERIOD_MS) * 1000UL, ackAtUs[1] - injectAtUs);
+}
+
+// The unacknowledged publish is sent again with DUP on the new connection
+static void test_unacked_qos1_resent_after_outage() {
+    TEST_ASSERT_EQUAL_UINT32(1, ackedBeforeOutage);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, beforeOutage.inflight);
+    TEST_ASSERT_GREATER_THAN_UINT32(1, ackCount[2]);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, afterOutage.retransmits);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, duplicates);
+    TEST_ASSERT_EQUAL_UINT8(0, afterOutage.inflight);
+}
+
+static void test_command_sent_while_offline_delivered() {
+    TEST_ASSERT_EQUAL_UINT32(1, ackCount[3]);
+}
+
+// Returns the number of diagnostics/stats messages containing text
+static unsigned long statsContaining(const char* text) {
+    unsigned long n = 0;
+    for (size_t i = 0; i < statsMessages.size(); i++)
+        if (statsMessages[i].find(text) != std::string::npos) n++;
+    return n;
+}
+
+// Every connect publishes the counters; the one after the outage carries
+// the reconnect and its duration
+static void test_stats_published_after_reconnect() {
+    TEST_ASSERT_EQUAL_UINT32(1, statsContaining("{\"net\":{\"reconnects\":1,"));
+    TEST_ASSERT_EQUAL_UINT32(1, statsContaining("{\"net\":{\"reconnects\":2,"));
+    TEST_ASSERT_EQUAL_UINT32(0, statsContaining("\"lastReconnectMs\":0,"));
+}
+
+// The report at boot goes out before the first telemetry; by the one after
+// the outage the JSON payload size is known
+static void test_stats_report_telemetry_formats() {
+    TEST_ASSERT_EQUAL_UINT32(2, statsContaining("{\"telemetry\":{\"json\":{\"messages\":"));
+    TEST_ASSERT_EQUAL_UINT32(1, statsContaining("\"json\":{\"messages\":0,"));
+    TEST_ASSERT_EQUAL_UINT32(2, statsContaining("\"msgpack\":{\"messages\":0,"));
+}
+
+// The report after the outage shows the resumed session and the resent publish
+static void test_stats_report_session() {
+    TEST_ASSERT_EQUAL_UINT32(2, statsContaining("{\"session\":{\"outboxUsed\":"));
+    TEST_ASSERT_EQUAL_UINT32(1, statsContaining("\"retransmits\":1,"));
+    TEST_ASSERT_EQUAL_UINT32(1, statsContaining("\"sessionPresent\":true}}"));
+}
+
+static void test_stats_report_store() {
+    TEST_ASSERT_EQUAL_UINT32(2, statsContaining("{\"store\":{\"count\":"));
+    TEST_ASSERT_EQUAL_UINT32(0, statsContaining("\"capacity\":0,"));
+    TEST_ASSERT_EQUAL_UINT32(2, statsContaining("\"overflowDrops\":0,\"corruptSkipped\":0,\"oversizeDrops\":0,"));
+}
+
+// Nothing was reported before the first connect; by the reconnect the
+// steady readings have been sent once and held back since
+static void test_stats_report_gate() {
+    TEST_ASSERT_EQUAL_UINT32(2, statsContaining("{\"gate\":{\"channels\":4,\"published\":["));
+    TEST_ASSERT_EQUAL_UINT32(1, statsContaining("\"published\":[0,0,0,0],"));
+    TEST_ASSERT_EQUAL_UINT32(1, statsContaining("\"suppressed\":[0,0,0,0],"));
+}
+
+static void test_stats_report_display() {
+    TEST_ASSERT_EQUAL_UINT32(2, statsContaining("{\"display\":{\"frames\":"));
+    TEST_ASSERT_EQUAL_UINT32(0, statsContaining("\"flushes\":0,"));
+    TEST_ASSERT_EQUAL_UINT32(2, statsContaining("\"i2cBytesPerFrame\":"));
+    TEST_ASSERT_EQUAL_UINT32(0, statsContaining("\"i2cBytesPerFrame\":0}}"));
+}
+
+// The boot and connect messages have been written by the first report
+static void test_stats_report_log() {
+    TEST_ASSERT_EQUAL_UINT32(2, statsContaining("{\"log\":{\"written\":"));
+    TEST_ASSERT_EQUAL_UINT32(0, statsContaining("{\"log\":{\"written\":0,"));
+}
+
+// A full outbox rejects new publishes; everything it accepted is delivered
+// once the broker is back
+static void test_outbox_bounded_and_lossless() {
+    sim_setBrokerAvailable(false);
+    sim_runFor(OUTAGE_MS);
+    fillReceived = 0;
+    unsigned long rejected;
+    unsigned long accepted = fillOutbox(rejected);
+    sim_setBrokerAvailable(true);
+    sim_runFor(RECONNECT_MS);
+    MqttAsyncStats stats;
+    mqttAsync_getStats(stats);
+
+    TEST_ASSERT_GREATER_THAN_UINT32(0, accepted);
+    TEST_ASSERT_EQUAL_UINT32(1, rejected);
+    TEST_ASSERT_EQUAL_UINT32(accepted, fillReceived);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(MQTT_OUTBOX_BYTES, stats.outboxPeak);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.outboxUsed);
+}
+
+// Connected, but the outbox is full of unacknowledged publishes: the pump
+// edge cannot be published, so it goes to the backlog and the gate keeps the
+// last published state. Once the broker acknowledges again the edge is
+// published and the backlog drained.
+static void test_rejected_telemetry_kept_in_backlog() {
+    sim_setBrokerAcks(false);
+    unsigned long rejected;
+    fillOutbox(rejected);
+    while (mqttAsync_publish(FILL_TOPIC, "{}", 1, false)) {} // not even a small batch fits
+    ReportGateStats gateBefore, gateRejected, gateAfter;
+    reportGate_getStats(gateBefore);
+    uint32_t backlogBefore = telemetryStore_count();
+    sendStatus(4, false); // t-3 left the pump on
+    sim_runFor(1000);
+    reportGate_getStats(gateRejected);
+    uint32_t backlogRejected = telemetryStore_count();
+    bool stillConnected = mqtt_connectionState() == NET_MQTT_CONNECTED;
+
+    sim_setBrokerAcks(true);
+    sim_runFor(RECONNECT_MS);
+    reportGate_getStats(gateAfter);
+
+    TEST_ASSERT_TRUE(stillConnected);
+    TEST_ASSERT_EQUAL_UINT32(gateBefore.published[REPORT_PUMP], gateRejected.published[REPORT_PUMP]);
+    TEST_ASSERT_GREATER_THAN_UINT32(backlogBefore, backlogRejected);
+    TEST_ASSERT_EQUAL_UINT32(gateBefore.published[REPORT_PUMP] + 1, gateAfter.published[REPORT_PUMP]);
+    TEST_ASSERT_EQUAL_UINT32(0, telemetryStore_count());
+}
+
+// Enqueueing is a copy into the ring, whether or not the link is up: no
+// virtual time passes and nothing is allocated
+static void test_enqueue_does_not_block() {
+    sim_setBrokerAvailable(false);
+    sim_runFor(OUTAGE_MS);
+    uint64_t startUs = sim_micros();
+    uint32_t allocationsBefore = memDiag_allocationCount();
+    unsigned long rejected;
+    fillOutbox(rejected);
+    TEST_ASSERT_EQUAL_UINT32(0, memDiag_allocationCount() - allocationsBefore);
+    TEST_ASSERT_EQUAL_UINT32(0, sim_micros() - startUs);
+    sim_setBrokerAvailable(true);
+    sim_runFor(RECONNECT_MS);
+}
+
+// Larger than a packet may be: rejected up front, the outbox is untouched
+static void test_oversized_publish_rejected() {
+    static char payload[MQTT_BUFFER_SIZE + 1];
+    memset(payload, 'x', MQTT_BUFFER_SIZE);
+    payload[MQTT_BUFFER_SIZE] = '\0';
+    MqttAsyncStats before, after;
+    mqttAsync_getStats(before);
+    TEST_ASSERT_FALSE(mqttAsync_publish(FILL_TOPIC, payload, 1, false));
+    mqttAsync_getStats(after);
+    TEST_ASSERT_EQUAL_UINT32(before.rejected + 1, after.rejected);
+    TEST_ASSERT_EQUAL_UINT32(before.enqueued, after.enqueued);
+    TEST_ASSERT_EQUAL_UINT32(before.outboxUsed, after.outboxUsed);
+}
+
+int main(int argc, char** argv) {
+    runScenario();
+    UNITY_BEGIN();
+    RUN_TEST(test_connects_with_persistent_session);
+    RUN_TEST(test_traced_command_acknowledged);
+    RUN_TEST(test_unacked_qos1_resent_after_outage);
+    RUN_TEST(test_command_sent_while_offline_delivered);
+    RUN_TEST(test_stats_published_after_reconnect);
+    RUN_TEST(test_stats_report_telemetry_formats);
+    RUN_TEST(test_stats_report_session);
+    RUN_TEST(test_stats_report_store);
+    RUN_TEST(test_stats_report_gate);
+    RUN_TEST(test_stats_report_display);
+    RUN_TEST(test_stats_report_log);
+    RUN_TEST(test_outbox_bounded_and_lossless);
+    RUN_TEST(test_rejected_telemetry_kept_in_backlog);
+    RUN_TEST(test_enqueue_does_not_block);
+    RUN_TEST(test_oversized_publish_rejected);
+    return UNITY_END();
+}
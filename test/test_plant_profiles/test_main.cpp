@@ -0,0 +1,146 @@
+// Plant profile database: every name in the generated table is found in any
+// letter case, each in its own slot with a single probe; unknown names miss,
+// the species the firmware used to know keep their thresholds, and a lookup
+// does not allocate. Lookup times against a linear scan are printed for
+// reference only.
+
+#include <unity.h>
+#include <ctype.h>
+#include "command_queue.h"
+#include "config.h"
+#include "mem_diag.h"
+#include "plant_profiles.h"
+#include "rule_engine.h"
+#include "sim.h"
+
+static const int ROUNDS = 50;
+static const char* UNKNOWN[] = {"", "Tomatoes", "tomat", "Basil ", "Chili Pepper Extra", "xyz"};
+static const size_t UNKNOWN_COUNT = sizeof(UNKNOWN) / sizeof(UNKNOWN[0]);
+
+static void toCase(const char* name, int (*convert)(int), char* out) {
+    size_t n = 0;
+    for (; name[n] && n < PLANT_NAME_MAX - 1; n++) out[n] = (char)convert((unsigned char)name[n]);
+    out[n] = '\0';
+}
+
+static const PlantProfile* linearFind(const char* name) {
+    for (size_t i = 0; i < plantProfile_count(); i++) {
+        if (strcasecmp(plantProfile_at(i).name, name) == 0) return &plantProfile_at(i);
+    }
+    return nullptr;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// The hash sends every spelling of a name to the entry's own slot, and the
+// one compare there finds it
+static void test_every_name_found_in_its_slot() {
+    char lower[PLANT_NAME_MAX], upper[PLANT_NAME_MAX];
+    for (size_t i = 0; i < plantProfile_count(); i++) {
+        const char* name = plantProfile_at(i).name;
+        toCase(name, tolower, lower);
+        toCase(name, toupper, upper);
+        TEST_ASSERT_EQUAL_UINT32(i, plantProfile_slot(name));
+        TEST_ASSERT_EQUAL_UINT32(i, plantProfile_slot(lower));
+        TEST_ASSERT_EQUAL_UINT32(i, plantProfile_slot(upper));
+        TEST_ASSERT_TRUE(plantProfile_find(name) == &plantProfile_at(i));
+        TEST_ASSERT_TRUE(plantProfile_find(lower) == &plantProfile_at(i));
+        TEST_ASSERT_TRUE(plantProfile_find(upper) == &plantProfile_at(i));
+    }
+}
+
+// A miss lands on some slot too, whose name does not match
+static void test_unknown_names_miss() {
+    for (size_t i = 0; i < UNKNOWN_COUNT; i++) {
+        TEST_ASSERT_TRUE(plantProfile_slot(UNKNOWN[i]) < plantProfile_count());
+        TEST_ASSERT_TRUE(plantProfile_find(UNKNOWN[i]) == nullptr);
+        TEST_ASSERT_TRUE(linearFind(UNKNOWN[i]) == nullptr);
+    }
+}
+
+// The thresholds getThresholdByPlantType() used to hard-code
+static void test_previous_species_keep_thresholds() {
+    TEST_ASSERT_EQUAL_UINT8(20, plantProfile_find("Cactus")->minMoisture);
+    TEST_ASSERT_EQUAL_UINT8(40, plantProfile_find("Chili")->minMoisture);
+    TEST_ASSERT_EQUAL_UINT8(50, plantProfile_find("Monstera")->minMoisture);
+    TEST_ASSERT_EQUAL_UINT8(60, plantProfile_find("Spinach")->minMoisture);
+    TEST_ASSERT_EQUAL_UINT8(55, plantProfile_find("Tomato")->minMoisture);
+}
+
+static void test_lookup_does_not_allocate() {
+    uint32_t before = memDiag_allocationCount();
+    for (size_t i = 0; i < plantProfile_count(); i++) plantProfile_find(plantProfile_at(i).name);
+    for (size_t i = 0; i < UNKNOWN_COUNT; i++) plantProfile_find(UNKNOWN[i]);
+    TEST_ASSERT_EQUAL_UINT32(0, memDiag_allocationCount() - before);
+}
+
+// Fields the rule message sets win; the profile fills the others
+static void test_profile_fills_unset_rule_fields() {
+    const PlantProfile* tomato = plantProfile_find("Tomato");
+    RuleUpdate rule = {};
+    rule.fields = RULE_FIELD_MIN_MOISTURE;
+    rule.minMoisture = 33;
+    plantProfile_fillRule(*tomato, rule);
+    TEST_ASSERT_EQUAL_UINT32(33, rule.minMoisture);
+    TEST_ASSERT_EQUAL_UINT32(tomato->maxMoisture, rule.maxMoisture);
+    TEST_ASSERT_EQUAL_UINT32(tomato->preferredHumidity, rule.preferredHumidity);
+    TEST_ASSERT_EQUAL_UINT32(tomato->runS, rule.runS);
+    TEST_ASSERT_EQUAL_UINT32(tomato->cooldownS, rule.cooldownS);
+    TEST_ASSERT_TRUE(rule.fields & RULE_FIELD_PUMP_TIMING);
+}
+
+// A profile's pump timing reaches a zone's default program, not a custom one
+static void test_profile_timing_reaches_default_program() {
+    const PlantProfile* cactus = plantProfile_find("Cactus");
+    ruleEngine_begin();
+    ruleEngine_setDefaultTiming(0, cactus->runS, cactus->cooldownS);
+    ruleEngine_minMoistureChanged(0);
+    RuleProgram timedDefault = ruleEngine_program(0);
+    TEST_ASSERT_FALSE(timedDefault.custom);
+    TEST_ASSERT_EQUAL_UINT32(cactus->runS, timedDefault.rules[0].runS);
+    TEST_ASSERT_EQUAL_UINT32(cactus->cooldownS, timedDefault.rules[0].cooldownS);
+
+    RuleProgram custom = timedDefault;
+    custom.custom = true;
+    custom.rules[0].runS = 7;
+    ruleEngine_load(0, custom);
+    ruleEngine_setDefaultTiming(0, 99, 99);
+    const RuleProgram& kept = ruleEngine_program(0);
+    TEST_ASSERT_TRUE(kept.custom);
+    TEST_ASSERT_EQUAL_UINT32(7, kept.rules[0].runS);
+}
+
+// Host nanoseconds per lookup over every name, ROUNDS times
+static double timeLookups(const PlantProfile* (*find)(const char*)) {
+    size_t count = plantProfile_count();
+    size_t found = 0;
+    uint64_t start = sim_hostNs();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < count; i++) {
+            if (find(plantProfile_at(i).name) != nullptr) found++;
+        }
+    }
+    double ns = (double)(sim_hostNs() - start) / (ROUNDS * count);
+    return found == 0 ? -1 : ns; // keeps the loop from being optimized away
+}
+
+// Depends on the host, so printed rather than checked
+static void reportTiming() {
+    double hashNs = timeLookups(plantProfile_find);
+    double linearNs = timeLookups(linearFind);
+    printf("%u profiles: %.0f ns per lookup, linear scan %.0f ns (%.1fx)\n", (unsigned)plantProfile_count(),
+           hashNs, linearNs, linearNs / hashNs);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_name_found_in_its_slot);
+    RUN_TEST(test_unknown_names_miss);
+    RUN_TEST(test_previous_species_keep_thresholds);
+    RUN_TEST(test_lookup_does_not_allocate);
+    RUN_TEST(test_profile_fills_unset_rule_fields);
+    RUN_TEST(test_profile_timing_reaches_default_program);
+    reportTiming();
+    return UNITY_END();
+}
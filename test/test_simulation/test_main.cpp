@@ -0,0 +1,208 @@
+// Closed-loop day in the field: the real setup()/loop() from src/main.cpp
+// controls the simulated plant (lib/native_hal) in auto mode with the
+// network offline. The pump cycle itself is also stepped directly, without
+// the plant, for the edges a day in the field may not hit.
+
+#include <unity.h>
+#include "actuation_trace.h"
+#include "command_queue.h"
+#include "config.h"
+#include "profiler.h"
+#include "pump_cycle.h"
+#include "scheduler.h"
+#include "sim.h"
+#include "sim_plant.h"
+#include "zones.h"
+
+static const unsigned long WARMUP_MS = 12UL * 3600 * 1000;   // dry down to the threshold
+static const unsigned long MEASURE_MS = 24UL * 3600 * 1000;
+static const float MEASURE_HOURS = MEASURE_MS / 3.6e6f;
+static const int MIN_MOISTURE = 40;        // loadDefaultRules()
+
+static SimZoneStats zone;
+static SimTaskStats loopTask;
+static uint64_t loopNsBefore;
+static unsigned long loopWakeupsBefore;
+static unsigned long stageRunsBefore;
+static uint64_t wallNs;
+static unsigned long controlRunsBefore;
+static ProfileStats control;
+
+static unsigned long controlRuns() {
+    for (int i = 0; i < scheduler_taskCount(); i++) {
+        const SchedTask* t = scheduler_getTask(i);
+        if (strcmp(t->name, "control") == 0) return t->runs;
+    }
+    return 0;
+}
+
+static unsigned long stageRuns() {
+    unsigned long runs = 0;
+    for (int i = 0; i < scheduler_taskCount(); i++) runs += scheduler_getTask(i)->runs;
+    return runs;
+}
+
+static void runScenario() {
+    sim_begin();
+    simPlant_begin(simPlant_defaultWeather());
+    simPlant_addZone(zoneSoilPin[0], zoneRelayPin[0], simPlant_defaultSoil());
+    setup();
+
+    // What the broker's retained actuator-mode message would do
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SET_MODE;
+    cmd.zone = 0;
+    cmd.mode = MODE_AUTO;
+    commandQueue_push(cmd);
+
+    sim_runFor(WARMUP_MS);
+    simPlant_resetStats();
+    sim_findTask("loopTask", loopTask);
+    loopNsBefore = loopTask.busyNs;
+    loopWakeupsBefore = loopTask.wakeups;
+    stageRunsBefore = stageRuns();
+    controlRunsBefore = controlRuns();
+    profiler_resetWindow();
+
+    uint64_t start = sim_hostNs();
+    sim_runFor(MEASURE_MS);
+    wallNs = sim_hostNs() - start;
+
+    simPlant_zoneStats(0, zone);
+    sim_findTask("loopTask", loopTask);
+    profiler_snapshot(PROF_CONTROL, control);
+
+    printf("moisture %.1f..%.1f%%, %lu starts, duty %.3f%%, runs %u..%u ms\n", zone.minMoisture,
+           zone.maxMoisture, zone.pumpStarts, zone.pumpOnMs * 100.0 / MEASURE_MS, zone.shortestRunMs,
+           zone.longestRunMs);
+    // Host figures depend on the machine running the suite: reported, not checked
+    printf("loop task %.0f wakeups and %.2f ms host CPU per simulated hour, %.0fx real time\n",
+           (loopTask.wakeups - loopWakeupsBefore) / MEASURE_HOURS,
+           (loopTask.busyNs - loopNsBefore) / 1e6 / MEASURE_HOURS, MEASURE_MS * 1e6 / wallNs);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_pump_started_only_after_drying_to_threshold() {
+    TEST_ASSERT_GREATER_THAN_UINT32(0, zone.pumpStarts);
+    TEST_ASSERT_GREATER_THAN_FLOAT(MIN_MOISTURE - 1.0f, zone.minMoisture);
+}
+
+// Water keeps soaking in after the last pulse; the 60 s cooldown has to
+// keep that from piling up well above the threshold
+static void test_overshoot_bounded() {
+    TEST_ASSERT_LESS_THAN_FLOAT(MIN_MOISTURE + 3.0f, zone.maxMoisture);
+}
+
+// Over a day the pumped water has to balance evapotranspiration: a duty
+// cycle far from it means the controller over- or under-waters
+static void test_duty_cycle_matches_water_balance() {
+    float duty = (float)zone.pumpOnMs / MEASURE_MS;
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.001f, duty);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.02f, duty);
+    TEST_ASSERT_FLOAT_WITHIN(zone.waterLost * 0.15f + 2.0f, zone.waterLost, zone.waterApplied);
+}
+
+// A started run and its cooldown complete even if the reading crosses back
+// over the threshold, so the relay cannot chatter
+static void test_runs_last_the_rule_run_time() {
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(MEASURE_MS / (PUMP_RUN_MS + PUMP_COOLDOWN_MS) + 1, zone.pumpStarts);
+    TEST_ASSERT_UINT32_WITHIN(CONTROL_PERIOD_MS, PUMP_RUN_MS + CONTROL_PERIOD_MS / 2, zone.shortestRunMs);
+    TEST_ASSERT_UINT32_WITHIN(CONTROL_PERIOD_MS, PUMP_RUN_MS + CONTROL_PERIOD_MS / 2, zone.longestRunMs);
+}
+
+static const CompiledRule RULE = { 0, 1, RULE_NO_WINDOW, RULE_NO_WINDOW, 10, 60 };
+
+// Steps a fresh cycle started at t = 0 through one tick per entry of
+// matched; returns the tick at which it asks to start again, or -1
+static int restartTick(const int8_t* matched, int ticks, PumpCycle& cycle) {
+    memset(&cycle, 0, sizeof(cycle));
+    TEST_ASSERT_TRUE(pumpCycle_step(cycle, 0, false, 0));
+    pumpCycle_start(cycle, RULE, 0);
+    for (int i = 0; i < ticks; i++) {
+        if (pumpCycle_step(cycle, matched[i], false, (i + 1) * 10000UL)) return i;
+    }
+    return -1;
+}
+
+// The rule stops matching right after the start: the run still lasts its
+// run_s, the cooldown runs out and the cycle goes idle
+static void test_cycle_completes_without_match() {
+    int8_t matched[] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+    PumpCycle cycle;
+    TEST_ASSERT_EQUAL_INT(-1, restartTick(matched, 8, cycle));
+    TEST_ASSERT_EQUAL_UINT8(PUMP_IDLE, cycle.phase);
+}
+
+// The rule matches again during the cooldown: no start before it runs out
+static void test_cooldown_gates_restart() {
+    int8_t matched[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    PumpCycle cycle;
+    // Running until 10 s, cooling down until 70 s
+    TEST_ASSERT_EQUAL_INT(6, restartTick(matched, 8, cycle));
+}
+
+static void test_above_max_stops_a_run() {
+    PumpCycle cycle;
+    memset(&cycle, 0, sizeof(cycle));
+    pumpCycle_start(cycle, RULE, 0);
+    TEST_ASSERT_FALSE(pumpCycle_step(cycle, 0, true, 1000));
+    TEST_ASSERT_EQUAL_UINT8(PUMP_IDLE, cycle.phase);
+    TEST_ASSERT_FALSE(pumpCycle_step(cycle, 0, true, 2000));
+    TEST_ASSERT_TRUE(pumpCycle_step(cycle, 0, false, 3000));
+}
+
+static void test_control_stage_keeps_its_period() {
+    unsigned long expected = MEASURE_MS / CONTROL_PERIOD_MS;
+    TEST_ASSERT_UINT32_WITHIN(expected / 100, expected, controlRuns() - controlRunsBefore);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler_totalMissedDeadlines());
+}
+
+// Loop cost on the virtual clock: every stage runs at its own period and no
+// more, and the loop task is woken no more often than the fastest periodic
+// task in the firmware (soil sampling) blocks
+static void test_loop_cost_per_simulated_hour() {
+    unsigned long expectedRuns = 0;
+    for (int i = 0; i < scheduler_taskCount(); i++) expectedRuns += MEASURE_MS / scheduler_getTask(i)->periodMs;
+    TEST_ASSERT_UINT32_WITHIN(expectedRuns / 100, expectedRuns, stageRuns() - stageRunsBefore);
+    unsigned long maxWakeups = MEASURE_MS / SOIL_FALLBACK_PERIOD_MS;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(maxWakeups + maxWakeups / 100, loopTask.wakeups - loopWakeupsBefore);
+}
+
+static void test_control_stage_allocation_free() {
+    TEST_ASSERT_GREATER_THAN_UINT32(0, control.count);
+    TEST_ASSERT_EQUAL_UINT32(0, control.allocations);
+}
+
+// Every auto start and stop is traced and handed to the network task, which
+// counts it unpublished while offline; the relay follows the decision within
+// the same control tick
+static void test_auto_transitions_traced() {
+    ActuationStats trace;
+    actuationTrace_getStats(trace);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2 * zone.pumpStarts - 1, trace.traces[ACTUATION_AUTO]);
+    TEST_ASSERT_EQUAL_UINT32(0, trace.traces[ACTUATION_COMMAND]);
+    TEST_ASSERT_EQUAL_UINT32(0, trace.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, trace.published);
+    TEST_ASSERT_UINT32_WITHIN(1, trace.traces[ACTUATION_AUTO], trace.unpublished);
+    TEST_ASSERT_LESS_THAN_UINT32(CONTROL_DEADLINE_MS * 1000UL, trace.maxControlUs);
+}
+
+int main(int argc, char** argv) {
+    runScenario();
+    UNITY_BEGIN();
+    RUN_TEST(test_pump_started_only_after_drying_to_threshold);
+    RUN_TEST(test_overshoot_bounded);
+    RUN_TEST(test_duty_cycle_matches_water_balance);
+    RUN_TEST(test_runs_last_the_rule_run_time);
+    RUN_TEST(test_cycle_completes_without_match);
+    RUN_TEST(test_cooldown_gates_restart);
+    RUN_TEST(test_above_max_stops_a_run);
+    RUN_TEST(test_control_stage_keeps_its_period);
+    RUN_TEST(test_loop_cost_per_simulated_hour);
+    RUN_TEST(test_control_stage_allocation_free);
+    RUN_TEST(test_auto_transitions_traced);
+    return UNITY_END();
+}
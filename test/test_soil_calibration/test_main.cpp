@@ -0,0 +1,292 @@
+// Soil probe calibration: the simulated probe reads a narrower, curved range
+// than the default mapping assumes and drifts with temperature. The real
+// firmware captures dry, wet and two intermediate points at different
+// temperatures through calibration commands, then tracks half a day of changing
+// moisture and temperature with drift compensation and another without.
+// Uploads, resets and saves are then checked one command at a time, and the
+// table conversion against a floating-point reference.
+
+#include <unity.h>
+#include "command_queue.h"
+#include "config.h"
+#include "sim.h"
+#include "sim_plant.h"
+#include "soil_calibration.h"
+#include "soil_sensor.h"
+#include "state_store.h"
+#include "zones.h"
+
+static const uint32_t HOUR_S = 3600;
+static const uint32_t SETTLE_S = 1800;         // per calibration step
+static const uint32_t TRACK_S = 12 * HOUR_S;    // with and without drift compensation
+static const float DRIFT_COUNTS_PER_C = 8.0f;
+
+struct CaptureStep {
+    float moisture;
+    float temperature;
+};
+
+// Captured at different temperatures, so the points only line up if the
+// capture itself is compensated
+static const CaptureStep CAPTURES[] = {
+    { 0.0f, 33.0f },
+    { 100.0f, 17.0f },
+    { 35.0f, 25.0f },
+    { 70.0f, 20.0f },
+};
+static const size_t CAPTURE_COUNT = sizeof(CAPTURES) / sizeof(CAPTURES[0]);
+
+static SimTracePoint trace[256];
+static size_t traceLength = 0;
+
+static float uncalibratedError;
+static SoilCalibration captured;
+static SoilCalibration saved[ZONE_COUNT];
+static bool savedFound;
+static float compensatedError;
+static float uncompensatedError;
+
+static void addPoint(uint32_t timeS, float moisture, float temperature) {
+    if (traceLength < sizeof(trace) / sizeof(trace[0])) trace[traceLength++] = { timeS, moisture, temperature, 60.0f };
+}
+
+// 20 % at 25 C, calibration steps held for SETTLE_S each, then moisture
+// swinging 25..75 % every 4 h and air 15..35 C every TRACK_S
+static void buildTrace() {
+    uint32_t t = 0;
+    addPoint(t, 20.0f, 25.0f);
+    addPoint(t += SETTLE_S, 20.0f, 25.0f);
+    for (size_t i = 0; i < CAPTURE_COUNT; i++) {
+        addPoint(t += 60, CAPTURES[i].moisture, CAPTURES[i].temperature);
+        addPoint(t += SETTLE_S - 60, CAPTURES[i].moisture, CAPTURES[i].temperature);
+    }
+    t += 60;
+    for (uint32_t s = 0; s <= 2 * TRACK_S; s += 600) {
+        float moisture = 50.0f + 25.0f * sinf(2.0f * (float)M_PI * s / (4 * HOUR_S));
+        float temperature = 25.0f + 10.0f * sinf(2.0f * (float)M_PI * s / TRACK_S);
+        addPoint(t + s, moisture, temperature);
+    }
+}
+
+static void pushCalibration(const CalibrationUpdate& update) {
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SET_CALIBRATION;
+    cmd.zone = 0;
+    cmd.calibration = update;
+    commandQueue_push(cmd);
+    sim_runFor(2 * CONTROL_PERIOD_MS);
+}
+
+// Largest gap between the firmware's reading and the true moisture, sampled
+// once a minute
+static float trackError(uint32_t seconds) {
+    float worst = 0.0f;
+    for (uint32_t s = 0; s < seconds; s += 60) {
+        sim_runFor(60 * 1000);
+        SimZoneStats truth;
+        simPlant_zoneStats(0, truth);
+        worst = std::max(worst, fabsf(soilSensor_moisture(0) - truth.moisture));
+    }
+    return worst;
+}
+
+// Host nanoseconds per conversion; depends on the host, so printed only
+static double timeConversion() {
+    SoilCalTable table;
+    soilCalibration_compile(captured, table);
+    uint32_t sum = 0;
+    uint64_t start = sim_hostNs();
+    for (int round = 0; round < 20; round++) {
+        for (int32_t raw = 0; raw <= SOIL_CAL_ADC_MAX; raw++) {
+            int32_t reference = soilCalibration_compensateQ8(table, raw << 8, 312 + round) >> 8;
+            sum += soilCalibration_toMoistureX100(table, reference);
+        }
+    }
+    double ns = (double)(sim_hostNs() - start) / (20 * (SOIL_CAL_ADC_MAX + 1));
+    return sum == 0 ? -1 : ns; // keeps the loop from being optimized away
+}
+
+static void runScenario() {
+    buildTrace();
+    sim_begin();
+    sim_resetPreferences();
+    simPlant_begin(simPlant_defaultWeather());
+    SimSoilParams soil = simPlant_defaultSoil();
+    soil.dryCounts = 3300;
+    soil.wetCounts = 1350;
+    soil.curve = 0.35f;
+    soil.countsPerC = DRIFT_COUNTS_PER_C;
+    simPlant_addZone(zoneSoilPin[0], zoneRelayPin[0], soil);
+    simPlant_playTrace(trace, traceLength);
+    setup();
+
+    uncalibratedError = trackError(SETTLE_S - 60);
+
+    CalibrationUpdate update;
+    memset(&update, 0, sizeof(update));
+    update.fields = CAL_FIELD_TEMP_COEFF;
+    update.tempCoeffQ8 = (int16_t)(DRIFT_COUNTS_PER_C * 256);
+    pushCalibration(update);
+    sim_runFor(60 * 1000 - 2 * CONTROL_PERIOD_MS);
+
+    for (size_t i = 0; i < CAPTURE_COUNT; i++) {
+        sim_runFor((SETTLE_S - 60) * 1000UL);
+        memset(&update, 0, sizeof(update));
+        update.fields = CAL_FIELD_CAPTURE;
+        update.captureMoistureX100 = (uint16_t)(CAPTURES[i].moisture * 100);
+        pushCalibration(update);
+        sim_runFor(60 * 1000 - 2 * CONTROL_PERIOD_MS);
+    }
+    soilSensor_getCalibration(0, captured);
+    savedFound = stateStore_loadCalibration(saved);
+
+    compensatedError = trackError(TRACK_S - 60);
+
+    memset(&update, 0, sizeof(update));
+    update.fields = CAL_FIELD_TEMP_COEFF;
+    update.tempCoeffQ8 = 0;
+    pushCalibration(update);
+    uncompensatedError = trackError(TRACK_S - 60);
+
+    printf("max error: uncalibrated %.1f%%, calibrated %.2f%%, without drift compensation %.2f%%; "
+           "%u points; %.1f ns per conversion\n",
+           uncalibratedError, compensatedError, uncompensatedError, captured.pointCount, timeConversion());
+}
+
+void setUp() {}
+void tearDown() {}
+
+// The default table reads this probe far off
+static void test_uncalibrated_probe_is_off() {
+    TEST_ASSERT_GREATER_THAN_FLOAT(8.0f, uncalibratedError);
+}
+
+static void test_captures_build_the_table() {
+    TEST_ASSERT_EQUAL_UINT8(CAPTURE_COUNT, captured.pointCount);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(DRIFT_COUNTS_PER_C * 256), (uint32_t)captured.tempCoeffQ8);
+    // Wet end first; the default end points were replaced by the captures
+    TEST_ASSERT_EQUAL_UINT32(10000, captured.points[0].moistureX100);
+    TEST_ASSERT_EQUAL_UINT32(0, captured.points[CAPTURE_COUNT - 1].moistureX100);
+    TEST_ASSERT_LESS_THAN_UINT32(30, abs((int)captured.points[0].raw - 1350));
+    TEST_ASSERT_LESS_THAN_UINT32(30, abs((int)captured.points[CAPTURE_COUNT - 1].raw - 3300));
+}
+
+static void test_calibration_saved() {
+    TEST_ASSERT_TRUE(savedFound);
+    TEST_ASSERT_TRUE(memcmp(&saved[0], &captured, sizeof(captured)) == 0);
+}
+
+// Counts falling while moisture rises and falls again: not a valid table,
+// and the zone keeps the one it has
+static void test_invalid_upload_rejected() {
+    SoilCalibration before, after;
+    soilSensor_getCalibration(0, before);
+    CalibrationUpdate update;
+    memset(&update, 0, sizeof(update));
+    update.fields = CAL_FIELD_POINTS;
+    update.pointCount = 3;
+    update.points[0] = { 1000, 10000 };
+    update.points[1] = { 2000, 0 };
+    update.points[2] = { 3000, 5000 };
+    pushCalibration(update);
+    soilSensor_getCalibration(0, after);
+    TEST_ASSERT_TRUE(memcmp(&before, &after, sizeof(after)) == 0);
+}
+
+static void test_calibrated_reading_tracks_moisture() {
+    TEST_ASSERT_LESS_THAN_FLOAT(2.0f, compensatedError);
+}
+
+// The probe drifts 80 counts over +/-10 C, about 4 % moisture
+static void test_drift_compensation_matters() {
+    TEST_ASSERT_GREATER_THAN_FLOAT(compensatedError + 2.0f, uncompensatedError);
+}
+
+static void test_reset_restores_default() {
+    CalibrationUpdate update;
+    memset(&update, 0, sizeof(update));
+    update.fields = CAL_FIELD_RESET;
+    pushCalibration(update);
+    SoilCalibration def, afterReset;
+    soilCalibration_default(def);
+    soilSensor_getCalibration(0, afterReset);
+    TEST_ASSERT_TRUE(memcmp(&def, &afterReset, sizeof(def)) == 0);
+}
+
+// The integer table lands within 0.01 % of plain floating-point
+// interpolation at every count, and clamps outside its ends
+static void test_conversion_matches_interpolation() {
+    SoilCalibration cal;
+    soilCalibration_default(cal);
+    TEST_ASSERT_TRUE(soilCalibration_setPoint(cal, 1350, 10000));
+    TEST_ASSERT_TRUE(soilCalibration_setPoint(cal, 3300, 0));
+    TEST_ASSERT_TRUE(soilCalibration_setPoint(cal, 1900, 7000));
+    TEST_ASSERT_TRUE(soilCalibration_setPoint(cal, 2600, 3500));
+    SoilCalTable table;
+    soilCalibration_compile(cal, table);
+    for (int32_t raw = 0; raw <= SOIL_CAL_ADC_MAX; raw++) {
+        float expected;
+        if (raw <= cal.points[0].raw) {
+            expected = cal.points[0].moistureX100;
+        } else if (raw >= cal.points[cal.pointCount - 1].raw) {
+            expected = cal.points[cal.pointCount - 1].moistureX100;
+        } else {
+            uint8_t i = 0;
+            while (raw >= cal.points[i + 1].raw) i++;
+            const SoilCalPoint& a = cal.points[i];
+            const SoilCalPoint& b = cal.points[i + 1];
+            expected = a.moistureX100 + ((float)b.moistureX100 - a.moistureX100) * (raw - a.raw) / (b.raw - a.raw);
+        }
+        TEST_ASSERT_FLOAT_WITHIN(1.0f, expected, (float)soilCalibration_toMoistureX100(table, raw));
+    }
+}
+
+// A calibration command only marks the table dirty; the write happens in
+// the persist stage once commands have been quiet for the debounce time
+static void test_calibration_save_debounced() {
+    StateStoreStats before, applied, settled;
+    stateStore_getStats(before);
+    CalibrationUpdate update;
+    memset(&update, 0, sizeof(update));
+    update.fields = CAL_FIELD_TEMP_COEFF;
+    update.tempCoeffQ8 = 3 * 256;
+    pushCalibration(update);
+    stateStore_getStats(applied);
+    sim_runFor(STATE_SAVE_DEBOUNCE_MS + PERSIST_PERIOD_MS);
+    stateStore_getStats(settled);
+    TEST_ASSERT_EQUAL_UINT32(before.calibrationSaves, applied.calibrationSaves);
+    TEST_ASSERT_EQUAL_UINT32(before.calibrationSaves + 1, settled.calibrationSaves);
+    TEST_ASSERT_EQUAL_UINT32(before.saves, settled.saves);
+}
+
+// A command that leaves the persisted state as it is does not schedule a save
+static void test_unchanged_mode_not_saved() {
+    StateStoreStats before, after;
+    stateStore_getStats(before);
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SET_MODE;
+    cmd.mode = actuatorMode[0];
+    commandQueue_push(cmd);
+    sim_runFor(STATE_SAVE_MAX_DELAY_MS + PERSIST_PERIOD_MS);
+    stateStore_getStats(after);
+    TEST_ASSERT_EQUAL_UINT32(before.saves, after.saves);
+    TEST_ASSERT_EQUAL_UINT32(before.unchanged, after.unchanged);
+}
+
+int main(int argc, char** argv) {
+    runScenario();
+    UNITY_BEGIN();
+    RUN_TEST(test_uncalibrated_probe_is_off);
+    RUN_TEST(test_captures_build_the_table);
+    RUN_TEST(test_calibration_saved);
+    RUN_TEST(test_calibrated_reading_tracks_moisture);
+    RUN_TEST(test_drift_compensation_matters);
+    RUN_TEST(test_invalid_upload_rejected);
+    RUN_TEST(test_calibration_save_debounced);
+    RUN_TEST(test_unchanged_mode_not_saved);
+    RUN_TEST(test_reset_restores_default);
+    RUN_TEST(test_conversion_matches_interpolation);
+    return UNITY_END();
+}
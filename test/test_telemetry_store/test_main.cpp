@@ -0,0 +1,145 @@
+// Store-and-forward backlog on the simulated flash: samples are appended as
+// if the broker were away and drained in batches the way the network task
+// does it. A slot corrupted on flash is dropped once without costing the
+// samples after it, an unreadable ring holds the backlog back instead of
+// skipping it, each sample keeps its zone through flash, and the drain
+// position is saved debounced.
+
+#include <unity.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include "config.h"
+#include "sim.h"
+#include "telemetry_store.h"
+
+static const char* RING_PATH = "/telemetry.bin";
+static const char* TAIL_PATH = "/telemetry.tail";
+static const uint16_t SAMPLES = 3 * TELEMETRY_STAGING_SAMPLES + 3; // three flash writes, three staged
+
+static uint16_t firstValue = 0; // moistureX10 of the next sample appended
+
+// Appends count samples numbered by their moisture, returns the first number
+static uint16_t appendSamples(uint16_t count) {
+    uint16_t first = firstValue;
+    for (uint16_t i = 0; i < count; i++) {
+        TelemetrySample s = telemetryStore_makeSample(0, 25.0f, 0, 60.0f, false);
+        s.moistureX10 = firstValue++;
+        telemetryStore_append(s);
+    }
+    return first;
+}
+
+// Drains the whole backlog in TELEMETRY_DRAIN_BATCH batches; out gets the
+// sample numbers in delivery order
+static size_t drainAll(uint16_t* out, size_t maxOut) {
+    TelemetrySample batch[TELEMETRY_DRAIN_BATCH];
+    size_t delivered = 0;
+    for (int guard = 0; guard < 100 && telemetryStore_count() > 0; guard++) {
+        size_t n = telemetryStore_peek(batch, TELEMETRY_DRAIN_BATCH);
+        if (n == 0) continue; // leading corrupt slots dropped, try again
+        for (size_t i = 0; i < n && delivered < maxOut; i++) out[delivered++] = batch[i].moistureX10;
+        telemetryStore_consume(n);
+    }
+    return delivered;
+}
+
+static uint32_t savedTail() {
+    File f = LittleFS.open(TAIL_PATH, "r");
+    uint32_t record[2] = { 0, 0 };
+    if (f) f.read(reinterpret_cast<uint8_t*>(record), sizeof(record));
+    return record[0];
+}
+
+void setUp() {}
+void tearDown() {}
+
+// One slot in the middle of the flashed part fails its CRC: it is skipped
+// once and every other sample arrives exactly once, in order
+static void test_corrupt_slot_skipped_without_duplicates() {
+    uint16_t first = appendSamples(SAMPLES);
+    size_t slotSize = LittleFS.open(RING_PATH, "r").size() / TELEMETRY_RING_CAPACITY;
+    const uint32_t corruptSeq = 1 + 5; // sequence numbers start at 1
+    TEST_ASSERT_TRUE(sim_corruptFile(RING_PATH, corruptSeq * slotSize + slotSize / 2));
+
+    uint16_t order[2 * SAMPLES];
+    size_t delivered = drainAll(order, 2 * SAMPLES);
+    TEST_ASSERT_EQUAL_UINT32(SAMPLES - 1, delivered);
+    uint16_t expected = first;
+    for (size_t i = 0; i < delivered; i++, expected++) {
+        if (expected == first + 5) expected++;
+        TEST_ASSERT_EQUAL_UINT32(expected, order[i]);
+    }
+    TelemetryStoreStats stats;
+    telemetryStore_getStats(stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.corruptSkipped);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.count);
+}
+
+// While the ring file cannot be opened nothing is handed out, so the staged
+// samples cannot overtake (and consume() cannot drop) the flashed ones
+static void test_unreadable_ring_holds_the_backlog() {
+    uint16_t first = appendSamples(SAMPLES);
+    sim_setFilesystemAvailable(false);
+    LittleFS.begin();
+    TelemetrySample batch[TELEMETRY_DRAIN_BATCH];
+    TEST_ASSERT_EQUAL_UINT32(0, telemetryStore_peek(batch, TELEMETRY_DRAIN_BATCH));
+    TEST_ASSERT_EQUAL_UINT32(SAMPLES, telemetryStore_count());
+
+    sim_setFilesystemAvailable(true);
+    LittleFS.begin();
+    uint16_t order[SAMPLES];
+    TEST_ASSERT_EQUAL_UINT32(SAMPLES, drainAll(order, SAMPLES));
+    for (uint16_t i = 0; i < SAMPLES; i++) TEST_ASSERT_EQUAL_UINT32(first + i, order[i]);
+}
+
+// Samples of several zones interleave in the ring; each comes back out of
+// flash and staging with its own zone index
+static void test_zone_kept_through_flash() {
+    uint16_t first = firstValue;
+    for (uint16_t i = 0; i < SAMPLES; i++) {
+        TelemetrySample s = telemetryStore_makeSample(i % 4, 25.0f, 0, 60.0f, i % 2);
+        s.moistureX10 = firstValue++;
+        telemetryStore_append(s);
+    }
+    TelemetrySample batch[TELEMETRY_DRAIN_BATCH];
+    uint16_t seen = 0;
+    for (int guard = 0; guard < 100 && telemetryStore_count() > 0; guard++) {
+        size_t n = telemetryStore_peek(batch, TELEMETRY_DRAIN_BATCH);
+        for (size_t i = 0; i < n; i++, seen++) {
+            TEST_ASSERT_EQUAL_UINT32(first + seen, batch[i].moistureX10);
+            TEST_ASSERT_EQUAL_UINT8(seen % 4, batch[i].zone);
+            TEST_ASSERT_EQUAL_UINT8(seen % 2, batch[i].pumpOn);
+        }
+        telemetryStore_consume(n);
+    }
+    TEST_ASSERT_EQUAL_UINT32(SAMPLES, seen);
+}
+
+// Draining a batch does not rewrite the tail file; it is saved once the
+// drain has paused for the debounce time
+static void test_tail_saved_debounced() {
+    telemetryStore_service(0); // settle what the earlier tests drained
+    telemetryStore_service(TELEMETRY_TAIL_SAVE_MAX_DELAY_MS);
+    uint32_t before = savedTail();
+    appendSamples(SAMPLES);
+    uint16_t order[SAMPLES];
+    drainAll(order, SAMPLES);
+
+    unsigned long now = millis();
+    telemetryStore_service(now);
+    TEST_ASSERT_EQUAL_UINT32(before, savedTail());
+    telemetryStore_service(now + TELEMETRY_TAIL_SAVE_DEBOUNCE_MS);
+    TEST_ASSERT_EQUAL_UINT32(before + SAMPLES, savedTail());
+}
+
+int main(int argc, char** argv) {
+    sim_begin();
+    sim_setFilesystemAvailable(true);
+    telemetryStore_begin();
+    UNITY_BEGIN();
+    RUN_TEST(test_corrupt_slot_skipped_without_duplicates);
+    RUN_TEST(test_unreadable_ring_holds_the_backlog);
+    RUN_TEST(test_zone_kept_through_flash);
+    RUN_TEST(test_tail_saved_debounced);
+    return UNITY_END();
+}
@@ -0,0 +1,140 @@
+// Open-loop trace replay: soil moisture and air follow a fixed trace (the
+// pump has no effect), and the probe picks up relay switching spikes. Checks
+// that the real firmware waters exactly while the trace is below the
+// threshold, that the soil filter keeps spikes from starting the pump and
+// that soil above max_moisture stops any rule from watering.
+
+#include <unity.h>
+#include "command_queue.h"
+#include "config.h"
+#include "sim.h"
+#include "sim_plant.h"
+#include "zones.h"
+
+static const uint32_t HOUR_S = 3600;
+
+// Dry-down to just above the 40 % threshold, a dry spell below it, then rain
+static const SimTracePoint TRACE[] = {
+    { 0,                    60.0f, 24.0f, 70.0f },
+    { 4 * HOUR_S,           44.0f, 30.0f, 50.0f },
+    { 4 * HOUR_S + 1800,    42.0f, 31.0f, 48.0f },
+    { 5 * HOUR_S,           36.0f, 32.0f, 45.0f },
+    { 6 * HOUR_S,           36.0f, 31.0f, 50.0f },
+    { 6 * HOUR_S + 600,     72.0f, 22.0f, 95.0f },
+    { 10 * HOUR_S,          66.0f, 23.0f, 85.0f },
+};
+
+static SimZoneStats dryDown;   // 0..4.5 h, never below 40 %
+static SimZoneStats drySpell;  // 4.5..6 h, below 40 % from ~4 h 40 min
+static SimZoneStats afterRain; // 6.5..10 h
+static SimZoneStats overMax;   // 10..11 h, a rule that always matches, soil above max_moisture
+static SimZoneStats underMax;  // 11..12 h, the same rule with max_moisture raised
+static bool stoppedMidRun;     // max_moisture lowered again while the pump runs
+
+void setUp() {}
+void tearDown() {}
+
+static void pushCommand(Command& cmd) {
+    cmd.zone = 0;
+    commandQueue_push(cmd);
+}
+
+static void setMaxMoisture(int16_t maxMoisture) {
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SET_RULE;
+    cmd.rule.fields = RULE_FIELD_MAX_MOISTURE;
+    cmd.rule.maxMoisture = maxMoisture;
+    pushCommand(cmd);
+}
+
+// { "if": { "temperature": { "gt": 0 } } }
+static void loadWarmRule() {
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SET_PROGRAM;
+    RuleProgram& program = cmd.program;
+    program.custom = true;
+    program.ruleCount = 1;
+    program.conditionCount = 1;
+    program.conditions[0] = { RULE_IN_TEMPERATURE, RULE_GT, 0 };
+    program.rules[0] = { 0, 1, RULE_NO_WINDOW, RULE_NO_WINDOW, PUMP_RUN_MS / 1000, PUMP_COOLDOWN_MS / 1000 };
+    pushCommand(cmd);
+}
+
+static void runScenario() {
+    sim_begin();
+    simPlant_begin(simPlant_defaultWeather());
+    SimSoilParams soil = simPlant_defaultSoil();
+    soil.spikeEvery = 7;       // ~2 of every 16-sample burst
+    soil.spikeCounts = 1200;   // reads ~30 % drier
+    simPlant_addZone(zoneSoilPin[0], zoneRelayPin[0], soil);
+    simPlant_playTrace(TRACE, sizeof(TRACE) / sizeof(TRACE[0]));
+    setup();
+
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SET_MODE;
+    cmd.mode = MODE_AUTO;
+    pushCommand(cmd);
+
+    sim_runFor(4 * HOUR_S * 1000 + 1800 * 1000);
+    simPlant_zoneStats(0, dryDown);
+    simPlant_resetStats();
+    sim_runFor(1800 * 1000 + HOUR_S * 1000);
+    simPlant_zoneStats(0, drySpell);
+    sim_runFor(1800 * 1000);
+    simPlant_resetStats();
+    sim_runFor(3 * HOUR_S * 1000 + 1800 * 1000);
+    simPlant_zoneStats(0, afterRain);
+
+    // The trace holds 66 % from here on
+    setMaxMoisture(60);
+    loadWarmRule();
+    simPlant_resetStats();
+    sim_runFor(HOUR_S * 1000);
+    simPlant_zoneStats(0, overMax);
+    setMaxMoisture(90);
+    simPlant_resetStats();
+    sim_runFor(HOUR_S * 1000);
+    simPlant_zoneStats(0, underMax);
+
+    while (sim_pinLevel(zoneRelayPin[0]) == LOW) sim_runFor(CONTROL_PERIOD_MS);
+    setMaxMoisture(60);
+    sim_runFor(2 * CONTROL_PERIOD_MS);
+    stoppedMidRun = sim_pinLevel(zoneRelayPin[0]) == LOW;
+}
+
+static void test_spikes_do_not_start_the_pump() {
+    TEST_ASSERT_EQUAL_UINT32(0, dryDown.pumpStarts);
+    TEST_ASSERT_GREATER_THAN_FLOAT(40.0f, dryDown.minMoisture);
+}
+
+static void test_waters_in_pulses_while_below_threshold() {
+    TEST_ASSERT_GREATER_THAN_UINT32(0, drySpell.pumpStarts);
+    // The trace is below 40 % for about 80 minutes: one pulse per run + cooldown
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(80UL * 60 * 1000 / (PUMP_RUN_MS + PUMP_COOLDOWN_MS) + 2, drySpell.pumpStarts);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(70UL * 60 * 1000 / (PUMP_RUN_MS + PUMP_COOLDOWN_MS), drySpell.pumpStarts);
+}
+
+static void test_stays_off_after_rain() {
+    TEST_ASSERT_EQUAL_UINT32(0, afterRain.pumpStarts);
+    TEST_ASSERT_EQUAL_UINT32(LOW, sim_pinLevel(zoneRelayPin[0]));
+}
+
+static void test_max_moisture_overrides_rules() {
+    TEST_ASSERT_EQUAL_UINT32(0, overMax.pumpStarts);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, underMax.pumpStarts);
+    // A run otherwise lasts its run_s; the upper bound cuts it short
+    TEST_ASSERT_TRUE(stoppedMidRun);
+}
+
+int main(int argc, char** argv) {
+    runScenario();
+    UNITY_BEGIN();
+    RUN_TEST(test_spikes_do_not_start_the_pump);
+    RUN_TEST(test_waters_in_pulses_while_below_threshold);
+    RUN_TEST(test_stays_off_after_rain);
+    RUN_TEST(test_max_moisture_overrides_rules);
+    return UNITY_END();
+}
@@ -0,0 +1,457 @@
+#include "device.h"
+#include "config.h"
+#include "mqtt_handler.h"
+#include "plant_profiles.h"
+#include <ArduinoJson.h>
+#include <math.h>
+
+#define DEVICE_KEEPALIVE_S MQTT_KEEPALIVE_S // same as the firmware
+#define DRY_RATE_PER_HOUR 1.5f
+#define PUMP_RATE_PER_MINUTE 6.0f
+
+Device::Device() : isOnline(false) {
+    memset(deviceCode, 0, sizeof(deviceCode));
+}
+
+void Device::begin(const char* code, const sockaddr_in& brokerAddress, const DeviceOptions& options,
+                   const DeviceClock& clock) {
+    strlcpy(deviceCode, code, sizeof(deviceCode));
+    static_assert(sizeof(deviceCode) <= DEVICE_CODE_MAX + 1, "device codes must fit the topics");
+    mqttSchema_buildTopics(topics, deviceCode, ACTUATOR_ID);
+    broker = brokerAddress;
+    bootMs = clock.nowMs + options.startDelayMs;
+    reconnectAt = bootMs;
+    backoffMs = MQTT_BACKOFF_BASE_MS;
+    noiseState = options.seed * 2654435761u + 1;
+
+    // Same defaults as loadDefaultRules() in main.cpp
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        mode[z] = options.mode;
+        statusOn[z] = false;
+        minMoisture[z] = 40;
+        maxMoisture[z] = 80;
+        defaultRunS[z] = PUMP_RUN_MS / 1000;
+        defaultCooldownS[z] = PUMP_COOLDOWN_MS / 1000;
+        ruleEngine_defaultProgram(minMoisture[z], program[z]);
+        memset(&cycle[z], 0, sizeof(cycle[z]));
+        moisture[z] = 35.0f + 35.0f * random01();
+        reportedMoisture[z] = NAN;
+    }
+    pumpOn = 0;
+    pendingCount = 0;
+    nowUs = clock.nowUs;
+    traceCount = 0;
+    traceSeq = 0;
+    climateOffset = 4.0f * random01() - 2.0f;
+    senseStep(clock, 0);
+
+    // Phases spread so a fleet does not tick in lockstep
+    unsigned long start = bootMs;
+    nextControlMs = start + (unsigned long)(random01() * CONTROL_PERIOD_MS);
+    nextNetworkMs = start + (unsigned long)(random01() * MQTT_LOOP_PERIOD_MS);
+    lastSampleMs = start;
+    reportEveryPeriod = options.reportEveryPeriod;
+    for (uint8_t ch = 0; ch <= REPORT_PUMP; ch++) lastReportMs[ch] = start;
+    reportedTemperature = reportedHumidity = NAN;
+    reportedPump = attemptedPump = 0xFFFF; // first report always carries the pump
+    telemetrySeq = 0;
+}
+
+float Device::random01() {
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    return (noiseState >> 8) / 16777216.0f;
+}
+
+unsigned long Device::nextDueMs() const {
+    unsigned long next = (long)(nextControlMs - nextNetworkMs) < 0 ? nextControlMs : nextNetworkMs;
+    if (!wire.open() && (long)(reconnectAt - next) < 0) next = reconnectAt;
+    return next;
+}
+
+size_t Device::memoryBytes() const {
+    return sizeof(*this) + wire.memoryBytes();
+}
+
+// --- Ingest (same routing as callback() in mqtt_handler.cpp) ---
+
+void Device::onMessage(void* ctx, const char* topic, const uint8_t* payload, size_t length) {
+    static_cast<Device*>(ctx)->handleMessage(topic, payload, length);
+}
+
+void Device::pushCommand(const Command& cmd) {
+    if (pendingCount >= DEVICE_COMMAND_SLOTS) {
+        counters.commandsDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    pending[pendingCount++] = cmd;
+}
+
+// Optional correlation id, as takeTraceId() in mqtt_handler.cpp
+static void takeTraceId(Command& cmd, const uint8_t* payload, size_t length, uint32_t nowUs) {
+    const char* id;
+    size_t idLen;
+    if (!mqttSchema_findString(payload, length, "id", &id, &idLen) || idLen == 0) return;
+    actuationTrace_copyId(cmd.traceId, id, idLen);
+    cmd.receivedUs = nowUs;
+}
+
+void Device::handleMessage(const char* topic, const uint8_t* payload, size_t length) {
+    counters.received.fetch_add(1, std::memory_order_relaxed);
+    if (strncmp(topic, topics.base, topics.baseLen) != 0) return;
+    const char* suffix = topic + topics.baseLen;
+    size_t suffixLen = strlen(suffix);
+
+    uint8_t zone;
+    const char* action;
+    size_t actionLen;
+    if (mqttSchema_parseActuatorTopic(suffix, suffixLen, ACTUATOR_ID, zone, action, actionLen)) {
+        Command cmd = {};
+        cmd.zone = zone;
+        const char* value = reinterpret_cast<const char*>(payload);
+        size_t valueLen = length;
+        if (actionLen == 4 && memcmp(action, "mode", 4) == 0) {
+            bool isJson = mqttSchema_findString(payload, length, "value", &value, &valueLen);
+            cmd.type = CMD_SET_MODE;
+            if (!mqttSchema_parseMode(value, valueLen, &cmd.mode)) return;
+            if (isJson) takeTraceId(cmd, payload, length, nowUs);
+            pushCommand(cmd);
+        } else if (actionLen == 6 && memcmp(action, "status", 6) == 0) {
+            cmd.type = CMD_SET_STATUS;
+            if (mqttSchema_findString(payload, length, "value", &value, &valueLen) &&
+                mqttSchema_parseOnOff(value, valueLen, &cmd.on)) {
+                takeTraceId(cmd, payload, length, nowUs);
+                pushCommand(cmd);
+            }
+        }
+        return; // actual-status: our own retained publishes coming back
+    }
+    if (suffixLen == 4 && memcmp(suffix, "rule", 4) == 0) handleRule(payload, length);
+}
+
+void Device::handleRule(const uint8_t* payload, size_t length) {
+    JsonDocument doc;
+    if (deserializeJson(doc, reinterpret_cast<const char*>(payload), length)) return;
+    uint32_t zone = (doc["actuator_id"] | ACTUATOR_ID) - ACTUATOR_ID;
+    if (zone >= ZONE_COUNT) return;
+
+    JsonVariantConst rules = doc["rules"];
+    if (!rules.isNull()) {
+        Command programCmd = {};
+        programCmd.type = CMD_SET_PROGRAM;
+        programCmd.zone = zone;
+        char error[64];
+        if (ruleEngine_compile(rules, programCmd.program, error, sizeof(error))) pushCommand(programCmd);
+    }
+    Command cmd = {};
+    cmd.type = CMD_SET_RULE;
+    cmd.zone = zone;
+    if (doc["min_moisture"].is<int>()) {
+        cmd.rule.fields |= RULE_FIELD_MIN_MOISTURE;
+        cmd.rule.minMoisture = doc["min_moisture"].as<int>();
+    }
+    if (doc["max_moisture"].is<int>()) {
+        cmd.rule.fields |= RULE_FIELD_MAX_MOISTURE;
+        cmd.rule.maxMoisture = doc["max_moisture"].as<int>();
+    }
+    // handleRuleMessage(): a known plant_name fills in the rest
+    const PlantProfile* profile =
+        doc["plant_name"].is<const char*>() ? plantProfile_find(doc["plant_name"].as<const char*>()) : nullptr;
+    if (profile != nullptr) plantProfile_fillRule(*profile, cmd.rule);
+    if (cmd.rule.fields) pushCommand(cmd);
+}
+
+// --- Connection ---
+
+void Device::connectStep(const DeviceClock& clock) {
+    if ((long)(clock.nowMs - reconnectAt) < 0) return;
+    if (wire.connect(broker, deviceCode, DEVICE_KEEPALIVE_S, onMessage, this, clock.nowMs)) {
+        backoffMs = MQTT_BACKOFF_BASE_MS;
+        return;
+    }
+    reconnectAt = clock.nowMs + backoffMs / 2 + (unsigned long)(random01() * backoffMs / 2);
+    backoffMs = backoffMs * 2 > MQTT_BACKOFF_MAX_MS ? MQTT_BACKOFF_MAX_MS : backoffMs * 2;
+}
+
+// --- Control stage ---
+
+void Device::senseStep(const DeviceClock& clock, float dtS) {
+    float hour = clock.minuteOfDay >= 0 ? clock.minuteOfDay / 60.0f : 12.0f;
+    float phase = sinf((hour - 9.0f) * (float)M_PI / 12.0f); // +1 at 15:00
+    temperature = roundf((27.0f + climateOffset + 5.0f * phase + 0.2f * (random01() - 0.5f)) * 10) / 10;
+    humidity = roundf((65.0f - 15.0f * phase + (random01() - 0.5f)) * 10) / 10;
+    float climate = 1.0f + 0.04f * (temperature - 25.0f) - 0.01f * (humidity - 50.0f);
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        float m = moisture[z] - DRY_RATE_PER_HOUR / 3600.0f * dtS * (climate > 0.2f ? climate : 0.2f);
+        if (pumpOn & ZONE_BIT(z)) m += PUMP_RATE_PER_MINUTE / 60.0f * dtS;
+        moisture[z] = constrain(m, 0.0f, 100.0f);
+    }
+}
+
+ActuationTrace* Device::openTrace(uint8_t zone, ActuationSource source, uint32_t appliedUs) {
+    if (traceCount >= DEVICE_TRACE_SLOTS) return nullptr;
+    ActuationTrace& t = traces[traceCount++];
+    memset(&t, 0, sizeof(t));
+    t.seq = traceSeq++;
+    t.zone = zone;
+    t.source = source;
+    t.appliedUs = appliedUs;
+    return &t;
+}
+
+void Device::controlStep(const DeviceClock& clock) {
+    unsigned long now = clock.nowMs;
+    uint8_t firstTrace = traceCount;
+    // applyCommands()
+    for (uint8_t i = 0; i < pendingCount; i++) {
+        const Command& cmd = pending[i];
+        uint8_t z = cmd.zone;
+        if ((cmd.type == CMD_SET_MODE || cmd.type == CMD_SET_STATUS) && cmd.traceId[0]) {
+            ActuationTrace* t = openTrace(z, ACTUATION_COMMAND, clock.nowUs);
+            if (t != nullptr) {
+                strlcpy(t->id, cmd.traceId, sizeof(t->id));
+                t->receivedUs = cmd.receivedUs;
+            }
+        }
+        switch (cmd.type) {
+            case CMD_SET_MODE:
+                mode[z] = cmd.mode;
+                break;
+            case CMD_SET_STATUS:
+                statusOn[z] = cmd.on;
+                break;
+            case CMD_SET_RULE:
+                if (cmd.rule.fields & RULE_FIELD_MIN_MOISTURE) minMoisture[z] = cmd.rule.minMoisture;
+                if (cmd.rule.fields & RULE_FIELD_MAX_MOISTURE) maxMoisture[z] = cmd.rule.maxMoisture;
+                if ((cmd.rule.fields & RULE_FIELD_PUMP_TIMING) && cmd.rule.runS > 0) {
+                    defaultRunS[z] = cmd.rule.runS;
+                    defaultCooldownS[z] = cmd.rule.cooldownS;
+                }
+                if (!program[z].custom) {
+                    ruleEngine_defaultProgram(minMoisture[z], program[z], defaultRunS[z], defaultCooldownS[z]);
+                }
+                break;
+            case CMD_SET_PROGRAM:
+                if (cmd.program.custom) program[z] = cmd.program;
+                else ruleEngine_defaultProgram(minMoisture[z], program[z], defaultRunS[z], defaultCooldownS[z]);
+                break;
+            case CMD_SET_CALIBRATION:
+                break; // simulated probes report true moisture
+        }
+        counters.commands.fetch_add(1, std::memory_order_relaxed);
+    }
+    pendingCount = 0;
+
+    senseStep(clock, CONTROL_PERIOD_MS / 1000.0f);
+
+    // zones_control(), with starts granted in zone order instead of round-robin
+    int8_t matched[ZONE_COUNT];
+    ZoneMask keep = 0;
+    ZoneMask wanted = 0;
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        ZoneMask bit = ZONE_BIT(z);
+        matched[z] = -1;
+        if (mode[z] == MODE_AUTO) {
+            matched[z] = ruleEngine_match(program[z], moisture[z], temperature, humidity, clock.minuteOfDay);
+            bool aboveMax = moisture[z] > maxMoisture[z];
+            if (pumpCycle_step(cycle[z], matched[z], aboveMax, now)) wanted |= bit;
+            else if (cycle[z].phase == PUMP_RUNNING) keep |= bit;
+        } else if (statusOn[z]) {
+            if (pumpOn & bit) keep |= bit;
+            else wanted |= bit;
+        }
+    }
+    uint8_t active = __builtin_popcount(keep);
+    for (uint8_t z = 0; wanted != 0 && z < ZONE_COUNT; z++) {
+        if (!(wanted & ZONE_BIT(z)) || active >= MAX_ACTIVE_PUMPS) continue;
+        keep |= ZONE_BIT(z);
+        active++;
+        if (mode[z] == MODE_AUTO) pumpCycle_start(cycle[z], program[z].rules[matched[z]], now);
+    }
+    uint8_t starts = __builtin_popcount(keep & ~pumpOn);
+    if (starts) counters.pumpStarts.fetch_add(starts, std::memory_order_relaxed);
+
+    // actuationTrace_relayWritten()/endTick(): the "relay" switches at once
+    ZoneMask changed = keep ^ pumpOn;
+    pumpOn = keep;
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        if (!(changed & ZONE_BIT(z))) continue;
+        bool traced = false;
+        for (uint8_t i = firstTrace; i < traceCount; i++) {
+            if (traces[i].zone != z || traces[i].relayChanged) continue;
+            traces[i].relayChanged = true;
+            traces[i].gpioUs = clock.nowUs;
+            traced = true;
+        }
+        if (traced || mode[z] != MODE_AUTO) continue;
+        ActuationTrace* t = openTrace(z, ACTUATION_AUTO, clock.nowUs);
+        if (t == nullptr) continue;
+        t->relayChanged = true;
+        t->gpioUs = clock.nowUs;
+    }
+    for (uint8_t i = firstTrace; i < traceCount; i++) traces[i].on = pumpOn & ZONE_BIT(traces[i].zone);
+}
+
+// --- Network loop (networkTask() in mqtt_handler.cpp) ---
+
+void Device::publishValue(const char* topic, const char* value) {
+    char payload[32];
+    int len = snprintf(payload, sizeof(payload), "{\"value\":\"%s\"}", value);
+    if (wire.publish(topic, payload, len, true)) {
+        counters.published.fetch_add(1, std::memory_order_relaxed);
+        counters.publishedBytes.fetch_add(len, std::memory_order_relaxed);
+    } else {
+        counters.publishDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Same payload as publishTelemetryBatch() (JSON) plus the legacy topics; false
+// when the batch could not be written
+bool Device::publishTelemetry(const DeviceClock& clock, ReportMask mask) {
+    char payload[256 + (ZONE_COUNT - 1) * 32];
+    size_t len = snprintf(payload, sizeof(payload), "{\"ts\":%lu,\"seq\":%lu", (unsigned long)clock.epoch,
+                          (unsigned long)telemetrySeq);
+    if (mask & REPORT_MASK(REPORT_TEMPERATURE)) len += snprintf(payload + len, sizeof(payload) - len, ",\"temperature\":%.1f", temperature);
+    if (mask & REPORT_MASK(REPORT_HUMIDITY)) len += snprintf(payload + len, sizeof(payload) - len, ",\"humidity\":%.1f", humidity);
+#if ZONE_COUNT == 1
+    if (mask & REPORT_MASK(REPORT_MOISTURE)) len += snprintf(payload + len, sizeof(payload) - len, ",\"moisture\":%.1f", moisture[0]);
+    if (mask & REPORT_MASK(REPORT_PUMP)) len += snprintf(payload + len, sizeof(payload) - len, ",\"pump\":\"%s\"", pumpOn ? "on" : "off");
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"mode\":\"%s\"}", actuatorModeName(mode[0]));
+#else
+    if (mask & REPORT_MASK(REPORT_MOISTURE)) {
+        for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+            len += snprintf(payload + len, sizeof(payload) - len, "%s%.1f", z ? "," : ",\"moisture\":[", moisture[z]);
+        }
+        len += snprintf(payload + len, sizeof(payload) - len, "]");
+    }
+    if (mask & REPORT_MASK(REPORT_PUMP)) {
+        for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+            len += snprintf(payload + len, sizeof(payload) - len, "%s\"%s\"", z ? "," : ",\"pump\":[",
+                            (pumpOn & ZONE_BIT(z)) ? "on" : "off");
+        }
+        len += snprintf(payload + len, sizeof(payload) - len, "]");
+    }
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+        len += snprintf(payload + len, sizeof(payload) - len, "%s\"%s\"", z ? "," : ",\"mode\":[", actuatorModeName(mode[z]));
+    }
+    len += snprintf(payload + len, sizeof(payload) - len, "]}");
+#endif
+    if (len < sizeof(payload) && wire.publish(topics.telemetry, payload, len, false)) {
+        counters.published.fetch_add(1, std::memory_order_relaxed);
+        counters.publishedBytes.fetch_add(len, std::memory_order_relaxed);
+        telemetrySeq++;
+    } else {
+        counters.publishDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+#if TELEMETRY_LEGACY_TOPICS
+    char text[16];
+    if (mask & REPORT_MASK(REPORT_MOISTURE)) {
+        snprintf(text, sizeof(text), "%.1f", moisture[0]);
+        publishValue(topics.sensor[0], text);
+    }
+    if (mask & REPORT_MASK(REPORT_TEMPERATURE)) {
+        snprintf(text, sizeof(text), "%.1f", temperature);
+        publishValue(topics.sensor[1], text);
+    }
+    if (mask & REPORT_MASK(REPORT_HUMIDITY)) {
+        snprintf(text, sizeof(text), "%.1f", humidity);
+        publishValue(topics.sensor[2], text);
+    }
+    if (mask & REPORT_MASK(REPORT_PUMP)) {
+        for (uint8_t z = 0; z < ZONE_COUNT; z++) publishValue(topics.actualStatus[z], (pumpOn & ZONE_BIT(z)) ? "on" : "off");
+    }
+#endif
+    return true;
+}
+
+void Device::publishTraces(const DeviceClock& clock) {
+    for (uint8_t i = 0; i < traceCount; i++) {
+        char payload[224];
+        size_t len = actuationTrace_format(traces[i], clock.nowUs, payload, sizeof(payload));
+        if (len > 0 && wire.publish(topics.actualStatus[traces[i].zone], payload, len, true)) {
+            counters.published.fetch_add(1, std::memory_order_relaxed);
+            counters.publishedBytes.fetch_add(len, std::memory_order_relaxed);
+        } else {
+            counters.publishDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    traceCount = 0;
+}
+
+static inline bool moved(float value, float reported, float deadband) {
+    return isnan(reported) || fabsf(value - reported) >= deadband;
+}
+
+void Device::networkStep(const DeviceClock& clock) {
+    unsigned long now = clock.nowMs;
+    bool pumpChanged = pumpOn != attemptedPump;
+    if (!pumpChanged && now - lastSampleMs < MQTT_PUBLISH_PERIOD_MS) return;
+    if (!pumpChanged) lastSampleMs = now;
+    attemptedPump = pumpOn;
+
+    // reportGate_due(): past the deadband or heartbeat expired
+    ReportMask mask = 0;
+    bool moistureMoved = false;
+    for (uint8_t z = 0; z < ZONE_COUNT; z++) moistureMoved |= moved(moisture[z], reportedMoisture[z], REPORT_MOISTURE_DEADBAND_ABS);
+    if (moistureMoved) mask |= REPORT_MASK(REPORT_MOISTURE);
+    if (moved(temperature, reportedTemperature, REPORT_TEMPERATURE_DEADBAND_ABS)) mask |= REPORT_MASK(REPORT_TEMPERATURE);
+    if (moved(humidity, reportedHumidity, REPORT_HUMIDITY_DEADBAND_ABS)) mask |= REPORT_MASK(REPORT_HUMIDITY);
+    if (pumpOn != reportedPump) mask |= REPORT_MASK(REPORT_PUMP);
+    for (uint8_t ch = 0; ch <= REPORT_PUMP; ch++) {
+        if (now - lastReportMs[ch] >= REPORT_HEARTBEAT_MS) mask |= REPORT_MASK(ch);
+    }
+    if (reportEveryPeriod && !pumpChanged) mask = REPORT_MASK(REPORT_PUMP + 1) - 1;
+    if (mask == 0) return;
+
+    // Like the firmware, the gate only moves on a written batch (the device
+    // model keeps no backlog); the next period tries again
+    if (!publishTelemetry(clock, mask)) return;
+    for (uint8_t ch = 0; ch <= REPORT_PUMP; ch++) {
+        if (mask & REPORT_MASK(ch)) lastReportMs[ch] = now;
+    }
+    if (mask & REPORT_MASK(REPORT_MOISTURE)) memcpy(reportedMoisture, moisture, sizeof(reportedMoisture));
+    if (mask & REPORT_MASK(REPORT_TEMPERATURE)) reportedTemperature = temperature;
+    if (mask & REPORT_MASK(REPORT_HUMIDITY)) reportedHumidity = humidity;
+    if (mask & REPORT_MASK(REPORT_PUMP)) reportedPump = pumpOn;
+}
+
+void Device::service(const DeviceClock& clock, bool readable) {
+    unsigned long now = clock.nowMs;
+    if ((long)(now - bootMs) < 0) return; // not powered up yet
+    nowUs = clock.nowUs;
+    if (!wire.open()) {
+        connectStep(clock);
+    } else {
+        bool wasConnected = wire.connected();
+        if (!wire.service(now, readable)) {
+            isOnline.store(false, std::memory_order_relaxed);
+            reconnectAt = now + backoffMs / 2 + (unsigned long)(random01() * backoffMs / 2);
+            backoffMs = backoffMs * 2 > MQTT_BACKOFF_MAX_MS ? MQTT_BACKOFF_MAX_MS : backoffMs * 2;
+        } else if (!wasConnected && wire.connected()) {
+            // One wildcard subscription, as the firmware does
+            wire.subscribe(topics.subscribe);
+            counters.connects.fetch_add(1, std::memory_order_relaxed);
+            isOnline.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // The control stage runs whether or not the network is up. A worker that
+    // fell far behind skips ticks instead of bursting through them.
+    if (now - nextControlMs > 10 * CONTROL_PERIOD_MS && (long)(now - nextControlMs) > 0) nextControlMs = now;
+    while ((long)(now - nextControlMs) >= 0) {
+        controlStep(clock);
+        nextControlMs += CONTROL_PERIOD_MS;
+    }
+    if ((long)(now - nextNetworkMs) >= 0) {
+        if (wire.connected()) {
+            publishTraces(clock);
+            networkStep(clock);
+        } else {
+            traceCount = 0; // offline: acknowledgements are not kept
+        }
+        nextNetworkMs = now + MQTT_LOOP_PERIOD_MS;
+    }
+}
@@ -0,0 +1,144 @@
+#ifndef FLEET_DEVICE_H
+#define FLEET_DEVICE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "actuation_trace.h"
+#include "command_queue.h"
+#include "mqtt_schema.h"
+#include "mqtt_wire.h"
+#include "pump_cycle.h"
+#include "report_gate.h"
+#include "rule_engine.h"
+
+// One simulated controller. The firmware keeps its control state in
+// process-wide globals (one device per process); this object holds the same
+// state per instance and replays the firmware's pipeline with the firmware's
+// own pieces, so a fleet of them shares one process:
+//   - topics, command payloads and routing from mqtt_schema.h
+//   - rule programs from ruleEngine_compile()/ruleEngine_match()
+//   - the auto-mode run/cooldown cycle from pump_cycle.h
+//   - the control stage every CONTROL_PERIOD_MS, the network loop every
+//     MQTT_LOOP_PERIOD_MS, telemetry and legacy topics every
+//     MQTT_PUBLISH_PERIOD_MS behind the REPORT_* deadbands, and an immediate
+//     report on every pump change
+//   - actuation traces (actuation_trace.h): status/mode commands with an
+//     "id" and auto transitions are acknowledged on actual-status on the
+//     next network tick, with the same payload
+// Commands go through a small queue and take effect on the next control
+// tick, as with the firmware's command queue. Sensors follow a simple
+// drying/watering model. Owned by one worker thread; stats() may be read
+// from any thread.
+
+#define DEVICE_COMMAND_SLOTS 4
+#define DEVICE_TRACE_SLOTS (DEVICE_COMMAND_SLOTS + ZONE_COUNT)
+
+struct DeviceClock {
+    unsigned long nowMs;     // monotonic
+    uint32_t nowUs;          // same clock in us, for actuation traces
+    uint32_t epoch;          // wall clock, seconds
+    int16_t minuteOfDay;     // local time (TIME_ZONE) for rule windows
+};
+
+struct DeviceOptions {
+    ActuatorMode mode;        // of every zone before any command arrives
+    bool reportEveryPeriod;   // ignore the deadbands: worst-case telemetry load
+    unsigned long startDelayMs; // first connect, to ramp a fleet up
+    uint32_t seed;            // sensor offsets, noise and start moisture
+};
+
+struct DeviceStats {
+    std::atomic<uint32_t> connects;
+    std::atomic<uint32_t> published;
+    std::atomic<uint32_t> publishedBytes;
+    std::atomic<uint32_t> publishDropped;  // outgoing buffer full or offline
+    std::atomic<uint32_t> received;
+    std::atomic<uint32_t> commands;        // applied by the control stage
+    std::atomic<uint32_t> commandsDropped; // queue full
+    std::atomic<uint32_t> pumpStarts;
+};
+
+class Device {
+public:
+    Device();
+
+    // code is the device_code of the topics and the MQTT client id
+    void begin(const char* code, const sockaddr_in& broker, const DeviceOptions& options,
+               const DeviceClock& clock);
+    // One step: (re)connects when due, takes in what arrived and runs the
+    // control and network ticks that are due
+    void service(const DeviceClock& clock, bool readable);
+
+    int fd() const { return wire.fd(); }
+    bool wantsWrite() const { return wire.wantsWrite(); }
+    bool online() const { return isOnline.load(std::memory_order_relaxed); }
+    unsigned long nextDueMs() const;
+    const DeviceStats& stats() const { return counters; }
+    const char* code() const { return deviceCode; }
+    size_t memoryBytes() const; // object plus the connection's buffers
+
+private:
+    static void onMessage(void* ctx, const char* topic, const uint8_t* payload, size_t length);
+    void handleMessage(const char* topic, const uint8_t* payload, size_t length);
+    void handleRule(const uint8_t* payload, size_t length);
+    void pushCommand(const Command& cmd);
+    void connectStep(const DeviceClock& clock);
+    void senseStep(const DeviceClock& clock, float dtS);
+    void controlStep(const DeviceClock& clock);
+    void networkStep(const DeviceClock& clock);
+    bool publishTelemetry(const DeviceClock& clock, ReportMask mask);
+    void publishValue(const char* topic, const char* value);
+    ActuationTrace* openTrace(uint8_t zone, ActuationSource source, uint32_t appliedUs);
+    void publishTraces(const DeviceClock& clock);
+    float random01();
+
+    char deviceCode[24];
+    MqttTopics topics;
+    sockaddr_in broker;
+    MqttWire wire;
+    std::atomic<bool> isOnline;
+    unsigned long bootMs;
+    unsigned long reconnectAt;
+    unsigned long backoffMs;
+
+    // Control state, per zone as in device_state.h
+    ActuatorMode mode[ZONE_COUNT];
+    bool statusOn[ZONE_COUNT];
+    int minMoisture[ZONE_COUNT];
+    int maxMoisture[ZONE_COUNT];
+    uint16_t defaultRunS[ZONE_COUNT];      // default program timing, from the plant profile
+    uint16_t defaultCooldownS[ZONE_COUNT];
+    RuleProgram program[ZONE_COUNT];
+    PumpCycle cycle[ZONE_COUNT];
+    ZoneMask pumpOn;
+    Command pending[DEVICE_COMMAND_SLOTS];
+    uint8_t pendingCount;
+    uint32_t nowUs;          // of the current service() call, stamps received commands
+    ActuationTrace traces[DEVICE_TRACE_SLOTS]; // finished, waiting for the network tick
+    uint8_t traceCount;
+    uint32_t traceSeq;
+
+    // Sensors
+    float moisture[ZONE_COUNT];
+    float temperature;
+    float humidity;
+    float climateOffset;
+    uint32_t noiseState;
+
+    // Network loop and report-by-exception
+    unsigned long nextControlMs;
+    unsigned long nextNetworkMs;
+    unsigned long lastSampleMs;
+    bool reportEveryPeriod;
+    unsigned long lastReportMs[REPORT_PUMP + 1]; // heartbeats of the shared channels
+    float reportedMoisture[ZONE_COUNT];
+    float reportedTemperature;
+    float reportedHumidity;
+    ZoneMask reportedPump;
+    ZoneMask attemptedPump;  // pump state of the last report attempt (edge trigger)
+    uint32_t telemetrySeq;
+
+    DeviceStats counters;
+};
+
+#endif
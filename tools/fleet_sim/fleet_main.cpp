@@ -0,0 +1,533 @@
+// Fleet simulator: N virtual controllers (device.h) on a pool of worker
+// threads against one MQTT broker, plus an operator connection that sends
+// actuator status commands with a correlation id and times them until the
+// actual-status carrying that id comes back. Reports publish throughput,
+// command-to-actual-status latency percentiles (round trip and the devices'
+// own share) and CPU/memory per simulated device. See README.md.
+
+#include <algorithm>
+#include <atomic>
+#include <getopt.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include "config.h"
+#include "device.h"
+#include "mqtt_handler.h"
+
+#define FLEET_SWEEP_MS 2               // workers look for due ticks this often
+#define FLEET_COMMAND_TIMEOUT_MS 10000 // no actual-status by then: counted as lost
+#define FLEET_EPOLL_BATCH 256
+
+struct FleetOptions {
+    const char* host;
+    uint16_t port;
+    unsigned devices;
+    unsigned threads;
+    unsigned durationS;
+    unsigned rampPerS;       // connects per second while the fleet comes up
+    float commandsPerS;      // operator status commands, fleet-wide
+    float autoShare;         // share of devices starting in auto mode
+    bool reportEveryPeriod;
+    uint32_t seed;
+};
+
+static std::atomic<bool> stopping(false);
+
+static unsigned long monotonicMs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+}
+
+static uint64_t monotonicUs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static double threadCpuS() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double processCpuS() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+static size_t residentBytes() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f == nullptr) return 0;
+    unsigned long size = 0, resident = 0;
+    if (fscanf(f, "%lu %lu", &size, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// Local minute of day, recomputed once per wall-clock minute per caller
+struct ClockCache {
+    time_t minute;
+    int16_t minuteOfDay;
+};
+
+static DeviceClock makeClock(ClockCache& cache) {
+    DeviceClock clock;
+    clock.nowMs = monotonicMs();
+    clock.nowUs = (uint32_t)monotonicUs();
+    time_t now = time(nullptr);
+    clock.epoch = (uint32_t)now;
+    if (now / 60 != cache.minute) {
+        struct tm local;
+        localtime_r(&now, &local);
+        cache.minute = now / 60;
+        cache.minuteOfDay = local.tm_hour * 60 + local.tm_min;
+    }
+    clock.minuteOfDay = cache.minuteOfDay;
+    return clock;
+}
+
+// --- Workers ---
+
+// One shard of the fleet: input is serviced as it arrives (epoll), due
+// control/network ticks every FLEET_SWEEP_MS
+static void workerLoop(Device* devices, size_t count) {
+    int ep = epoll_create1(0);
+    std::vector<int> registered(count, -1);
+    epoll_event events[FLEET_EPOLL_BATCH];
+    ClockCache cache = { 0, -1 };
+    unsigned long nextSweep = monotonicMs();
+
+    // Sockets come and go with reconnects; closed ones leave the epoll set by themselves
+    auto track = [&](size_t i) {
+        int fd = devices[i].fd();
+        if (fd >= 0 && fd != registered[i]) {
+            epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.u32 = (uint32_t)i;
+            epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+        }
+        registered[i] = fd;
+    };
+
+    while (!stopping.load(std::memory_order_relaxed)) {
+        long wait = (long)(nextSweep - monotonicMs());
+        int n = epoll_wait(ep, events, FLEET_EPOLL_BATCH, wait > 0 ? (int)wait : 0);
+        DeviceClock clock = makeClock(cache);
+        for (int e = 0; e < n; e++) {
+            size_t i = events[e].data.u32;
+            devices[i].service(clock, true);
+            track(i);
+        }
+        if ((long)(clock.nowMs - nextSweep) < 0) continue;
+        for (size_t i = 0; i < count; i++) {
+            Device& d = devices[i];
+            if ((long)(clock.nowMs - d.nextDueMs()) < 0 && !d.wantsWrite()) continue;
+            d.service(clock, false);
+            track(i);
+        }
+        nextSweep = clock.nowMs + FLEET_SWEEP_MS;
+    }
+    close(ep);
+}
+
+// --- Operator ---
+
+struct PendingCommand {
+    uint64_t sentUs;    // 0 = nothing outstanding
+    uint32_t id;        // "op-{id}" correlation id
+};
+
+struct Operator {
+    const char* prefix;          // "device/FLEET-"
+    size_t prefixLen;
+    std::vector<PendingCommand> pending;
+    std::vector<bool> requested; // last value sent per device
+    std::vector<bool> manual;    // status commands only move the pump in manual mode
+    std::vector<uint32_t> latencyUs;
+    std::vector<uint32_t> deviceUs; // "total" of the acknowledgement: time spent on the device
+    uint32_t nextId;
+    bool recording;
+    unsigned long sent;
+    unsigned long acked;
+    unsigned long lost;
+};
+
+// Unsigned number after "key": anywhere in the payload (the hop latencies
+// sit in a nested object)
+static bool findNumber(const uint8_t* payload, size_t length, const char* key, uint32_t& out) {
+    const char* p = reinterpret_cast<const char*>(payload);
+    const char* end = p + length;
+    size_t keyLen = strlen(key);
+    for (; p + keyLen + 3 <= end; p++) {
+        if (p[0] != '"' || memcmp(p + 1, key, keyLen) != 0 || p[keyLen + 1] != '"' || p[keyLen + 2] != ':') continue;
+        uint32_t n = 0;
+        const char* d = p + keyLen + 3;
+        if (d >= end || *d < '0' || *d > '9') return false;
+        for (; d < end && *d >= '0' && *d <= '9'; d++) n = n * 10 + (*d - '0');
+        out = n;
+        return true;
+    }
+    return false;
+}
+
+// device/FLEET-00012/actuator/1/actual-status {"value":"on","id":"op-17",...}
+// Untraced actual-status messages (periodic, pump changes) carry no id.
+static void onOperatorMessage(void* ctx, const char* topic, const uint8_t* payload, size_t length) {
+    Operator& op = *static_cast<Operator*>(ctx);
+    if (strncmp(topic, op.prefix, op.prefixLen) != 0) return;
+    char* end;
+    unsigned long index = strtoul(topic + op.prefixLen, &end, 10);
+    if (end == topic + op.prefixLen || index >= op.pending.size()) return;
+
+    const char* id;
+    size_t idLen;
+    char text[ACTUATION_ID_MAX];
+    if (!mqttSchema_findString(payload, length, "id", &id, &idLen) || idLen < 4 || memcmp(id, "op-", 3) != 0) return;
+    actuationTrace_copyId(text, id + 3, idLen - 3);
+    PendingCommand& p = op.pending[index];
+    if (p.sentUs == 0 || strtoul(text, nullptr, 10) != p.id) return;
+    if (op.recording) {
+        op.latencyUs.push_back((uint32_t)(monotonicUs() - p.sentUs));
+        uint32_t deviceUs;
+        if (findNumber(payload, length, "total", deviceUs)) op.deviceUs.push_back(deviceUs);
+        op.acked++;
+    }
+    p.sentUs = 0;
+}
+
+static uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Sends one status command to a random online manual-mode device without an
+// outstanding one
+static void sendCommand(Operator& op, MqttWire& wire, Device* devices, unsigned count, uint32_t& rng) {
+    for (int attempt = 0; attempt < 8; attempt++) {
+        unsigned i = nextRandom(rng) % count;
+        if (!op.manual[i] || !devices[i].online() || op.pending[i].sentUs != 0) continue;
+        bool value = !op.requested[i];
+        char topic[TOPIC_MAX];
+        snprintf(topic, sizeof(topic), "device/%s/actuator/%d/status", devices[i].code(), ACTUATOR_ID);
+        uint32_t id = op.nextId++;
+        char payload[64];
+        int len = snprintf(payload, sizeof(payload), "{\"value\":\"%s\",\"id\":\"op-%lu\"}", value ? "on" : "off",
+                           (unsigned long)id);
+        op.pending[i].sentUs = monotonicUs();
+        op.pending[i].id = id;
+        if (!wire.publish(topic, payload, len, false)) {
+            op.pending[i].sentUs = 0;
+            return;
+        }
+        op.requested[i] = value;
+        if (op.recording) op.sent++;
+        return;
+    }
+}
+
+static void expireCommands(Operator& op) {
+    uint64_t now = monotonicUs();
+    for (size_t i = 0; i < op.pending.size(); i++) {
+        PendingCommand& p = op.pending[i];
+        if (p.sentUs == 0 || now - p.sentUs < FLEET_COMMAND_TIMEOUT_MS * 1000ULL) continue;
+        p.sentUs = 0;
+        if (op.recording) op.lost++;
+    }
+}
+
+// --- Report ---
+
+struct FleetTotals {
+    unsigned long online;
+    unsigned long connects;
+    unsigned long published;
+    unsigned long publishedBytes;
+    unsigned long publishDropped;
+    unsigned long received;
+    unsigned long commands;
+    unsigned long commandsDropped;
+    unsigned long pumpStarts;
+};
+
+static FleetTotals collect(const Device* devices, unsigned count) {
+    FleetTotals t = {};
+    for (unsigned i = 0; i < count; i++) {
+        const DeviceStats& s = devices[i].stats();
+        t.online += devices[i].online();
+        t.connects += s.connects.load(std::memory_order_relaxed);
+        t.published += s.published.load(std::memory_order_relaxed);
+        t.publishedBytes += s.publishedBytes.load(std::memory_order_relaxed);
+        t.publishDropped += s.publishDropped.load(std::memory_order_relaxed);
+        t.received += s.received.load(std::memory_order_relaxed);
+        t.commands += s.commands.load(std::memory_order_relaxed);
+        t.commandsDropped += s.commandsDropped.load(std::memory_order_relaxed);
+        t.pumpStarts += s.pumpStarts.load(std::memory_order_relaxed);
+    }
+    return t;
+}
+
+static double percentileMs(const std::vector<uint32_t>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    size_t i = (size_t)(q * sorted.size());
+    return sorted[std::min(i, sorted.size() - 1)] / 1000.0;
+}
+
+// --- Main ---
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --broker HOST[:PORT]  MQTT broker (default 127.0.0.1:1883)\n"
+            "  --devices N           simulated controllers (default 100)\n"
+            "  --threads N           worker threads (default: CPU count)\n"
+            "  --duration S          measured seconds after ramp-up (default 60)\n"
+            "  --ramp N              connects per second during ramp-up (default 200)\n"
+            "  --commands N          operator status commands per second (default 10)\n"
+            "  --auto F              share of devices starting in auto mode (default 0)\n"
+            "  --report-all          publish every channel every period (ignore deadbands)\n"
+            "  --seed N              random seed (default 1)\n",
+            name);
+}
+
+static bool parseOptions(int argc, char** argv, FleetOptions& o) {
+    static const option longOptions[] = {
+        { "broker", required_argument, nullptr, 'b' },
+        { "devices", required_argument, nullptr, 'n' },
+        { "threads", required_argument, nullptr, 't' },
+        { "duration", required_argument, nullptr, 'd' },
+        { "ramp", required_argument, nullptr, 'r' },
+        { "commands", required_argument, nullptr, 'c' },
+        { "auto", required_argument, nullptr, 'a' },
+        { "report-all", no_argument, nullptr, 'A' },
+        { "seed", required_argument, nullptr, 's' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 },
+    };
+    static char host[128] = "127.0.0.1";
+    o.host = host;
+    o.port = 1883;
+    o.devices = 100;
+    o.threads = std::max(1u, std::thread::hardware_concurrency());
+    o.durationS = 60;
+    o.rampPerS = 200;
+    o.commandsPerS = 10;
+    o.autoShare = 0;
+    o.reportEveryPeriod = false;
+    o.seed = 1;
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+        switch (c) {
+            case 'b': {
+                strlcpy(host, optarg, sizeof(host));
+                char* colon = strrchr(host, ':');
+                if (colon) {
+                    *colon = '\0';
+                    o.port = (uint16_t)atoi(colon + 1);
+                }
+                break;
+            }
+            case 'n': o.devices = (unsigned)atoi(optarg); break;
+            case 't': o.threads = (unsigned)atoi(optarg); break;
+            case 'd': o.durationS = (unsigned)atoi(optarg); break;
+            case 'r': o.rampPerS = (unsigned)atoi(optarg); break;
+            case 'c': o.commandsPerS = (float)atof(optarg); break;
+            case 'a': o.autoShare = (float)atof(optarg); break;
+            case 'A': o.reportEveryPeriod = true; break;
+            case 's': o.seed = (uint32_t)atoi(optarg); break;
+            default: return false;
+        }
+    }
+    if (o.devices == 0 || o.threads == 0 || o.rampPerS == 0 || o.devices > 99999) return false;
+    if (o.threads > o.devices) o.threads = o.devices;
+    return true;
+}
+
+static bool resolve(const char* host, uint16_t port, sockaddr_in& out) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result;
+    if (getaddrinfo(host, nullptr, &hints, &result) != 0) return false;
+    out = *reinterpret_cast<sockaddr_in*>(result->ai_addr);
+    out.sin_port = htons(port);
+    freeaddrinfo(result);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    FleetOptions o;
+    if (!parseOptions(argc, argv, o)) {
+        usage(argv[0]);
+        return 2;
+    }
+    sockaddr_in broker;
+    if (!resolve(o.host, o.port, broker)) {
+        fprintf(stderr, "cannot resolve %s\n", o.host);
+        return 1;
+    }
+    // Rule windows use the firmware's local time
+    setenv("TZ", TIME_ZONE, 1);
+    tzset();
+
+    // Each device is one open socket, plus the operator's
+    rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < o.devices + 64) {
+        files.rlim_cur = std::min<rlim_t>(files.rlim_max, o.devices + 64);
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+
+    Operator op;
+    op.prefix = "device/FLEET-";
+    op.prefixLen = strlen(op.prefix);
+    op.pending.assign(o.devices, PendingCommand());
+    op.requested.assign(o.devices, false);
+    op.manual.assign(o.devices, true);
+    op.nextId = 0;
+    op.recording = false;
+    op.sent = op.acked = op.lost = 0;
+
+    size_t rssBefore = residentBytes();
+    Device* devices = new Device[o.devices];
+    ClockCache cache = { 0, -1 };
+    DeviceClock clock = makeClock(cache);
+    uint32_t rng = o.seed * 2654435761u + 7;
+    for (unsigned i = 0; i < o.devices; i++) {
+        char code[24];
+        snprintf(code, sizeof(code), "FLEET-%05u", i);
+        DeviceOptions options;
+        options.mode = (nextRandom(rng) % 1000) < o.autoShare * 1000 ? MODE_AUTO : MODE_MANUAL;
+        options.reportEveryPeriod = o.reportEveryPeriod;
+        options.startDelayMs = i * 1000UL / o.rampPerS;
+        options.seed = o.seed * 100003u + i;
+        devices[i].begin(code, broker, options, clock);
+        op.manual[i] = options.mode == MODE_MANUAL;
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < o.threads; t++) {
+        size_t first = (size_t)o.devices * t / o.threads;
+        size_t last = (size_t)o.devices * (t + 1) / o.threads;
+        workers.push_back(std::thread(workerLoop, devices + first, last - first));
+    }
+
+    MqttWire wire;
+    bool subscribed = false;
+
+    // Ramp-up: every device has had its turn to connect, plus a settling second
+    unsigned long start = monotonicMs();
+    unsigned long rampEnd = start + o.devices * 1000UL / o.rampPerS + 1000;
+    unsigned long measureStart = 0;
+    unsigned long measureEnd = 0;
+    unsigned long nextExpire = start;
+    unsigned long lastProgress = start;
+    unsigned long commandIntervalUs = o.commandsPerS > 0 ? (unsigned long)(1e6f / o.commandsPerS) : 0;
+    uint64_t nextCommandUs = monotonicUs();
+    FleetTotals before = {};
+    double cpuBefore = 0, operatorCpuBefore = 0;
+    size_t rssFleet = 0;
+
+    fprintf(stderr, "fleet: %u devices on %u threads -> %s:%u, ramp %u/s\n", o.devices, o.threads, o.host,
+            o.port, o.rampPerS);
+    for (;;) {
+        unsigned long now = monotonicMs();
+        if (!wire.open() && !wire.connect(broker, "fleet-operator", 15, onOperatorMessage, &op, now)) {
+            fprintf(stderr, "operator: cannot connect to the broker\n");
+            stopping = true;
+            break;
+        }
+        if (wire.connected() && !subscribed) {
+            subscribed = wire.subscribe("device/+/actuator/+/actual-status");
+        }
+
+        pollfd pfd = { wire.fd(), POLLIN, 0 };
+        poll(&pfd, 1, 5);
+        now = monotonicMs();
+        if (!wire.service(now, pfd.revents != 0)) subscribed = false;
+
+        if (measureStart == 0 && (long)(now - rampEnd) >= 0) {
+            measureStart = now;
+            measureEnd = now + o.durationS * 1000UL;
+            rssFleet = residentBytes();
+            before = collect(devices, o.devices);
+            cpuBefore = processCpuS();
+            operatorCpuBefore = threadCpuS();
+            // Commands from the ramp-up are not timed
+            for (size_t i = 0; i < op.pending.size(); i++) op.pending[i].sentUs = 0;
+            op.recording = true;
+            fprintf(stderr, "fleet: %lu/%u online, measuring %u s\n", before.online, o.devices, o.durationS);
+        }
+        if (measureStart != 0 && (long)(now - measureEnd) >= 0) break;
+
+        if (commandIntervalUs && wire.connected()) {
+            uint64_t nowUs = monotonicUs();
+            for (int burst = 0; burst < 100 && nowUs >= nextCommandUs; burst++) {
+                sendCommand(op, wire, devices, o.devices, rng);
+                nextCommandUs += commandIntervalUs;
+            }
+            if (nowUs >= nextCommandUs) nextCommandUs = nowUs; // could not keep up
+        }
+        if ((long)(now - nextExpire) >= 0) {
+            expireCommands(op);
+            nextExpire = now + 500;
+        }
+        if (now - lastProgress >= 10000) {
+            lastProgress = now;
+            FleetTotals t = collect(devices, o.devices);
+            fprintf(stderr, "fleet: %lu online, %lu published, %lu commands acked\n", t.online, t.published, op.acked);
+        }
+    }
+
+    FleetTotals after = collect(devices, o.devices);
+    double cpuS = processCpuS() - cpuBefore;
+    double operatorCpuS = threadCpuS() - operatorCpuBefore;
+    stopping = true;
+    for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+    if (measureStart == 0) return 1;
+
+    double seconds = (measureEnd - measureStart) / 1000.0;
+    std::vector<uint32_t> sorted = op.latencyUs;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<uint32_t> onDevice = op.deviceUs;
+    std::sort(onDevice.begin(), onDevice.end());
+    double fleetCpuS = cpuS - operatorCpuS;
+    size_t deviceBytes = 0;
+    for (unsigned i = 0; i < o.devices; i++) deviceBytes += devices[i].memoryBytes();
+
+    printf("fleet      %u devices, %u worker threads, broker %s:%u, %.0f s measured\n", o.devices, o.threads,
+           o.host, o.port, seconds);
+    printf("online     %lu at start, %lu at end, %lu reconnects\n", before.online, after.online,
+           after.connects - before.connects);
+    printf("publish    %.1f msg/s, %.1f KB/s, %lu dropped\n", (after.published - before.published) / seconds,
+           (after.publishedBytes - before.publishedBytes) / seconds / 1024.0, after.publishDropped - before.publishDropped);
+    printf("receive    %.1f msg/s at the devices, %lu commands applied, %lu dropped, %lu pump starts\n",
+           (after.received - before.received) / seconds, after.commands - before.commands,
+           after.commandsDropped - before.commandsDropped, after.pumpStarts - before.pumpStarts);
+    printf("commands   %lu sent, %lu acknowledged, %lu lost (> %u ms)\n", op.sent, op.acked, op.lost,
+           FLEET_COMMAND_TIMEOUT_MS);
+    printf("latency    command -> actual-status p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+           percentileMs(sorted, 0.50), percentileMs(sorted, 0.90), percentileMs(sorted, 0.99),
+           sorted.empty() ? 0.0 : sorted.back() / 1000.0);
+    printf("           on the device (rx -> actual-status) p50 %.1f ms, p99 %.1f ms\n", percentileMs(onDevice, 0.50),
+           percentileMs(onDevice, 0.99));
+    printf("cpu        %.1f us/s per device (%.4f%% of a core), workers %.1f%% of %u cores\n",
+           fleetCpuS * 1e6 / seconds / o.devices, fleetCpuS * 100 / seconds / o.devices,
+           fleetCpuS * 100 / seconds / o.threads, o.threads);
+    printf("memory     %u B per Device object, %.0f B per device incl. buffers, RSS +%.1f KB per device\n",
+           (unsigned)sizeof(Device), (double)deviceBytes / o.devices,
+           rssFleet > rssBefore ? (rssFleet - rssBefore) / 1024.0 / o.devices : 0.0);
+
+    wire.disconnect();
+    delete[] devices;
+    return 0;
+}
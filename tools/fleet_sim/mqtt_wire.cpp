@@ -0,0 +1,258 @@
+#include "mqtt_wire.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define WIRE_RX_MAX 65536  // largest packet accepted from the broker
+#define WIRE_TX_MAX 32768  // unsent bytes before publishes are dropped
+#define WIRE_TOPIC_MAX 128
+
+enum PacketType : uint8_t {
+    PKT_CONNECT = 1,
+    PKT_CONNACK = 2,
+    PKT_PUBLISH = 3,
+    PKT_PUBACK = 4,
+    PKT_SUBSCRIBE = 8,
+    PKT_SUBACK = 9,
+    PKT_PINGREQ = 12,
+    PKT_PINGRESP = 13,
+    PKT_DISCONNECT = 14
+};
+
+// Fixed header: type/flags byte plus the 1-4 byte remaining length
+static size_t fixedHeader(uint8_t* out, uint8_t first, size_t remaining) {
+    size_t n = 0;
+    out[n++] = first;
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        out[n++] = remaining ? (digit | 0x80) : digit;
+    } while (remaining && n < 5);
+    return n;
+}
+
+static size_t putString(uint8_t* out, const char* text, size_t len) {
+    out[0] = (uint8_t)(len >> 8);
+    out[1] = (uint8_t)len;
+    memcpy(out + 2, text, len);
+    return len + 2;
+}
+
+MqttWire::MqttWire()
+    : sock(-1), acked(false), keepAliveS(15), nextPacketId(1), lastSendMs(0), lastReceiveMs(0), lastServiceMs(0),
+      pingOutstanding(false), handler(nullptr), handlerCtx(nullptr), rxLength(0), txLength(0) {}
+
+MqttWire::~MqttWire() {
+    if (sock >= 0) close(sock);
+}
+
+bool MqttWire::connect(const sockaddr_in& broker, const char* clientId, uint16_t keepAlive,
+                       MessageHandler onMessage, void* ctx, unsigned long now) {
+    disconnect();
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return false;
+    if (::connect(sock, reinterpret_cast<const sockaddr*>(&broker), sizeof(broker)) != 0) {
+        close(sock);
+        sock = -1;
+        return false;
+    }
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    handler = onMessage;
+    handlerCtx = ctx;
+    keepAliveS = keepAlive;
+    lastSendMs = lastReceiveMs = lastServiceMs = now;
+    pingOutstanding = false;
+
+    size_t idLen = strlen(clientId);
+    uint8_t body[10 + 2 + WIRE_TOPIC_MAX];
+    if (idLen > WIRE_TOPIC_MAX) idLen = WIRE_TOPIC_MAX;
+    size_t n = putString(body, "MQTT", 4);
+    body[n++] = 4;    // protocol level 3.1.1
+    body[n++] = 0x02; // clean session
+    body[n++] = (uint8_t)(keepAlive >> 8);
+    body[n++] = (uint8_t)keepAlive;
+    n += putString(body + n, clientId, idLen);
+    uint8_t header[5];
+    return queue(header, fixedHeader(header, PKT_CONNECT << 4, n), body, n);
+}
+
+void MqttWire::disconnect() {
+    if (sock >= 0) {
+        if (acked) {
+            static const uint8_t packet[2] = { PKT_DISCONNECT << 4, 0 };
+            send(sock, packet, sizeof(packet), MSG_NOSIGNAL);
+        }
+        close(sock);
+    }
+    sock = -1;
+    acked = false;
+    rxLength = 0;
+    txLength = 0;
+}
+
+bool MqttWire::queue(const uint8_t* header, size_t headerLen, const void* body, size_t bodyLen) {
+    if (sock < 0 || txLength + headerLen + bodyLen > WIRE_TX_MAX) return false;
+    if (tx.size() < txLength + headerLen + bodyLen) tx.resize(txLength + headerLen + bodyLen);
+    memcpy(&tx[txLength], header, headerLen);
+    memcpy(&tx[txLength + headerLen], body, bodyLen);
+    txLength += headerLen + bodyLen;
+    lastSendMs = lastServiceMs;
+    return flush();
+}
+
+bool MqttWire::flush() {
+    size_t sent = 0;
+    while (sent < txLength) {
+        ssize_t n = send(sock, &tx[sent], txLength - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0 && errno == EINTR) continue;
+        disconnect();
+        return false;
+    }
+    if (sent > 0) {
+        memmove(&tx[0], &tx[sent], txLength - sent);
+        txLength -= sent;
+    }
+    return true;
+}
+
+bool MqttWire::publish(const char* topic, const void* payload, size_t length, bool retain) {
+    if (!connected()) return false;
+    size_t topicLen = strlen(topic);
+    if (topicLen > WIRE_TOPIC_MAX) return false;
+    uint8_t header[5 + 2 + WIRE_TOPIC_MAX];
+    size_t n = fixedHeader(header, (PKT_PUBLISH << 4) | (retain ? 1 : 0), 2 + topicLen + length);
+    n += putString(header + n, topic, topicLen);
+    return queue(header, n, payload, length);
+}
+
+bool MqttWire::subscribe(const char* filter) {
+    if (!connected()) return false;
+    size_t filterLen = strlen(filter);
+    if (filterLen > WIRE_TOPIC_MAX) return false;
+    uint8_t body[2 + 2 + WIRE_TOPIC_MAX + 1];
+    uint16_t id = nextPacketId++;
+    if (nextPacketId == 0) nextPacketId = 1;
+    body[0] = (uint8_t)(id >> 8);
+    body[1] = (uint8_t)id;
+    size_t n = 2 + putString(body + 2, filter, filterLen);
+    body[n++] = 0; // QoS 0
+    uint8_t header[5];
+    return queue(header, fixedHeader(header, (PKT_SUBSCRIBE << 4) | 0x02, n), body, n);
+}
+
+void MqttWire::dispatch(uint8_t first, const uint8_t* body, size_t length) {
+    switch (first >> 4) {
+        case PKT_CONNACK:
+            if (length >= 2 && body[1] == 0) acked = true;
+            else disconnect(); // refused
+            break;
+        case PKT_PUBLISH: {
+            if (length < 2) return;
+            size_t topicLen = ((size_t)body[0] << 8) | body[1];
+            uint8_t qos = (first >> 1) & 0x03;
+            size_t offset = 2 + topicLen + (qos ? 2 : 0);
+            if (offset > length || topicLen >= WIRE_TOPIC_MAX) return;
+            if (qos == 1) {
+                uint8_t ack[4] = { PKT_PUBACK << 4, 2, body[2 + topicLen], body[3 + topicLen] };
+                uint8_t none = 0;
+                queue(ack, sizeof(ack), &none, 0);
+            }
+            char topic[WIRE_TOPIC_MAX];
+            memcpy(topic, body + 2, topicLen);
+            topic[topicLen] = '\0';
+            if (handler) handler(handlerCtx, topic, body + offset, length - offset);
+            break;
+        }
+        case PKT_PINGRESP:
+            pingOutstanding = false;
+            break;
+        default: // SUBACK and anything else needs no action
+            break;
+    }
+}
+
+bool MqttWire::readAvailable() {
+    for (;;) {
+        if (rx.size() - rxLength < 2048) rx.resize(rxLength + 4096);
+        ssize_t n = recv(sock, &rx[rxLength], rx.size() - rxLength, 0);
+        if (n > 0) {
+            rxLength += n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (n < 0 && errno == EINTR) continue;
+        return false; // closed by the broker or failed
+    }
+}
+
+bool MqttWire::service(unsigned long now, bool readable) {
+    if (sock < 0) return false;
+    lastServiceMs = now;
+    if (readable) {
+        if (!readAvailable()) {
+            disconnect();
+            return false;
+        }
+        lastReceiveMs = now;
+
+        // Dispatch every complete packet, keep a partial one for next time
+        size_t pos = 0;
+        while (sock >= 0 && rxLength - pos >= 2) {
+            size_t remaining = 0;
+            size_t i = 1;
+            uint32_t scale = 1;
+            bool complete = false;
+            while (i < 5 && pos + i < rxLength) {
+                uint8_t digit = rx[pos + i++];
+                remaining += (digit & 0x7F) * scale;
+                scale *= 128;
+                if (!(digit & 0x80)) {
+                    complete = true;
+                    break;
+                }
+            }
+            if (!complete || remaining > WIRE_RX_MAX) {
+                if (i >= 5 || remaining > WIRE_RX_MAX) disconnect(); // malformed or oversized
+                break;
+            }
+            if (rxLength - pos < i + remaining) break;
+            dispatch(rx[pos], &rx[pos + i], remaining);
+            pos += i + remaining;
+        }
+        if (sock < 0) return false;
+        memmove(&rx[0], &rx[pos], rxLength - pos);
+        rxLength -= pos;
+    }
+
+    if (txLength > 0 && !flush()) return false;
+
+    // Keepalive: ping when quiet, give up when the broker stays silent
+    unsigned long keepAliveMs = keepAliveS * 1000UL;
+    if (acked && keepAliveMs > 0) {
+        if (now - lastReceiveMs > keepAliveMs + keepAliveMs / 2) {
+            disconnect();
+            return false;
+        }
+        if (!pingOutstanding && now - lastSendMs >= keepAliveMs / 2 && now - lastReceiveMs >= keepAliveMs / 2) {
+            uint8_t ping[2] = { PKT_PINGREQ << 4, 0 };
+            uint8_t none = 0;
+            pingOutstanding = queue(ping, sizeof(ping), &none, 0);
+        }
+    }
+    return sock >= 0;
+}
+
+size_t MqttWire::memoryBytes() const {
+    return rx.capacity() + tx.capacity();
+}
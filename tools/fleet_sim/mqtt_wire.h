@@ -0,0 +1,66 @@
+#ifndef FLEET_MQTT_WIRE_H
+#define FLEET_MQTT_WIRE_H
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Minimal MQTT 3.1.1 client for the fleet simulator: QoS 0 publish and
+// subscribe, retain, keepalive, over a non-blocking socket driven by the
+// caller's poll loop. It carries the firmware's traffic without the QoS 1
+// outbox and persistent session of mqtt_async.h, so thousands of them fit in
+// one process and none of them owns a thread. Not thread-safe; one owner at a
+// time.
+class MqttWire {
+public:
+    typedef void (*MessageHandler)(void* ctx, const char* topic, const uint8_t* payload, size_t length);
+
+    MqttWire();
+    ~MqttWire();
+
+    // TCP connect (blocking, meant for a broker on localhost or the LAN),
+    // then sends CONNECT with a clean session; connected() turns true on
+    // CONNACK. False if the socket could not be opened.
+    bool connect(const sockaddr_in& broker, const char* clientId, uint16_t keepAliveS,
+                 MessageHandler handler, void* ctx, unsigned long now);
+    void disconnect();
+    bool open() const { return sock >= 0; }
+    bool connected() const { return sock >= 0 && acked; }
+    int fd() const { return sock; }
+    bool wantsWrite() const { return txLength > 0; }
+
+    // False when the outgoing buffer is full (the message is dropped)
+    bool publish(const char* topic, const void* payload, size_t length, bool retain);
+    bool subscribe(const char* filter);
+
+    // Reads whatever arrived (readable = poll reported input), dispatches
+    // PUBLISHes, flushes pending output and keeps the session alive. Returns
+    // false once the connection is gone.
+    bool service(unsigned long now, bool readable);
+
+    size_t memoryBytes() const; // buffers currently held
+
+private:
+    bool queue(const uint8_t* header, size_t headerLen, const void* body, size_t bodyLen);
+    bool flush();
+    bool readAvailable();
+    void dispatch(uint8_t type, const uint8_t* body, size_t length);
+
+    int sock;
+    bool acked;
+    uint16_t keepAliveS;
+    uint16_t nextPacketId;
+    unsigned long lastSendMs;
+    unsigned long lastReceiveMs;
+    unsigned long lastServiceMs;  // "now" of the latest call, stamps queued output
+    bool pingOutstanding;
+    MessageHandler handler;
+    void* handlerCtx;
+    std::vector<uint8_t> rx;
+    size_t rxLength;
+    std::vector<uint8_t> tx;
+    size_t txLength;
+};
+
+#endif
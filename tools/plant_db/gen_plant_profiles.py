@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Generate include/plant_profiles_table.h from plants.csv.
+
+The table is laid out by a minimal perfect hash (hash and displace): every
+name falls into a bucket by plantHash(name, 0), and each bucket gets the
+smallest seed that sends all of its names to free slots through
+plantHash(name, seed) % count. The firmware computes the same hash (see
+plant_profiles.h) and the build checks every slot with a static_assert, so a
+table that does not match its hash does not compile.
+
+Usage: python3 tools/plant_db/gen_plant_profiles.py
+"""
+
+import csv
+import os
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SOURCE = os.path.join(HERE, "plants.csv")
+OUTPUT = os.path.join(HERE, "..", "..", "include", "plant_profiles_table.h")
+
+NAME_MAX = 24        # PLANT_NAME_MAX in device_state.h, terminator included
+NAMES_PER_BUCKET = 3
+MASK = 0xFFFFFFFF
+
+
+def plant_hash(name, seed):
+    """plantHash() from plant_profiles.h: FNV-1a over the lowercased name, then a mix."""
+    h = 2166136261 ^ seed
+    for c in name.encode("ascii"):
+        if ord("A") <= c <= ord("Z"):
+            c += 32
+        h = ((h ^ c) * 16777619) & MASK
+    h ^= h >> 16
+    h = (h * 0x45D9F3B) & MASK
+    h ^= h >> 16
+    return h
+
+
+def load():
+    rows = []
+    with open(SOURCE, newline="") as f:
+        lines = (line for line in f if not line.startswith("#"))
+        for row in csv.DictReader(lines):
+            name = row["name"].strip()
+            if len(name) >= NAME_MAX or not name.isascii() or '"' in name or "\\" in name:
+                raise SystemExit("%s: name must be plain ASCII, at most %d characters" % (name, NAME_MAX - 1))
+            profile = {k: int(row[k]) for k in ("min_moisture", "max_moisture", "preferred_temp",
+                                                "preferred_humidity", "run_s", "cooldown_s")}
+            if not 0 <= profile["min_moisture"] < profile["max_moisture"] <= 100:
+                raise SystemExit("%s: need 0 <= min_moisture < max_moisture <= 100" % name)
+            if not 1 <= profile["run_s"] <= 3600 or not 0 <= profile["cooldown_s"] <= 65535:
+                raise SystemExit("%s: run_s must be 1..3600, cooldown_s 0..65535" % name)
+            profile["name"] = name
+            profile["group"] = row["group"].strip()
+            rows.append(profile)
+    names = [r["name"].lower() for r in rows]
+    duplicates = sorted(set(n for n in names if names.count(n) > 1))
+    if duplicates:
+        raise SystemExit("duplicate names: %s" % ", ".join(duplicates))
+    return rows
+
+
+def build(rows):
+    count = len(rows)
+    bucket_count = max(1, (count + NAMES_PER_BUCKET - 1) // NAMES_PER_BUCKET)
+    buckets = [[] for _ in range(bucket_count)]
+    for i, r in enumerate(rows):
+        buckets[plant_hash(r["name"], 0) % bucket_count].append(i)
+
+    seeds = [0] * bucket_count
+    slots = [None] * count
+    # Largest buckets first, while most slots are still free
+    for b in sorted(range(bucket_count), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            continue
+        for seed in range(1, 0x10000):
+            taken = [plant_hash(rows[i]["name"], seed) % count for i in buckets[b]]
+            if len(set(taken)) == len(taken) and all(slots[s] is None for s in taken):
+                break
+        else:
+            raise SystemExit("no seed for bucket %d; lower NAMES_PER_BUCKET" % b)
+        seeds[b] = seed
+        for i, s in zip(buckets[b], taken):
+            slots[s] = rows[i]
+    return seeds, slots
+
+
+def write(seeds, slots):
+    out = []
+    out.append("// Generated by tools/plant_db/gen_plant_profiles.py from plants.csv - do not edit.")
+    out.append("// Included by src/plant_profiles.cpp only; slot order is the perfect hash's.")
+    out.append("")
+    out.append("#define PLANT_PROFILE_COUNT %d" % len(slots))
+    out.append("#define PLANT_BUCKET_COUNT  %d" % len(seeds))
+    out.append("")
+    out.append("static constexpr uint16_t PLANT_SEEDS[PLANT_BUCKET_COUNT] = {")
+    for i in range(0, len(seeds), 16):
+        out.append("    " + ", ".join("%d" % s for s in seeds[i:i + 16]) + ",")
+    out.append("};")
+    out.append("")
+    out.append("static constexpr PlantProfile PLANT_PROFILES[PLANT_PROFILE_COUNT] = {")
+    out.append("    // name, min/max moisture %, preferred temp C, preferred humidity %, run s, cooldown s")
+    for r in slots:
+        out.append('    { %-26s %3d, %3d, %3d, %3d, %4d, %5d }, // %s' % (
+            '"%s",' % r["name"], r["min_moisture"], r["max_moisture"], r["preferred_temp"],
+            r["preferred_humidity"], r["run_s"], r["cooldown_s"], r["group"]))
+    out.append("};")
+    with open(OUTPUT, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    rows = load()
+    seeds, slots = build(rows)
+    write(seeds, slots)
+    print("%d profiles, %d buckets, largest seed %d -> %s" % (len(slots), len(seeds), max(seeds),
+                                                          os.path.relpath(OUTPUT)))